@@ -106,6 +106,14 @@ static NSError *ExceptionToError (const std::exception &e)
         desc = @"The volume slot is unavailable.";
     else if (dynamic_cast <const TemporaryDirectoryFailure *> (&e))
         desc = @"Failed to create a temporary directory.";
+    else if (dynamic_cast <const ReEncryptionNotRequired *> (&e))
+        desc = @"The volume already uses the current format.";
+
+    // --- Volume exceptions (VolumeException.h) ---
+    else if (dynamic_cast <const VolumeEncryptionNotCompleted *> (&e))
+        desc = @"Re-encryption of the volume has not been completed. Run basalt-cli --reencrypt to resume it.";
+    else if (dynamic_cast <const KeyRotationNotCompleted *> (&e))
+        desc = @"Rotation of the master key of the volume has not been completed. Mount the volume read-write to resume it.";
 
     // --- Password exceptions (VolumePassword.h) ---
     // Order matters: most-derived first (PasswordKeyfilesIncorrect before PasswordIncorrect).
@@ -17,11 +17,15 @@
 #include "Core/Unix/CoreService.h"
 #include "Platform/Unix/Process.h"
 #endif
+#include "Core/CoreTest.h"
 #include "Core/VolumeOperations.h"
 #include "Core/VolumeCreator.h"
+#include "Core/VolumeKeyRotator.h"
+#include "Core/VolumeReEncryptor.h"
 #include "Core/RandomNumberGenerator.h"
 #include "Volume/Version.h"
 #include "Volume/EncryptionTest.h"
+#include "Crypto/CryptoDispatch.h"
 #include "Platform/PlatformTest.h"
 #include "CLICallback.h"
 
@@ -62,7 +66,16 @@ enum CLICommand
 	CmdBackupHeaders,
 	CmdRestoreHeaders,
 	CmdChangePassword,
+	CmdReEncrypt,
+	CmdGrow,
+	CmdKeyRotation,
 	CmdCreateKeyfile,
+	CmdWipeFreeSpace,
+	CmdBenchmark,
+	CmdExport,
+	CmdImport,
+	CmdChangedSince,
+	CmdCpuFeatures,
 	CmdListDevices,
 	CmdVersion,
 	CmdHelp
@@ -117,7 +130,7 @@ static inline string W (const wstring &ws) { return StringConverter::ToSingle (w
 
 // ---- Progress bar ----
 
-static void DrawProgressBar (uint64 done, uint64 total, double elapsedSec)
+static void DrawProgressBar (uint64 done, uint64 total, double elapsedSec, uint64 bytesPerSecond = 0)
 {
 	if (total == 0) return;
 	int pct = (int) (done * 100 / total);
@@ -135,6 +148,10 @@ static void DrawProgressBar (uint64 done, uint64 total, double elapsedSec)
 	// Size progress
 	std::cerr << W (FormatSize (done)) << " / " << W (FormatSize (total));
 
+	// Throughput
+	if (bytesPerSecond > 0 && elapsedSec > 1.0)
+		std::cerr << "  " << W (FormatSize (bytesPerSecond)) << "/s";
+
 	// ETA
 	if (elapsedSec > 1.0 && done > 0)
 	{
@@ -389,25 +406,67 @@ static void ShowHelp (const char *argv0)
 		"  --backup-headers PATH    Backup volume headers\n"
 		"  --restore-headers PATH   Restore volume headers\n"
 		"  --change, -C PATH        Change password/keyfiles\n"
+		"  --grow PATH              Enlarge a volume in place by --size=+SIZE, or to the\n"
+		"                           current size of its device; resize the filesystem\n"
+		"                           afterwards. Resumes an interrupted expansion\n"
+		"  --reencrypt PATH         Convert a legacy volume in place to the current\n"
+		"                           format (XTS); resumes an interrupted conversion\n"
+		"  --key-rotation=ACTION PATH\n"
+		"                           Control master key rotation of a mounted volume\n"
+		"                           (status, pause, resume, rate=MB/s; 0 = unlimited)\n"
 		"  --create-keyfile PATH    Create a new keyfile\n"
+		"  --wipe-free-space PATH   Overwrite the free space of a mounted volume (volume\n"
+		"                           path or mount point) with random data\n"
+		"  --benchmark PATH         Measure random read latency of a mounted volume, alone\n"
+		"                           and during bulk writes (about 10 s; compare queuedepth)\n"
+		"  --export PATH OUTPUT     Write the decrypted data area of a volume to a raw\n"
+		"                           image file, or to standard output if OUTPUT is -\n"
+		"  --import INPUT PATH      Overwrite the data area of a volume with a raw image\n"
+		"                           file, or with standard input if INPUT is -\n"
+		"  --changed-since=TOKEN PATH\n"
+		"                           List the areas of a container changed since the backup\n"
+		"                           that received TOKEN (0 = all), followed by a new token\n"
+		"                           (requires mounting with trackchanges)\n"
 		"  --list-devices           List available devices/partitions\n"
 		"  --test                   Run self-tests\n"
+		"  --cpu-features           Display CPU features and selected crypto kernels\n"
 		"  --version                Display version\n"
 		"  --help, -h               Display this help\n"
 		"\n"
 		"Options:\n"
 		"  -p, --password=PASS      Volume password\n"
 		"  -k, --keyfiles=K1[,K2]   Keyfile(s), comma-separated\n"
-		"  --size=SIZE              Volume size for --create (e.g. 10M, 1G, 500K)\n"
+		"  --size=SIZE              Volume size for --create (e.g. 10M, 1G, 500K), or\n"
+		"                           +SIZE to add for --grow\n"
 		"  --encryption=ALG         Encryption algorithm (default: AES)\n"
 		"  --hash=HASH              Hash algorithm (default: Argon2id-Max)\n"
 		"  --filesystem=TYPE        Filesystem: fat, hfs, none (default: hfs on macOS)\n"
 		"  --hidden                 Create a hidden volume inside an existing container\n"
-		"  --quick                  Quick format (skip random data fill)\n"
+		"  --quick                  Quick format (skip random data fill); leave the space\n"
+		"                           added by --grow unfilled (sparse in containers)\n"
+		"  --fill=MODE              Data fill for --create: encrypted (default: zeros\n"
+		"                           encrypted with a random key) or random\n"
+		"  --sector-size=SIZE       Sector size of a new file container: 512 (default)\n"
+		"                           or 4096 (fewer, larger requests; with fat or none;\n"
+		"                           used through libbasalt, not mountable on macOS)\n"
 		"  --new-password=PASS      New password (for --change)\n"
 		"  --new-keyfiles=K1[,K2]   New keyfiles (for --change)\n"
-		"  --mount-options=OPTS     Mount options (readonly,headerbak,nokernelcrypto,timestamp)\n"
-		"  --force                  Force mount/dismount\n"
+		"  --mount-options=OPTS     Mount options (readonly,headerbak,nokernelcrypto,timestamp,\n"
+		"                           rotatekey: re-encrypt the volume with a new master key\n"
+		"                           in the background while it is mounted,\n"
+		"                           sync=grouped|strict|none: flushing of the volume file\n"
+		"                           on fsync/NFS COMMIT (default: grouped; concurrent\n"
+		"                           requests share one flush), syncdelay=MS: longest wait\n"
+		"                           for further requests in grouped mode, default 1),\n"
+		"                           discard: pass TRIM through as holes in the container\n"
+		"                           file (reveals unused areas; not for outer volumes\n"
+		"                           containing a hidden volume; not on macOS),\n"
+		"                           queuedepth=N: volume requests processed at a time, with\n"
+		"                           reads served ahead of writes while more wait (default: 4,\n"
+		"                           0 = arrival order),\n"
+		"                           trackchanges: record changed areas of a container file\n"
+		"                           for --changed-since)\n"
+		"  --force                  Force mount/dismount, export a mounted volume\n"
 		"  --non-interactive        No user interaction\n"
 		"  --verbose, -v            Verbose output\n"
 		"\n"
@@ -438,6 +497,7 @@ static void ShowHelp (const char *argv0)
 		"  " << argv0 << " -c /dev/disk2 --password=secret              Create on device\n"
 		"  " << argv0 << " /dev/disk2 /mnt/tc                           Mount device\n"
 #endif
+		"  " << argv0 << " --export volume.tc - | gzip >volume.img.gz\n"
 		"  " << argv0 << " --test\n"
 		;
 }
@@ -498,14 +558,30 @@ static void ParseMountOptions (MountOptions &options, const string &arg)
 	{
 		if (token == "readonly" || token == "ro")
 			options.Protection = VolumeProtection::ReadOnly;
+		else if (token == "discard")
+			options.AllowDiscard = true;
 		else if (token == "headerbak")
 			options.UseBackupHeaders = true;
 		else if (token == "nokernelcrypto")
 			options.NoKernelCrypto = true;
+		else if (token == "rotatekey")
+			options.RotateMasterKey = true;
 		else if (token == "system")
 			options.PartitionInSystemEncryptionScope = true;
 		else if (token == "timestamp" || token == "ts")
 			options.PreserveTimestamps = false;
+		else if (token == "trackchanges")
+			options.TrackChanges = true;
+		else if (token == "sync=grouped")
+			options.SyncPolicy = VolumeSyncPolicy::Grouped;
+		else if (token == "sync=strict")
+			options.SyncPolicy = VolumeSyncPolicy::Strict;
+		else if (token == "sync=none")
+			options.SyncPolicy = VolumeSyncPolicy::None;
+		else if (token.compare (0, 10, "syncdelay=") == 0)
+			options.SyncMaxDelay = StringConverter::ToUInt32 (token.substr (10));
+		else if (token.compare (0, 11, "queuedepth=") == 0)
+			options.QueueDepth = StringConverter::ToUInt32 (token.substr (11));
 		else
 		{
 			std::cerr << ansiRed << "Unknown mount option: " << token << ansiReset << std::endl;
@@ -516,6 +592,18 @@ static void ParseMountOptions (MountOptions &options, const string &arg)
 
 // ---- Volume listing ----
 
+static string FormatKeyRotationProgress (const VolumeInfo &volume)
+{
+	stringstream s;
+	s << (volume.Size ? (int) (volume.KeyRotationSizeDone * 100 / volume.Size) : 100) << "% ("
+	  << W (FormatSize (volume.KeyRotationSizeDone)) << " / " << W (FormatSize (volume.Size)) << ")";
+
+	if (volume.KeyRotationPaused)
+		s << ", paused";
+
+	return s.str ();
+}
+
 static void ListMountedVolumes (bool verbose)
 {
 	VolumeInfoList volumes = Core->GetMountedVolumes ();
@@ -590,6 +678,9 @@ static void ListMountedVolumes (bool verbose)
 			if (vol->HiddenVolumeProtectionTriggered)
 				std::cerr << "  " << ansiRed << ansiBold << "\xe2\x9a\xa0 PROTECTION TRIGGERED"
 				           << ansiReset << " \xe2\x80\x94 hidden volume safe, outer filesystem may be corrupted" << std::endl;
+
+			if (vol->KeyRotationInProgress)
+				std::cerr << "  " << ansiDim << "Key rotation: " << FormatKeyRotationProgress (*vol) << ansiReset << std::endl;
 		}
 	}
 	else
@@ -611,6 +702,13 @@ static void ListMountedVolumes (bool verbose)
 			std::cout << ansiDim << "  KDF:        " << ansiReset << W (vol->Pkcs5PrfName) << std::endl;
 			std::cout << ansiDim << "  Read-only:  " << ansiReset
 			           << (vol->Protection == VolumeProtection::ReadOnly ? "Yes" : "No") << std::endl;
+			if (vol->KeyRotationInProgress)
+				std::cout << ansiDim << "  Key rotation: " << ansiReset << FormatKeyRotationProgress (*vol) << std::endl;
+			if (vol->SyncRequestCount)
+				std::cout << ansiDim << "  Sync:       " << ansiReset << vol->SyncRequestCount << " requests, "
+				           << vol->SyncFlushCount << " flushes, latency p50 " << vol->SyncLatencyP50
+				           << " us, p90 " << vol->SyncLatencyP90 << " us, p99 " << vol->SyncLatencyP99
+				           << " us, max " << vol->SyncLatencyMax << " us" << std::endl;
 			std::cout << std::endl;
 		}
 	}
@@ -652,16 +750,24 @@ int main (int argc, char *argv[])
 	static struct option longOptions[] =
 	{
 		{ "backup-headers",  required_argument, nullptr, 'B' },
+		{ "benchmark",       required_argument, nullptr, 'J' },
 		{ "change",          optional_argument, nullptr, 'C' },
+		{ "changed-since",   required_argument, nullptr, 'g' },
+		{ "cpu-features",    no_argument,       nullptr, 'U' },
 		{ "create",          required_argument, nullptr, 'c' },
 		{ "create-keyfile",  required_argument, nullptr, 'K' },
 		{ "dismount",        optional_argument, nullptr, 'd' },
 		{ "encryption",      required_argument, nullptr, 'E' },
+		{ "export",          required_argument, nullptr, 'e' },
 		{ "filesystem",      required_argument, nullptr, 'F' },
+		{ "fill",            required_argument, nullptr, 'G' },
 		{ "force",           no_argument,       nullptr, 'f' },
+		{ "grow",            required_argument, nullptr, 'r' },
 		{ "hash",            required_argument, nullptr, 'H' },
 		{ "help",            no_argument,       nullptr, 'h' },
 		{ "hidden",          no_argument,       nullptr, 'W' },
+		{ "import",          required_argument, nullptr, 'i' },
+		{ "key-rotation",    required_argument, nullptr, 'Y' },
 		{ "keyfiles",        required_argument, nullptr, 'k' },
 		{ "list",            no_argument,       nullptr, 'l' },
 		{ "list-devices",    no_argument,       nullptr, 'D' },
@@ -672,11 +778,14 @@ int main (int argc, char *argv[])
 		{ "non-interactive", no_argument,       nullptr, 'I' },
 		{ "password",        required_argument, nullptr, 'p' },
 		{ "quick",           no_argument,       nullptr, 'Q' },
+		{ "reencrypt",       required_argument, nullptr, 'X' },
 		{ "restore-headers", required_argument, nullptr, 'R' },
+		{ "sector-size",     required_argument, nullptr, 'S' },
 		{ "size",            required_argument, nullptr, 'Z' },
 		{ "test",            no_argument,       nullptr, 'T' },
 		{ "verbose",         no_argument,       nullptr, 'v' },
 		{ "version",         no_argument,       nullptr, 'V' },
+		{ "wipe-free-space", required_argument, nullptr, 'O' },
 		{ nullptr,           0,                 nullptr, 0   }
 	};
 
@@ -693,6 +802,10 @@ int main (int argc, char *argv[])
 	string argSize;
 	string argEncryption;
 	string argFilesystem;
+	string argFill;
+	string argKeyRotation;
+	string argChangedSince;
+	string argSectorSize;
 	bool verbose = false;
 	bool force = false;
 	bool nonInteractive = false;
@@ -714,6 +827,11 @@ int main (int argc, char *argv[])
 			argVolumePath = optarg;
 			break;
 
+		case 'J':  // --benchmark
+			command = CmdBenchmark;
+			argVolumePath = optarg;
+			break;
+
 		case 'c':  // --create
 			command = CmdCreate;
 			argVolumePath = optarg;
@@ -725,6 +843,11 @@ int main (int argc, char *argv[])
 				argVolumePath = optarg;
 			break;
 
+		case 'g':  // --changed-since
+			command = CmdChangedSince;
+			argChangedSince = optarg;
+			break;
+
 		case 'd':  // --dismount
 			command = CmdDismount;
 			if (optarg)
@@ -739,6 +862,11 @@ int main (int argc, char *argv[])
 			argEncryption = optarg;
 			break;
 
+		case 'e':  // --export
+			command = CmdExport;
+			argVolumePath = optarg;
+			break;
+
 		case 'F':  // --filesystem
 			{
 				string fs = optarg;
@@ -750,6 +878,15 @@ int main (int argc, char *argv[])
 			}
 			break;
 
+		case 'G':  // --fill
+			argFill = optarg;
+			break;
+
+		case 'r':  // --grow
+			command = CmdGrow;
+			argVolumePath = optarg;
+			break;
+
 		case 'h':  // --help
 			command = CmdHelp;
 			break;
@@ -766,10 +903,20 @@ int main (int argc, char *argv[])
 			hiddenVolume = true;
 			break;
 
+		case 'i':  // --import
+			command = CmdImport;
+			argFilePath = optarg;
+			break;
+
 		case 'k':  // --keyfiles
 			argKeyfiles = optarg;
 			break;
 
+		case 'Y':  // --key-rotation
+			command = CmdKeyRotation;
+			argKeyRotation = optarg;
+			break;
+
 		case 'K':  // --create-keyfile
 			command = CmdCreateKeyfile;
 			argFilePath = optarg;
@@ -779,6 +926,10 @@ int main (int argc, char *argv[])
 			command = CmdList;
 			break;
 
+		case 'U':  // --cpu-features
+			command = CmdCpuFeatures;
+			break;
+
 		case 'D':  // --list-devices
 			command = CmdListDevices;
 			break;
@@ -807,11 +958,20 @@ int main (int argc, char *argv[])
 			quickFormat = true;
 			break;
 
+		case 'X':  // --reencrypt
+			command = CmdReEncrypt;
+			argVolumePath = optarg;
+			break;
+
 		case 'R':  // --restore-headers
 			command = CmdRestoreHeaders;
 			argVolumePath = optarg;
 			break;
 
+		case 'S':  // --sector-size
+			argSectorSize = optarg;
+			break;
+
 		case 'T':  // --test
 			command = CmdTest;
 			break;
@@ -828,6 +988,11 @@ int main (int argc, char *argv[])
 			command = CmdVersion;
 			break;
 
+		case 'O':  // --wipe-free-space
+			command = CmdWipeFreeSpace;
+			argVolumePath = optarg;
+			break;
+
 		case '?':
 		default:
 			return 1;
@@ -835,6 +1000,9 @@ int main (int argc, char *argv[])
 	}
 
 	// Positional arguments
+	if (command == CmdExport && optind < argc)
+		argFilePath = argv[optind++];
+
 	if (optind < argc)
 	{
 		if (argVolumePath.empty ())
@@ -865,6 +1033,47 @@ int main (int argc, char *argv[])
 		return 0;
 	}
 
+	if (command == CmdCpuFeatures)
+	{
+		uint32 detected = cpu_detect_features ();
+		const CryptoDispatchTable *dispatch = crypto_dispatch ();
+
+		std::cout << ansiDim << "CPU features: " << ansiReset;
+		bool any = false;
+		for (uint32 feature = 1; feature != 0; feature <<= 1)
+		{
+			if (detected & feature)
+			{
+				std::cout << (any ? " " : "") << cpu_get_feature_name (feature);
+				any = true;
+			}
+		}
+		std::cout << (any ? "" : "none") << std::endl;
+
+		std::cout << ansiDim << "Tiers:        " << ansiReset;
+		any = false;
+		for (int tier = CPU_TIER_GENERIC; tier < CPU_TIER_COUNT; ++tier)
+		{
+			if (!cpu_is_tier_supported (tier))
+				continue;
+
+			std::cout << (any ? ", " : "");
+			if (tier == dispatch->Tier)
+				std::cout << ansiBold << cpu_get_tier_name (tier) << ansiReset << " (active)";
+			else
+				std::cout << cpu_get_tier_name (tier);
+			any = true;
+		}
+		std::cout << std::endl;
+
+		std::cout << ansiDim << "AES kernel:   " << ansiReset << dispatch->AesKernelName << std::endl;
+		std::cout << ansiDim << "AES-XTS:      " << ansiReset << dispatch->AesXtsKernelName << std::endl;
+		std::cout << ansiDim << "AES-CTR:      " << ansiReset << dispatch->AesCtrKernelName << std::endl;
+		std::cout << ansiDim << "SHA-1:        " << ansiReset << dispatch->Sha1KernelName << std::endl;
+		std::cout << ansiDim << "SHA-512:      " << ansiReset << dispatch->Sha512KernelName << std::endl;
+		return 0;
+	}
+
 	if (command == CmdTest)
 	{
 		try
@@ -877,6 +1086,10 @@ int main (int argc, char *argv[])
 			PlatformTest::TestAll ();
 			std::cerr << ansiGreen << "\xe2\x9c\x93 " << ansiReset << "Platform tests passed." << std::endl;
 
+			std::cerr << ansiDim << "Testing volume creation..." << ansiReset << std::endl;
+			CoreTest::TestAll ();
+			std::cerr << ansiGreen << "\xe2\x9c\x93 " << ansiReset << "Volume creation tests passed." << std::endl;
+
 			std::cerr << ansiGreen << ansiBold << "\xe2\x9c\x93 Self-test passed." << ansiReset << std::endl;
 		}
 		catch (exception &e)
@@ -1010,6 +1223,21 @@ int main (int argc, char *argv[])
 
 				}
 
+				if (mountOptions.RotateMasterKey && !nonInteractive)
+				{
+					std::cerr << ansiYellow << ansiBold << "WARNING: " << ansiReset << ansiYellow
+					           << "The volume is re-encrypted with a new master key in the background while it is mounted." << std::endl
+					           << "A hidden volume inside it will be destroyed. Back up the container first." << ansiReset << std::endl;
+					std::cerr << "Type \"yes\" to continue: ";
+					string confirm;
+					std::getline (std::cin, confirm);
+					if (confirm != "yes")
+					{
+						std::cerr << ansiYellow << "Aborted." << ansiReset << std::endl;
+						return 1;
+					}
+				}
+
 				if (!mountOptions.Password)
 					mountOptions.Password = cb.AskPassword ();
 
@@ -1048,6 +1276,14 @@ int main (int argc, char *argv[])
 						<< "Volume \"" << ansiBold << W (wstring (volume->Path)) << ansiReset << "\" mounted at "
 						<< ansiCyan << W (wstring (volume->MountPoint)) << ansiReset
 						<< ansiDim << " (slot " << volume->SlotNumber << ")" << ansiReset << std::endl;
+
+					if (volume->KeyRotationInProgress)
+					{
+						std::cout << ansiDim << "Key rotation is running in the background: "
+							<< FormatKeyRotationProgress (*volume) << ansiReset << std::endl;
+						std::cout << ansiDim << "  Check progress with --key-rotation=status "
+							<< W (wstring (volume->Path)) << ansiReset << std::endl;
+					}
 				}
 
 				// Offer KDF upgrade for legacy volumes (low iteration count)
@@ -1256,6 +1492,269 @@ int main (int argc, char *argv[])
 			}
 			break;
 
+		case CmdReEncrypt:
+			{
+				if (argVolumePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				if (FilesystemPath (StringConverter::ToWide (argVolumePath)).IsDevice ())
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "--reencrypt supports file containers only" << std::endl;
+					return 1;
+				}
+
+				// Encryption algorithm (default: AES)
+				string encName = argEncryption.empty () ? "AES" : argEncryption;
+				shared_ptr <Basalt::EncryptionAlgorithm> ea;
+				for (const auto &a : Basalt::EncryptionAlgorithm::GetAvailableAlgorithms ())
+				{
+					if (!a->IsDeprecated () && StringConverter::ToSingle (a->GetName ()) == encName)
+					{
+						ea = a;
+						break;
+					}
+				}
+				if (!ea)
+				{
+					std::cerr << ansiRed << "Unknown encryption algorithm: " << ansiReset << encName << std::endl;
+					return 1;
+				}
+
+				// Hash / KDF of the new header (default: Argon2id-Max)
+				string hashName = argHash.empty () ? "Argon2id-Max" : argHash;
+				shared_ptr <Basalt::Hash> hash;
+				for (const auto &h : Basalt::Hash::GetAvailableAlgorithms ())
+				{
+					if (!h->IsDeprecated () && StringConverter::ToSingle (h->GetName ()) == hashName)
+					{
+						hash = h;
+						break;
+					}
+				}
+				if (!hash)
+				{
+					std::cerr << ansiRed << "Unknown hash algorithm: " << ansiReset << hashName << std::endl;
+					return 1;
+				}
+
+				if (!nonInteractive)
+				{
+					std::cerr << ansiYellow << ansiBold << "WARNING: " << ansiReset << ansiYellow
+					           << "The volume is converted in place and cannot be mounted until the conversion completes." << std::endl
+					           << "A hidden volume inside it will be destroyed. Back up the container first." << ansiReset << std::endl;
+					std::cerr << "Type \"yes\" to continue: ";
+					string confirm;
+					std::getline (std::cin, confirm);
+					if (confirm != "yes")
+					{
+						std::cerr << ansiYellow << "Aborted." << ansiReset << std::endl;
+						return 1;
+					}
+				}
+
+				shared_ptr <VolumePassword> password = mountOptions.Password;
+				if (!password)
+					password = cb.AskPassword ();
+
+				cb.EnrichRandomPool (hash);
+				RandomNumberGenerator::SetHash (hash);
+
+				auto options = make_shared <VolumeReEncryptionOptions> ();
+				options->Path = VolumePath (StringConverter::ToWide (argVolumePath));
+				options->Password = password;
+				options->Keyfiles = mountOptions.Keyfiles;
+				options->VolumeHeaderKdf = Pkcs5Kdf::GetAlgorithm (*hash);
+				options->EA = ea;
+
+				VolumeReEncryptor reEncryptor;
+				reEncryptor.ReEncryptVolume (options);
+
+				VolumeReEncryptor::ProgressInfo progress = reEncryptor.GetProgressInfo ();
+				if (progress.Resumed)
+					std::cerr << ansiDim << "Resuming interrupted re-encryption..." << ansiReset << std::endl;
+
+				auto startTime = std::chrono::steady_clock::now ();
+				bool aborted = false;
+				while (true)
+				{
+					progress = reEncryptor.GetProgressInfo ();
+					if (!progress.ReEncryptionInProgress)
+						break;
+
+					auto elapsed = std::chrono::steady_clock::now () - startTime;
+					DrawProgressBar (progress.SizeDone, progress.TotalSize, std::chrono::duration <double> (elapsed).count ());
+
+					if (TerminationRequested && !aborted)
+					{
+						reEncryptor.Abort ();
+						aborted = true;
+					}
+
+#ifdef TC_WINDOWS
+					Sleep (200);
+#else
+					usleep (200000);  // 200ms
+#endif
+				}
+
+				std::cerr << "\r\033[K" << std::flush;
+
+				reEncryptor.CheckResult ();
+
+				if (aborted)
+				{
+					std::cerr << ansiYellow << "Paused." << ansiReset << " Run --reencrypt again to resume." << std::endl;
+					return 1;
+				}
+
+				std::cout << ansiGreen << "\xe2\x9c\x93 " << ansiReset << "Volume re-encrypted: "
+				           << ansiBold << argVolumePath << ansiReset << std::endl;
+			}
+			break;
+
+		case CmdGrow:
+			{
+				if (argVolumePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				// Devices grow to their current size, containers by the requested amount
+				uint64 sizeIncrease = 0;
+				if (!argSize.empty ())
+				{
+					if (argSize[0] != '+' || mountOptions.Path->IsDevice ())
+					{
+						std::cerr << ansiRed << "Error: " << ansiReset << "Use --size=+SIZE to enlarge a container; devices grow to their current size" << std::endl;
+						return 1;
+					}
+
+					try { sizeIncrease = ParseSize (argSize.substr (1)); }
+					catch (...)
+					{
+						std::cerr << ansiRed << "Error: " << ansiReset << "Invalid size: " << argSize << std::endl;
+						return 1;
+					}
+				}
+
+				if (Core->IsVolumeMounted (*mountOptions.Path))
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "The volume is mounted" << std::endl;
+					return 1;
+				}
+
+				shared_ptr <VolumePassword> password = mountOptions.Password;
+				if (!password)
+					password = cb.AskPassword ();
+
+				// Enrich RNG
+				cb.EnrichRandomPool ();
+
+				auto options = make_shared <VolumeExpansionOptions> ();
+				options->Path = *mountOptions.Path;
+				options->Password = password;
+				options->Keyfiles = mountOptions.Keyfiles;
+				options->SizeIncrease = sizeIncrease;
+				options->Quick = quickFormat;
+
+				VolumeExpander expander;
+				expander.ExpandVolume (options);
+
+				VolumeExpander::ProgressInfo progress = expander.GetProgressInfo ();
+				if (progress.Resumed)
+					std::cerr << ansiDim << "Resuming interrupted expansion..." << ansiReset << std::endl;
+
+				auto startTime = std::chrono::steady_clock::now ();
+				bool aborted = false;
+				while (true)
+				{
+					progress = expander.GetProgressInfo ();
+					if (!progress.ExpansionInProgress)
+						break;
+
+					auto elapsed = std::chrono::steady_clock::now () - startTime;
+					DrawProgressBar (progress.SizeDone, progress.TotalSize, std::chrono::duration <double> (elapsed).count ());
+
+					if (TerminationRequested && !aborted)
+					{
+						expander.Abort ();
+						aborted = true;
+					}
+
+#ifdef TC_WINDOWS
+					Sleep (200);
+#else
+					usleep (200000);  // 200ms
+#endif
+				}
+
+				std::cerr << "\r\033[K" << std::flush;
+
+				expander.CheckResult ();
+
+				if (aborted)
+				{
+					std::cerr << ansiYellow << "Paused." << ansiReset << " Run --grow again to resume." << std::endl;
+					return 1;
+				}
+
+				std::cout << ansiGreen << "\xe2\x9c\x93 " << ansiReset << "Volume expanded to "
+				           << W (FormatSize (expander.GetNewVolumeSize ())) << ": " << ansiBold << argVolumePath << ansiReset << std::endl;
+				std::cout << ansiDim << "  Resize the filesystem with the tools of the operating system." << ansiReset << std::endl;
+			}
+			break;
+
+		case CmdKeyRotation:
+			{
+				if (argVolumePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				shared_ptr <VolumeInfo> volume = Core->GetMountedVolume (VolumePath (StringConverter::ToWide (argVolumePath)));
+				if (!volume)
+				{
+					std::cerr << ansiRed << "Volume not mounted: " << ansiReset << argVolumePath << std::endl;
+					return 1;
+				}
+
+				if (!volume->KeyRotationInProgress)
+				{
+					std::cout << "Key rotation of " << ansiBold << argVolumePath << ansiReset << " is not in progress." << std::endl;
+					return argKeyRotation == "status" ? 0 : 1;
+				}
+
+				FilePath controlFilePath = VolumeKeyRotator::GetControlFilePath (volume->AuxMountPoint);
+				KeyRotationControl control;
+				try
+				{
+					control = VolumeKeyRotator::ReadControlFile (controlFilePath);
+				}
+				catch (...) { }
+
+				if (argKeyRotation == "pause")
+					control.Paused = true;
+				else if (argKeyRotation == "resume")
+					control.Paused = false;
+				else if (argKeyRotation.find ("rate=") == 0)
+				{
+					uint64 rate = StringConverter::ToUInt64 (argKeyRotation.substr (5));
+					control.MaxBytesPerSecond = rate * BYTES_PER_MB;
+				}
+				else if (argKeyRotation != "status")
+				{
+					std::cerr << ansiRed << "Unknown key rotation action: " << ansiReset << argKeyRotation << std::endl;
+					return 1;
+				}
+
+				if (argKeyRotation != "status")
+				{
+					VolumeKeyRotator::WriteControlFile (controlFilePath, control);
+					volume->KeyRotationPaused = control.Paused;
+				}
+
+				std::cout << "Key rotation: " << FormatKeyRotationProgress (*volume) << std::endl;
+				if (control.MaxBytesPerSecond != 0)
+					std::cout << ansiDim << "  Rate limit: " << W (FormatSize (control.MaxBytesPerSecond)) << "/s" << ansiReset << std::endl;
+			}
+			break;
+
 		case CmdCreate:
 			{
 				if (argVolumePath.empty ())
@@ -1392,6 +1891,46 @@ int main (int argc, char *argv[])
 					}
 				}
 
+				// Data fill
+				VolumeCreationOptions::FillType::Enum fill = VolumeCreationOptions::FillType::Encrypted;
+				if (argFill == "random")
+					fill = VolumeCreationOptions::FillType::Random;
+				else if (!argFill.empty () && argFill != "encrypted")
+				{
+					std::cerr << ansiRed << "Unknown fill mode: " << ansiReset << argFill << std::endl;
+					return 1;
+				}
+
+				// Sector size (devices use their own, hidden volumes the default)
+				uint32 sectorSize = 0;
+				if (!argSectorSize.empty ())
+				{
+					if (argSectorSize == "512")
+						sectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+					else if (argSectorSize == "4096")
+						sectorSize = TC_MAX_VOLUME_SECTOR_SIZE;
+					else
+					{
+						std::cerr << ansiRed << "Unsupported sector size: " << ansiReset << argSectorSize << std::endl;
+						std::cerr << ansiDim << "  Use 512 or 4096" << ansiReset << std::endl;
+						return 1;
+					}
+
+					if (sectorSize != TC_SECTOR_SIZE_FILE_HOSTED_VOLUME && (isDeviceCreate || hiddenVolume))
+					{
+						std::cerr << ansiRed << "Error: " << ansiReset << "--sector-size=4096 applies to new file containers only" << std::endl;
+						return 1;
+					}
+#ifdef TC_MACOSX
+					// HFS+ is formatted through a mount, and such volumes cannot be mounted (disk images have 512-byte sectors)
+					if (sectorSize != TC_SECTOR_SIZE_FILE_HOSTED_VOLUME && fsType == VolumeCreationOptions::FilesystemType::MacOsExt)
+					{
+						std::cerr << ansiRed << "Error: " << ansiReset << "--sector-size=4096 requires --filesystem=fat or none on macOS" << std::endl;
+						return 1;
+					}
+#endif
+				}
+
 				// For HFS+, use None during creation (format afterwards via newfs_hfs)
 				VolumeCreationOptions::FilesystemType::Enum creationFsType = fsType;
 #ifdef TC_MACOSX
@@ -1413,9 +1952,10 @@ int main (int argc, char *argv[])
 				options->VolumeHeaderKdf = kdf;
 				options->EA = ea;
 				options->Quick = quickFormat;
+				options->Fill = fill;
 				options->Filesystem = creationFsType;
 				options->FilesystemClusterSize = 0;  // auto
-				options->SectorSize = 0;
+				options->SectorSize = sectorSize;
 
 				if (verbose)
 				{
@@ -1429,7 +1969,11 @@ int main (int argc, char *argv[])
 					std::cout << "  Hash:       " << W (hash->GetName ()) << std::endl;
 					std::cout << "  Filesystem: " << (fsType == VolumeCreationOptions::FilesystemType::FAT ? "FAT" :
 						(fsType == VolumeCreationOptions::FilesystemType::MacOsExt ? "HFS+" : "None")) << std::endl;
+					if (sectorSize != 0)
+						std::cout << "  Sector:     " << sectorSize << " bytes" << std::endl;
 					std::cout << "  Quick:      " << (quickFormat ? "Yes" : "No") << std::endl;
+					if (!quickFormat)
+						std::cout << "  Fill:       " << (fill == VolumeCreationOptions::FillType::Random ? "Random" : "Encrypted") << std::endl;
 				}
 
 				// Auto-dismount device filesystems before creation
@@ -1474,7 +2018,7 @@ int main (int argc, char *argv[])
 					{
 						auto elapsed = std::chrono::steady_clock::now () - startTime;
 						double elapsedSec = std::chrono::duration <double> (elapsed).count ();
-						DrawProgressBar (progress.SizeDone, progress.TotalSize, elapsedSec);
+						DrawProgressBar (progress.SizeDone, progress.TotalSize, elapsedSec, progress.BytesPerSecond);
 					}
 
 					if (TerminationRequested)
@@ -1530,6 +2074,226 @@ int main (int argc, char *argv[])
 			}
 			break;
 
+		case CmdWipeFreeSpace:
+			{
+				if (argVolumePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				// Accept the volume path or the mount point of a mounted volume
+				shared_ptr <VolumeInfo> volume = Core->GetMountedVolume (VolumePath (StringConverter::ToWide (argVolumePath)));
+				if (!volume)
+				{
+					for (const auto &v : Core->GetMountedVolumes ())
+					{
+						if (!v->MountPoint.IsEmpty () && StringConverter::ToSingle (wstring (v->MountPoint)) == argVolumePath)
+							volume = v;
+					}
+				}
+
+				if (!volume)
+				{
+					std::cerr << ansiRed << "Volume not mounted: " << ansiReset << argVolumePath << std::endl;
+					return 1;
+				}
+
+				if (volume->MountPoint.IsEmpty () || volume->Protection == VolumeProtection::ReadOnly)
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "The filesystem of the volume must be mounted read-write" << std::endl;
+					return 1;
+				}
+
+				RandomNumberGenerator::Start ();
+
+				FreeSpaceWiper wiper;
+				wiper.WipeFreeSpace (volume->MountPoint);
+
+				FreeSpaceWiper::ProgressInfo progress;
+				auto startTime = std::chrono::steady_clock::now ();
+				while (true)
+				{
+					progress = wiper.GetProgressInfo ();
+					if (!progress.WipeInProgress)
+						break;
+
+					// The free space shrinks while other writers use the filesystem
+					if (progress.TotalSize > 0)
+					{
+						auto elapsed = std::chrono::steady_clock::now () - startTime;
+						DrawProgressBar (std::min (progress.SizeDone, progress.TotalSize), progress.TotalSize,
+							std::chrono::duration <double> (elapsed).count (), progress.BytesPerSecond);
+					}
+
+					if (TerminationRequested)
+						wiper.Abort ();
+
+#ifdef TC_WINDOWS
+					Sleep (200);
+#else
+					usleep (200000);  // 200ms
+#endif
+				}
+
+				std::cerr << "\r\033[K" << std::flush;
+
+				wiper.CheckResult ();
+
+				if (TerminationRequested)
+				{
+					std::cerr << ansiYellow << "Aborted." << ansiReset << std::endl;
+					return 1;
+				}
+
+				std::cout << ansiGreen << "\xe2\x9c\x93 " << ansiReset << "Free space wiped: "
+				           << W (FormatSize (progress.SizeDone)) << " on " << W (wstring (volume->MountPoint)) << std::endl;
+			}
+			break;
+
+		case CmdBenchmark:
+			{
+				if (argVolumePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				// Accept the volume path or the mount point of a mounted volume
+				shared_ptr <VolumeInfo> volume = Core->GetMountedVolume (VolumePath (StringConverter::ToWide (argVolumePath)));
+				if (!volume)
+				{
+					for (const auto &v : Core->GetMountedVolumes ())
+					{
+						if (!v->MountPoint.IsEmpty () && StringConverter::ToSingle (wstring (v->MountPoint)) == argVolumePath)
+							volume = v;
+					}
+				}
+
+				if (!volume)
+				{
+					std::cerr << ansiRed << "Volume not mounted: " << ansiReset << argVolumePath << std::endl;
+					return 1;
+				}
+
+				if (volume->MountPoint.IsEmpty () || volume->Protection == VolumeProtection::ReadOnly)
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "The filesystem of the volume must be mounted read-write" << std::endl;
+					return 1;
+				}
+
+				std::cerr << ansiDim << "Measuring read latency, idle and under write load..." << ansiReset << std::endl;
+
+				VolumeBenchmark benchmark (volume->MountPoint);
+				VolumeBenchmark::Result result = benchmark.Run ();
+
+				std::cout << ansiDim << "Reads, idle:       " << ansiReset << result.IdleReads.Count << " reads, latency p50 "
+				           << result.IdleReads.P50 << " us, p99 " << result.IdleReads.P99 << " us, max " << result.IdleReads.Max << " us" << std::endl;
+				std::cout << ansiDim << "Reads, write load: " << ansiReset << result.LoadedReads.Count << " reads, latency p50 "
+				           << result.LoadedReads.P50 << " us, p99 " << result.LoadedReads.P99 << " us, max " << result.LoadedReads.Max << " us" << std::endl;
+				std::cout << ansiDim << "Writes:            " << ansiReset << W (FormatSize (result.WriteBytesPerSecond)) << "/s" << std::endl;
+			}
+			break;
+
+		case CmdExport:
+		case CmdImport:
+			{
+				if (argVolumePath.empty () || argFilePath.empty ())
+					throw ParameterIncorrect (SRC_POS);
+
+				bool exportImage = (command == CmdExport);
+				FilePath imagePath (StringConverter::ToWide (argFilePath));
+
+				// A mounted volume changes while it is copied
+				if (Core->IsVolumeMounted (*mountOptions.Path) && (!exportImage || !force))
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "The volume is mounted"
+					           << (exportImage ? " (use --force to export it anyway)" : "") << std::endl;
+					return 1;
+				}
+
+				shared_ptr <VolumePassword> password = mountOptions.Password;
+				if (!password)
+				{
+					// The password prompt would consume the image
+					if (!exportImage && VolumeImageTransfer::IsStandardStream (imagePath))
+					{
+						std::cerr << ansiRed << "Error: " << ansiReset << "--import from standard input requires --password" << std::endl;
+						return 1;
+					}
+					password = cb.AskPassword ();
+				}
+
+				shared_ptr <Volume> volume = Core->OpenVolume (mountOptions.Path, mountOptions.PreserveTimestamps, password, mountOptions.Keyfiles,
+					exportImage ? VolumeProtection::ReadOnly : VolumeProtection::None, shared_ptr <VolumePassword> (), shared_ptr <KeyfileList> (),
+					force, VolumeType::Unknown, mountOptions.UseBackupHeaders);
+
+				VolumeImageTransfer transfer;
+				if (exportImage)
+					transfer.ExportVolume (volume, imagePath);
+				else
+					transfer.ImportVolume (imagePath, volume);
+
+				VolumeImageTransfer::ProgressInfo progress;
+				auto startTime = std::chrono::steady_clock::now ();
+				while (true)
+				{
+					progress = transfer.GetProgressInfo ();
+					if (!progress.TransferInProgress)
+						break;
+
+					auto elapsed = std::chrono::steady_clock::now () - startTime;
+					if (progress.TotalSize > 0)
+						DrawProgressBar (progress.SizeDone, progress.TotalSize, std::chrono::duration <double> (elapsed).count (), progress.BytesPerSecond);
+					else
+						std::cerr << "\r  " << ansiDim << W (FormatSize (progress.SizeDone)) << "  " << W (FormatSize (progress.BytesPerSecond)) << "/s" << ansiReset << "   " << std::flush;
+
+					if (TerminationRequested)
+						transfer.Abort ();
+
+#ifdef TC_WINDOWS
+					Sleep (200);
+#else
+					usleep (200000);  // 200ms
+#endif
+				}
+
+				std::cerr << "\r\033[K" << std::flush;
+
+				transfer.CheckResult ();
+				volume->Close ();
+
+				if (TerminationRequested)
+				{
+					std::cerr << ansiYellow << "Aborted." << ansiReset << std::endl;
+					return 1;
+				}
+
+				// Standard output carries the image
+				std::ostream &out = (exportImage && VolumeImageTransfer::IsStandardStream (imagePath)) ? std::cerr : std::cout;
+				out << ansiGreen << "\xe2\x9c\x93 " << ansiReset << (exportImage ? "Volume exported: " : "Volume imported: ")
+				    << W (FormatSize (progress.SizeDone)) << std::endl;
+			}
+			break;
+
+		case CmdChangedSince:
+			{
+				if (!mountOptions.Path || mountOptions.Path->IsDevice ())
+					throw ParameterIncorrect (SRC_POS);
+
+				FilePath trackerPath = VolumeChangeTracker::GetTrackerPath (FilePath (wstring (*mountOptions.Path)));
+				if (!trackerPath.IsFile ())
+				{
+					std::cerr << ansiRed << "Error: " << ansiReset << "Changes of the volume are not tracked (mount it with --mount-options=trackchanges)" << std::endl;
+					return 1;
+				}
+
+				// The map of a mounted volume is flagged as in use, but its completed generations are valid
+				VolumeChangedRangeList ranges;
+				uint32 token = VolumeChangeTracker::GetChanges (trackerPath, StringConverter::ToUInt32 (argChangedSince),
+					Core->IsVolumeMounted (*mountOptions.Path), ranges);
+
+				// Offsets refer to the container file, whose changed areas are copied as they are
+				std::cout << "token " << token << std::endl;
+				for (const auto &range : ranges)
+					std::cout << range.Offset << " " << range.Length << std::endl;
+			}
+			break;
+
 		default:
 			break;
 		}
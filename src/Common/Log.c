@@ -0,0 +1,389 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Log.h"
+
+#define LOG_RING_SIZE		512			/* Power of two */
+#define LOG_MESSAGE_SIZE	1024		/* Longer messages are truncated and end with "..." */
+#define LOG_WRITE_BUFFER_SIZE	(16 * 1024)
+#define LOG_WRITER_INTERVAL_MS	100
+
+/*
+ * Bounded multi-producer queue (D. Vyukov). A slot may be written when its
+ * sequence equals the enqueue position and read when it equals the position
+ * plus one.
+ */
+typedef struct
+{
+	atomic_size_t Sequence;
+	int Level;
+	time_t Time;
+	char Message[LOG_MESSAGE_SIZE];
+} log_record;
+
+static log_record Ring[LOG_RING_SIZE];
+static atomic_size_t EnqueuePosition;
+static size_t DequeuePosition;			/* Protected by WriterMutex */
+
+static atomic_int CurrentLevel = -1;
+static atomic_uint Sinks = BASALT_LOG_SINK_SYSLOG;
+static atomic_int FileDescriptor = -1;
+
+static atomic_llong RateWindow;
+static atomic_uint RateCount;
+static atomic_uint SuppressedCount;
+static atomic_uint DroppedCount;
+
+static pthread_once_t InitOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t WriterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t WriterCond = PTHREAD_COND_INITIALIZER;
+static atomic_int WriterRunning;
+
+static const char *const LevelNames[] = { "ERROR", "WARNING", "INFO", "DEBUG", "TRACE" };
+
+static void log_write_all (int fd, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write (fd, data, size);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+
+		data += n;
+		size -= (size_t) n;
+	}
+}
+
+/* Writes all queued records to the sinks; WriterMutex must be held */
+static void log_drain (void)
+{
+	char buffer[LOG_WRITE_BUFFER_SIZE];
+	size_t bufferSize = 0;
+	unsigned int sinks = atomic_load_explicit (&Sinks, memory_order_relaxed);
+	int fd = atomic_load_explicit (&FileDescriptor, memory_order_relaxed);
+	unsigned int dropped, suppressed;
+
+	while (1)
+	{
+		log_record *record = &Ring[DequeuePosition & (LOG_RING_SIZE - 1)];
+		char line[LOG_MESSAGE_SIZE + 64];
+		struct tm tm;
+		int lineSize;
+
+		if (atomic_load_explicit (&record->Sequence, memory_order_acquire) != DequeuePosition + 1)
+			break;
+
+		localtime_r (&record->Time, &tm);
+		lineSize = snprintf (line, sizeof (line), "%04d-%02d-%02d %02d:%02d:%02d %s %s\n",
+			tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+			LevelNames[record->Level], record->Message);
+
+		if (sinks & BASALT_LOG_SINK_SYSLOG)
+			syslog (record->Level == BASALT_LOG_ERROR ? LOG_ERR : record->Level == BASALT_LOG_WARNING ? LOG_WARNING : record->Level == BASALT_LOG_INFO ? LOG_INFO : LOG_DEBUG, "%s", record->Message);
+
+		atomic_store_explicit (&record->Sequence, DequeuePosition + LOG_RING_SIZE, memory_order_release);
+		++DequeuePosition;
+
+		if (lineSize < 0)
+			continue;
+		if ((size_t) lineSize >= sizeof (line))
+			lineSize = sizeof (line) - 1;
+
+		if (bufferSize + (size_t) lineSize > sizeof (buffer))
+		{
+			if ((sinks & BASALT_LOG_SINK_FILE) && fd != -1)
+				log_write_all (fd, buffer, bufferSize);
+			if (sinks & BASALT_LOG_SINK_STDERR)
+				log_write_all (STDERR_FILENO, buffer, bufferSize);
+			bufferSize = 0;
+		}
+
+		memcpy (buffer + bufferSize, line, (size_t) lineSize);
+		bufferSize += (size_t) lineSize;
+	}
+
+	dropped = atomic_exchange_explicit (&DroppedCount, 0, memory_order_relaxed);
+	suppressed = atomic_exchange_explicit (&SuppressedCount, 0, memory_order_relaxed);
+
+	if ((dropped || suppressed) && bufferSize + 128 <= sizeof (buffer))
+	{
+		int n = snprintf (buffer + bufferSize, sizeof (buffer) - bufferSize,
+			"log: %u messages suppressed by rate limit, %u dropped\n", suppressed, dropped);
+
+		if (n > 0)
+			bufferSize += (size_t) n;
+
+		if (sinks & BASALT_LOG_SINK_SYSLOG)
+			syslog (LOG_WARNING, "log: %u messages suppressed by rate limit, %u dropped", suppressed, dropped);
+	}
+
+	if (bufferSize > 0)
+	{
+		if ((sinks & BASALT_LOG_SINK_FILE) && fd != -1)
+			log_write_all (fd, buffer, bufferSize);
+		if (sinks & BASALT_LOG_SINK_STDERR)
+			log_write_all (STDERR_FILENO, buffer, bufferSize);
+	}
+}
+
+static void *log_writer_thread (void *arg)
+{
+	(void) arg;
+	pthread_mutex_lock (&WriterMutex);
+
+	while (1)
+	{
+		struct timeval now;
+		struct timespec timeout;
+
+		log_drain ();
+
+		gettimeofday (&now, NULL);
+		timeout.tv_sec = now.tv_sec;
+		timeout.tv_nsec = (long) now.tv_usec * 1000 + LOG_WRITER_INTERVAL_MS * 1000000L;
+		if (timeout.tv_nsec >= 1000000000L)
+		{
+			timeout.tv_sec += 1;
+			timeout.tv_nsec -= 1000000000L;
+		}
+
+		pthread_cond_timedwait (&WriterCond, &WriterMutex, &timeout);
+	}
+
+	return NULL;
+}
+
+static void log_start_writer (void)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	int expected = 0;
+
+	if (!atomic_compare_exchange_strong (&WriterRunning, &expected, 1))
+		return;
+
+	pthread_attr_init (&attr);
+	pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+	if (pthread_create (&thread, &attr, log_writer_thread, NULL) != 0)
+		atomic_store (&WriterRunning, 0);
+
+	pthread_attr_destroy (&attr);
+}
+
+/* The queue is emptied before fork() so that the child does not write the messages again */
+static void log_prepare_fork (void)
+{
+	pthread_mutex_lock (&WriterMutex);
+	log_drain ();
+}
+
+static void log_parent_fork (void)
+{
+	pthread_mutex_unlock (&WriterMutex);
+}
+
+static void log_child_fork (void)
+{
+	size_t position = atomic_load (&EnqueuePosition);
+
+	/* Slots claimed by threads that do not exist in the child are never completed */
+	for (; DequeuePosition != position; ++DequeuePosition)
+		atomic_store (&Ring[DequeuePosition & (LOG_RING_SIZE - 1)].Sequence, DequeuePosition + LOG_RING_SIZE);
+
+	/* The writer thread is started again on the next message */
+	pthread_mutex_unlock (&WriterMutex);
+	pthread_cond_init (&WriterCond, NULL);
+	atomic_store (&WriterRunning, 0);
+}
+
+static basalt_log_level log_parse_level (const char *name)
+{
+	static const char *const names[] = { "error", "warning", "info", "debug", "trace" };
+	int i;
+
+	for (i = 0; i < (int) (sizeof (names) / sizeof (names[0])); ++i)
+	{
+		if (strcasecmp (name, names[i]) == 0)
+			return (basalt_log_level) i;
+	}
+
+	if (name[0] >= '0' && name[0] <= '4' && name[1] == 0)
+		return (basalt_log_level) (name[0] - '0');
+
+	return BASALT_LOG_INFO;
+}
+
+static void log_init (void)
+{
+	const char *level = getenv ("BASALT_LOG_LEVEL");
+	int expected = -1;
+	size_t i;
+
+	for (i = 0; i < LOG_RING_SIZE; ++i)
+		atomic_init (&Ring[i].Sequence, i);
+
+	atomic_compare_exchange_strong (&CurrentLevel, &expected, (int) (level ? log_parse_level (level) : BASALT_LOG_INFO));
+
+	openlog ("truecrypt", LOG_PID, LOG_USER);
+	pthread_atfork (log_prepare_fork, log_parent_fork, log_child_fork);
+	atexit (basalt_log_flush);
+}
+
+int basalt_log_enabled (basalt_log_level level)
+{
+	int current = atomic_load_explicit (&CurrentLevel, memory_order_relaxed);
+	if (current < 0)
+	{
+		pthread_once (&InitOnce, log_init);
+		current = atomic_load_explicit (&CurrentLevel, memory_order_relaxed);
+	}
+
+	return (int) level <= current;
+}
+
+basalt_log_level basalt_log_get_level (void)
+{
+	pthread_once (&InitOnce, log_init);
+	return (basalt_log_level) atomic_load (&CurrentLevel);
+}
+
+void basalt_log_set_level (basalt_log_level level)
+{
+	pthread_once (&InitOnce, log_init);
+	atomic_store (&CurrentLevel, (int) level);
+}
+
+int basalt_log_open_file (const char *path)
+{
+	int fd = -1;
+	int previous;
+
+	pthread_once (&InitOnce, log_init);
+
+	if (path)
+	{
+		fd = open (path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (fd == -1)
+			return -1;
+	}
+
+	pthread_mutex_lock (&WriterMutex);
+	log_drain ();
+	previous = atomic_exchange (&FileDescriptor, fd);
+	pthread_mutex_unlock (&WriterMutex);
+
+	if (previous != -1)
+		close (previous);
+
+	return 0;
+}
+
+void basalt_log_set_sinks (unsigned int sinks)
+{
+	pthread_once (&InitOnce, log_init);
+
+	pthread_mutex_lock (&WriterMutex);
+	log_drain ();
+	atomic_store (&Sinks, sinks);
+	pthread_mutex_unlock (&WriterMutex);
+}
+
+void basalt_log_write_v (basalt_log_level level, const char *format, va_list args)
+{
+	size_t position;
+	log_record *record;
+
+	if (!basalt_log_enabled (level))
+		return;
+
+	if (level != BASALT_LOG_ERROR)
+	{
+		long long now = (long long) time (NULL);
+		long long window = atomic_load_explicit (&RateWindow, memory_order_relaxed);
+
+		if (window != now && atomic_compare_exchange_strong (&RateWindow, &window, now))
+			atomic_store_explicit (&RateCount, 0, memory_order_relaxed);
+
+		if (atomic_fetch_add_explicit (&RateCount, 1, memory_order_relaxed) >= BASALT_LOG_RATE_LIMIT)
+		{
+			atomic_fetch_add_explicit (&SuppressedCount, 1, memory_order_relaxed);
+			return;
+		}
+	}
+
+	position = atomic_load_explicit (&EnqueuePosition, memory_order_relaxed);
+	while (1)
+	{
+		size_t sequence;
+		record = &Ring[position & (LOG_RING_SIZE - 1)];
+		sequence = atomic_load_explicit (&record->Sequence, memory_order_acquire);
+
+		if (sequence == position)
+		{
+			if (atomic_compare_exchange_weak_explicit (&EnqueuePosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if ((ptrdiff_t) (sequence - position) < 0)
+		{
+			atomic_fetch_add_explicit (&DroppedCount, 1, memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			position = atomic_load_explicit (&EnqueuePosition, memory_order_relaxed);
+		}
+	}
+
+	record->Level = (int) level;
+	record->Time = time (NULL);
+	if (vsnprintf (record->Message, sizeof (record->Message), format, args) >= (int) sizeof (record->Message))
+		memcpy (record->Message + sizeof (record->Message) - 4, "...", 4);
+	atomic_store_explicit (&record->Sequence, position + 1, memory_order_release);
+
+	if (!atomic_load_explicit (&WriterRunning, memory_order_relaxed))
+		log_start_writer ();
+
+	if (level == BASALT_LOG_ERROR)
+		pthread_cond_signal (&WriterCond);
+}
+
+void basalt_log_write (basalt_log_level level, const char *format, ...)
+{
+	va_list args;
+	va_start (args, format);
+	basalt_log_write_v (level, format, args);
+	va_end (args);
+}
+
+void basalt_log_flush (void)
+{
+	pthread_once (&InitOnce, log_init);
+
+	pthread_mutex_lock (&WriterMutex);
+	log_drain ();
+	pthread_mutex_unlock (&WriterMutex);
+}
@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Common_Log
+#define TC_HEADER_Common_Log
+
+#include <stdarg.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/*
+ * Leveled log shared by the C (DarwinFUSE) and C++ (SystemLog) code.
+ *
+ * Messages are formatted by the caller into a fixed-size lock-free ring and
+ * written to the sinks by a background thread, so that logging on the I/O
+ * path costs no system call. Messages below the current level cost a single
+ * atomic load. The ring drops messages when it is full, and messages other
+ * than errors are rate limited; both are reported by the writer thread.
+ *
+ * The level is read from the BASALT_LOG_LEVEL environment variable (error,
+ * warning, info, debug or trace; info by default) on first use.
+ */
+
+typedef enum
+{
+	BASALT_LOG_ERROR = 0,
+	BASALT_LOG_WARNING,
+	BASALT_LOG_INFO,
+	BASALT_LOG_DEBUG,
+	BASALT_LOG_TRACE		/* Per-operation tracing */
+} basalt_log_level;
+
+/* Sinks; syslog is the only sink enabled by default */
+#define BASALT_LOG_SINK_SYSLOG	0x1
+#define BASALT_LOG_SINK_FILE	0x2
+#define BASALT_LOG_SINK_STDERR	0x4
+
+/* Messages other than errors accepted per second */
+#define BASALT_LOG_RATE_LIMIT	1000
+
+int basalt_log_enabled (basalt_log_level level);
+basalt_log_level basalt_log_get_level (void);
+void basalt_log_set_level (basalt_log_level level);
+
+/* Opens the file sink in append mode; a NULL path closes it */
+int basalt_log_open_file (const char *path);
+void basalt_log_set_sinks (unsigned int sinks);
+
+void basalt_log_write (basalt_log_level level, const char *format, ...)
+#if defined(__GNUC__)
+	__attribute__ ((format (printf, 2, 3)))
+#endif
+	;
+void basalt_log_write_v (basalt_log_level level, const char *format, va_list args);
+
+/* Writes all queued messages before returning; call before _exit() */
+void basalt_log_flush (void);
+
+#define basalt_log(level, ...) do { if (basalt_log_enabled (level)) basalt_log_write ((level), __VA_ARGS__); } while (0)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // TC_HEADER_Common_Log
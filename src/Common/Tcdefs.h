@@ -126,6 +126,10 @@ typedef union
 #ifdef _WIN32
 #include <windows.h>
 #define burn(mem,size) do { volatile char *burnm = (volatile char *)(mem); int burnc = size; RtlSecureZeroMemory (mem, size); while (burnc--) *burnm++ = 0; } while (0)
+#elif defined (TC_LINUX)
+/* glibc does not implement Annex K; explicit_bzero() is not optimized away either */
+#include <string.h>
+#define burn(mem,size) explicit_bzero((mem), (size))
 #else
 /* Use memset_s() - C11 Annex K, guaranteed not to be optimized away.
    Available on macOS 10.9+, and most C11-compliant platforms. */
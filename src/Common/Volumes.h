@@ -116,6 +116,8 @@ extern "C" {
 // Volume header flags
 #define TC_HEADER_FLAG_ENCRYPTED_SYSTEM			0x1
 #define TC_HEADER_FLAG_NONSYS_INPLACE_ENC		0x2		// The volume has been created using non-system in-place encryption
+#define TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS	0x4		// In-place re-encryption of the volume has not been completed
+#define TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS	0x8		// Rotation of the master key of the volume has not been completed
 
 
 #ifndef TC_HEADER_Volume_VolumeHeader
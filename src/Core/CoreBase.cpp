@@ -9,7 +9,9 @@
 #include <set>
 
 #include "CoreBase.h"
+#include "RandomBitGenerator.h"
 #include "RandomNumberGenerator.h"
+#include "Crypto/CryptoDispatch.h"
 #include "Volume/Volume.h"
 
 namespace Basalt
@@ -17,12 +19,38 @@ namespace Basalt
 	CoreBase::CoreBase ()
 		: DeviceChangeInProgress (false)
 	{
+		// Select the crypto kernels before any worker threads are started
+		crypto_dispatch();
 	}
 
 	CoreBase::~CoreBase ()
 	{
 	}
 
+	void CoreBase::BeginKeyRotation (shared_ptr <Volume> openVolume, shared_ptr <VolumePassword> password, shared_ptr <KeyfileList> keyfiles) const
+	{
+		shared_ptr <Pkcs5Kdf> pkcs5Kdf = openVolume->GetPkcs5Kdf();
+		RandomNumberGenerator::SetHash (pkcs5Kdf->GetHash());
+
+		shared_ptr <VolumePassword> passwordKey (Keyfile::ApplyListToPassword (keyfiles, password));
+
+		SecureBuffer newDataKey (openVolume->GetEncryptionAlgorithm()->GetKeySize() * 2);
+		RandomNumberGenerator::GetData (newDataKey);
+
+		// The volume header and the header with the new key (at the backup header location) use different salts
+		SecureBuffer headerSalt (openVolume->GetSaltSize());
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+		RandomNumberGenerator::GetData (headerSalt);
+		pkcs5Kdf->DeriveKey (headerKey, *passwordKey, headerSalt);
+
+		SecureBuffer rotationHeaderSalt (openVolume->GetSaltSize());
+		SecureBuffer rotationHeaderKey (VolumeHeader::GetLargestSerializedKeySize());
+		RandomNumberGenerator::GetData (rotationHeaderSalt);
+		pkcs5Kdf->DeriveKey (rotationHeaderKey, *passwordKey, rotationHeaderSalt);
+
+		openVolume->BeginKeyRotation (newDataKey, headerSalt, headerKey, rotationHeaderSalt, rotationHeaderKey);
+	}
+
 	void CoreBase::ChangePassword (shared_ptr <Volume> openVolume, shared_ptr <VolumePassword> newPassword, shared_ptr <KeyfileList> newKeyfiles, shared_ptr <Pkcs5Kdf> newPkcs5Kdf, int wipePassCount) const
 	{
 		if ((!newPassword || newPassword->Size() < 1) && (!newKeyfiles || newKeyfiles->empty()))
@@ -50,6 +78,11 @@ namespace Basalt
 
 		shared_ptr <VolumePassword> password (Keyfile::ApplyListToPassword (newKeyfiles, newPassword));
 
+		// Salts of the overwritten intermediate headers are not key material and come from the bulk generator
+		unique_ptr <RandomBitGenerator> wipeSaltGenerator;
+		if (actualWipePassCount > 1)
+			wipeSaltGenerator.reset (new RandomBitGenerator);
+
 		bool backupHeader = false;
 		while (true)
 		{
@@ -58,7 +91,7 @@ namespace Basalt
 				if (i == actualWipePassCount)
 					RandomNumberGenerator::GetData (newSalt);
 				else
-					RandomNumberGenerator::GetDataFast (newSalt);
+					wipeSaltGenerator->GetData (newSalt);
 
 				newPkcs5Kdf->DeriveKey (newHeaderKey, *password, newSalt);
 
@@ -38,6 +38,7 @@ namespace Basalt
 	TC_EXCEPTION (MountPointRequired); \
 	TC_EXCEPTION (MountPointUnavailable); \
 	TC_EXCEPTION (NoDriveLetterAvailable); \
+	TC_EXCEPTION (ReEncryptionNotRequired); \
 	TC_EXCEPTION (TemporaryDirectoryFailure); \
 	TC_EXCEPTION (UnsupportedSectorSizeHiddenVolumeProtection); \
 	TC_EXCEPTION (UnsupportedSectorSizeNoKernelCrypto); \
@@ -22,6 +22,14 @@
 // Mount/create options
 #include "Core/MountOptions.h"
 #include "Core/VolumeCreator.h"
+#include "Core/VolumeExpander.h"
+#include "Core/FreeSpaceWiper.h"
+#include "Core/VolumeBenchmark.h"
+#include "Core/VolumeImageTransfer.h"
+#include "Core/VolumeKeyRotator.h"
+#include "Core/VolumeReEncryptor.h"
+#include "Core/ParallelRandomBitGenerator.h"
+#include "Core/RandomBitGenerator.h"
 #include "Core/RandomNumberGenerator.h"
 
 // Volume information and types
@@ -0,0 +1,243 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "Volume/Volume.h"
+#include "CoreTest.h"
+#include "FatFormatter.h"
+#include "RandomBitGenerator.h"
+#include "RandomNumberGenerator.h"
+#include "VolumeCreator.h"
+
+namespace Basalt
+{
+	// Checks the boot sector and the start of the first FAT; sectors must hold the first sectors of the filesystem
+	static void CheckFatFilesystem (const ConstBufferPtr &sectors, uint32 sectorSize, uint64 filesystemSize)
+	{
+		const byte *boot = sectors.Get();
+
+		if (boot[510] != 0x55 || boot[511] != 0xaa)
+			throw TestFailed (SRC_POS);
+
+		uint32 bytesPerSector = boot[11] | (boot[12] << 8);
+		uint32 reservedSectors = boot[14] | (boot[15] << 8);
+		uint64 totalSectors = boot[19] | (boot[20] << 8);
+
+		if (totalSectors == 0)
+			totalSectors = boot[32] | (boot[33] << 8) | (boot[34] << 16) | ((uint32) boot[35] << 24);
+
+		if (bytesPerSector != sectorSize || boot[16] != 2 || totalSectors != filesystemSize / sectorSize)
+			throw TestFailed (SRC_POS);
+
+		// The first FAT starts with the media descriptor
+		uint64 fatOffset = (uint64) reservedSectors * sectorSize;
+		if (fatOffset + 2 > sectors.Size() || sectors[fatOffset] != 0xf8 || sectors[fatOffset + 1] != 0xff)
+			throw TestFailed (SRC_POS);
+	}
+
+	void CoreTest::TestAll ()
+	{
+		TestRandomBitGenerator();
+
+		bool rngRunning = RandomNumberGenerator::IsRunning();
+		if (!rngRunning)
+			RandomNumberGenerator::Start();
+
+		finally_do_arg (bool, rngRunning, { if (!finally_arg) RandomNumberGenerator::Stop(); });
+
+		TestFatFormatter (TC_SECTOR_SIZE_FILE_HOSTED_VOLUME);
+		TestFatFormatter (TC_MAX_VOLUME_SECTOR_SIZE);
+		TestLargeSectorVolume();
+	}
+
+	void CoreTest::TestFatFormatter (uint32 sectorSize)
+	{
+		struct WriteSectorCallback : public FatFormatter::WriteSectorCallback
+		{
+			WriteSectorCallback (uint32 sectorSize) : Data (64 * 1024), DataSize (0), SectorSize (sectorSize), SizeMismatch (false) { }
+
+			virtual bool operator() (const BufferPtr &sector)
+			{
+				if (sector.Size() != SectorSize)
+					SizeMismatch = true;
+
+				// Only the start of the filesystem is checked
+				if (DataSize + sector.Size() <= Data.Size())
+					Data.GetRange (DataSize, sector.Size()).CopyFrom (sector);
+
+				DataSize += sector.Size();
+				return true;
+			}
+
+			Buffer Data;
+			uint64 DataSize;
+			uint32 SectorSize;
+			bool SizeMismatch;
+		};
+
+		// FAT16 with 512-byte sectors, FAT12 with 4096-byte sectors
+		const uint64 filesystemSize = 16 * BYTES_PER_MB;
+
+		WriteSectorCallback writeSector (sectorSize);
+		FatFormatter::Format (writeSector, filesystemSize, 0, sectorSize);
+
+		if (writeSector.SizeMismatch || writeSector.DataSize % sectorSize != 0 || writeSector.DataSize > filesystemSize)
+			throw TestFailed (SRC_POS);
+
+		CheckFatFilesystem (writeSector.Data.GetRange (0, (size_t) min (writeSector.DataSize, (uint64) writeSector.Data.Size())), sectorSize, filesystemSize);
+	}
+
+	void CoreTest::TestLargeSectorVolume ()
+	{
+		const char *tempDir = getenv ("TMPDIR");
+		string path = string (tempDir && *tempDir ? tempDir : "/tmp") + "/basalt-test-XXXXXX";
+
+		int fd = mkstemp (&path[0]);
+		if (fd == -1)
+			throw SystemException (SRC_POS);
+
+		close (fd);
+		finally_do_arg (string, path, { unlink (finally_arg.c_str()); });
+
+		const uint32 sectorSize = TC_MAX_VOLUME_SECTOR_SIZE;
+		shared_ptr <VolumePassword> password (new VolumePassword ("core test", 9));
+
+		// The container size is not a multiple of the sector size
+		shared_ptr <VolumeCreationOptions> options (new VolumeCreationOptions);
+		options->Path = VolumePath (StringConverter::ToWide (path));
+		options->Type = VolumeType::Normal;
+		options->Size = 16 * BYTES_PER_MB + 1536;
+		options->Password = password;
+		options->VolumeHeaderKdf.reset (new Pkcs5HmacSha512_Legacy);	// Few iterations keep the test fast
+		options->EA.reset (new AES);
+		options->Quick = true;
+		options->Fill = VolumeCreationOptions::FillType::Encrypted;
+		options->Filesystem = VolumeCreationOptions::FilesystemType::FAT;
+		options->FilesystemClusterSize = 0;
+		options->SectorSize = sectorSize;
+
+		VolumeCreator creator;
+		creator.CreateVolume (options);
+
+		while (creator.GetProgressInfo().CreationInProgress)
+			Thread::Sleep (10);
+
+		creator.CheckResult();
+
+		for (int header = 0; header < 2; ++header)
+		{
+			bool useBackupHeader = (header == 1);
+
+			Volume volume;
+			volume.Open (options->Path, false, password, shared_ptr <KeyfileList>(), VolumeProtection::None,
+				shared_ptr <VolumePassword>(), shared_ptr <KeyfileList>(), false, VolumeType::Unknown, useBackupHeader);
+
+			if (volume.GetSectorSize() != sectorSize || volume.GetSize() % sectorSize != 0 || volume.GetSize() > options->Size)
+				throw TestFailed (SRC_POS);
+
+			// Filesystem written by the formatter
+			SecureBuffer start (16 * sectorSize);
+			volume.ReadSectors (start, 0);
+			CheckFatFilesystem (start, sectorSize, volume.GetSize());
+
+			// Round trip of the last sectors, written through the primary header and read through both
+			SecureBuffer data (sectorSize * 3);
+			for (size_t i = 0; i < data.Size(); ++i)
+				data[i] = (byte) (i * 7 + 1);
+
+			uint64 lastSectors = volume.GetSize() - data.Size();
+
+			if (!useBackupHeader)
+				volume.WriteSectors (data, lastSectors);
+
+			SecureBuffer readBack (data.Size());
+			volume.ReadSectors (readBack, lastSectors);
+
+			if (memcmp (data.Ptr(), readBack.Ptr(), data.Size()) != 0)
+				throw TestFailed (SRC_POS);
+
+			// Requests must consist of whole sectors
+			bool misalignedRejected = false;
+			try
+			{
+				volume.ReadSectors (readBack.GetRange (0, sectorSize), ENCRYPTION_DATA_UNIT_SIZE);
+			}
+			catch (ParameterIncorrect&)
+			{
+				misalignedRejected = true;
+			}
+
+			if (!misalignedRejected)
+				throw TestFailed (SRC_POS);
+
+			volume.Close();
+		}
+	}
+
+	void CoreTest::TestRandomBitGenerator ()
+	{
+		// NIST CAVP CTR_DRBG, AES-256 no df, no prediction resistance, COUNT = 0 without and with reseeding
+		struct
+		{
+			const char *EntropyInput;
+			const char *EntropyInputReseed;
+			const char *ReturnedBits;
+		} static const vectors[] =
+		{
+			{
+				"\xdf\x5d\x73\xfa\xa4\x68\x64\x9e\xdd\xa3\x3b\x5c\xca\x79\xb0\xb0\x56\x00\x41\x9c\xcb\x7a\x87\x9d\xdf\xec\x9d\xb3\x2e\xe4\x94\xe5"
+				"\x53\x1b\x51\xde\x16\xa3\x0f\x76\x92\x62\x47\x4c\x73\xbe\xc0\x10",
+				nullptr,
+				"\xd1\xc0\x7c\xd9\x5a\xf8\xa7\xf1\x10\x12\xc8\x4c\xe4\x8b\xb8\xcb\x87\x18\x9e\x99\xd4\x0f\xcc\xb1\x77\x1c\x61\x9b\xdf\x82\xab\x22"
+				"\x80\xb1\xdc\x2f\x25\x81\xf3\x91\x64\xf7\xac\x0c\x51\x04\x94\xb3\xa4\x3c\x41\xb7\xdb\x17\x51\x4c\x87\xb1\x07\xae\x79\x3e\x01\xc5"
+			},
+			{
+				"\xe4\xbc\x23\xc5\x08\x9a\x19\xd8\x6f\x41\x19\xcb\x3f\xa0\x8c\x0a\x49\x91\xe0\xa1\xde\xf1\x7e\x10\x1e\x4c\x14\xd9\xc3\x23\x46\x0a"
+				"\x7c\x2f\xb5\x8e\x0b\x08\x6c\x6c\x57\xb5\x5f\x56\xca\xe2\x5b\xad",
+				"\xfd\x85\xa8\x36\xbb\xa8\x50\x19\x88\x1e\x8c\x6b\xad\x23\xc9\x06\x1a\xdc\x75\x47\x76\x59\xac\xae\xa8\xe4\xa0\x1d\xfe\x07\xa1\x83"
+				"\x2d\xad\x1c\x13\x6f\x59\xd7\x0f\x86\x53\xa5\xdc\x11\x86\x63\xd6",
+				"\xb2\xcb\x89\x05\xc0\x5e\x59\x50\xca\x31\x89\x50\x96\xbe\x29\xea\x3d\x5a\x3b\x82\xb2\x69\x49\x55\x54\xeb\x80\xfe\x07\xde\x43\xe1"
+				"\x93\xb9\xe7\xc3\xec\xe7\x3b\x80\xe0\x62\xb1\xc1\xf6\x82\x02\xfb\xb1\xc5\x2a\x04\x0e\xa2\x47\x88\x64\x29\x52\x82\x23\x4a\xaa\xda"
+			}
+		};
+
+		for (size_t i = 0; i < array_capacity (vectors); ++i)
+		{
+			RandomBitGenerator generator (ConstBufferPtr ((const byte *) vectors[i].EntropyInput, RandomBitGenerator::SeedSize));
+
+			if (vectors[i].EntropyInputReseed)
+				generator.Reseed (ConstBufferPtr ((const byte *) vectors[i].EntropyInputReseed, RandomBitGenerator::SeedSize));
+
+			// Each call is one generate request of 512 bits; the second one is returned by the test
+			SecureBuffer returnedBits (64);
+			generator.GetData (returnedBits);
+			generator.GetData (returnedBits);
+
+			if (memcmp (returnedBits.Ptr(), vectors[i].ReturnedBits, returnedBits.Size()) != 0)
+				throw TestFailed (SRC_POS);
+		}
+
+		// A request that ends within a block returns the start of that block
+		ConstBufferPtr entropyInput ((const byte *) vectors[0].EntropyInput, RandomBitGenerator::SeedSize);
+		RandomBitGenerator wholeBlocks (entropyInput);
+		RandomBitGenerator partialBlock (entropyInput);
+
+		SecureBuffer wholeData (48);
+		SecureBuffer partialData (37);
+
+		for (int request = 0; request < 2; ++request)
+		{
+			wholeBlocks.GetData (wholeData);
+			partialBlock.GetData (partialData);
+
+			if (memcmp (wholeData.Ptr(), partialData.Ptr(), partialData.Size()) != 0)
+				throw TestFailed (SRC_POS);
+		}
+	}
+}
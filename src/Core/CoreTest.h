@@ -0,0 +1,34 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_CoreTest
+#define TC_HEADER_Core_CoreTest
+
+#include "Platform/Platform.h"
+
+namespace Basalt
+{
+	class CoreTest
+	{
+	public:
+		static void TestAll ();
+
+	protected:
+		static void TestFatFormatter (uint32 sectorSize);
+		static void TestLargeSectorVolume ();
+		static void TestRandomBitGenerator ();
+
+	private:
+		CoreTest ();
+		virtual ~CoreTest ();
+		CoreTest (const CoreTest &);
+		CoreTest &operator= (const CoreTest &);
+	};
+}
+
+#endif // TC_HEADER_Core_CoreTest
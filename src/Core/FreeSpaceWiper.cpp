@@ -0,0 +1,239 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#include <errno.h>
+#include <sys/statvfs.h>
+#endif
+
+#include "Platform/Time.h"
+#include "FreeSpaceWiper.h"
+#include "ParallelRandomBitGenerator.h"
+
+namespace Basalt
+{
+	FreeSpaceWiper::FreeSpaceWiper ()
+		: AbortRequested (false), SizeDone (0), StartTime (0), WipeThreadStarted (false)
+	{
+		mProgressInfo.WipeInProgress = false;
+		mProgressInfo.TotalSize = 0;
+		mProgressInfo.SizeDone = 0;
+		mProgressInfo.BytesPerSecond = 0;
+	}
+
+	FreeSpaceWiper::~FreeSpaceWiper ()
+	{
+		if (WipeThreadStarted)
+		{
+			AbortRequested = true;
+			WipeThreadHandle.Join();
+		}
+	}
+
+	void FreeSpaceWiper::Abort ()
+	{
+		AbortRequested = true;
+	}
+
+	void FreeSpaceWiper::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	uint64 FreeSpaceWiper::GetFreeSpace (const DirectoryPath &path)
+	{
+#ifdef TC_UNIX
+		struct statvfs fsInfo;
+		throw_sys_sub_if (statvfs (string (path).c_str(), &fsInfo) == -1, wstring (path));
+
+		return (uint64) fsInfo.f_bavail * fsInfo.f_frsize;
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
+	FreeSpaceWiper::ProgressInfo FreeSpaceWiper::GetProgressInfo ()
+	{
+		mProgressInfo.SizeDone = SizeDone.Get();
+
+		// Time is measured in units of 100 ns
+		uint64 elapsed = Time::GetCurrent() - StartTime;
+		if (mProgressInfo.WipeInProgress && elapsed > 0)
+			mProgressInfo.BytesPerSecond = (uint64) (mProgressInfo.SizeDone * 10000000.0 / elapsed);
+
+		return mProgressInfo;
+	}
+
+	FilePath FreeSpaceWiper::GetWipeFilePath (size_t fileNumber) const
+	{
+		wstringstream name;
+		name << wstring (MountPoint) << L"/.basalt-wipe-" << fileNumber << L".tmp";
+		return FilePath (name.str());
+	}
+
+	bool FreeSpaceWiper::IsFilesystemFull (const SystemException &e)
+	{
+#ifdef TC_UNIX
+		return e.GetErrorCode() == ENOSPC || e.GetErrorCode() == EDQUOT;
+#else
+		return false;
+#endif
+	}
+
+	void FreeSpaceWiper::WipeFreeSpace (const DirectoryPath &mountPoint)
+	{
+		if (WipeThreadStarted)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (!mountPoint.IsDirectory())
+			throw ParameterIncorrect (SRC_POS);
+
+		MountPoint = mountPoint;
+		AbortRequested = false;
+		SizeDone.Set (0);
+
+		mProgressInfo.WipeInProgress = true;
+		mProgressInfo.TotalSize = GetFreeSpace (mountPoint);
+		mProgressInfo.BytesPerSecond = 0;
+		StartTime = Time::GetCurrent();
+
+		struct ThreadFunctor : public Functor
+		{
+			ThreadFunctor (FreeSpaceWiper *wiper) : Wiper (wiper) { }
+			virtual void operator() ()
+			{
+				Wiper->WipeThread ();
+			}
+			FreeSpaceWiper *Wiper;
+		};
+
+		try
+		{
+			WipeThreadHandle.Start (new ThreadFunctor (this));
+			WipeThreadStarted = true;
+		}
+		catch (...)
+		{
+			mProgressInfo.WipeInProgress = false;
+			throw;
+		}
+	}
+
+	void FreeSpaceWiper::WipeThread ()
+	{
+		size_t fileCount = 0;
+
+		try
+		{
+			// Each buffer is filled by the generator threads while the other one is written
+			SecureBuffer buffers[2];
+			buffers[0].Allocate (BufferSize);
+			buffers[1].Allocate (BufferSize);
+
+			ParallelRandomBitGenerator generator;
+			generator.BeginGetData (buffers[0]);
+
+			File file;
+			file.Open (GetWipeFilePath (fileCount++), File::CreateWrite);
+			uint64 fileOffset = 0;
+
+			size_t writeSize = BufferSize;
+			bool filesystemFull = false;
+
+			for (size_t current = 0; !AbortRequested && !filesystemFull; current ^= 1)
+			{
+				generator.WaitForData();
+				generator.BeginGetData (buffers[current ^ 1]);
+
+				for (size_t written = 0; written < BufferSize && !filesystemFull && !AbortRequested; )
+				{
+					size_t length = BufferSize - written < writeSize ? BufferSize - written : writeSize;
+
+					try
+					{
+						file.WriteAt (buffers[current].GetRange (written, length), fileOffset);
+					}
+					catch (SystemException &e)
+					{
+						// A short write fails with a stale error code. The data that has been written is kept, and
+						// writing continues at the end of the file, where the cause is reported by the next write.
+						uint64 fileLength = file.Length();
+						if (fileLength > fileOffset && fileLength < fileOffset + length)
+						{
+							size_t partialLength = (size_t) (fileLength - fileOffset);
+
+							fileOffset += partialLength;
+							written += partialLength;
+							SizeDone.Set (SizeDone.Get() + partialLength);
+							continue;
+						}
+
+						bool sizeLimit = false;
+#ifdef TC_UNIX
+						sizeLimit = e.GetErrorCode() == EFBIG;
+#endif
+						// File size limit of the filesystem (FAT)
+						if (fileOffset > 0 && (sizeLimit || (length <= MinWriteSize && !IsFilesystemFull (e))))
+						{
+							file.Flush();
+							file.Close();
+							file.Open (GetWipeFilePath (fileCount++), File::CreateWrite);
+							fileOffset = 0;
+							writeSize = BufferSize;
+							continue;
+						}
+
+						// The remaining free space is filled in smaller writes
+						if (length > MinWriteSize)
+						{
+							writeSize = length / 2;
+							continue;
+						}
+
+						if (fileOffset == 0 && !IsFilesystemFull (e))
+							throw;
+
+						filesystemFull = true;
+						break;
+					}
+
+					fileOffset += length;
+					written += length;
+					SizeDone.Set (SizeDone.Get() + length);
+				}
+			}
+
+			generator.WaitForData();
+			file.Flush();
+		}
+		catch (Exception &e)
+		{
+			ThreadException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			ThreadException.reset (new UnknownException (SRC_POS));
+		}
+
+		for (size_t i = 0; i < fileCount; ++i)
+		{
+			try
+			{
+				GetWipeFilePath (i).Delete();
+			}
+			catch (...) { }
+		}
+
+		mProgressInfo.WipeInProgress = false;
+	}
+}
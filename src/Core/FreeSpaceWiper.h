@@ -0,0 +1,66 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_FreeSpaceWiper
+#define TC_HEADER_Core_FreeSpaceWiper
+
+#include "Platform/Platform.h"
+#include "Platform/SharedVal.h"
+
+namespace Basalt
+{
+	/*
+	 * Overwrites the free space of a mounted filesystem with random data.
+	 * Temporary files are filled with the output of the parallel random bit
+	 * generator until the filesystem is full, flushed and deleted again. A
+	 * new file is started when the filesystem limits the file size (FAT).
+	 */
+	class FreeSpaceWiper
+	{
+	public:
+		struct ProgressInfo
+		{
+			bool WipeInProgress;
+			uint64 TotalSize;		// Free space when the wipe was started
+			uint64 SizeDone;
+			uint64 BytesPerSecond;
+		};
+
+		FreeSpaceWiper ();
+		virtual ~FreeSpaceWiper ();
+
+		void Abort ();
+		void CheckResult ();
+		ProgressInfo GetProgressInfo ();
+		static uint64 GetFreeSpace (const DirectoryPath &path);
+		void WipeFreeSpace (const DirectoryPath &mountPoint);
+
+		static const size_t BufferSize = 8 * 1024 * 1024;
+		static const size_t MinWriteSize = 4096;
+
+	protected:
+		FilePath GetWipeFilePath (size_t fileNumber) const;
+		static bool IsFilesystemFull (const SystemException &e);
+		void WipeThread ();
+
+		volatile bool AbortRequested;
+		DirectoryPath MountPoint;
+		SharedVal <uint64> SizeDone;
+		uint64 StartTime;
+		shared_ptr <Exception> ThreadException;
+		Thread WipeThreadHandle;
+		bool WipeThreadStarted;
+		ProgressInfo mProgressInfo;
+
+	private:
+		FreeSpaceWiper (const FreeSpaceWiper &);
+		FreeSpaceWiper &operator= (const FreeSpaceWiper &);
+	};
+}
+
+#endif // TC_HEADER_Core_FreeSpaceWiper
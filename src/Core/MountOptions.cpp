@@ -17,6 +17,7 @@ namespace Basalt
 #define TC_CLONE(NAME) NAME = other.NAME
 #define TC_CLONE_SHARED(TYPE,NAME) NAME = other.NAME ? make_shared <TYPE> (*other.NAME) : shared_ptr <TYPE> ()
 
+		TC_CLONE (AllowDiscard);
 		TC_CLONE (FilesystemOptions);
 		TC_CLONE (FilesystemType);
 		TC_CLONE_SHARED (KeyfileList, Keyfiles);
@@ -31,9 +32,14 @@ namespace Basalt
 		TC_CLONE (Protection);
 		TC_CLONE_SHARED (VolumePassword, ProtectionPassword);
 		TC_CLONE_SHARED (KeyfileList, ProtectionKeyfiles);
+		TC_CLONE (QueueDepth);
 		TC_CLONE (Removable);
+		TC_CLONE (RotateMasterKey);
 		TC_CLONE (SharedAccessAllowed);
 		TC_CLONE (SlotNumber);
+		TC_CLONE (SyncMaxDelay);
+		TC_CLONE (SyncPolicy);
+		TC_CLONE (TrackChanges);
 		TC_CLONE (UseBackupHeaders);
 	}
 
@@ -41,6 +47,7 @@ namespace Basalt
 	{
 		Serializer sr (stream);
 
+		sr.Deserialize ("AllowDiscard", AllowDiscard);
 		sr.Deserialize ("FilesystemOptions", FilesystemOptions);
 		sr.Deserialize ("FilesystemType", FilesystemType);
 
@@ -76,9 +83,14 @@ namespace Basalt
 			ProtectionPassword.reset();
 
 		ProtectionKeyfiles = Keyfile::DeserializeList (stream, "ProtectionKeyfiles");
+		sr.Deserialize ("QueueDepth", QueueDepth);
 		sr.Deserialize ("Removable", Removable);
+		sr.Deserialize ("RotateMasterKey", RotateMasterKey);
 		sr.Deserialize ("SharedAccessAllowed", SharedAccessAllowed);
 		sr.Deserialize ("SlotNumber", SlotNumber);
+		sr.Deserialize ("SyncMaxDelay", SyncMaxDelay);
+		SyncPolicy = static_cast <VolumeSyncPolicy::Enum> (sr.DeserializeInt32 ("SyncPolicy"));
+		sr.Deserialize ("TrackChanges", TrackChanges);
 		sr.Deserialize ("UseBackupHeaders", UseBackupHeaders);
 	}
 
@@ -87,6 +99,7 @@ namespace Basalt
 		Serializable::Serialize (stream);
 		Serializer sr (stream);
 
+		sr.Serialize ("AllowDiscard", AllowDiscard);
 		sr.Serialize ("FilesystemOptions", FilesystemOptions);
 		sr.Serialize ("FilesystemType", FilesystemType);
 		Keyfile::SerializeList (stream, "Keyfiles", Keyfiles);
@@ -116,9 +129,14 @@ namespace Basalt
 			ProtectionPassword->Serialize (stream);
 
 		Keyfile::SerializeList (stream, "ProtectionKeyfiles", ProtectionKeyfiles);
+		sr.Serialize ("QueueDepth", QueueDepth);
 		sr.Serialize ("Removable", Removable);
+		sr.Serialize ("RotateMasterKey", RotateMasterKey);
 		sr.Serialize ("SharedAccessAllowed", SharedAccessAllowed);
 		sr.Serialize ("SlotNumber", SlotNumber);
+		sr.Serialize ("SyncMaxDelay", SyncMaxDelay);
+		sr.Serialize ("SyncPolicy", static_cast <uint32> (SyncPolicy));
+		sr.Serialize ("TrackChanges", TrackChanges);
 		sr.Serialize ("UseBackupHeaders", UseBackupHeaders);
 	}
 
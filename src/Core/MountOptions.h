@@ -10,10 +10,12 @@
 #define TC_HEADER_Core_MountOptions
 
 #include "Platform/Serializable.h"
+#include "Volume/GroupCommitFlusher.h"
 #include "Volume/Keyfile.h"
 #include "Volume/Volume.h"
 #include "Volume/VolumeSlot.h"
 #include "Volume/VolumePassword.h"
+#include "Volume/VolumeRequestScheduler.h"
 
 namespace Basalt
 {
@@ -21,15 +23,21 @@ namespace Basalt
 	{
 		MountOptions ()
 			:
+			AllowDiscard (false),
 			NoFilesystem (false),
 			NoHardwareCrypto (false),
 			NoKernelCrypto (false),
 			PartitionInSystemEncryptionScope (false),
 			PreserveTimestamps (true),
 			Protection (VolumeProtection::None),
+			QueueDepth (VolumeRequestScheduler::DefaultQueueDepth),
 			Removable (false),
+			RotateMasterKey (false),
 			SharedAccessAllowed (false),
 			SlotNumber (0),
+			SyncMaxDelay (GroupCommitFlusher::DefaultMaxDelay),
+			SyncPolicy (VolumeSyncPolicy::Grouped),
+			TrackChanges (false),
 			UseBackupHeaders (false)
 		{
 		}
@@ -41,6 +49,7 @@ namespace Basalt
 
 		TC_SERIALIZABLE (MountOptions);
 
+		bool AllowDiscard;
 		wstring FilesystemOptions;
 		wstring FilesystemType;
 		shared_ptr <KeyfileList> Keyfiles;
@@ -55,9 +64,14 @@ namespace Basalt
 		VolumeProtection::Enum Protection;
 		shared_ptr <VolumePassword> ProtectionPassword;
 		shared_ptr <KeyfileList> ProtectionKeyfiles;
+		uint32 QueueDepth;
 		bool Removable;
+		bool RotateMasterKey;
 		bool SharedAccessAllowed;
 		VolumeSlotNumber SlotNumber;
+		uint32 SyncMaxDelay;
+		VolumeSyncPolicy::Enum SyncPolicy;
+		bool TrackChanges;
 		bool UseBackupHeaders;
 
 	protected:
@@ -0,0 +1,166 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "Platform/SystemInfo.h"
+#include "Platform/SystemLog.h"
+#include "ParallelRandomBitGenerator.h"
+
+namespace Basalt
+{
+	ParallelRandomBitGenerator::ParallelRandomBitGenerator ()
+		: DataPending (false), OutstandingSliceCount (0), StopPending (false)
+	{
+		size_t threadCount = SystemInfo::GetProcessorCount();
+		if (threadCount > MaxThreadCount)
+			threadCount = MaxThreadCount;
+
+		try
+		{
+			// A single worker still lets the caller write while data is generated
+			for (size_t i = 0; i < threadCount; ++i)
+			{
+				struct ThreadFunctor : public Functor
+				{
+					ThreadFunctor (ParallelRandomBitGenerator *generator, Worker *worker) : Generator (generator), ThreadWorker (worker) { }
+					virtual void operator() ()
+					{
+						Generator->WorkThreadProc (*ThreadWorker);
+					}
+					ParallelRandomBitGenerator *Generator;
+					Worker *ThreadWorker;
+				};
+
+				shared_ptr <Worker> worker (new Worker);
+				worker->WorkerThread.Start (new ThreadFunctor (this, worker.get()));
+				Workers.push_back (worker);
+			}
+		}
+		catch (...)
+		{
+			Stop();
+			throw;
+		}
+	}
+
+	ParallelRandomBitGenerator::~ParallelRandomBitGenerator ()
+	{
+		try
+		{
+			WaitForData();
+		}
+		catch (...) { }
+
+		Stop();
+	}
+
+	void ParallelRandomBitGenerator::BeginGetData (const BufferPtr &buffer)
+	{
+		if (DataPending)
+			throw ParameterIncorrect (SRC_POS);
+
+		// Slices are multiples of the request size of the generators
+		size_t sliceSize = buffer.Size() / Workers.size();
+		sliceSize = (sliceSize + RandomBitGenerator::MaxRequestSize - 1) / RandomBitGenerator::MaxRequestSize * RandomBitGenerator::MaxRequestSize;
+
+		size_t sliceCount = 0;
+		for (size_t offset = 0; offset < buffer.Size(); offset += sliceSize)
+		{
+			Worker &worker = *Workers[sliceCount++];
+			worker.SliceData = buffer.Get() + offset;
+			worker.SliceSize = buffer.Size() - offset < sliceSize ? buffer.Size() - offset : sliceSize;
+		}
+
+		if (sliceCount == 0)
+			return;
+
+		OutstandingSliceCount.Set (sliceCount);
+		DataPending = true;
+
+		for (size_t i = 0; i < sliceCount; ++i)
+			Workers[i]->WorkReadyEvent.Signal();
+	}
+
+	void ParallelRandomBitGenerator::Stop ()
+	{
+		StopPending = true;
+
+		for (const auto &worker : Workers)
+			worker->WorkReadyEvent.Signal();
+
+		for (const auto &worker : Workers)
+			worker->WorkerThread.Join();
+
+		Workers.clear();
+	}
+
+	void ParallelRandomBitGenerator::WaitForData ()
+	{
+		if (!DataPending)
+			return;
+
+		DataCompletedEvent.Wait();
+		DataPending = false;
+
+		unique_ptr <Exception> sliceException;
+		for (const auto &worker : Workers)
+		{
+			worker->SliceData = nullptr;
+			worker->SliceSize = 0;
+
+			if (worker->SliceException.get() && !sliceException.get())
+				sliceException = std::move (worker->SliceException);
+
+			worker->SliceException.reset();
+		}
+
+		if (sliceException.get())
+			sliceException->Throw();
+	}
+
+	void ParallelRandomBitGenerator::WorkThreadProc (Worker &worker)
+	{
+		try
+		{
+			while (true)
+			{
+				worker.WorkReadyEvent.Wait();
+
+				if (StopPending)
+					break;
+
+				try
+				{
+					worker.Generator.GetData (BufferPtr (worker.SliceData, worker.SliceSize));
+				}
+				catch (Exception &e)
+				{
+					worker.SliceException.reset (e.CloneNew());
+				}
+				catch (exception &e)
+				{
+					worker.SliceException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+				}
+				catch (...)
+				{
+					worker.SliceException.reset (new UnknownException (SRC_POS));
+				}
+
+				if (OutstandingSliceCount.Decrement() == 0)
+					DataCompletedEvent.Signal();
+			}
+		}
+		catch (exception &e)
+		{
+			SystemLog::WriteException (e);
+		}
+		catch (...)
+		{
+			SystemLog::WriteException (UnknownException (SRC_POS));
+		}
+	}
+}
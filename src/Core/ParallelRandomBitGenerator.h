@@ -0,0 +1,65 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_ParallelRandomBitGenerator
+#define TC_HEADER_Core_ParallelRandomBitGenerator
+
+#include "Platform/Platform.h"
+#include "Platform/SharedVal.h"
+#include "RandomBitGenerator.h"
+
+namespace Basalt
+{
+	/*
+	 * Fills large buffers with RandomBitGenerator output on one worker thread
+	 * per CPU, each with its own independently seeded generator. A buffer is
+	 * filled asynchronously between BeginGetData() and WaitForData(), so that
+	 * the caller can write the previous buffer in the meantime.
+	 */
+	class ParallelRandomBitGenerator
+	{
+	public:
+		ParallelRandomBitGenerator ();
+		virtual ~ParallelRandomBitGenerator ();
+
+		void BeginGetData (const BufferPtr &buffer);
+		void GetData (const BufferPtr &buffer) { BeginGetData (buffer); WaitForData(); }
+		size_t GetThreadCount () const { return Workers.size(); }
+		void WaitForData ();
+
+		static const size_t MaxThreadCount = 32;
+
+	protected:
+		struct Worker
+		{
+			Worker () : SliceData (nullptr), SliceSize (0) { }
+
+			RandomBitGenerator Generator;
+			unique_ptr <Exception> SliceException;
+			byte *SliceData;
+			size_t SliceSize;
+			Thread WorkerThread;
+			SyncEvent WorkReadyEvent;
+		};
+
+		void Stop ();
+		void WorkThreadProc (Worker &worker);
+
+		bool DataPending;
+		SyncEvent DataCompletedEvent;
+		SharedVal <size_t> OutstandingSliceCount;
+		volatile bool StopPending;
+		vector < shared_ptr <Worker> > Workers;
+
+	private:
+		ParallelRandomBitGenerator (const ParallelRandomBitGenerator &);
+		ParallelRandomBitGenerator &operator= (const ParallelRandomBitGenerator &);
+	};
+}
+
+#endif // TC_HEADER_Core_ParallelRandomBitGenerator
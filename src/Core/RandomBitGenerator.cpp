@@ -0,0 +1,144 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "RandomBitGenerator.h"
+#include "RandomNumberGenerator.h"
+
+namespace Basalt
+{
+	RandomBitGenerator::RandomBitGenerator ()
+		: BytesSinceReseed (0), CounterBlocks (SeedSize), CounterHigh (0), CounterLow (0)
+	{
+		Instantiate();
+		Reseed();
+	}
+
+	RandomBitGenerator::RandomBitGenerator (const ConstBufferPtr &entropyInput)
+		: BytesSinceReseed (0), CounterBlocks (SeedSize), CounterHigh (0), CounterLow (0)
+	{
+		Instantiate();
+		Reseed (entropyInput);
+	}
+
+	void RandomBitGenerator::Generate (byte *data, size_t size)
+	{
+		const size_t blockSize = 16;
+		size_t blockCount = size / blockSize;
+
+		// The counter is incremented before each block is generated
+		uint64 firstHigh = CounterHigh + (CounterLow == (uint64) -1 ? 1 : 0);
+		uint64 firstLow = CounterLow + 1;
+
+		if (blockCount > 0 && Aes.EncryptCounterBlocks (data, firstHigh, firstLow, blockCount))
+		{
+			CounterLow += blockCount;
+			if (CounterLow < blockCount)
+				++CounterHigh;
+		}
+		else
+		{
+			// Counter blocks are written to the output buffer and encrypted in place
+			for (size_t i = 0; i < blockCount; ++i)
+			{
+				if (++CounterLow == 0)
+					++CounterHigh;
+
+				uint64 high = Endian::Big (CounterHigh);
+				uint64 low = Endian::Big (CounterLow);
+				memcpy (data + i * blockSize, &high, sizeof (high));
+				memcpy (data + i * blockSize + sizeof (high), &low, sizeof (low));
+			}
+
+			// Multiples of 32 blocks are processed by the pipelined hardware kernels
+			size_t bulkBlockCount = blockCount & ~size_t (32 - 1);
+			if (bulkBlockCount > 0)
+				Aes.EncryptBlocks (data, bulkBlockCount);
+
+			if (blockCount > bulkBlockCount)
+				Aes.EncryptBlocks (data + bulkBlockCount * blockSize, blockCount - bulkBlockCount);
+		}
+
+		size_t tailSize = size % blockSize;
+		if (tailSize > 0)
+		{
+			byte tail[16];
+			Generate (tail, sizeof (tail));
+			memcpy (data + blockCount * blockSize, tail, tailSize);
+			burn (tail, sizeof (tail));
+		}
+	}
+
+	void RandomBitGenerator::GetData (const BufferPtr &buffer)
+	{
+		SecureBuffer noAdditionalInput (SeedSize);
+		noAdditionalInput.Zero();
+
+		for (size_t offset = 0; offset < buffer.Size(); )
+		{
+			if (BytesSinceReseed >= ReseedInterval)
+				Reseed();
+
+			size_t requestSize = buffer.Size() - offset;
+			if (requestSize > MaxRequestSize)
+				requestSize = MaxRequestSize;
+
+			Generate (buffer.Get() + offset, requestSize);
+			Update (noAdditionalInput);
+
+			offset += requestSize;
+			BytesSinceReseed += requestSize;
+		}
+	}
+
+	void RandomBitGenerator::Instantiate ()
+	{
+		// The state starts from a zero key and counter and is then updated with the seed
+		SecureBuffer key (Aes.GetKeySize());
+		key.Zero();
+		Aes.SetKey (key);
+
+		CounterHigh = 0;
+		CounterLow = 0;
+	}
+
+	void RandomBitGenerator::Reseed ()
+	{
+		SecureBuffer seed (SeedSize);
+		RandomNumberGenerator::GetData (seed);
+
+		Reseed (seed);
+	}
+
+	void RandomBitGenerator::Reseed (const ConstBufferPtr &entropyInput)
+	{
+		if (entropyInput.Size() != SeedSize)
+			throw ParameterIncorrect (SRC_POS);
+
+		Update (entropyInput);
+		BytesSinceReseed = 0;
+	}
+
+	void RandomBitGenerator::Update (const ConstBufferPtr &providedData)
+	{
+		Generate (CounterBlocks, SeedSize);
+
+		for (size_t i = 0; i < SeedSize; ++i)
+			CounterBlocks[i] ^= providedData[i];
+
+		size_t keySize = Aes.GetKeySize();
+		Aes.SetKey (CounterBlocks.GetRange (0, keySize));
+
+		uint64 high, low;
+		memcpy (&high, CounterBlocks.Ptr() + keySize, sizeof (high));
+		memcpy (&low, CounterBlocks.Ptr() + keySize + sizeof (high), sizeof (low));
+		CounterHigh = Endian::Big (high);
+		CounterLow = Endian::Big (low);
+
+		CounterBlocks.Erase();
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_RandomBitGenerator
+#define TC_HEADER_Core_RandomBitGenerator
+
+#include "Platform/Platform.h"
+#include "Volume/Cipher.h"
+
+namespace Basalt
+{
+	/*
+	 * Deterministic random bit generator for bulk data (AES-256 CTR_DRBG of
+	 * NIST SP 800-90A without derivation function). It is seeded and
+	 * periodically reseeded from RandomNumberGenerator, whose pool remains the
+	 * only source of key material (master keys, salts, keyfiles). Output is
+	 * generated in requests of at most MaxRequestSize bytes; the key and
+	 * counter are replaced after each request, so that a later compromise of
+	 * the state does not reveal data generated before.
+	 *
+	 * An instance is not thread-safe; threads producing bulk data in parallel
+	 * use an instance each. Entropy input may be supplied by the caller only
+	 * for known-answer tests.
+	 */
+	class RandomBitGenerator
+	{
+	public:
+		RandomBitGenerator ();
+		RandomBitGenerator (const ConstBufferPtr &entropyInput);
+		virtual ~RandomBitGenerator () { }
+
+		void GetData (const BufferPtr &buffer);
+		void Reseed ();
+		void Reseed (const ConstBufferPtr &entropyInput);
+
+		static const size_t MaxRequestSize = 64 * 1024;
+		static const uint64 ReseedInterval = 1ULL * 1024 * 1024 * 1024;
+		static const size_t SeedSize = 32 + 16;
+
+	protected:
+		void Generate (byte *data, size_t size);
+		void Instantiate ();
+		void Update (const ConstBufferPtr &providedData);
+
+		CipherAES Aes;
+		uint64 BytesSinceReseed;
+		SecureBuffer CounterBlocks;
+		uint64 CounterHigh;
+		uint64 CounterLow;
+
+	private:
+		RandomBitGenerator (const RandomBitGenerator &);
+		RandomBitGenerator &operator= (const RandomBitGenerator &);
+	};
+}
+
+#endif // TC_HEADER_Core_RandomBitGenerator
@@ -17,6 +17,7 @@
 #include "Platform/FileStream.h"
 #include "Platform/Serializer.h"
 #include "Fuse/FuseService.h"
+#include "Core/RandomNumberGenerator.h"
 
 namespace Basalt
 {
@@ -460,6 +461,27 @@ namespace Basalt
 		if (IsVolumeMounted (*options.Path))
 			throw VolumeAlreadyMounted (SRC_POS);
 
+#ifdef TC_MACOSX
+		// The NFS client of macOS does not pass discards on to the server
+		if (options.AllowDiscard)
+			throw NotApplicable (SRC_POS);
+#endif
+
+		if (options.TrackChanges)
+		{
+			// Changes are tracked in a file next to the container
+			if (options.Path->IsDevice())
+				throw NotApplicable (SRC_POS);
+
+			FilePath trackerPath = VolumeChangeTracker::GetTrackerPath (FilePath (wstring (*options.Path)));
+			if (!trackerPath.IsFile())
+			{
+				File volumeFile;
+				volumeFile.Open (FilePath (wstring (*options.Path)));
+				VolumeChangeTracker::Create (trackerPath, volumeFile.Length());
+			}
+		}
+
 		Cipher::EnableHwSupport (!options.NoHardwareCrypto);
 
 		shared_ptr <Volume> volume;
@@ -482,6 +504,15 @@ namespace Basalt
 					options.PartitionInSystemEncryptionScope
 					);
 
+				// An interrupted key rotation is resumed without being requested
+				if (options.RotateMasterKey && !volume->IsKeyRotationInProgress())
+				{
+					if (!RandomNumberGenerator::IsRunning())
+						RandomNumberGenerator::Start();
+
+					BeginKeyRotation (volume, options.Password, options.Keyfiles);
+				}
+
 				options.Password.reset();
 			}
 			catch (SystemException &e)
@@ -500,6 +531,12 @@ namespace Basalt
 			break;
 		}
 
+#ifdef TC_MACOSX
+		// The volume is attached as a disk image, which has 512-byte sectors
+		if (volume->GetSectorSize() != TC_SECTOR_SIZE_FILE_HOSTED_VOLUME)
+			throw UnsupportedSectorSize (SRC_POS);
+#endif
+
 		if (options.Path->IsDevice())
 		{
 			if (volume->GetFile()->GetDeviceSectorSize() != volume->GetSectorSize())
@@ -557,9 +594,15 @@ namespace Basalt
 			}
 		}
 
+		// Holes punched in the host file reveal which areas of the volume are unused. Outer volumes
+		// are not excluded, so discarding their free space destroys any hidden volume they contain.
+		bool allowDiscard = options.AllowDiscard
+			&& volume->GetType() == VolumeType::Normal
+			&& volume->GetProtectionType() == VolumeProtection::None;
+
 		try
 		{
-			FuseService::Mount (volume, options.SlotNumber, fuseMountPoint);
+			FuseService::Mount (volume, options.SlotNumber, fuseMountPoint, options.SyncPolicy, options.SyncMaxDelay, allowDiscard, options.QueueDepth);
 		}
 		catch (...)
 		{
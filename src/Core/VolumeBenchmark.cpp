@@ -0,0 +1,261 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include "Platform/Time.h"
+#include "VolumeBenchmark.h"
+
+namespace Basalt
+{
+	VolumeBenchmark::VolumeBenchmark (const DirectoryPath &mountPoint, uint32 duration)
+		: AbortRequested (false), Duration (duration), MountPoint (mountPoint), StopRequested (false)
+	{
+	}
+
+	VolumeBenchmark::~VolumeBenchmark ()
+	{
+		StopWriters();
+		RemoveFiles();
+	}
+
+	void VolumeBenchmark::Abort ()
+	{
+		AbortRequested = true;
+	}
+
+	FilePath VolumeBenchmark::GetFilePath (const wstring &name) const
+	{
+		return FilePath (wstring (MountPoint) + L"/.basalt-benchmark-" + name + L".tmp");
+	}
+
+	VolumeBenchmark::LatencyInfo VolumeBenchmark::MeasureReads (int readFile, uint64 endTime)
+	{
+#ifdef TC_UNIX
+		// Direct I/O requires a buffer aligned to the logical block size
+		Buffer buffer (ReadSize * 2);
+		byte *alignedBuffer = buffer.Ptr() + (ReadSize - reinterpret_cast <uintptr_t> (buffer.Ptr()) % ReadSize) % ReadSize;
+
+		vector <uint64> samples;
+		uint64 blockCount = ReadFileSize / ReadSize;
+
+		// Offsets only need to defeat read-ahead, not to be unpredictable
+		uint64 randomState = Time::GetCurrent() | 1;
+
+		while (!AbortRequested && Time::GetCurrent() < endTime)
+		{
+			randomState ^= randomState << 13;
+			randomState ^= randomState >> 7;
+			randomState ^= randomState << 17;
+			uint64 offset = (randomState % blockCount) * ReadSize;
+
+			// Time is measured in units of 100 ns
+			uint64 startTime = Time::GetCurrent();
+			throw_sys_if (pread (readFile, alignedBuffer, ReadSize, offset) != (ssize_t) ReadSize);
+
+			uint64 currentTime = Time::GetCurrent();
+			samples.push_back (currentTime > startTime ? (currentTime - startTime) / 10 : 0);
+		}
+
+		LatencyInfo latency;
+		latency.Count = samples.size();
+		latency.P50 = latency.P99 = latency.Max = 0;
+
+		if (!samples.empty())
+		{
+			sort (samples.begin(), samples.end());
+			latency.P50 = samples[(samples.size() - 1) * 50 / 100];
+			latency.P99 = samples[(samples.size() - 1) * 99 / 100];
+			latency.Max = samples.back();
+		}
+
+		return latency;
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
+	void VolumeBenchmark::PrepareReadFile ()
+	{
+		Buffer buffer (WriteSize);
+		buffer.Zero();
+
+		File file;
+		file.Open (GetFilePath (L"read"), File::CreateWrite);
+
+		for (uint64 offset = 0; offset < ReadFileSize && !AbortRequested; offset += WriteSize)
+			file.WriteAt (buffer, offset);
+
+		file.Flush();
+	}
+
+	void VolumeBenchmark::RemoveFiles ()
+	{
+		try
+		{
+			GetFilePath (L"read").Delete();
+		}
+		catch (...) { }
+
+		for (size_t i = 0; i < WriterCount; ++i)
+		{
+			try
+			{
+				GetFilePath (L"write-" + StringConverter::ToWide (static_cast <uint64> (i))).Delete();
+			}
+			catch (...) { }
+		}
+	}
+
+	VolumeBenchmark::Result VolumeBenchmark::Run ()
+	{
+#ifdef TC_UNIX
+		if (!MountPoint.IsDirectory())
+			throw ParameterIncorrect (SRC_POS);
+
+		AbortRequested = false;
+		StopRequested = false;
+		Writers.clear();
+
+		Result result;
+		PrepareReadFile();
+
+		FilePath readPath = GetFilePath (L"read");
+		int flags = O_RDONLY;
+#ifdef O_DIRECT
+		flags |= O_DIRECT;
+#endif
+		int readFile = open (string (readPath).c_str(), flags);
+#ifdef O_DIRECT
+		// Not all filesystems support direct I/O
+		if (readFile == -1 && errno == EINVAL)
+			readFile = open (string (readPath).c_str(), O_RDONLY);
+#endif
+		throw_sys_sub_if (readFile == -1, wstring (readPath));
+
+		finally_do_arg (int, readFile, { close (finally_arg); });
+
+#ifdef F_NOCACHE
+		fcntl (readFile, F_NOCACHE, 1);
+#endif
+
+		// Time is measured in units of 100 ns
+		result.IdleReads = MeasureReads (readFile, Time::GetCurrent() + Duration * 10000000ULL);
+
+		struct WriteThreadFunctor : public Functor
+		{
+			WriteThreadFunctor (VolumeBenchmark *benchmark, size_t writerNumber, WriterInfo &writer)
+				: Benchmark (benchmark), Writer (writer), WriterNumber (writerNumber) { }
+
+			virtual void operator() ()
+			{
+				Benchmark->WriteThread (WriterNumber, Writer);
+			}
+
+			VolumeBenchmark *Benchmark;
+			WriterInfo &Writer;
+			size_t WriterNumber;
+		};
+
+		for (size_t i = 0; i < WriterCount; ++i)
+		{
+			shared_ptr <WriterInfo> writer (new WriterInfo);
+			Writers.push_back (writer);
+
+			writer->WriterThread.Start (new WriteThreadFunctor (this, i, *writer));
+			writer->ThreadStarted = true;
+		}
+
+		uint64 loadStartTime = Time::GetCurrent();
+		result.LoadedReads = MeasureReads (readFile, loadStartTime + Duration * 10000000ULL);
+		uint64 loadTime = Time::GetCurrent() - loadStartTime;
+
+		StopWriters();
+
+		uint64 sizeWritten = 0;
+		for (const shared_ptr <WriterInfo> &writer : Writers)
+		{
+			if (writer->ThreadException)
+				writer->ThreadException->Throw();
+
+			sizeWritten += writer->SizeWritten;
+		}
+
+		result.WriteBytesPerSecond = loadTime > 0 ? (uint64) (sizeWritten * 10000000.0 / loadTime) : 0;
+
+		if (AbortRequested)
+			throw UserAbort (SRC_POS);
+
+		return result;
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
+	void VolumeBenchmark::StopWriters ()
+	{
+		StopRequested = true;
+
+		for (const shared_ptr <WriterInfo> &writer : Writers)
+		{
+			if (writer->ThreadStarted)
+			{
+				writer->WriterThread.Join();
+				writer->ThreadStarted = false;
+			}
+		}
+	}
+
+	void VolumeBenchmark::WriteThread (size_t writerNumber, WriterInfo &writer)
+	{
+		try
+		{
+			Buffer buffer (WriteSize);
+			buffer.Zero();
+
+			File file;
+			file.Open (GetFilePath (L"write-" + StringConverter::ToWide (static_cast <uint64> (writerNumber))), File::CreateWrite);
+
+			// The file is rewritten from the start when it reaches its size, like a backup overwriting older data
+			uint64 offset = 0;
+			uint64 unsynced = 0;
+
+			while (!StopRequested && !AbortRequested)
+			{
+				file.WriteAt (buffer, offset);
+				writer.SizeWritten += WriteSize;
+
+				offset = (offset + WriteSize) % WriteFileSize;
+				unsynced += WriteSize;
+
+				if (unsynced >= WriteSyncInterval)
+				{
+					file.Flush();
+					unsynced = 0;
+				}
+			}
+		}
+		catch (Exception &e)
+		{
+			writer.ThreadException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			writer.ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			writer.ThreadException.reset (new UnknownException (SRC_POS));
+		}
+	}
+}
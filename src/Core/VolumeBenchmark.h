@@ -0,0 +1,88 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeBenchmark
+#define TC_HEADER_Core_VolumeBenchmark
+
+#include "Platform/Platform.h"
+
+namespace Basalt
+{
+	/*
+	 * Measures the latency of small random reads from the filesystem of a
+	 * mounted volume, first alone and then while background threads stream
+	 * large writes to the same filesystem. Reads bypass the page cache, so
+	 * each of them is served by the volume. Comparing runs with different
+	 * queue depths (mount option queuedepth) shows how far interactive reads
+	 * are delayed by bulk writes.
+	 */
+	class VolumeBenchmark
+	{
+	public:
+		struct LatencyInfo
+		{
+			uint64 Count;
+
+			// Microseconds
+			uint64 P50;
+			uint64 P99;
+			uint64 Max;
+		};
+
+		struct Result
+		{
+			LatencyInfo IdleReads;
+			LatencyInfo LoadedReads;
+			uint64 WriteBytesPerSecond;
+		};
+
+		VolumeBenchmark (const DirectoryPath &mountPoint, uint32 duration = DefaultDuration);
+		virtual ~VolumeBenchmark ();
+
+		void Abort ();
+		Result Run ();
+
+		static const uint32 DefaultDuration = 5;		// Seconds per phase
+		static const uint64 ReadFileSize = 64 * 1024 * 1024;
+		static const size_t ReadSize = 4096;
+		static const size_t WriterCount = 4;
+		static const uint64 WriteFileSize = 128 * 1024 * 1024;
+		static const uint64 WriteSyncInterval = 16 * 1024 * 1024;
+		static const size_t WriteSize = 1024 * 1024;
+
+	protected:
+		struct WriterInfo
+		{
+			WriterInfo () : SizeWritten (0), ThreadStarted (false) { }
+
+			uint64 SizeWritten;
+			shared_ptr <Exception> ThreadException;
+			Thread WriterThread;
+			bool ThreadStarted;
+		};
+
+		FilePath GetFilePath (const wstring &name) const;
+		LatencyInfo MeasureReads (int readFile, uint64 endTime);
+		void PrepareReadFile ();
+		void RemoveFiles ();
+		void StopWriters ();
+		void WriteThread (size_t writerNumber, WriterInfo &writer);
+
+		volatile bool AbortRequested;
+		uint32 Duration;
+		DirectoryPath MountPoint;
+		volatile bool StopRequested;
+		vector < shared_ptr <WriterInfo> > Writers;
+
+	private:
+		VolumeBenchmark (const VolumeBenchmark &);
+		VolumeBenchmark &operator= (const VolumeBenchmark &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeBenchmark
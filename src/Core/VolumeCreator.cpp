@@ -6,6 +6,7 @@
  packages.
 */
 
+#include "Platform/Time.h"
 #include "Volume/EncryptionTest.h"
 #include "Volume/EncryptionModeXTS.h"
 #include "Core.h"
@@ -18,6 +19,7 @@
 
 #include "VolumeCreator.h"
 #include "FatFormatter.h"
+#include "ParallelRandomBitGenerator.h"
 
 namespace Basalt
 {
@@ -104,7 +106,11 @@ namespace Basalt
 				sectorWriter.FlushOutputBuffer();
 			}
 
-			if (!Options->Quick)
+			if (!Options->Quick && Options->Fill == VolumeCreationOptions::FillType::Random)
+			{
+				WriteRandomFill (endOffset);
+			}
+			else if (!Options->Quick)
 			{
 				// Empty sectors are encrypted with different key to randomize plaintext
 				Core->RandomizeEncryptionAlgorithmKey (Options->EA);
@@ -140,7 +146,12 @@ namespace Basalt
 
 				Layout->GetHeader()->EncryptNew (backupHeader, backupHeaderSalt, HeaderKey, Options->VolumeHeaderKdf);
 
-				if (Options->Quick || Options->Type == VolumeType::Hidden)
+				if (Options->Type == VolumeType::Normal && Options->Quick && !Options->Path.IsDevice())
+				{
+					// The data area of a new container has not been written, so the file does not extend to the backup header yet
+					VolumeFile->SeekAt (Options->Size + Layout->GetBackupHeaderOffset());
+				}
+				else if (Options->Quick || Options->Type == VolumeType::Hidden)
 					VolumeFile->SeekEnd (Layout->GetBackupHeaderOffset());
 
 				VolumeFile->Write (backupHeader);
@@ -226,8 +237,16 @@ namespace Basalt
 					throw UnsupportedSectorSize (SRC_POS);
 				}
 			}
-			else
+			else if (options->SectorSize == 0)
+			{
 				options->SectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+			}
+			else if (options->SectorSize != TC_SECTOR_SIZE_FILE_HOSTED_VOLUME
+				&& (options->SectorSize != TC_MAX_VOLUME_SECTOR_SIZE || options->Type == VolumeType::Hidden))
+			{
+				// Larger sectors are available to new normal containers only
+				throw UnsupportedSectorSize (SRC_POS);
+			}
 
 			// Volume layout
 			switch (options->Type)
@@ -265,6 +284,9 @@ namespace Basalt
 
 			headerOptions.VolumeDataSize = Layout->GetMaxDataSize (options->Size);
 
+			// The data area consists of whole sectors
+			headerOptions.VolumeDataSize -= headerOptions.VolumeDataSize % options->SectorSize;
+
 			if (headerOptions.VolumeDataSize < 1)
 				throw ParameterIncorrect (SRC_POS);
 
@@ -316,6 +338,8 @@ namespace Basalt
 
 			mProgressInfo.CreationInProgress = true;
 			mProgressInfo.TotalSize = options->Size;
+			mProgressInfo.BytesPerSecond = 0;
+			StartTime = Time::GetCurrent();
 
 			struct ThreadFunctor : public Functor
 			{
@@ -348,6 +372,42 @@ namespace Basalt
 	VolumeCreator::ProgressInfo VolumeCreator::GetProgressInfo ()
 	{
 		mProgressInfo.SizeDone = SizeDone.Get();
+
+		// Time is measured in units of 100 ns
+		uint64 elapsed = Time::GetCurrent() - StartTime;
+		if (mProgressInfo.CreationInProgress && elapsed > 0)
+			mProgressInfo.BytesPerSecond = (uint64) (mProgressInfo.SizeDone * 10000000.0 / elapsed);
+
 		return mProgressInfo;
 	}
+
+	void VolumeCreator::WriteRandomFill (uint64 endOffset)
+	{
+		// Each buffer is filled by the generator threads while the other one is written
+		SecureBuffer buffers[2];
+		buffers[0].Allocate (RandomFillBufferSize);
+		buffers[1].Allocate (RandomFillBufferSize);
+
+		ParallelRandomBitGenerator generator;
+
+		uint64 nextLength = endOffset - WriteOffset < RandomFillBufferSize ? endOffset - WriteOffset : RandomFillBufferSize;
+		generator.BeginGetData (buffers[0].GetRange (0, (size_t) nextLength));
+
+		for (size_t current = 0; !AbortRequested && WriteOffset < endOffset; current ^= 1)
+		{
+			uint64 length = nextLength;
+			generator.WaitForData();
+
+			uint64 nextOffset = WriteOffset + length;
+			nextLength = endOffset - nextOffset < RandomFillBufferSize ? endOffset - nextOffset : RandomFillBufferSize;
+
+			if (nextLength > 0)
+				generator.BeginGetData (buffers[current ^ 1].GetRange (0, (size_t) nextLength));
+
+			VolumeFile->Write (buffers[current], (size_t) length);
+
+			WriteOffset += length;
+			SizeDone.Set (WriteOffset - DataStart);
+		}
+	}
 }
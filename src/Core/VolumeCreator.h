@@ -27,6 +27,18 @@ namespace Basalt
 		shared_ptr <EncryptionAlgorithm> EA;
 		bool Quick;
 
+		// Content written to the data area not occupied by the filesystem (unless Quick is set)
+		struct FillType
+		{
+			enum Enum
+			{
+				Encrypted = 0,	// Zeros encrypted with a random key
+				Random			// Output of the parallel random bit generator
+			};
+		};
+
+		FillType::Enum Fill;
+
 		struct FilesystemType
 		{
 			enum Enum
@@ -60,7 +72,7 @@ namespace Basalt
 
 		FilesystemType::Enum Filesystem;
 		uint32 FilesystemClusterSize;
-		uint32 SectorSize;
+		uint32 SectorSize;		// File containers: zero for the default or TC_MAX_VOLUME_SECTOR_SIZE; devices use their own
 	};
 
 	class VolumeCreator
@@ -72,6 +84,7 @@ namespace Basalt
 			bool CreationInProgress;
 			uint64 TotalSize;
 			uint64 SizeDone;
+			uint64 BytesPerSecond;
 		};
 
 		struct KeyInfo
@@ -91,6 +104,9 @@ namespace Basalt
 
 	protected:
 		void CreationThread ();
+		void WriteRandomFill (uint64 endOffset);
+
+		static const size_t RandomFillBufferSize = 8 * 1024 * 1024;
 
 		volatile bool AbortRequested;
 		volatile bool CreationInProgress;
@@ -103,6 +119,7 @@ namespace Basalt
 		shared_ptr <VolumeLayout> Layout;
 		shared_ptr <File> VolumeFile;
 		SharedVal <uint64> SizeDone;
+		uint64 StartTime;
 		uint64 WriteOffset;
 		ProgressInfo mProgressInfo;
 
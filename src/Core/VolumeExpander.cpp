@@ -0,0 +1,246 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "Volume/EncryptionModeXTS.h"
+#include "Volume/EncryptionThreadPool.h"
+#include "Core.h"
+#include "VolumeExpander.h"
+
+namespace Basalt
+{
+	VolumeExpander::VolumeExpander ()
+		: AbortRequested (false), DataStart (0), FillEnd (0), FillStart (0), NewDataSize (0), SizeDone (0)
+	{
+		mProgressInfo.ExpansionInProgress = false;
+		mProgressInfo.Resumed = false;
+		mProgressInfo.TotalSize = 0;
+	}
+
+	VolumeExpander::~VolumeExpander ()
+	{
+	}
+
+	void VolumeExpander::Abort ()
+	{
+		AbortRequested = true;
+	}
+
+	void VolumeExpander::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	void VolumeExpander::ExpandVolume (shared_ptr <VolumeExpansionOptions> options)
+	{
+		VolumeFile.reset (new File);
+		VolumeFile->Open (options->Path, File::OpenReadWrite, File::ShareNone);
+
+		try
+		{
+			shared_ptr <VolumePassword> passwordKey = Keyfile::ApplyListToPassword (options->Keyfiles, options->Password);
+
+			shared_ptr <VolumeLayout> layout (new VolumeLayoutV2Normal());
+			Header = layout->GetHeader();
+			SecureBuffer headerBuffer (layout->GetHeaderSize());
+
+			if (VolumeFile->ReadAt (headerBuffer, layout->GetHeaderOffset()) != headerBuffer.Size()
+				|| !Header->Decrypt (headerBuffer, *passwordKey, layout->GetSupportedKeyDerivationFunctions(),
+					layout->GetSupportedEncryptionAlgorithms(), layout->GetSupportedEncryptionModes()))
+			{
+				if (options->Keyfiles && !options->Keyfiles->empty())
+					throw PasswordKeyfilesIncorrect (SRC_POS);
+				throw PasswordIncorrect (SRC_POS);
+			}
+
+			// Legacy volumes have no backup headers and need to be converted first
+			if (Header->GetRequiredMinProgramVersion() < 0x600
+				|| (Header->GetFlags() & TC_HEADER_FLAG_ENCRYPTED_SYSTEM))
+			{
+				throw ParameterIncorrect (SRC_POS);
+			}
+
+			if (Header->GetFlags() & TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS)
+				throw VolumeEncryptionNotCompleted (SRC_POS);
+
+			if (Header->GetFlags() & TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS)
+				throw KeyRotationNotCompleted (SRC_POS);
+
+			DataStart = Header->GetEncryptedAreaStart();
+			uint64 dataSize = Header->GetVolumeDataSize();
+			uint64 oldHostSize = DataStart + dataSize + TC_VOLUME_HEADER_GROUP_SIZE;
+			uint64 hostSize = VolumeFile->Length();
+
+			if (Header->GetEncryptedAreaLength() != dataSize || hostSize < oldHostSize)
+				throw ParameterIncorrect (SRC_POS);
+
+			uint64 newHostSize = options->SizeIncrease > 0 ? oldHostSize + options->SizeIncrease : hostSize;
+
+			// The data area consists of whole sectors
+			NewDataSize = newHostSize - DataStart - TC_VOLUME_HEADER_GROUP_SIZE;
+			NewDataSize -= NewDataSize % Header->GetSectorSize();
+			newHostSize = DataStart + NewDataSize + TC_VOLUME_HEADER_GROUP_SIZE;
+
+			if (NewDataSize <= dataSize || NewDataSize > TC_MAX_VOLUME_SIZE)
+				throw ParameterIncorrect (SRC_POS);
+
+			// Backup headers are located relative to the end of the host
+			if (options->Path.IsDevice() ? newHostSize != hostSize : newHostSize < hostSize)
+				throw ParameterIncorrect (SRC_POS);
+
+			Header->SetVolumeDataSize (NewDataSize);
+			Header->SetEncryptedArea (DataStart, NewDataSize);
+
+			Options = options;
+
+			// Resume an interrupted expansion
+			bool resumed = false;
+			if (hostSize == newHostSize)
+			{
+				shared_ptr <VolumeLayout> backupLayout (new VolumeLayoutV2Normal());
+				shared_ptr <VolumeHeader> backupHeader = backupLayout->GetHeader();
+
+				resumed = VolumeFile->ReadAt (headerBuffer, newHostSize - TC_VOLUME_HEADER_GROUP_SIZE) == headerBuffer.Size()
+					&& backupHeader->Decrypt (headerBuffer, *passwordKey, backupLayout->GetSupportedKeyDerivationFunctions(),
+						backupLayout->GetSupportedEncryptionAlgorithms(), backupLayout->GetSupportedEncryptionModes())
+					&& backupHeader->GetVolumeCreationTime() == Header->GetVolumeCreationTime()
+					&& backupHeader->GetEncryptedAreaStart() == DataStart
+					&& backupHeader->GetVolumeDataSize() == NewDataSize;
+			}
+
+			// Blocks of a change map are located by the host size it was created for
+			if (!options->Path.IsDevice())
+			{
+				FilePath trackerPath = VolumeChangeTracker::GetTrackerPath (FilePath (wstring (options->Path)));
+				if (trackerPath.IsFile())
+					VolumeChangeTracker::Reset (trackerPath, newHostSize);
+			}
+
+			if (!resumed)
+			{
+				// The backup header of a hidden volume moves to the new end with the outer one
+				SecureBuffer headerGroup (TC_VOLUME_HEADER_GROUP_SIZE);
+				if (VolumeFile->ReadAt (headerGroup, oldHostSize - TC_VOLUME_HEADER_GROUP_SIZE) != headerGroup.Size())
+					throw MissingVolumeData (SRC_POS);
+
+				VolumeFile->WriteAt (headerGroup, newHostSize - TC_VOLUME_HEADER_GROUP_SIZE);
+				WriteHeader (newHostSize - TC_VOLUME_HEADER_GROUP_SIZE);
+				VolumeFile->Flush();
+			}
+
+			// The old backup headers must not remain in the data area
+			FillStart = oldHostSize - TC_VOLUME_HEADER_GROUP_SIZE;
+			FillEnd = newHostSize - TC_VOLUME_HEADER_GROUP_SIZE;
+			if (options->Quick && FillEnd > oldHostSize)
+				FillEnd = oldHostSize;
+
+			if (!EncryptionThreadPool::IsRunning())
+				EncryptionThreadPool::Start();
+
+			AbortRequested = false;
+			SizeDone.Set (0);
+
+			mProgressInfo.ExpansionInProgress = true;
+			mProgressInfo.Resumed = resumed;
+			mProgressInfo.TotalSize = FillEnd - FillStart;
+
+			struct ThreadFunctor : public Functor
+			{
+				ThreadFunctor (VolumeExpander *expander) : Expander (expander) { }
+				virtual void operator() ()
+				{
+					Expander->ExpansionThread ();
+				}
+				VolumeExpander *Expander;
+			};
+
+			Thread thread;
+			thread.Start (new ThreadFunctor (this));
+		}
+		catch (...)
+		{
+			VolumeFile.reset();
+			throw;
+		}
+	}
+
+	void VolumeExpander::ExpansionThread ()
+	{
+		try
+		{
+			WriteFiller (FillStart, FillEnd - FillStart);
+
+			if (!AbortRequested)
+				Finalize();
+		}
+		catch (Exception &e)
+		{
+			ThreadException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			ThreadException.reset (new UnknownException (SRC_POS));
+		}
+
+		VolumeFile.reset();
+		mProgressInfo.ExpansionInProgress = false;
+	}
+
+	void VolumeExpander::Finalize ()
+	{
+		// The added space becomes part of the volume when the header describing it is written
+		VolumeFile->Flush();
+
+		WriteHeader (TC_VOLUME_HEADER_OFFSET);
+		VolumeFile->Flush();
+	}
+
+	VolumeExpander::ProgressInfo VolumeExpander::GetProgressInfo ()
+	{
+		mProgressInfo.SizeDone = SizeDone.Get();
+		return mProgressInfo;
+	}
+
+	void VolumeExpander::WriteFiller (uint64 offset, uint64 length)
+	{
+		// Zeros encrypted with a random key cannot be told apart from the data of the volume
+		shared_ptr <EncryptionAlgorithm> ea = Header->GetEncryptionAlgorithm()->GetNew();
+		ea->SetMode (shared_ptr <EncryptionMode> (new EncryptionModeXTS ()));
+		Core->RandomizeEncryptionAlgorithmKey (ea);
+
+		SecureBuffer buffer (FillBufferSize);
+		uint64 endOffset = offset + length;
+
+		while (!AbortRequested && offset < endOffset)
+		{
+			uint64 fragmentLength = buffer.Size();
+			if (fragmentLength > endOffset - offset)
+				fragmentLength = endOffset - offset;
+
+			BufferPtr fragment = buffer.GetRange (0, (size_t) fragmentLength);
+			fragment.Zero();
+			ea->EncryptSectors (fragment, offset / ENCRYPTION_DATA_UNIT_SIZE, fragmentLength / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+			VolumeFile->WriteAt (fragment, offset);
+
+			offset += fragmentLength;
+			SizeDone.Set (SizeDone.Get() + fragmentLength);
+		}
+	}
+
+	void VolumeExpander::WriteHeader (uint64 offset)
+	{
+		SecureBuffer headerBuffer (TC_VOLUME_HEADER_SIZE);
+		Core->ReEncryptVolumeHeaderWithNewSalt (headerBuffer, Header, Options->Password, Options->Keyfiles);
+
+		VolumeFile->WriteAt (headerBuffer, offset);
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeExpander
+#define TC_HEADER_Core_VolumeExpander
+
+#include "Platform/Platform.h"
+#include "Platform/SharedVal.h"
+#include "Volume/Volume.h"
+#include "Volume/VolumeLayout.h"
+#include "RandomNumberGenerator.h"
+
+namespace Basalt
+{
+	struct VolumeExpansionOptions
+	{
+		VolumePath Path;
+		shared_ptr <VolumePassword> Password;
+		shared_ptr <KeyfileList> Keyfiles;
+		uint64 SizeIncrease;	// Zero: grow to the current size of the host
+		bool Quick;				// Added space is not filled (left sparse in containers)
+	};
+
+	/*
+	 * Enlarges the data area of a VolumeLayoutV2Normal volume in place, after
+	 * the container has been extended or the host device has been enlarged.
+	 * Only the added space is written; the filesystem has to be resized with
+	 * the tools of the operating system.
+	 *
+	 * The group of backup headers is copied from the old end of the host to
+	 * the new end, which preserves the backup header of a hidden volume, and
+	 * the backup header describing the new size replaces the outer one. The
+	 * added space and the old backup header group are then filled with zeros
+	 * encrypted with a random key. The volume header is updated last, so an
+	 * interrupted expansion leaves the volume usable at its old size and is
+	 * resumed when requested again.
+	 */
+	class VolumeExpander
+	{
+	public:
+
+		struct ProgressInfo
+		{
+			bool ExpansionInProgress;
+			bool Resumed;
+			uint64 TotalSize;
+			uint64 SizeDone;
+		};
+
+		VolumeExpander ();
+		virtual ~VolumeExpander ();
+
+		void Abort ();
+		void CheckResult ();
+		void ExpandVolume (shared_ptr <VolumeExpansionOptions> options);
+		uint64 GetNewVolumeSize () const { return NewDataSize; }
+		ProgressInfo GetProgressInfo ();
+
+	protected:
+		void ExpansionThread ();
+		void Finalize ();
+		void WriteFiller (uint64 offset, uint64 length);
+		void WriteHeader (uint64 offset);
+
+		static const size_t FillBufferSize = 8 * 1024 * 1024;
+
+		volatile bool AbortRequested;
+		uint64 DataStart;
+		uint64 FillEnd;
+		uint64 FillStart;
+		shared_ptr <VolumeHeader> Header;
+		uint64 NewDataSize;
+		shared_ptr <VolumeExpansionOptions> Options;
+		shared_ptr <Exception> ThreadException;
+		shared_ptr <File> VolumeFile;
+		SharedVal <uint64> SizeDone;
+		ProgressInfo mProgressInfo;
+
+	private:
+		VolumeExpander (const VolumeExpander &);
+		VolumeExpander &operator= (const VolumeExpander &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeExpander
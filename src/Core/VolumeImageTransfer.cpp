@@ -0,0 +1,393 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifdef TC_UNIX
+#include <unistd.h>
+#endif
+
+#include "Platform/Time.h"
+#include "VolumeImageTransfer.h"
+
+namespace Basalt
+{
+	VolumeImageTransfer::VolumeImageTransfer ()
+		: AbortRequested (false), ChunkTotal (0), Exporting (false), NextChunk (0), SizeDone (0), StartTime (0), TransferThreadStarted (false)
+	{
+		mProgressInfo.TransferInProgress = false;
+		mProgressInfo.TotalSize = 0;
+		mProgressInfo.SizeDone = 0;
+		mProgressInfo.BytesPerSecond = 0;
+	}
+
+	VolumeImageTransfer::~VolumeImageTransfer ()
+	{
+		if (TransferThreadStarted)
+		{
+			Abort();
+			TransferThreadHandle.Join();
+		}
+	}
+
+	void VolumeImageTransfer::Abort ()
+	{
+		AbortRequested = true;
+		WakeAll();
+	}
+
+	void VolumeImageTransfer::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	void VolumeImageTransfer::ExportChunks ()
+	{
+		for (uint64 index = 0; index < ChunkTotal; ++index)
+		{
+			Chunk &chunk = Chunks[index % ChunkCount];
+			if (!WaitForChunk (chunk, index, true))
+				return;
+
+			ImageFile.Write (chunk.Data.GetRange (0, chunk.Length));
+			ReleaseChunk (chunk);
+		}
+	}
+
+	void VolumeImageTransfer::ExportVolume (shared_ptr <Volume> volume, const FilePath &imagePath)
+	{
+		Start (volume, imagePath, true);
+	}
+
+	void VolumeImageTransfer::FailTransfer (Exception *exception)
+	{
+		{
+			ScopeLock lock (ChunkMutex);
+
+			// The first failure is reported; the others are usually caused by it
+			if (!ThreadException)
+				ThreadException.reset (exception);
+			else
+				delete exception;
+		}
+
+		Abort();
+	}
+
+	VolumeImageTransfer::ProgressInfo VolumeImageTransfer::GetProgressInfo ()
+	{
+		mProgressInfo.SizeDone = SizeDone.Get();
+
+		// Time is measured in units of 100 ns
+		uint64 elapsed = Time::GetCurrent() - StartTime;
+		if (mProgressInfo.TransferInProgress && elapsed > 0)
+			mProgressInfo.BytesPerSecond = (uint64) (mProgressInfo.SizeDone * 10000000.0 / elapsed);
+
+		return mProgressInfo;
+	}
+
+	void VolumeImageTransfer::ImportChunks ()
+	{
+		uint64 volumeSize = TransferVolume->GetSize();
+		size_t sectorSize = TransferVolume->GetSectorSize();
+
+		for (uint64 index = 0; ; ++index)
+		{
+			Chunk &chunk = Chunks[index % ChunkCount];
+			if (!WaitForChunk (chunk, index, false))
+				return;
+
+			// Pipes return data in pieces
+			size_t length = 0;
+			while (length < ChunkSize && !AbortRequested)
+			{
+				size_t dataRead = (size_t) ImageFile.Read (chunk.Data.GetRange (length, ChunkSize - length));
+				if (dataRead == 0)
+					break;
+
+				length += dataRead;
+			}
+
+			if (AbortRequested)
+				return;
+
+			if (length % sectorSize != 0)
+			{
+				size_t paddedLength = length + sectorSize - length % sectorSize;
+				chunk.Data.GetRange (length, paddedLength - length).Zero();
+				length = paddedLength;
+			}
+
+			if (index * ChunkSize + length > volumeSize)
+				throw ParameterIncorrect (SRC_POS);
+
+			bool endOfImage = length < ChunkSize;
+			{
+				ScopeLock lock (ChunkMutex);
+
+				if (length > 0)
+				{
+					chunk.Length = length;
+					chunk.Filled = true;
+					chunk.FilledEvent.Signal();
+				}
+
+				if (endOfImage)
+					ChunkTotal = length > 0 ? index + 1 : index;
+			}
+
+			if (endOfImage)
+			{
+				// Workers waiting for chunks beyond the end of the image
+				WakeAll();
+				return;
+			}
+		}
+	}
+
+	void VolumeImageTransfer::ImportVolume (const FilePath &imagePath, shared_ptr <Volume> volume)
+	{
+		Start (volume, imagePath, false);
+	}
+
+	void VolumeImageTransfer::ReleaseChunk (Chunk &chunk)
+	{
+		ScopeLock lock (ChunkMutex);
+
+		SizeDone.Set (SizeDone.Get() + chunk.Length);
+
+		chunk.Filled = false;
+		chunk.Index += ChunkCount;
+		chunk.FreeEvent.Signal();
+	}
+
+	void VolumeImageTransfer::Start (shared_ptr <Volume> volume, const FilePath &imagePath, bool exportImage)
+	{
+		if (TransferThreadStarted || !volume)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (!exportImage && volume->GetProtectionType() == VolumeProtection::ReadOnly)
+			throw VolumeReadOnly (SRC_POS);
+
+#ifdef TC_UNIX
+		if (IsStandardStream (imagePath))
+			ImageFile.AssignSystemHandle (exportImage ? STDOUT_FILENO : STDIN_FILENO);
+		else
+#endif
+			ImageFile.Open (imagePath, exportImage ? File::CreateWrite : File::OpenRead);
+
+		ImagePath = imagePath;
+		TransferVolume = volume;
+		Exporting = exportImage;
+		AbortRequested = false;
+		NextChunk = 0;
+		SizeDone.Set (0);
+
+		if (exportImage)
+		{
+			mProgressInfo.TotalSize = volume->GetSize();
+			ChunkTotal = (volume->GetSize() + ChunkSize - 1) / ChunkSize;
+		}
+		else
+		{
+			mProgressInfo.TotalSize = IsStandardStream (imagePath) ? 0 : ImageFile.Length();
+			if (mProgressInfo.TotalSize > volume->GetSize())
+				throw ParameterIncorrect (SRC_POS);
+
+			// Known when the end of the image has been read
+			ChunkTotal = 0xffffFFFFffffFFFFULL;
+		}
+
+		for (size_t i = 0; i < ChunkCount; ++i)
+		{
+			if (Chunks[i].Data.IsAllocated())
+				Chunks[i].Data.Erase();
+			else
+				Chunks[i].Data.Allocate (ChunkSize);
+
+			Chunks[i].Filled = false;
+			Chunks[i].Index = i;
+			Chunks[i].Length = 0;
+		}
+
+		mProgressInfo.TransferInProgress = true;
+		mProgressInfo.BytesPerSecond = 0;
+		StartTime = Time::GetCurrent();
+
+		struct ThreadFunctor : public Functor
+		{
+			ThreadFunctor (VolumeImageTransfer *transfer) : Transfer (transfer) { }
+			virtual void operator() ()
+			{
+				Transfer->TransferThread ();
+			}
+			VolumeImageTransfer *Transfer;
+		};
+
+		try
+		{
+			TransferThreadHandle.Start (new ThreadFunctor (this));
+			TransferThreadStarted = true;
+		}
+		catch (...)
+		{
+			mProgressInfo.TransferInProgress = false;
+			throw;
+		}
+	}
+
+	void VolumeImageTransfer::TransferThread ()
+	{
+		struct WorkerThreadFunctor : public Functor
+		{
+			WorkerThreadFunctor (VolumeImageTransfer *transfer) : Transfer (transfer) { }
+			virtual void operator() ()
+			{
+				Transfer->WorkerThread ();
+			}
+			VolumeImageTransfer *Transfer;
+		};
+
+		Thread workers[WorkerCount];
+		size_t workersStarted = 0;
+
+		try
+		{
+			for (; workersStarted < WorkerCount; ++workersStarted)
+				workers[workersStarted].Start (new WorkerThreadFunctor (this));
+
+			if (Exporting)
+				ExportChunks();
+			else
+				ImportChunks();
+		}
+		catch (Exception &e)
+		{
+			FailTransfer (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			FailTransfer (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			FailTransfer (new UnknownException (SRC_POS));
+		}
+
+		for (size_t i = 0; i < workersStarted; ++i)
+			workers[i].Join();
+
+		try
+		{
+			if (!ThreadException && !AbortRequested)
+			{
+				if (Exporting)
+				{
+					if (!IsStandardStream (ImagePath))
+						ImageFile.Flush();
+				}
+				else
+				{
+					TransferVolume->GetFile()->Flush();
+				}
+			}
+		}
+		catch (Exception &e)
+		{
+			FailTransfer (e.CloneNew());
+		}
+
+		mProgressInfo.TransferInProgress = false;
+	}
+
+	bool VolumeImageTransfer::WaitForChunk (Chunk &chunk, uint64 index, bool filled)
+	{
+		// Events may have been signaled for an earlier state of the chunk
+		while (true)
+		{
+			{
+				ScopeLock lock (ChunkMutex);
+
+				if (AbortRequested || index >= ChunkTotal)
+					return false;
+
+				if (chunk.Index == index && chunk.Filled == filled)
+					return true;
+			}
+
+			if (filled)
+				chunk.FilledEvent.Wait();
+			else
+				chunk.FreeEvent.Wait();
+		}
+	}
+
+	void VolumeImageTransfer::WakeAll ()
+	{
+		for (size_t i = 0; i < ChunkCount; ++i)
+		{
+			Chunks[i].FilledEvent.Signal();
+			Chunks[i].FreeEvent.Signal();
+		}
+	}
+
+	void VolumeImageTransfer::WorkerThread ()
+	{
+		try
+		{
+			uint64 volumeSize = TransferVolume->GetSize();
+
+			while (true)
+			{
+				uint64 index;
+				{
+					ScopeLock lock (ChunkMutex);
+
+					if (AbortRequested || NextChunk >= ChunkTotal)
+						break;
+
+					index = NextChunk++;
+				}
+
+				// An exported chunk is filled when its buffer is free, an imported one is written when it is filled
+				Chunk &chunk = Chunks[index % ChunkCount];
+				if (!WaitForChunk (chunk, index, !Exporting))
+					break;
+
+				uint64 offset = index * ChunkSize;
+
+				if (Exporting)
+				{
+					size_t length = (size_t) (volumeSize - offset < ChunkSize ? volumeSize - offset : ChunkSize);
+					TransferVolume->ReadSectors (chunk.Data.GetRange (0, length), offset);
+
+					ScopeLock lock (ChunkMutex);
+					chunk.Length = length;
+					chunk.Filled = true;
+					chunk.FilledEvent.Signal();
+				}
+				else
+				{
+					TransferVolume->WriteSectors (chunk.Data.GetRange (0, chunk.Length), offset);
+					ReleaseChunk (chunk);
+				}
+			}
+		}
+		catch (Exception &e)
+		{
+			FailTransfer (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			FailTransfer (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			FailTransfer (new UnknownException (SRC_POS));
+		}
+	}
+}
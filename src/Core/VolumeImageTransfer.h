@@ -0,0 +1,97 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeImageTransfer
+#define TC_HEADER_Core_VolumeImageTransfer
+
+#include "Platform/Platform.h"
+#include "Platform/SharedVal.h"
+#include "Volume/Volume.h"
+
+namespace Basalt
+{
+	/*
+	 * Copies the data area of an open volume to a plaintext image, or a
+	 * plaintext image to the data area. The image may be a file or a pipe
+	 * (standard input/output). Chunks pass through a ring of buffers: worker
+	 * threads read and decrypt (or encrypt and write) chunks of the volume
+	 * while the transfer thread streams other chunks to or from the image,
+	 * so the host, the cipher and the image are busy at the same time.
+	 * Chunks are written to the image in order.
+	 */
+	class VolumeImageTransfer
+	{
+	public:
+		struct ProgressInfo
+		{
+			bool TransferInProgress;
+			uint64 TotalSize;		// Zero if the size of the image being imported is unknown
+			uint64 SizeDone;
+			uint64 BytesPerSecond;
+		};
+
+		VolumeImageTransfer ();
+		virtual ~VolumeImageTransfer ();
+
+		void Abort ();
+		void CheckResult ();
+		void ExportVolume (shared_ptr <Volume> volume, const FilePath &imagePath);
+		ProgressInfo GetProgressInfo ();
+		void ImportVolume (const FilePath &imagePath, shared_ptr <Volume> volume);
+		static bool IsStandardStream (const FilePath &imagePath) { return wstring (imagePath) == L"-"; }
+
+		static const size_t ChunkCount = 4;
+		static const size_t ChunkSize = 8 * 1024 * 1024;
+		static const size_t WorkerCount = 2;
+
+	protected:
+		struct Chunk
+		{
+			Chunk () : Filled (false), Index (0), Length (0) { }
+
+			SecureBuffer Data;
+			bool Filled;
+			SyncEvent FilledEvent;
+			SyncEvent FreeEvent;
+			uint64 Index;			// Next chunk of the image to pass through this buffer
+			size_t Length;
+		};
+
+		void ExportChunks ();
+		void FailTransfer (Exception *exception);
+		void ImportChunks ();
+		void ReleaseChunk (Chunk &chunk);
+		void Start (shared_ptr <Volume> volume, const FilePath &imagePath, bool exportImage);
+		void TransferThread ();
+		bool WaitForChunk (Chunk &chunk, uint64 index, bool filled);
+		void WakeAll ();
+		void WorkerThread ();
+
+		volatile bool AbortRequested;
+		Chunk Chunks[ChunkCount];
+		uint64 ChunkTotal;
+		Mutex ChunkMutex;
+		bool Exporting;
+		File ImageFile;
+		FilePath ImagePath;
+		uint64 NextChunk;
+		SharedVal <uint64> SizeDone;
+		uint64 StartTime;
+		shared_ptr <Exception> ThreadException;
+		shared_ptr <Volume> TransferVolume;
+		Thread TransferThreadHandle;
+		bool TransferThreadStarted;
+		ProgressInfo mProgressInfo;
+
+	private:
+		VolumeImageTransfer (const VolumeImageTransfer &);
+		VolumeImageTransfer &operator= (const VolumeImageTransfer &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeImageTransfer
@@ -0,0 +1,193 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <chrono>
+#include "Platform/FileStream.h"
+#include "Platform/MemoryStream.h"
+#include "Platform/Serializer.h"
+#include "VolumeKeyRotator.h"
+
+namespace Basalt
+{
+	VolumeKeyRotator::VolumeKeyRotator (shared_ptr <Volume> volume, shared_ptr <Functor> controlFunctor)
+		: ControlFunctor (controlFunctor), MaxBytesPerSecond (0), MountedVolume (volume), Paused (false), Running (false), StopRequested (false), ThreadStarted (false)
+	{
+		if (!MountedVolume)
+			throw ParameterIncorrect (SRC_POS);
+	}
+
+	VolumeKeyRotator::~VolumeKeyRotator ()
+	{
+		try
+		{
+			Stop();
+		}
+		catch (...) { }
+	}
+
+	void VolumeKeyRotator::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	VolumeKeyRotator::ProgressInfo VolumeKeyRotator::GetProgressInfo ()
+	{
+		ProgressInfo info;
+		info.KeyRotationInProgress = MountedVolume->IsKeyRotationInProgress();
+		info.MaxBytesPerSecond = MaxBytesPerSecond;
+		info.Paused = Paused;
+		info.SizeDone = MountedVolume->GetKeyRotationWatermark();
+		info.TotalSize = MountedVolume->GetSize();
+		return info;
+	}
+
+	void VolumeKeyRotator::KeyRotationThread ()
+	{
+		try
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			// Throttling measures the rate since it was last changed or the rotation was resumed
+			Clock::time_point rateStartTime = Clock::now();
+			uint64 rateSizeDone = 0;
+			uint64 rateMaxBytesPerSecond = MaxBytesPerSecond;
+			bool wasPaused = false;
+
+			while (!StopRequested)
+			{
+				if (ControlFunctor)
+					(*ControlFunctor) ();
+
+				if (Paused)
+				{
+					wasPaused = true;
+					Thread::Sleep (PollInterval);
+					continue;
+				}
+
+				if (wasPaused || rateMaxBytesPerSecond != MaxBytesPerSecond)
+				{
+					rateStartTime = Clock::now();
+					rateSizeDone = 0;
+					rateMaxBytesPerSecond = MaxBytesPerSecond;
+					wasPaused = false;
+				}
+
+				if (rateMaxBytesPerSecond != 0)
+				{
+					double elapsed = std::chrono::duration <double> (Clock::now() - rateStartTime).count();
+					double due = (double) rateSizeDone / rateMaxBytesPerSecond;
+
+					if (due > elapsed)
+					{
+						double delay = (due - elapsed) * 1000;
+						Thread::Sleep (delay < PollInterval ? (uint32) delay + 1 : PollInterval);
+						continue;
+					}
+				}
+
+				uint64 size = MountedVolume->RotateKeyChunk();
+				if (size == 0)
+				{
+					MountedVolume->FinishKeyRotation();
+					break;
+				}
+
+				rateSizeDone += size;
+			}
+		}
+		catch (Exception &e)
+		{
+			ThreadException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			ThreadException.reset (new UnknownException (SRC_POS));
+		}
+
+		Running = false;
+	}
+
+	KeyRotationControl VolumeKeyRotator::ReadControlFile (const FilePath &path)
+	{
+		shared_ptr <File> file (new File);
+		file->Open (path);
+
+		shared_ptr <Stream> stream (new FileStream (file));
+		Serializer sr (stream);
+
+		KeyRotationControl control;
+		sr.Deserialize ("MaxBytesPerSecond", control.MaxBytesPerSecond);
+		sr.Deserialize ("Paused", control.Paused);
+		return control;
+	}
+
+	void VolumeKeyRotator::Start ()
+	{
+		if (Running)
+			throw ParameterIncorrect (SRC_POS);
+
+		Stop();
+
+		if (!MountedVolume->IsKeyRotationInProgress())
+			throw ParameterIncorrect (SRC_POS);
+
+		StopRequested = false;
+		ThreadException.reset();
+		Running = true;
+
+		struct ThreadFunctor : public Functor
+		{
+			ThreadFunctor (VolumeKeyRotator *rotator) : Rotator (rotator) { }
+			virtual void operator() ()
+			{
+				Rotator->KeyRotationThread ();
+			}
+			VolumeKeyRotator *Rotator;
+		};
+
+		try
+		{
+			RotationThread.Start (new ThreadFunctor (this));
+			ThreadStarted = true;
+		}
+		catch (...)
+		{
+			Running = false;
+			throw;
+		}
+	}
+
+	void VolumeKeyRotator::Stop ()
+	{
+		if (!ThreadStarted)
+			return;
+
+		// The current chunk is completed and its watermark persisted before the thread exits
+		StopRequested = true;
+		RotationThread.Join();
+		ThreadStarted = false;
+	}
+
+	void VolumeKeyRotator::WriteControlFile (const FilePath &path, const KeyRotationControl &control)
+	{
+		shared_ptr <Stream> stream (new MemoryStream);
+		Serializer sr (stream);
+		sr.Serialize ("MaxBytesPerSecond", control.MaxBytesPerSecond);
+		sr.Serialize ("Paused", control.Paused);
+
+		File file;
+		file.Open (path, File::CreateWrite);
+		file.Write (dynamic_cast <MemoryStream&> (*stream));
+	}
+}
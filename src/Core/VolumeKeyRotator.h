@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeKeyRotator
+#define TC_HEADER_Core_VolumeKeyRotator
+
+#include "Platform/Platform.h"
+#include "Platform/Functor.h"
+#include "Platform/Thread.h"
+#include "Volume/Volume.h"
+
+namespace Basalt
+{
+	struct KeyRotationControl
+	{
+		KeyRotationControl () : MaxBytesPerSecond (0), Paused (false) { }
+
+		uint64 MaxBytesPerSecond; // 0 = unlimited
+		bool Paused;
+	};
+
+	/*
+	 * Re-encrypts the data area of a mounted volume with a new master key in the
+	 * background. The volume decrypts sectors below the watermark with the new key
+	 * and the rest with the old key (see Volume::BeginKeyRotation). Each call to
+	 * Volume::RotateKeyChunk moves the watermark by Volume::KeyRotationChunkSize
+	 * and persists it, so an interrupted rotation continues on the next mount.
+	 *
+	 * The optional control functor is called before each chunk, which allows the
+	 * owner to apply pause and throttling requests received from other processes.
+	 */
+	class VolumeKeyRotator
+	{
+	public:
+		struct ProgressInfo
+		{
+			bool KeyRotationInProgress;
+			uint64 MaxBytesPerSecond;
+			bool Paused;
+			uint64 SizeDone;
+			uint64 TotalSize;
+		};
+
+		VolumeKeyRotator (shared_ptr <Volume> volume, shared_ptr <Functor> controlFunctor = shared_ptr <Functor> ());
+		virtual ~VolumeKeyRotator ();
+
+		void CheckResult ();
+		static FilePath GetControlFilePath (const DirectoryPath &auxMountPoint) { return FilePath (wstring (auxMountPoint) + L".keyrotation"); }
+		ProgressInfo GetProgressInfo ();
+		bool IsRunning () const { return Running; }
+		void Pause () { Paused = true; }
+		static KeyRotationControl ReadControlFile (const FilePath &path);
+		void Resume () { Paused = false; }
+		void SetMaxBytesPerSecond (uint64 maxBytesPerSecond) { MaxBytesPerSecond = maxBytesPerSecond; }
+		void Start ();
+		void Stop ();
+		static void WriteControlFile (const FilePath &path, const KeyRotationControl &control);
+
+	protected:
+		void KeyRotationThread ();
+
+		static const uint32 PollInterval = 100; // ms
+
+		shared_ptr <Functor> ControlFunctor;
+		volatile uint64 MaxBytesPerSecond;
+		shared_ptr <Volume> MountedVolume;
+		volatile bool Paused;
+		volatile bool Running;
+		volatile bool StopRequested;
+		Thread RotationThread;
+		bool ThreadStarted;
+		shared_ptr <Exception> ThreadException;
+
+	private:
+		VolumeKeyRotator (const VolumeKeyRotator &);
+		VolumeKeyRotator &operator= (const VolumeKeyRotator &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeKeyRotator
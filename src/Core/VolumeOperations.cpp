@@ -428,6 +428,10 @@ namespace Basalt
 		if (mountedVolume->Pkcs5IterationCount <= 0 || mountedVolume->Pkcs5IterationCount >= 10000)
 			return false;
 
+		// Headers cannot be changed until key rotation completes
+		if (mountedVolume->KeyRotationInProgress)
+			return false;
+
 		// Argon2id variants use low t_cost (4) which is correct — not legacy
 		if (mountedVolume->Pkcs5PrfName == L"Argon2id" || mountedVolume->Pkcs5PrfName == L"Argon2id-Max")
 			return false;
@@ -0,0 +1,345 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "Volume/EncryptionModeLRW.h"
+#include "Volume/EncryptionModeXTS.h"
+#include "Volume/EncryptionTest.h"
+#include "Volume/EncryptionThreadPool.h"
+#include "Core.h"
+#include "VolumeReEncryptor.h"
+
+namespace Basalt
+{
+	VolumeReEncryptor::VolumeReEncryptor ()
+		: AbortRequested (false), DataSize (0), NewDataOffset (ReEncryptedDataOffset), RemainingSize (0), SizeDone (0)
+	{
+		mProgressInfo.ReEncryptionInProgress = false;
+		mProgressInfo.Resumed = false;
+		mProgressInfo.TotalSize = 0;
+	}
+
+	VolumeReEncryptor::~VolumeReEncryptor ()
+	{
+	}
+
+	void VolumeReEncryptor::Abort ()
+	{
+		AbortRequested = true;
+	}
+
+	void VolumeReEncryptor::CheckResult ()
+	{
+		if (ThreadException)
+			ThreadException->Throw();
+	}
+
+	void VolumeReEncryptor::Finalize ()
+	{
+		// The backup header has been completed by the last journal update.
+		// Replacing the old header makes the conversion final.
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		RandomNumberGenerator::GetData (salt);
+
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+		NewHeader->GetPkcs5Kdf()->DeriveKey (headerKey, *PasswordKey, salt);
+
+		WriteNewHeader (TC_VOLUME_HEADER_OFFSET, salt, headerKey);
+
+		// Space reserved for hidden volume header and the rest of the old data area
+		WriteFiller (TC_HIDDEN_VOLUME_HEADER_OFFSET, NewDataOffset - TC_HIDDEN_VOLUME_HEADER_OFFSET);
+
+		VolumeFile->Flush();
+	}
+
+	VolumeReEncryptor::ProgressInfo VolumeReEncryptor::GetProgressInfo ()
+	{
+		mProgressInfo.SizeDone = SizeDone.Get();
+		return mProgressInfo;
+	}
+
+	void VolumeReEncryptor::ReEncryptionThread ()
+	{
+		try
+		{
+			// A chunk must not be larger than the distance the data area moves. Its
+			// destination then only overlaps source data which has already been
+			// converted and journaled.
+			const uint64 oldDataOffset = TC_VOLUME_HEADER_SIZE_LEGACY;
+			const size_t sectorSize = TC_SECTOR_SIZE_LEGACY;
+
+			SecureBuffer buffer ((size_t) (NewDataOffset - oldDataOffset));
+
+			while (!AbortRequested && RemainingSize > 0)
+			{
+				uint64 length = buffer.Size();
+				if (length > RemainingSize)
+					length = RemainingSize;
+
+				uint64 offset = RemainingSize - length;
+				BufferPtr chunk = buffer.GetRange (0, (size_t) length);
+
+				if (VolumeFile->ReadAt (chunk, oldDataOffset + offset) != length)
+					throw MissingVolumeData (SRC_POS);
+
+				OldEA->ReEncryptSectors (chunk, (oldDataOffset + offset) / sectorSize, length / sectorSize, sectorSize,
+					*NewEA, (NewDataOffset + offset) / sectorSize);
+
+				VolumeFile->WriteAt (chunk, NewDataOffset + offset);
+				VolumeFile->Flush();
+
+				RemainingSize = offset;
+				WriteNewHeader (GetBackupHeaderOffset(), NewHeaderSalt, NewHeaderKey);
+				VolumeFile->Flush();
+
+				SizeDone.Set (DataSize - RemainingSize);
+			}
+
+			buffer.Erase();
+
+			if (!AbortRequested)
+				Finalize();
+		}
+		catch (Exception &e)
+		{
+			ThreadException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			ThreadException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			ThreadException.reset (new UnknownException (SRC_POS));
+		}
+
+		VolumeFile.reset();
+		mProgressInfo.ReEncryptionInProgress = false;
+	}
+
+	void VolumeReEncryptor::ReEncryptVolume (shared_ptr <VolumeReEncryptionOptions> options)
+	{
+		EncryptionTest::TestAll();
+
+		if (!options->EA || !options->VolumeHeaderKdf)
+			throw ParameterIncorrect (SRC_POS);
+
+		NewLayout.reset (new VolumeLayoutV2Normal());
+
+		bool eaSupported = false;
+		for (const auto &ea : NewLayout->GetSupportedEncryptionAlgorithms())
+		{
+			if (typeid (*ea) == typeid (*options->EA))
+				eaSupported = true;
+		}
+
+		if (!eaSupported || options->EA->IsDeprecated())
+			throw ParameterIncorrect (SRC_POS);
+
+		// The container has to grow, which is not possible for devices
+		if (options->Path.IsDevice())
+			throw ParameterIncorrect (SRC_POS);
+
+		VolumeFile.reset (new File);
+		VolumeFile->Open (options->Path, File::OpenReadWrite, File::ShareNone);
+
+		try
+		{
+			uint64 hostSize = VolumeFile->Length();
+			PasswordKey = Keyfile::ApplyListToPassword (options->Keyfiles, options->Password);
+
+			// Old header
+			shared_ptr <VolumeLayout> oldLayout (new VolumeLayoutV1Normal());
+			shared_ptr <VolumeHeader> oldHeader = oldLayout->GetHeader();
+			SecureBuffer oldHeaderBuffer (oldLayout->GetHeaderSize());
+
+			if (VolumeFile->ReadAt (oldHeaderBuffer, oldLayout->GetHeaderOffset()) != oldHeaderBuffer.Size()
+				|| !oldHeader->Decrypt (oldHeaderBuffer, *PasswordKey, oldLayout->GetSupportedKeyDerivationFunctions(),
+					oldLayout->GetSupportedEncryptionAlgorithms(), oldLayout->GetSupportedEncryptionModes()))
+			{
+				if (options->Keyfiles && !options->Keyfiles->empty())
+					throw PasswordKeyfilesIncorrect (SRC_POS);
+				throw PasswordIncorrect (SRC_POS);
+			}
+
+			// Headers of VolumeLayoutV2Normal share the location and can be decrypted as well
+			if (oldHeader->GetRequiredMinProgramVersion() >= 0x600)
+				throw ReEncryptionNotRequired (SRC_POS);
+
+			if (oldHeader->GetSectorSize() != TC_SECTOR_SIZE_LEGACY)
+				throw UnsupportedSectorSize (SRC_POS);
+
+			OldEA = oldHeader->GetEncryptionAlgorithm();
+			if (typeid (*OldEA->GetMode()) == typeid (EncryptionModeLRW))
+				OldEA->GetMode()->SetSectorOffset (TC_VOLUME_HEADER_SIZE_LEGACY / TC_SECTOR_SIZE_LEGACY);
+
+			if (oldHeader->GetFlags() & TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS)
+			{
+				DataSize = oldHeader->GetEncryptedAreaLength();
+			}
+			else
+			{
+				if (hostSize < TC_VOLUME_HEADER_SIZE_LEGACY + TC_SECTOR_SIZE_LEGACY)
+					throw ParameterIncorrect (SRC_POS);
+
+				DataSize = hostSize - TC_VOLUME_HEADER_SIZE_LEGACY;
+				DataSize -= DataSize % TC_SECTOR_SIZE_LEGACY;
+
+				if (DataSize > TC_MAX_VOLUME_SIZE)
+					throw ParameterIncorrect (SRC_POS);
+
+				// Prevent the volume from being mounted until the conversion is complete
+				oldHeader->SetFlags (oldHeader->GetFlags() | TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS);
+				oldHeader->SetEncryptedArea (TC_VOLUME_HEADER_SIZE_LEGACY, DataSize);
+
+				Core->ReEncryptVolumeHeaderWithNewSalt (oldHeaderBuffer, oldHeader, options->Password, options->Keyfiles);
+				VolumeFile->WriteAt (oldHeaderBuffer, oldLayout->GetHeaderOffset());
+				VolumeFile->Flush();
+			}
+
+			if (DataSize == 0 || DataSize % TC_SECTOR_SIZE_LEGACY != 0)
+				throw ParameterIncorrect (SRC_POS);
+
+			NewHeaderSalt.Allocate (VolumeHeader::GetSaltSize());
+			NewHeaderKey.Allocate (VolumeHeader::GetLargestSerializedKeySize());
+			NewHeader = NewLayout->GetHeader();
+
+			// Resume an interrupted conversion
+			bool resumed = false;
+			if (hostSize >= GetBackupHeaderOffset() + TC_VOLUME_HEADER_GROUP_SIZE)
+			{
+				SecureBuffer headerBuffer (NewLayout->GetHeaderSize());
+
+				if (VolumeFile->ReadAt (headerBuffer, GetBackupHeaderOffset()) == headerBuffer.Size()
+					&& NewHeader->Decrypt (headerBuffer, *PasswordKey, NewLayout->GetSupportedKeyDerivationFunctions(),
+						NewLayout->GetSupportedEncryptionAlgorithms(), NewLayout->GetSupportedEncryptionModes())
+					&& NewHeader->GetVolumeDataSize() == DataSize
+					&& NewHeader->GetEncryptedAreaStart() >= NewDataOffset
+					&& NewHeader->GetEncryptedAreaStart() + NewHeader->GetEncryptedAreaLength() == NewDataOffset + DataSize
+					&& NewHeader->GetEncryptedAreaLength() % TC_SECTOR_SIZE_LEGACY == 0)
+				{
+					NewHeaderSalt.CopyFrom (headerBuffer.GetRange (0, VolumeHeader::GetSaltSize()));
+					NewHeader->GetPkcs5Kdf()->DeriveKey (NewHeaderKey, *PasswordKey, NewHeaderSalt);
+
+					NewEA = NewHeader->GetEncryptionAlgorithm();
+					RemainingSize = NewHeader->GetEncryptedAreaStart() - NewDataOffset;
+					resumed = true;
+				}
+			}
+
+			if (!resumed)
+			{
+				RandomNumberGenerator::SetHash (options->VolumeHeaderKdf->GetHash());
+
+				SecureBuffer masterKey (options->EA->GetKeySize() * 2);
+				RandomNumberGenerator::GetData (masterKey);
+
+				RandomNumberGenerator::GetData (NewHeaderSalt);
+				options->VolumeHeaderKdf->DeriveKey (NewHeaderKey, *PasswordKey, NewHeaderSalt);
+
+				VolumeHeaderCreationOptions headerOptions;
+				headerOptions.EA = options->EA;
+				headerOptions.Kdf = options->VolumeHeaderKdf;
+				headerOptions.Type = VolumeType::Normal;
+				headerOptions.SectorSize = TC_SECTOR_SIZE_FILE_HOSTED_VOLUME;
+				headerOptions.VolumeDataStart = NewDataOffset;
+				headerOptions.VolumeDataSize = DataSize;
+				headerOptions.DataKey = masterKey;
+				headerOptions.Salt = NewHeaderSalt;
+				headerOptions.HeaderKey = NewHeaderKey;
+
+				SecureBuffer headerBuffer (NewLayout->GetHeaderSize());
+				NewHeader->Create (headerBuffer, headerOptions);
+
+				// Data area keys
+				NewEA = options->EA->GetNew();
+				NewEA->SetKey (masterKey.GetRange (0, NewEA->GetKeySize()));
+				shared_ptr <EncryptionMode> mode (new EncryptionModeXTS ());
+				mode->SetKey (masterKey.GetRange (NewEA->GetKeySize(), NewEA->GetKeySize()));
+				NewEA->SetMode (mode);
+
+				RemainingSize = DataSize;
+
+				// Allocate the space the container grows by before any data is moved
+				uint64 oldEndOffset = TC_VOLUME_HEADER_SIZE_LEGACY + DataSize;
+				WriteFiller (oldEndOffset, GetBackupHeaderOffset() + TC_VOLUME_HEADER_GROUP_SIZE - oldEndOffset);
+
+				WriteNewHeader (GetBackupHeaderOffset(), NewHeaderSalt, NewHeaderKey);
+				VolumeFile->Flush();
+			}
+
+			if (!EncryptionThreadPool::IsRunning())
+				EncryptionThreadPool::Start();
+
+			Options = options;
+			AbortRequested = false;
+			SizeDone.Set (DataSize - RemainingSize);
+
+			mProgressInfo.ReEncryptionInProgress = true;
+			mProgressInfo.Resumed = resumed;
+			mProgressInfo.TotalSize = DataSize;
+
+			struct ThreadFunctor : public Functor
+			{
+				ThreadFunctor (VolumeReEncryptor *reEncryptor) : ReEncryptor (reEncryptor) { }
+				virtual void operator() ()
+				{
+					ReEncryptor->ReEncryptionThread ();
+				}
+				VolumeReEncryptor *ReEncryptor;
+			};
+
+			Thread thread;
+			thread.Start (new ThreadFunctor (this));
+		}
+		catch (...)
+		{
+			VolumeFile.reset();
+			throw;
+		}
+	}
+
+	void VolumeReEncryptor::WriteFiller (uint64 offset, uint64 length)
+	{
+		shared_ptr <EncryptionAlgorithm> ea = NewEA->GetNew();
+		ea->SetMode (shared_ptr <EncryptionMode> (new EncryptionModeXTS ()));
+		Core->RandomizeEncryptionAlgorithmKey (ea);
+
+		SecureBuffer buffer (File::GetOptimalWriteSize());
+
+		while (length > 0)
+		{
+			uint64 fragmentLength = buffer.Size();
+			if (fragmentLength > length)
+				fragmentLength = length;
+
+			BufferPtr fragment = buffer.GetRange (0, (size_t) fragmentLength);
+			fragment.Zero();
+			ea->EncryptSectors (fragment, offset / ENCRYPTION_DATA_UNIT_SIZE, fragmentLength / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+			VolumeFile->WriteAt (fragment, offset);
+
+			offset += fragmentLength;
+			length -= fragmentLength;
+		}
+	}
+
+	void VolumeReEncryptor::WriteNewHeader (uint64 offset, const ConstBufferPtr &salt, const ConstBufferPtr &headerKey)
+	{
+		// EncryptedAreaStart/Length describe the part of the data area converted so far
+		uint32 flags = NewHeader->GetFlags() & ~TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS;
+		if (RemainingSize > 0)
+			flags |= TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS;
+
+		NewHeader->SetFlags (flags);
+		NewHeader->SetEncryptedArea (NewDataOffset + RemainingSize, DataSize - RemainingSize);
+
+		SecureBuffer headerBuffer (NewLayout->GetHeaderSize());
+		NewHeader->EncryptNew (headerBuffer, salt, headerKey, shared_ptr <Pkcs5Kdf> ());
+
+		VolumeFile->WriteAt (headerBuffer, offset);
+	}
+}
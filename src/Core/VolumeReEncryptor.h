@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Core_VolumeReEncryptor
+#define TC_HEADER_Core_VolumeReEncryptor
+
+#include "Platform/Platform.h"
+#include "Volume/Volume.h"
+#include "Volume/VolumeLayout.h"
+#include "RandomNumberGenerator.h"
+
+namespace Basalt
+{
+	struct VolumeReEncryptionOptions
+	{
+		VolumePath Path;
+		shared_ptr <VolumePassword> Password;
+		shared_ptr <KeyfileList> Keyfiles;
+		shared_ptr <Pkcs5Kdf> VolumeHeaderKdf;
+		shared_ptr <EncryptionAlgorithm> EA;
+	};
+
+	/*
+	 * Converts a legacy volume (VolumeLayoutV1Normal: 512-byte header, data at
+	 * offset 512, LRW/CBC/XTS with any cipher) in place to VolumeLayoutV2Normal
+	 * with XTS and a 128-bit block cipher.
+	 *
+	 * The data area is moved towards the end of the container in chunks no
+	 * larger than the distance it moves, so a chunk never overwrites data that
+	 * has not been re-encrypted yet. Progress is journaled in the new header,
+	 * which is kept at the backup header location until the conversion completes
+	 * (EncryptedAreaStart/Length describe the converted part). The old header
+	 * is flagged with TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS, which prevents
+	 * the volume from being mounted, and keeps the old master key available for
+	 * resuming an interrupted conversion. The container grows by
+	 * ReEncryptedDataOffset - TC_VOLUME_HEADER_SIZE_LEGACY + TC_VOLUME_HEADER_GROUP_SIZE.
+	 */
+	class VolumeReEncryptor
+	{
+	public:
+
+		struct ProgressInfo
+		{
+			bool ReEncryptionInProgress;
+			bool Resumed;
+			uint64 TotalSize;
+			uint64 SizeDone;
+		};
+
+		VolumeReEncryptor ();
+		virtual ~VolumeReEncryptor ();
+
+		void Abort ();
+		void CheckResult ();
+		ProgressInfo GetProgressInfo ();
+		void ReEncryptVolume (shared_ptr <VolumeReEncryptionOptions> options);
+
+		static const uint64 ReEncryptedDataOffset = 4 * BYTES_PER_MB;
+
+	protected:
+		void Finalize ();
+		uint64 GetBackupHeaderOffset () const { return NewDataOffset + DataSize; }
+		void ReEncryptionThread ();
+		void WriteFiller (uint64 offset, uint64 length);
+		void WriteNewHeader (uint64 offset, const ConstBufferPtr &salt, const ConstBufferPtr &headerKey);
+
+		volatile bool AbortRequested;
+		uint64 DataSize;
+		uint64 NewDataOffset;
+		shared_ptr <VolumeReEncryptionOptions> Options;
+		uint64 RemainingSize;
+		shared_ptr <Exception> ThreadException;
+
+		shared_ptr <EncryptionAlgorithm> NewEA;
+		shared_ptr <VolumeHeader> NewHeader;
+		SecureBuffer NewHeaderKey;
+		SecureBuffer NewHeaderSalt;
+		shared_ptr <VolumeLayout> NewLayout;
+		shared_ptr <EncryptionAlgorithm> OldEA;
+		shared_ptr <VolumePassword> PasswordKey;
+		shared_ptr <File> VolumeFile;
+		SharedVal <uint64> SizeDone;
+		ProgressInfo mProgressInfo;
+
+	private:
+		VolumeReEncryptor (const VolumeReEncryptor &);
+		VolumeReEncryptor &operator= (const VolumeReEncryptor &);
+	};
+}
+
+#endif // TC_HEADER_Core_VolumeReEncryptor
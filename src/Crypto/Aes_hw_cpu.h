@@ -11,6 +11,15 @@
 
 #include "Common/Tcdefs.h"
 
+#if ((defined (TC_ARCH_X86) || defined (TC_ARCH_X64) || defined (__x86_64__) || defined (_M_X64)) && !defined (__ppc__)) \
+	|| (defined (__aarch64__) && (defined (__ARM_FEATURE_CRYPTO) || defined (__ARM_FEATURE_AES)))
+#	define TC_AES_HW_CPU
+#endif
+
+#if (defined (__x86_64__) && (defined (__GNUC__) || defined (__clang__)))
+#	define TC_AES_HW_VAES
+#endif
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -23,6 +32,15 @@ void aes_hw_cpu_decrypt_32_blocks (const byte *ks, byte *data);
 void aes_hw_cpu_encrypt (const byte *ks, byte *data);
 void aes_hw_cpu_encrypt_32_blocks (const byte *ks, byte *data);
 
+#ifdef TC_AES_HW_VAES
+void aes_ctr_vaes256_generate (const byte *ks, byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount);
+void aes_ctr_vaes512_generate (const byte *ks, byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount);
+void aes_xts_vaes256_decrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+void aes_xts_vaes256_encrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+void aes_xts_vaes512_decrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+void aes_xts_vaes512_encrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -19,6 +19,7 @@
 
 #include <arm_neon.h>
 #include "Aes.h"
+#include "Cpu.h"
 
 /* Number of AES rounds for AES-256 */
 #define AES256_ROUNDS 14
@@ -31,8 +32,7 @@ static inline uint8x16_t load_round_key (const uint32_t *ks, int round)
 
 byte is_aes_hw_cpu_supported (void)
 {
-	/* Apple Silicon always supports ARMv8 Crypto Extensions */
-	return 1;
+	return (cpu_detect_features() & CPU_FEATURE_ARM_AES) ? 1 : 0;
 }
 
 void aes_hw_cpu_enable_sse (void)
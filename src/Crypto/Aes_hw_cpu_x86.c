@@ -0,0 +1,158 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ x86-64 hardware AES acceleration using AES-NI intrinsics.
+
+ Drop-in replacement for Aes_hw_cpu.asm in builds without an assembler
+ (NOASM=1, which includes the x86_64 slice of the universal build). The
+ functions are compiled for AES-NI regardless of the baseline target, so
+ they must only be called when the CPU supports it (see Crypto/Cpu.h).
+
+ Key schedule format is identical to the software implementation:
+   aes_encrypt_ctx: 60 x uint32 round keys + 4-byte info (inf.b[0] = rounds*16)
+   aes_decrypt_ctx: same layout, with AES_REV_DKS (reversed key order, with
+   InvMixColumns applied to the inner round keys as AESDEC expects)
+*/
+
+#include "Common/Tcdefs.h"
+
+#if defined (__x86_64__) || defined (_M_X64)
+
+#include <wmmintrin.h>
+#include "Aes.h"
+#include "Aes_hw_cpu.h"
+#include "Cpu.h"
+
+#if defined (_MSC_VER)
+#	define TC_AES_NI_TARGET
+#else
+#	define TC_AES_NI_TARGET __attribute__ ((target ("aes,sse2")))
+#endif
+
+#define AES_HW_PARALLEL_BLOCKS 8
+
+static int aes_hw_rounds (const byte *ks)
+{
+	int rounds = ks[sizeof (aes_encrypt_ctx) - 4] / 16;
+	return rounds == 0 ? 14 : rounds;
+}
+
+byte is_aes_hw_cpu_supported (void)
+{
+	return (cpu_detect_features() & CPU_FEATURE_AESNI) ? 1 : 0;
+}
+
+void aes_hw_cpu_enable_sse (void)
+{
+	/* SSE is always enabled in 64-bit mode */
+}
+
+TC_AES_NI_TARGET
+static void aes_hw_encrypt_blocks (const byte *ks, byte *data, size_t blockCount)
+{
+	const __m128i *rk = (const __m128i *) ks;
+	int rounds = aes_hw_rounds (ks);
+	__m128i b[AES_HW_PARALLEL_BLOCKS];
+	int r, i;
+
+	while (blockCount >= AES_HW_PARALLEL_BLOCKS)
+	{
+		__m128i k = _mm_loadu_si128 (rk);
+		for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+			b[i] = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) data + i), k);
+
+		for (r = 1; r < rounds; ++r)
+		{
+			k = _mm_loadu_si128 (rk + r);
+			for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+				b[i] = _mm_aesenc_si128 (b[i], k);
+		}
+
+		k = _mm_loadu_si128 (rk + rounds);
+		for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+			_mm_storeu_si128 ((__m128i *) data + i, _mm_aesenclast_si128 (b[i], k));
+
+		data += AES_HW_PARALLEL_BLOCKS * 16;
+		blockCount -= AES_HW_PARALLEL_BLOCKS;
+	}
+
+	while (blockCount-- > 0)
+	{
+		__m128i s = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) data), _mm_loadu_si128 (rk));
+
+		for (r = 1; r < rounds; ++r)
+			s = _mm_aesenc_si128 (s, _mm_loadu_si128 (rk + r));
+
+		_mm_storeu_si128 ((__m128i *) data, _mm_aesenclast_si128 (s, _mm_loadu_si128 (rk + rounds)));
+		data += 16;
+	}
+}
+
+TC_AES_NI_TARGET
+static void aes_hw_decrypt_blocks (const byte *ks, byte *data, size_t blockCount)
+{
+	const __m128i *rk = (const __m128i *) ks;
+	int rounds = aes_hw_rounds (ks);
+	__m128i b[AES_HW_PARALLEL_BLOCKS];
+	int r, i;
+
+	while (blockCount >= AES_HW_PARALLEL_BLOCKS)
+	{
+		__m128i k = _mm_loadu_si128 (rk);
+		for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+			b[i] = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) data + i), k);
+
+		for (r = 1; r < rounds; ++r)
+		{
+			k = _mm_loadu_si128 (rk + r);
+			for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+				b[i] = _mm_aesdec_si128 (b[i], k);
+		}
+
+		k = _mm_loadu_si128 (rk + rounds);
+		for (i = 0; i < AES_HW_PARALLEL_BLOCKS; ++i)
+			_mm_storeu_si128 ((__m128i *) data + i, _mm_aesdeclast_si128 (b[i], k));
+
+		data += AES_HW_PARALLEL_BLOCKS * 16;
+		blockCount -= AES_HW_PARALLEL_BLOCKS;
+	}
+
+	while (blockCount-- > 0)
+	{
+		__m128i s = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *) data), _mm_loadu_si128 (rk));
+
+		for (r = 1; r < rounds; ++r)
+			s = _mm_aesdec_si128 (s, _mm_loadu_si128 (rk + r));
+
+		_mm_storeu_si128 ((__m128i *) data, _mm_aesdeclast_si128 (s, _mm_loadu_si128 (rk + rounds)));
+		data += 16;
+	}
+}
+
+void aes_hw_cpu_encrypt (const byte *ks, byte *data)
+{
+	aes_hw_encrypt_blocks (ks, data, 1);
+}
+
+void aes_hw_cpu_decrypt (const byte *ks, byte *data)
+{
+	aes_hw_decrypt_blocks (ks, data, 1);
+}
+
+void aes_hw_cpu_encrypt_32_blocks (const byte *ks, byte *data)
+{
+	aes_hw_encrypt_blocks (ks, data, 32);
+}
+
+void aes_hw_cpu_decrypt_32_blocks (const byte *ks, byte *data)
+{
+	aes_hw_decrypt_blocks (ks, data, 32);
+}
+
+#endif /* __x86_64__ || _M_X64 */
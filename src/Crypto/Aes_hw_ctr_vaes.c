@@ -0,0 +1,158 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ AES-CTR keystream kernels for x86-64 CPUs with VAES, used by the bulk random
+ bit generator (Core/RandomBitGenerator.cpp).
+
+ The output is the encryption of consecutive 128-bit big-endian counter
+ blocks, starting with counterHigh:counterLow. Counters are kept in host
+ order in the 128-bit lanes, incremented with 64-bit additions and converted
+ to big-endian with a byte shuffle. A batch in which the low half of the
+ counter would wrap, and the final partial batch, are built in memory.
+
+ The functions are compiled for their instruction sets regardless of the
+ baseline target and must only be called when the CPU supports them (see
+ Crypto/Cpu.h and Crypto/CryptoDispatch.h). ks is the encryption schedule
+ of Aescrypt.c/Aeskey.c (see Aes_hw_cpu_x86.c).
+*/
+
+#include "Aes_hw_cpu.h"
+
+#ifdef TC_AES_HW_VAES
+
+#include <immintrin.h>
+#include "Aes.h"
+#include "Common/Crypto.h"
+
+#define TC_VAES512_TARGET __attribute__ ((target ("avx512f,avx512vl,avx2,vaes,aes")))
+#define TC_VAES256_TARGET __attribute__ ((target ("avx2,vaes,aes")))
+
+#define CTR_BLOCK_SIZE 16
+#define CTR_REGS 8
+
+static int aes_ctr_rounds (const byte *ks)
+{
+	int rounds = ks[sizeof (aes_encrypt_ctx) - 4] / 16;
+	return rounds == 0 ? 14 : rounds;
+}
+
+/* Writes blockCount big-endian counter blocks starting with counterHigh:counterLow */
+static void aes_ctr_fill_blocks (byte *blocks, uint64 counterHigh, uint64 counterLow, size_t blockCount)
+{
+	size_t i;
+	int j;
+
+	for (i = 0; i < blockCount; ++i)
+	{
+		for (j = 0; j < 8; ++j)
+		{
+			blocks[i * CTR_BLOCK_SIZE + j] = (byte) (counterHigh >> (56 - j * 8));
+			blocks[i * CTR_BLOCK_SIZE + 8 + j] = (byte) (counterLow >> (56 - j * 8));
+		}
+
+		if (++counterLow == 0)
+			++counterHigh;
+	}
+}
+
+/* Host-order lanes (low half in the first quadword) to big-endian blocks */
+TC_VAES256_TARGET
+static inline __m256i aes_ctr_to_big_endian_256 (__m256i counters)
+{
+	const __m256i reverse = _mm256_set_epi8 (
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+	return _mm256_shuffle_epi8 (counters, reverse);
+}
+
+#define AES_CTR_VAES_GENERATE(REG, BLOCKS_PER_REG, BROADCAST, XOR, AESENC, AESENCLAST, LOADU, STOREU, COUNTERS) \
+{ \
+	const __m128i *rk = (const __m128i *) ks; \
+	const uint64 batchBlocks = CTR_REGS * BLOCKS_PER_REG; \
+	int rounds = aes_ctr_rounds (ks); \
+	REG k[15], b[CTR_REGS]; \
+	byte batch[CTR_REGS * BLOCKS_PER_REG * CTR_BLOCK_SIZE]; \
+	int r, i; \
+\
+	for (r = 0; r <= rounds; ++r) \
+		k[r] = BROADCAST (_mm_loadu_si128 (rk + r)); \
+\
+	while (blockCount > 0) \
+	{ \
+		uint64 n = blockCount < batchBlocks ? blockCount : batchBlocks; \
+\
+		if (n == batchBlocks && counterLow <= (uint64) -1 - batchBlocks) \
+		{ \
+			for (i = 0; i < CTR_REGS; ++i) \
+				b[i] = XOR (COUNTERS (counterHigh, counterLow + (uint64) i * BLOCKS_PER_REG), k[0]); \
+		} \
+		else \
+		{ \
+			aes_ctr_fill_blocks (batch, counterHigh, counterLow, (size_t) n); \
+			for (i = 0; i < CTR_REGS; ++i) \
+				b[i] = XOR (LOADU ((const void *) (batch + i * BLOCKS_PER_REG * CTR_BLOCK_SIZE)), k[0]); \
+		} \
+\
+		for (r = 1; r < rounds; ++r) \
+		{ \
+			for (i = 0; i < CTR_REGS; ++i) \
+				b[i] = AESENC (b[i], k[r]); \
+		} \
+\
+		if (n == batchBlocks) \
+		{ \
+			for (i = 0; i < CTR_REGS; ++i) \
+				STOREU ((void *) (data + i * BLOCKS_PER_REG * CTR_BLOCK_SIZE), AESENCLAST (b[i], k[rounds])); \
+		} \
+		else \
+		{ \
+			for (i = 0; i < CTR_REGS; ++i) \
+				STOREU ((void *) (batch + i * BLOCKS_PER_REG * CTR_BLOCK_SIZE), AESENCLAST (b[i], k[rounds])); \
+			memcpy (data, batch, (size_t) n * CTR_BLOCK_SIZE); \
+		} \
+\
+		data += n * CTR_BLOCK_SIZE; \
+		blockCount -= n; \
+		counterLow += n; \
+		if (counterLow < n) \
+			++counterHigh; \
+	} \
+\
+	burn (k, sizeof (k)); \
+	burn (b, sizeof (b)); \
+	burn (batch, sizeof (batch)); \
+}
+
+TC_VAES512_TARGET
+static inline __m512i aes_ctr_counters_512 (uint64 counterHigh, uint64 counterLow)
+{
+	__m256i lo = _mm256_set_epi64x ((long long) counterHigh, (long long) (counterLow + 1), (long long) counterHigh, (long long) counterLow);
+	__m256i hi = _mm256_set_epi64x ((long long) counterHigh, (long long) (counterLow + 3), (long long) counterHigh, (long long) (counterLow + 2));
+
+	return _mm512_inserti64x4 (_mm512_castsi256_si512 (aes_ctr_to_big_endian_256 (lo)), aes_ctr_to_big_endian_256 (hi), 1);
+}
+
+TC_VAES256_TARGET
+static inline __m256i aes_ctr_counters_256 (uint64 counterHigh, uint64 counterLow)
+{
+	return aes_ctr_to_big_endian_256 (_mm256_set_epi64x ((long long) counterHigh, (long long) (counterLow + 1), (long long) counterHigh, (long long) counterLow));
+}
+
+TC_VAES512_TARGET
+void aes_ctr_vaes512_generate (const byte *ks, byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount)
+AES_CTR_VAES_GENERATE (__m512i, 4, _mm512_broadcast_i32x4, _mm512_xor_si512, _mm512_aesenc_epi128, _mm512_aesenclast_epi128,
+	_mm512_loadu_si512, _mm512_storeu_si512, aes_ctr_counters_512)
+
+TC_VAES256_TARGET
+void aes_ctr_vaes256_generate (const byte *ks, byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount)
+AES_CTR_VAES_GENERATE (__m256i, 2, _mm256_broadcastsi128_si256, _mm256_xor_si256, _mm256_aesenc_epi128, _mm256_aesenclast_epi128,
+	_mm256_loadu_si256, _mm256_storeu_si256, aes_ctr_counters_256)
+
+#endif // TC_AES_HW_VAES
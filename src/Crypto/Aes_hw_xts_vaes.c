@@ -0,0 +1,244 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ AES-XTS kernels for x86-64 CPUs with VAES and VPCLMULQDQ.
+
+ The 512-bit kernel (AVX-512) encrypts a whole XTS data unit (32 blocks) with
+ 8 zmm registers, 4 blocks per instruction. The 256-bit kernel (AVX2-class
+ CPUs with VAES, e.g. AMD Zen 3) processes half a data unit at a time in 8
+ ymm registers. Tweaks of consecutive blocks are derived in parallel: each
+ lane is multiplied by x^4 (or x^2) in GF(2^128) with a shift and a carry-less
+ multiplication of the carried-out bits by the reduction polynomial. The
+ initial tweaks of four data units are encrypted together.
+
+ The functions are compiled for their instruction sets regardless of the
+ baseline target and must only be called when the CPU supports them (see
+ Crypto/Cpu.h and Crypto/CryptoDispatch.h).
+
+ Key schedules are those of Aescrypt.c/Aeskey.c (see Aes_hw_cpu_x86.c).
+ ks is the encryption schedule when encrypting and the decryption schedule
+ when decrypting; tweakKs is always the encryption schedule of the
+ secondary key.
+*/
+
+#include "Aes_hw_cpu.h"
+
+#ifdef TC_AES_HW_VAES
+
+#include <immintrin.h>
+#include "Aes.h"
+#include "Common/Crypto.h"
+
+#define TC_VAES512_TARGET __attribute__ ((target ("avx512f,avx512vl,vaes,vpclmulqdq,aes,pclmul")))
+#define TC_VAES256_TARGET __attribute__ ((target ("avx2,vaes,vpclmulqdq,aes,pclmul")))
+
+#define XTS_GF_POLYNOMIAL 0x87
+#define XTS_TWEAK_BATCH 4
+
+static int aes_xts_rounds (const byte *ks)
+{
+	int rounds = ks[sizeof (aes_encrypt_ctx) - 4] / 16;
+	return rounds == 0 ? 14 : rounds;
+}
+
+/* Multiplies a tweak by x in GF(2^128) */
+__attribute__ ((target ("pclmul")))
+static inline __m128i xts_mul_x_128 (__m128i t)
+{
+	__m128i carry = _mm_srli_epi64 (t, 63);
+	__m128i r = _mm_xor_si128 (_mm_slli_epi64 (t, 1), _mm_unpacklo_epi64 (_mm_setzero_si128(), carry));
+	return _mm_xor_si128 (r, _mm_clmulepi64_si128 (carry, _mm_cvtsi32_si128 (XTS_GF_POLYNOMIAL), 0x01));
+}
+
+/* Encrypts four consecutive data unit numbers with the tweak key */
+TC_VAES512_TARGET
+static void xts_vaes512_initial_tweaks (const byte *tweakKs, uint64 dataUnitNo, __m128i *tweaks)
+{
+	const __m128i *rk = (const __m128i *) tweakKs;
+	int rounds = aes_xts_rounds (tweakKs);
+	int r;
+
+	__m512i t = _mm512_set_epi64 (0, (long long) (dataUnitNo + 3), 0, (long long) (dataUnitNo + 2),
+		0, (long long) (dataUnitNo + 1), 0, (long long) dataUnitNo);
+
+	t = _mm512_xor_si512 (t, _mm512_broadcast_i32x4 (_mm_loadu_si128 (rk)));
+	for (r = 1; r < rounds; ++r)
+		t = _mm512_aesenc_epi128 (t, _mm512_broadcast_i32x4 (_mm_loadu_si128 (rk + r)));
+	t = _mm512_aesenclast_epi128 (t, _mm512_broadcast_i32x4 (_mm_loadu_si128 (rk + rounds)));
+
+	_mm512_storeu_si512 ((void *) tweaks, t);
+}
+
+TC_VAES256_TARGET
+static void xts_vaes256_initial_tweaks (const byte *tweakKs, uint64 dataUnitNo, __m128i *tweaks)
+{
+	const __m128i *rk = (const __m128i *) tweakKs;
+	int rounds = aes_xts_rounds (tweakKs);
+	int r;
+
+	__m256i t0 = _mm256_set_epi64x (0, (long long) (dataUnitNo + 1), 0, (long long) dataUnitNo);
+	__m256i t1 = _mm256_set_epi64x (0, (long long) (dataUnitNo + 3), 0, (long long) (dataUnitNo + 2));
+	__m256i k = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (rk));
+
+	t0 = _mm256_xor_si256 (t0, k);
+	t1 = _mm256_xor_si256 (t1, k);
+	for (r = 1; r < rounds; ++r)
+	{
+		k = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (rk + r));
+		t0 = _mm256_aesenc_epi128 (t0, k);
+		t1 = _mm256_aesenc_epi128 (t1, k);
+	}
+	k = _mm256_broadcastsi128_si256 (_mm_loadu_si128 (rk + rounds));
+	t0 = _mm256_aesenclast_epi128 (t0, k);
+	t1 = _mm256_aesenclast_epi128 (t1, k);
+
+	_mm256_storeu_si256 ((__m256i *) tweaks, t0);
+	_mm256_storeu_si256 ((__m256i *) tweaks + 1, t1);
+}
+
+/* Multiplies the tweak in each 128-bit lane by x^4 */
+TC_VAES512_TARGET
+static inline __m512i xts_mul_x4_512 (__m512i t, __m512i poly)
+{
+	__m512i carry = _mm512_srli_epi64 (t, 60);
+	__m512i r = _mm512_xor_si512 (_mm512_slli_epi64 (t, 4), _mm512_unpacklo_epi64 (_mm512_setzero_si512(), carry));
+	return _mm512_xor_si512 (r, _mm512_clmulepi64_epi128 (carry, poly, 0x01));
+}
+
+/* Multiplies the tweak in each 128-bit lane by x^2 */
+TC_VAES256_TARGET
+static inline __m256i xts_mul_x2_256 (__m256i t, __m256i poly)
+{
+	__m256i carry = _mm256_srli_epi64 (t, 62);
+	__m256i r = _mm256_xor_si256 (_mm256_slli_epi64 (t, 2), _mm256_unpacklo_epi64 (_mm256_setzero_si256(), carry));
+	return _mm256_xor_si256 (r, _mm256_clmulepi64_epi128 (carry, poly, 0x01));
+}
+
+#define XTS_VAES512_BLOCKS_PER_REG 4
+#define XTS_VAES512_REGS (BLOCKS_PER_XTS_DATA_UNIT / XTS_VAES512_BLOCKS_PER_REG)
+
+#define XTS_VAES512_DATA_UNIT(NAME, ROUND, LAST_ROUND) \
+TC_VAES512_TARGET \
+static void NAME (const __m512i *k, int rounds, __m128i t, byte *data) \
+{ \
+	const __m512i poly = _mm512_set1_epi64 (XTS_GF_POLYNOMIAL); \
+	__m512i tw[XTS_VAES512_REGS], b[XTS_VAES512_REGS]; \
+	__m128i t1 = xts_mul_x_128 (t); \
+	__m128i t2 = xts_mul_x_128 (t1); \
+	__m128i t3 = xts_mul_x_128 (t2); \
+	int r, i; \
+\
+	tw[0] = _mm512_inserti32x4 (_mm512_inserti32x4 (_mm512_inserti32x4 (_mm512_castsi128_si512 (t), t1, 1), t2, 2), t3, 3); \
+	for (i = 1; i < XTS_VAES512_REGS; ++i) \
+		tw[i] = xts_mul_x4_512 (tw[i - 1], poly); \
+\
+	for (i = 0; i < XTS_VAES512_REGS; ++i) \
+		b[i] = _mm512_xor_si512 (_mm512_xor_si512 (_mm512_loadu_si512 ((const void *) (data + i * 64)), tw[i]), k[0]); \
+\
+	for (r = 1; r < rounds; ++r) \
+	{ \
+		for (i = 0; i < XTS_VAES512_REGS; ++i) \
+			b[i] = ROUND (b[i], k[r]); \
+	} \
+\
+	for (i = 0; i < XTS_VAES512_REGS; ++i) \
+		_mm512_storeu_si512 ((void *) (data + i * 64), _mm512_xor_si512 (LAST_ROUND (b[i], k[rounds]), tw[i])); \
+}
+
+XTS_VAES512_DATA_UNIT (xts_vaes512_encrypt_data_unit, _mm512_aesenc_epi128, _mm512_aesenclast_epi128)
+XTS_VAES512_DATA_UNIT (xts_vaes512_decrypt_data_unit, _mm512_aesdec_epi128, _mm512_aesdeclast_epi128)
+
+#define XTS_VAES256_BLOCKS_PER_REG 2
+#define XTS_VAES256_REGS 8		/* Half a data unit; 16 ymm registers are available without AVX-512 */
+
+#define XTS_VAES256_DATA_UNIT(NAME, ROUND, LAST_ROUND) \
+TC_VAES256_TARGET \
+static void NAME (const __m256i *k, int rounds, __m128i t, byte *data) \
+{ \
+	const __m256i poly = _mm256_set1_epi64x (XTS_GF_POLYNOMIAL); \
+	__m256i tw[XTS_VAES256_REGS], b[XTS_VAES256_REGS]; \
+	__m256i next = _mm256_inserti128_si256 (_mm256_castsi128_si256 (t), xts_mul_x_128 (t), 1); \
+	int half, r, i; \
+\
+	for (half = 0; half < 2; ++half) \
+	{ \
+		for (i = 0; i < XTS_VAES256_REGS; ++i) \
+		{ \
+			tw[i] = next; \
+			next = xts_mul_x2_256 (next, poly); \
+		} \
+\
+		for (i = 0; i < XTS_VAES256_REGS; ++i) \
+			b[i] = _mm256_xor_si256 (_mm256_xor_si256 (_mm256_loadu_si256 ((const __m256i *) data + i), tw[i]), k[0]); \
+\
+		for (r = 1; r < rounds; ++r) \
+		{ \
+			for (i = 0; i < XTS_VAES256_REGS; ++i) \
+				b[i] = ROUND (b[i], k[r]); \
+		} \
+\
+		for (i = 0; i < XTS_VAES256_REGS; ++i) \
+			_mm256_storeu_si256 ((__m256i *) data + i, _mm256_xor_si256 (LAST_ROUND (b[i], k[rounds]), tw[i])); \
+\
+		data += XTS_VAES256_REGS * XTS_VAES256_BLOCKS_PER_REG * BYTES_PER_XTS_BLOCK; \
+	} \
+}
+
+XTS_VAES256_DATA_UNIT (xts_vaes256_encrypt_data_unit, _mm256_aesenc_epi128, _mm256_aesenclast_epi128)
+XTS_VAES256_DATA_UNIT (xts_vaes256_decrypt_data_unit, _mm256_aesdec_epi128, _mm256_aesdeclast_epi128)
+
+#define XTS_VAES_PROCESS(WIDTH, REG, BROADCAST, DATA_UNIT) \
+{ \
+	const __m128i *rk = (const __m128i *) ks; \
+	int rounds = aes_xts_rounds (ks); \
+	REG k[15]; \
+	__m128i tweaks[XTS_TWEAK_BATCH]; \
+	int r; \
+\
+	for (r = 0; r <= rounds; ++r) \
+		k[r] = BROADCAST (_mm_loadu_si128 (rk + r)); \
+\
+	while (dataUnitCount > 0) \
+	{ \
+		uint64 batch = dataUnitCount < XTS_TWEAK_BATCH ? dataUnitCount : XTS_TWEAK_BATCH; \
+		uint64 i; \
+\
+		xts_vaes##WIDTH##_initial_tweaks (tweakKs, dataUnitNo, tweaks); \
+\
+		for (i = 0; i < batch; ++i) \
+		{ \
+			DATA_UNIT (k, rounds, _mm_loadu_si128 (tweaks + i), data); \
+			data += ENCRYPTION_DATA_UNIT_SIZE; \
+		} \
+\
+		dataUnitNo += batch; \
+		dataUnitCount -= batch; \
+	} \
+\
+	burn (k, sizeof (k)); \
+	burn (tweaks, sizeof (tweaks)); \
+}
+
+TC_VAES512_TARGET
+void aes_xts_vaes512_encrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount)
+XTS_VAES_PROCESS (512, __m512i, _mm512_broadcast_i32x4, xts_vaes512_encrypt_data_unit)
+
+TC_VAES512_TARGET
+void aes_xts_vaes512_decrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount)
+XTS_VAES_PROCESS (512, __m512i, _mm512_broadcast_i32x4, xts_vaes512_decrypt_data_unit)
+
+TC_VAES256_TARGET
+void aes_xts_vaes256_encrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount)
+XTS_VAES_PROCESS (256, __m256i, _mm256_broadcastsi128_si256, xts_vaes256_encrypt_data_unit)
+
+TC_VAES256_TARGET
+void aes_xts_vaes256_decrypt (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount)
+XTS_VAES_PROCESS (256, __m256i, _mm256_broadcastsi128_si256, xts_vaes256_decrypt_data_unit)
+
+#endif // TC_AES_HW_VAES
@@ -0,0 +1,325 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <stdatomic.h>
+#include "Cpu.h"
+
+#if defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)
+#	define TC_CPU_X86
+#	if defined (_MSC_VER)
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#elif defined (__aarch64__) || defined (_M_ARM64)
+#	define TC_CPU_ARM64
+#	if defined (__linux__)
+#		include <sys/auxv.h>
+#		include <asm/hwcap.h>
+#	endif
+#endif
+
+#if defined (__APPLE__)
+#	include <sys/sysctl.h>
+#endif
+
+static atomic_int CpuTier = CPU_TIER_AUTO;
+static atomic_uint DetectedFeatures;
+static atomic_int DetectionDone;
+
+static const uint32 TierFeatures[CPU_TIER_COUNT] =
+{
+	/* Generic */	0,
+	/* AES-NI */	CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI | CPU_FEATURE_PCLMUL | CPU_FEATURE_SHANI,
+	/* AVX2 */		CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI | CPU_FEATURE_PCLMUL | CPU_FEATURE_SHANI
+					| CPU_FEATURE_AVX | CPU_FEATURE_AVX2 | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ,
+	/* AVX-512 */	CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI | CPU_FEATURE_PCLMUL | CPU_FEATURE_SHANI
+					| CPU_FEATURE_AVX | CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512VL | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ,
+	/* ARMv8 */		CPU_FEATURE_NEON | CPU_FEATURE_ARM_AES | CPU_FEATURE_ARM_PMULL | CPU_FEATURE_ARM_SHA2 | CPU_FEATURE_ARM_SHA512
+};
+
+static const uint32 TierRequiredFeatures[CPU_TIER_COUNT] =
+{
+	/* Generic */	0,
+	/* AES-NI */	CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI,
+	/* AVX2 */		CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI | CPU_FEATURE_AVX | CPU_FEATURE_AVX2,
+	/* AVX-512 */	CPU_FEATURE_SSE41 | CPU_FEATURE_AESNI | CPU_FEATURE_AVX | CPU_FEATURE_AVX2 | CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512VL | CPU_FEATURE_VAES,
+	/* ARMv8 */		CPU_FEATURE_NEON | CPU_FEATURE_ARM_AES
+};
+
+static const char *TierNames[CPU_TIER_COUNT] =
+{
+	"Generic",
+	"AES-NI",
+	"AVX2",
+	"AVX-512",
+	"ARMv8"
+};
+
+#if defined (__APPLE__)
+
+static int cpu_sysctl_flag (const char *name, int *value)
+{
+	int v = 0;
+	size_t size = sizeof (v);
+
+	if (sysctlbyname (name, &v, &size, NULL, 0) != 0)
+		return 0;
+
+	*value = v;
+	return 1;
+}
+
+#endif
+
+#ifdef TC_CPU_X86
+
+static void cpu_cpuid (uint32 leaf, uint32 subleaf, uint32 *regs)
+{
+#if defined (_MSC_VER)
+	int r[4];
+	__cpuidex (r, (int) leaf, (int) subleaf);
+	regs[0] = (uint32) r[0];
+	regs[1] = (uint32) r[1];
+	regs[2] = (uint32) r[2];
+	regs[3] = (uint32) r[3];
+#else
+	__cpuid_count (leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64 cpu_xgetbv (void)
+{
+#if defined (_MSC_VER)
+	return _xgetbv (0);
+#else
+	uint32 eax, edx;
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((uint64) edx << 32) | eax;
+#endif
+}
+
+static uint32 cpu_detect_x86 (void)
+{
+	uint32 features = 0;
+	uint32 regs[4];
+	uint32 maxLeaf;
+	uint64 xcr0 = 0;
+
+	cpu_cpuid (0, 0, regs);
+	maxLeaf = regs[0];
+
+	if (maxLeaf < 1)
+		return 0;
+
+	cpu_cpuid (1, 0, regs);
+
+	if (regs[3] & (1u << 26))	features |= CPU_FEATURE_SSE2;
+	if (regs[2] & (1u << 9))	features |= CPU_FEATURE_SSSE3;
+	if (regs[2] & (1u << 19))	features |= CPU_FEATURE_SSE41;
+	if (regs[2] & (1u << 25))	features |= CPU_FEATURE_AESNI;
+	if (regs[2] & (1u << 1))	features |= CPU_FEATURE_PCLMUL;
+
+	// AVX state must be enabled by the operating system (OSXSAVE and XCR0)
+	if ((regs[2] & (1u << 27)) && (regs[2] & (1u << 28)))
+	{
+		xcr0 = cpu_xgetbv();
+		if ((xcr0 & 0x6) == 0x6)
+			features |= CPU_FEATURE_AVX;
+	}
+
+	if (maxLeaf >= 7)
+	{
+		int avx512StateEnabled = (xcr0 & 0xe6) == 0xe6;
+
+#if defined (__APPLE__)
+		// macOS enables the AVX-512 state on first use; XCR0 does not reflect it until then
+		int avx512 = 0;
+		if (!avx512StateEnabled && cpu_sysctl_flag ("hw.optional.avx512f", &avx512) && avx512)
+			avx512StateEnabled = (features & CPU_FEATURE_AVX) ? 1 : 0;
+#endif
+		cpu_cpuid (7, 0, regs);
+
+		if ((features & CPU_FEATURE_AVX) && (regs[1] & (1u << 5)))
+			features |= CPU_FEATURE_AVX2;
+
+		if (regs[1] & (1u << 29))
+			features |= CPU_FEATURE_SHANI;
+
+		if (features & CPU_FEATURE_AVX)
+		{
+			if (regs[2] & (1u << 9))	features |= CPU_FEATURE_VAES;
+			if (regs[2] & (1u << 10))	features |= CPU_FEATURE_VPCLMULQDQ;
+		}
+
+		if (avx512StateEnabled)
+		{
+			if (regs[1] & (1u << 16))	features |= CPU_FEATURE_AVX512F;
+			if (regs[1] & (1u << 31))	features |= CPU_FEATURE_AVX512VL;
+		}
+	}
+
+	return features;
+}
+
+#endif // TC_CPU_X86
+
+#ifdef TC_CPU_ARM64
+
+static uint32 cpu_detect_arm64 (void)
+{
+	uint32 features = CPU_FEATURE_NEON;
+
+#if defined (__APPLE__)
+	int value;
+
+	// The FEAT_* names are available since macOS 12; every Apple silicon CPU implements AES, PMULL and SHA-256
+	if (cpu_sysctl_flag ("hw.optional.arm.FEAT_AES", &value))
+	{
+		if (value)	features |= CPU_FEATURE_ARM_AES;
+		if (cpu_sysctl_flag ("hw.optional.arm.FEAT_PMULL", &value) && value)	features |= CPU_FEATURE_ARM_PMULL;
+		if (cpu_sysctl_flag ("hw.optional.arm.FEAT_SHA256", &value) && value)	features |= CPU_FEATURE_ARM_SHA2;
+	}
+	else
+		features |= CPU_FEATURE_ARM_AES | CPU_FEATURE_ARM_PMULL | CPU_FEATURE_ARM_SHA2;
+
+	if ((cpu_sysctl_flag ("hw.optional.arm.FEAT_SHA512", &value) && value)
+		|| (cpu_sysctl_flag ("hw.optional.armv8_2_sha512", &value) && value))
+		features |= CPU_FEATURE_ARM_SHA512;
+
+#elif defined (__linux__)
+	unsigned long hwcap = getauxval (AT_HWCAP);
+
+	if (hwcap & HWCAP_AES)		features |= CPU_FEATURE_ARM_AES;
+	if (hwcap & HWCAP_PMULL)	features |= CPU_FEATURE_ARM_PMULL;
+	if (hwcap & HWCAP_SHA2)		features |= CPU_FEATURE_ARM_SHA2;
+#	ifdef HWCAP_SHA512
+	if (hwcap & HWCAP_SHA512)	features |= CPU_FEATURE_ARM_SHA512;
+#	endif
+
+#else
+#	if defined (__ARM_FEATURE_CRYPTO) || defined (__ARM_FEATURE_AES)
+	features |= CPU_FEATURE_ARM_AES | CPU_FEATURE_ARM_PMULL;
+#	endif
+#	if defined (__ARM_FEATURE_CRYPTO) || defined (__ARM_FEATURE_SHA2)
+	features |= CPU_FEATURE_ARM_SHA2;
+#	endif
+#endif
+
+	return features;
+}
+
+#endif // TC_CPU_ARM64
+
+uint32 cpu_detect_features (void)
+{
+	// Detection has no side effects, so threads racing here store the same value
+	if (!atomic_load_explicit (&DetectionDone, memory_order_acquire))
+	{
+		uint32 features;
+
+#if defined (TC_CPU_X86)
+		features = cpu_detect_x86();
+#elif defined (TC_CPU_ARM64)
+		features = cpu_detect_arm64();
+#else
+		features = 0;
+#endif
+		atomic_store_explicit (&DetectedFeatures, features, memory_order_relaxed);
+		atomic_store_explicit (&DetectionDone, 1, memory_order_release);
+	}
+
+	return atomic_load_explicit (&DetectedFeatures, memory_order_relaxed);
+}
+
+uint32 cpu_get_features (void)
+{
+	return cpu_get_tier_features (cpu_get_active_tier());
+}
+
+const char *cpu_get_feature_name (uint32 feature)
+{
+	switch (feature)
+	{
+	case CPU_FEATURE_SSE2:			return "SSE2";
+	case CPU_FEATURE_SSSE3:			return "SSSE3";
+	case CPU_FEATURE_SSE41:			return "SSE4.1";
+	case CPU_FEATURE_AESNI:			return "AES-NI";
+	case CPU_FEATURE_PCLMUL:		return "PCLMULQDQ";
+	case CPU_FEATURE_AVX:			return "AVX";
+	case CPU_FEATURE_AVX2:			return "AVX2";
+	case CPU_FEATURE_AVX512F:		return "AVX-512F";
+	case CPU_FEATURE_AVX512VL:		return "AVX-512VL";
+	case CPU_FEATURE_VAES:			return "VAES";
+	case CPU_FEATURE_VPCLMULQDQ:	return "VPCLMULQDQ";
+	case CPU_FEATURE_SHANI:			return "SHA-NI";
+	case CPU_FEATURE_NEON:			return "NEON";
+	case CPU_FEATURE_ARM_AES:		return "AES";
+	case CPU_FEATURE_ARM_PMULL:		return "PMULL";
+	case CPU_FEATURE_ARM_SHA2:		return "SHA2";
+	case CPU_FEATURE_ARM_SHA512:	return "SHA512";
+	default:						return "";
+	}
+}
+
+int cpu_get_active_tier (void)
+{
+	int tier = atomic_load (&CpuTier);
+	return tier == CPU_TIER_AUTO ? cpu_get_best_tier() : tier;
+}
+
+int cpu_get_best_tier (void)
+{
+	int tier;
+
+	for (tier = CPU_TIER_COUNT - 1; tier > CPU_TIER_GENERIC; --tier)
+	{
+		if (cpu_is_tier_supported (tier))
+			return tier;
+	}
+
+	return CPU_TIER_GENERIC;
+}
+
+int cpu_get_tier (void)
+{
+	return atomic_load (&CpuTier);
+}
+
+const char *cpu_get_tier_name (int tier)
+{
+	if (tier < 0 || tier >= CPU_TIER_COUNT)
+		return "";
+
+	return TierNames[tier];
+}
+
+uint32 cpu_get_tier_features (int tier)
+{
+	if (tier < 0 || tier >= CPU_TIER_COUNT)
+		return 0;
+
+	return cpu_detect_features() & TierFeatures[tier];
+}
+
+int cpu_is_tier_supported (int tier)
+{
+	if (tier < 0 || tier >= CPU_TIER_COUNT)
+		return 0;
+
+	return (cpu_detect_features() & TierRequiredFeatures[tier]) == TierRequiredFeatures[tier];
+}
+
+int cpu_set_tier (int tier)
+{
+	if (tier != CPU_TIER_AUTO && !cpu_is_tier_supported (tier))
+		return 0;
+
+	atomic_store (&CpuTier, tier);
+	return 1;
+}
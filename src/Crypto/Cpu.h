@@ -0,0 +1,82 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Crypto_Cpu
+#define TC_HEADER_Crypto_Cpu
+
+#include "Common/Tcdefs.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/* Instruction set extensions relevant to the cryptographic primitives */
+
+#define CPU_FEATURE_SSE2			0x00000001
+#define CPU_FEATURE_SSSE3			0x00000002
+#define CPU_FEATURE_SSE41			0x00000004
+#define CPU_FEATURE_AESNI			0x00000008
+#define CPU_FEATURE_PCLMUL			0x00000010
+#define CPU_FEATURE_AVX				0x00000020
+#define CPU_FEATURE_AVX2			0x00000040
+#define CPU_FEATURE_AVX512F			0x00000080
+#define CPU_FEATURE_AVX512VL		0x00000100
+#define CPU_FEATURE_VAES			0x00000200
+#define CPU_FEATURE_VPCLMULQDQ		0x00000400
+#define CPU_FEATURE_SHANI			0x00000800
+
+#define CPU_FEATURE_NEON			0x00010000
+#define CPU_FEATURE_ARM_AES			0x00020000
+#define CPU_FEATURE_ARM_PMULL		0x00040000
+#define CPU_FEATURE_ARM_SHA2		0x00080000
+#define CPU_FEATURE_ARM_SHA512		0x00100000
+
+/*
+ * A tier is a set of features the dispatcher is allowed to use. The best tier
+ * supported by the CPU is selected by default; a lower tier may be forced to
+ * test or benchmark the kernels it selects.
+ */
+
+#define CPU_TIER_AUTO				(-1)
+#define CPU_TIER_GENERIC			0
+#define CPU_TIER_AESNI				1
+#define CPU_TIER_AVX2				2
+#define CPU_TIER_AVX512				3
+#define CPU_TIER_ARMV8				4
+#define CPU_TIER_COUNT				5
+
+/* Features present on this CPU and enabled by the operating system */
+uint32 cpu_detect_features (void);
+
+/* Features the dispatcher may use under the current tier */
+uint32 cpu_get_features (void);
+
+const char *cpu_get_feature_name (uint32 feature);
+
+int cpu_get_active_tier (void);
+int cpu_get_best_tier (void);
+
+/* Returns the forced tier or CPU_TIER_AUTO */
+int cpu_get_tier (void);
+
+const char *cpu_get_tier_name (int tier);
+
+/* Features the dispatcher may use under the given tier */
+uint32 cpu_get_tier_features (int tier);
+
+int cpu_is_tier_supported (int tier);
+
+/* Returns 0 if the tier is not supported by this CPU */
+int cpu_set_tier (int tier);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // TC_HEADER_Crypto_Cpu
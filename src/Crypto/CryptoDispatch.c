@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "CryptoDispatch.h"
+#include "Aes_hw_cpu.h"
+#include "Hash_hw_cpu.h"
+
+// One table per tier; a table is filled once and never modified after it has been published
+static CryptoDispatchTable TierTables[CPU_TIER_COUNT];
+static int TierTableValid[CPU_TIER_COUNT];
+static pthread_mutex_t TierTableMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic (const CryptoDispatchTable *) ActiveTable;
+
+static void crypto_dispatch_fill (CryptoDispatchTable *table, int tier)
+{
+	uint32 features = cpu_get_tier_features (tier);
+
+	CryptoDispatchTable t;
+	memset (&t, 0, sizeof (t));
+
+	t.Tier = tier;
+	t.AesKernelName = "Generic";
+	t.AesXtsKernelName = "Generic";
+	t.AesCtrKernelName = "Generic";
+	t.Sha1KernelName = "Generic";
+	t.Sha512KernelName = "Generic";
+
+#ifdef TC_AES_HW_CPU
+	if (features & (CPU_FEATURE_AESNI | CPU_FEATURE_ARM_AES))
+	{
+		t.AesKernelName = (features & CPU_FEATURE_AESNI) ? "AES-NI" : "ARMv8 AES";
+		t.AesEncrypt = aes_hw_cpu_encrypt;
+		t.AesDecrypt = aes_hw_cpu_decrypt;
+		t.AesEncrypt32Blocks = aes_hw_cpu_encrypt_32_blocks;
+		t.AesDecrypt32Blocks = aes_hw_cpu_decrypt_32_blocks;
+	}
+
+#ifdef TC_AES_HW_VAES
+	if ((features & (CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512VL | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ))
+		== (CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512VL | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ))
+	{
+		t.AesXtsKernelName = "VAES-512";
+		t.AesXtsEncrypt = aes_xts_vaes512_encrypt;
+		t.AesXtsDecrypt = aes_xts_vaes512_decrypt;
+		t.AesCtrKernelName = "VAES-512";
+		t.AesCtrGenerate = aes_ctr_vaes512_generate;
+	}
+	else if ((features & (CPU_FEATURE_AVX2 | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ))
+		== (CPU_FEATURE_AVX2 | CPU_FEATURE_VAES | CPU_FEATURE_VPCLMULQDQ))
+	{
+		t.AesXtsKernelName = "VAES-256";
+		t.AesXtsEncrypt = aes_xts_vaes256_encrypt;
+		t.AesXtsDecrypt = aes_xts_vaes256_decrypt;
+		t.AesCtrKernelName = "VAES-256";
+		t.AesCtrGenerate = aes_ctr_vaes256_generate;
+	}
+#endif
+#endif
+
+#ifdef TC_HASH_HW_X86
+	if ((features & (CPU_FEATURE_SSE41 | CPU_FEATURE_SHANI)) == (CPU_FEATURE_SSE41 | CPU_FEATURE_SHANI))
+	{
+		t.Sha1KernelName = "SHA-NI";
+		t.Sha1Compile = sha1_shani_compile;
+	}
+
+	if (features & CPU_FEATURE_AVX2)
+	{
+		t.Sha512KernelName = "AVX2";
+		t.Sha512Compile = sha512_avx2_compile;
+	}
+#endif
+
+#ifdef TC_HASH_HW_ARM
+	if (features & CPU_FEATURE_ARM_SHA512)
+	{
+		t.Sha512KernelName = "ARMv8 SHA512";
+		t.Sha512Compile = sha512_armv8_compile;
+	}
+#endif
+
+	(void) features;
+	*table = t;
+}
+
+static const CryptoDispatchTable *crypto_dispatch_get_tier_table (int tier)
+{
+	pthread_mutex_lock (&TierTableMutex);
+
+	if (!TierTableValid[tier])
+	{
+		crypto_dispatch_fill (&TierTables[tier], tier);
+		TierTableValid[tier] = 1;
+	}
+
+	pthread_mutex_unlock (&TierTableMutex);
+	return &TierTables[tier];
+}
+
+const CryptoDispatchTable *crypto_dispatch (void)
+{
+	const CryptoDispatchTable *table = atomic_load_explicit (&ActiveTable, memory_order_acquire);
+
+	if (!table)
+	{
+		const CryptoDispatchTable *expected = NULL;
+		table = crypto_dispatch_get_tier_table (cpu_get_active_tier());
+
+		// A tier forced by another thread in the meantime takes precedence
+		if (!atomic_compare_exchange_strong_explicit (&ActiveTable, &expected, table, memory_order_acq_rel, memory_order_acquire))
+			table = expected;
+	}
+
+	return table;
+}
+
+int crypto_dispatch_force_tier (int tier)
+{
+	if (!cpu_set_tier (tier))
+		return 0;
+
+	atomic_store_explicit (&ActiveTable, crypto_dispatch_get_tier_table (cpu_get_active_tier()), memory_order_release);
+	return 1;
+}
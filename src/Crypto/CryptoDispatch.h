@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Crypto_CryptoDispatch
+#define TC_HEADER_Crypto_CryptoDispatch
+
+#include "Common/Tcdefs.h"
+#include "Cpu.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/*
+ * Kernels selected for the current CPU tier. The table of a tier is filled on
+ * first use and never modified afterwards; forcing a tier publishes the table
+ * of that tier atomically, so a caller always sees one complete table.
+ *
+ * A NULL kernel means that no accelerated variant is available and callers
+ * use the portable implementation.
+ */
+typedef struct
+{
+	int Tier;
+
+	const char *AesKernelName;
+	void (*AesEncrypt) (const byte *ks, byte *data);
+	void (*AesDecrypt) (const byte *ks, byte *data);
+	void (*AesEncrypt32Blocks) (const byte *ks, byte *data);
+	void (*AesDecrypt32Blocks) (const byte *ks, byte *data);
+
+	/* Whole XTS data units; ks is the encryption or decryption schedule, tweakKs the encryption schedule of the secondary key */
+	const char *AesXtsKernelName;
+	void (*AesXtsEncrypt) (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+	void (*AesXtsDecrypt) (const byte *ks, const byte *tweakKs, byte *data, uint64 dataUnitNo, uint64 dataUnitCount);
+
+	/* Encryption of blockCount big-endian counter blocks starting with counterHigh:counterLow (CTR keystream) */
+	const char *AesCtrKernelName;
+	void (*AesCtrGenerate) (const byte *ks, byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount);
+
+	/* Hash compression functions; the block holds the message words in host byte order */
+	const char *Sha1KernelName;
+	void (*Sha1Compile) (uint32 hash[5], const uint32 block[16]);
+
+	const char *Sha512KernelName;
+	void (*Sha512Compile) (uint64 hash[8], const uint64 block[16]);
+} CryptoDispatchTable;
+
+const CryptoDispatchTable *crypto_dispatch (void);
+
+/* Returns 0 if the tier is not supported by this CPU. Use EncryptionThreadPool::ForceCpuTier() while the pool may be busy. */
+int crypto_dispatch_force_tier (int tier);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // TC_HEADER_Crypto_CryptoDispatch
@@ -0,0 +1,48 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Crypto_Hash_Hw_Cpu
+#define TC_HEADER_Crypto_Hash_Hw_Cpu
+
+#include "Common/Tcdefs.h"
+
+#if (defined (__x86_64__) && (defined (__GNUC__) || defined (__clang__)))
+#	define TC_HASH_HW_X86
+#endif
+
+// The SHA-512 intrinsics are usable in functions with a target attribute since GCC 8 and clang 16
+#if defined (__aarch64__) && (defined (__ARM_FEATURE_SHA512) \
+	|| (defined (__clang__) && __clang_major__ >= 16) \
+	|| (defined (__GNUC__) && !defined (__clang__) && __GNUC__ >= 8))
+#	define TC_HASH_HW_ARM
+#endif
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+/*
+ Compression functions equivalent to sha1_compile() and sha512_compile().
+ The block holds the message words in host byte order.
+*/
+
+#ifdef TC_HASH_HW_X86
+void sha1_shani_compile (uint32 hash[5], const uint32 block[16]);
+void sha512_avx2_compile (uint64 hash[8], const uint64 block[16]);
+#endif
+
+#ifdef TC_HASH_HW_ARM
+void sha512_armv8_compile (uint64 hash[8], const uint64 block[16]);
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // TC_HEADER_Crypto_Hash_Hw_Cpu
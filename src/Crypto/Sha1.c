@@ -36,6 +36,7 @@
 #include <stdlib.h>     /* for _lrotl with VC++     */
 
 #include "Sha1.h"
+#include "CryptoDispatch.h"
 
 #if defined(__cplusplus)
 extern "C"
@@ -139,6 +140,7 @@ extern "C"
 
 void sha1_compile(sha1_ctx ctx[1])
 {   sha1_32t    *w = ctx->wbuf;
+    const CryptoDispatchTable *dispatch = crypto_dispatch();
 
 #ifdef ARRAY
     sha1_32t    v[5];
@@ -150,6 +152,12 @@ void sha1_compile(sha1_ctx ctx[1])
     v4 = ctx->hash[4];
 #endif
 
+    if(dispatch->Sha1Compile)
+    {
+        dispatch->Sha1Compile(ctx->hash, ctx->wbuf);
+        return;
+    }
+
 #define hf(i)   w[i]
 
     five_cycle(v, ch, 0x5a827999,  0);
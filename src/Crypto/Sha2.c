@@ -79,6 +79,7 @@
 #include <string.h>     /* for memcpy() etc.        */
 
 #include "Sha2.h"
+#include "CryptoDispatch.h"
 
 #if defined(__cplusplus)
 extern "C"
@@ -511,6 +512,13 @@ const uint_64t  k512[80] =
 VOID_RETURN sha512_compile(sha512_ctx ctx[1])
 {   uint_64t    v[8], *p = ctx->wbuf;
     uint_32t    j;
+    const CryptoDispatchTable *dispatch = crypto_dispatch();
+
+    if(dispatch->Sha512Compile)
+    {
+        dispatch->Sha512Compile(ctx->hash, ctx->wbuf);
+        return;
+    }
 
     memcpy(v, ctx->hash, 8 * sizeof(uint_64t));
 
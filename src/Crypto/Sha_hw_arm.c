@@ -0,0 +1,76 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ SHA-512 compression function using the ARMv8.2 SHA512 instructions
+ (FEAT_SHA512, present on Apple silicon), selected at run time by
+ Crypto/CryptoDispatch.c.
+
+ The state is kept as the pairs {a,b} {c,d} {e,f} {g,h}. SHA512H computes
+ T1 of two consecutive rounds from {h+K+W, g+K+W}, {f,g} and {d,e};
+ SHA512H2 completes the two rounds from T1, {c,d} and {a,b}.
+*/
+
+#include "Common/Tcdefs.h"
+#include "Hash_hw_cpu.h"
+
+#ifdef TC_HASH_HW_ARM
+
+#include <arm_neon.h>
+
+#define TC_SHA512_TARGET __attribute__ ((target ("arch=armv8.2-a+sha3")))
+
+extern const uint64 k512[80];
+
+TC_SHA512_TARGET
+static inline void sha512_armv8_rounds2 (uint64x2_t *ab, uint64x2_t *cd, uint64x2_t *ef, uint64x2_t *gh, uint64x2_t kw)
+{
+	uint64x2_t fg = vextq_u64 (*ef, *gh, 1);
+	uint64x2_t de = vextq_u64 (*cd, *ef, 1);
+	uint64x2_t t1 = vsha512hq_u64 (vaddq_u64 (*gh, vextq_u64 (kw, kw, 1)), fg, de);
+	uint64x2_t newAb = vsha512h2q_u64 (t1, *cd, *ab);
+
+	*gh = *ef;
+	*ef = vaddq_u64 (*cd, t1);
+	*cd = *ab;
+	*ab = newAb;
+}
+
+TC_SHA512_TARGET
+void sha512_armv8_compile (uint64 hash[8], const uint64 block[16])
+{
+	uint64x2_t ab = vld1q_u64 (hash);
+	uint64x2_t cd = vld1q_u64 (hash + 2);
+	uint64x2_t ef = vld1q_u64 (hash + 4);
+	uint64x2_t gh = vld1q_u64 (hash + 6);
+	uint64x2_t abSave = ab, cdSave = cd, efSave = ef, ghSave = gh;
+	uint64x2_t w[8];
+	int i;
+
+	for (i = 0; i < 8; ++i)
+	{
+		w[i] = vld1q_u64 (block + i * 2);
+		sha512_armv8_rounds2 (&ab, &cd, &ef, &gh, vaddq_u64 (w[i], vld1q_u64 (k512 + i * 2)));
+	}
+
+	// W[t..t+1] from W[t-16..t-15], W[t-15..t-14], W[t-7..t-6] and W[t-2..t-1]
+	for (i = 8; i < 40; ++i)
+	{
+		uint64x2_t *wt = &w[i % 8];
+
+		*wt = vsha512su1q_u64 (vsha512su0q_u64 (*wt, w[(i + 1) % 8]), w[(i + 7) % 8], vextq_u64 (w[(i + 4) % 8], w[(i + 5) % 8], 1));
+		sha512_armv8_rounds2 (&ab, &cd, &ef, &gh, vaddq_u64 (*wt, vld1q_u64 (k512 + i * 2)));
+	}
+
+	vst1q_u64 (hash, vaddq_u64 (ab, abSave));
+	vst1q_u64 (hash + 2, vaddq_u64 (cd, cdSave));
+	vst1q_u64 (hash + 4, vaddq_u64 (ef, efSave));
+	vst1q_u64 (hash + 6, vaddq_u64 (gh, ghSave));
+}
+
+#endif // TC_HASH_HW_ARM
@@ -0,0 +1,208 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ x86-64 compression functions for SHA-1 (SHA-NI) and SHA-512 (AVX2 message
+ schedule) selected at run time by Crypto/CryptoDispatch.c.
+
+ Both operate on the context buffers of Sha1.c and Sha2.c, whose message
+ words have already been converted to host byte order, and produce exactly
+ the same state as sha1_compile() and sha512_compile().
+*/
+
+#include "Common/Tcdefs.h"
+#include "Hash_hw_cpu.h"
+
+#ifdef TC_HASH_HW_X86
+
+#include <immintrin.h>
+
+#if defined (_MSC_VER)
+#	define TC_SHA_NI_TARGET
+#	define TC_AVX2_TARGET
+#else
+#	define TC_SHA_NI_TARGET __attribute__ ((target ("sha,sse4.1")))
+#	define TC_AVX2_TARGET __attribute__ ((target ("avx2")))
+#endif
+
+extern const uint64 k512[80];
+
+/* SHA-1 */
+
+/*
+ Four rounds with the message schedule of the words used four rounds later
+ interleaved, as in the Intel SHA extensions reference. msg[i % 4] holds
+ W[4i..4i+3]; e alternates between two registers because SHA1NEXTE derives
+ E from the state four rounds earlier.
+*/
+#define SHA1_ROUNDS4(i, ecur, enext) \
+	do { \
+		if (i == 0) \
+			ecur = _mm_add_epi32 (ecur, msg[0]); \
+		else \
+			ecur = _mm_sha1nexte_epu32 (ecur, msg[(i) % 4]); \
+		enext = abcd; \
+		if (i >= 3 && i <= 18) \
+			msg[((i) + 1) % 4] = _mm_sha1msg2_epu32 (msg[((i) + 1) % 4], msg[(i) % 4]); \
+		abcd = _mm_sha1rnds4_epu32 (abcd, ecur, (i) / 5); \
+		if (i >= 1 && i <= 16) \
+			msg[((i) + 3) % 4] = _mm_sha1msg1_epu32 (msg[((i) + 3) % 4], msg[(i) % 4]); \
+		if (i >= 2 && i <= 17) \
+			msg[((i) + 2) % 4] = _mm_xor_si128 (msg[((i) + 2) % 4], msg[(i) % 4]); \
+	} while (0)
+
+TC_SHA_NI_TARGET
+void sha1_shani_compile (uint32 hash[5], const uint32 block[16])
+{
+	__m128i abcd, abcdSave, e0, e1, eSave;
+	__m128i msg[4];
+	int i;
+
+	// The instructions expect A in the most significant lane and message words in descending order
+	abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) hash), 0x1b);
+	e0 = _mm_set_epi32 ((int) hash[4], 0, 0, 0);
+
+	for (i = 0; i < 4; ++i)
+		msg[i] = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *) (block + i * 4)), 0x1b);
+
+	abcdSave = abcd;
+	eSave = e0;
+	e1 = _mm_setzero_si128();
+
+	SHA1_ROUNDS4 (0, e0, e1);
+	SHA1_ROUNDS4 (1, e1, e0);
+	SHA1_ROUNDS4 (2, e0, e1);
+	SHA1_ROUNDS4 (3, e1, e0);
+	SHA1_ROUNDS4 (4, e0, e1);
+	SHA1_ROUNDS4 (5, e1, e0);
+	SHA1_ROUNDS4 (6, e0, e1);
+	SHA1_ROUNDS4 (7, e1, e0);
+	SHA1_ROUNDS4 (8, e0, e1);
+	SHA1_ROUNDS4 (9, e1, e0);
+	SHA1_ROUNDS4 (10, e0, e1);
+	SHA1_ROUNDS4 (11, e1, e0);
+	SHA1_ROUNDS4 (12, e0, e1);
+	SHA1_ROUNDS4 (13, e1, e0);
+	SHA1_ROUNDS4 (14, e0, e1);
+	SHA1_ROUNDS4 (15, e1, e0);
+	SHA1_ROUNDS4 (16, e0, e1);
+	SHA1_ROUNDS4 (17, e1, e0);
+	SHA1_ROUNDS4 (18, e0, e1);
+	SHA1_ROUNDS4 (19, e1, e0);
+
+	e0 = _mm_sha1nexte_epu32 (e0, eSave);
+	abcd = _mm_add_epi32 (abcd, abcdSave);
+
+	_mm_storeu_si128 ((__m128i *) hash, _mm_shuffle_epi32 (abcd, 0x1b));
+	hash[4] = (uint32) _mm_extract_epi32 (e0, 3);
+}
+
+/* SHA-512 */
+
+#define SHA512_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+#define SHA512_ROUND(a, b, c, d, e, f, g, h, i) \
+	do { \
+		uint64 t1 = h + (SHA512_ROTR (e, 14) ^ SHA512_ROTR (e, 18) ^ SHA512_ROTR (e, 41)) + (g ^ (e & (f ^ g))) + wk[i]; \
+		uint64 t2 = (SHA512_ROTR (a, 28) ^ SHA512_ROTR (a, 34) ^ SHA512_ROTR (a, 39)) + ((a & b) | (c & (a ^ b))); \
+		d += t1; \
+		h = t1 + t2; \
+	} while (0)
+
+TC_AVX2_TARGET
+static inline __m256i sha512_avx2_rotr (__m256i x, int n)
+{
+	return _mm256_or_si256 (_mm256_srli_epi64 (x, n), _mm256_slli_epi64 (x, 64 - n));
+}
+
+TC_AVX2_TARGET
+static inline __m128i sha512_sse2_rotr (__m128i x, int n)
+{
+	return _mm_or_si128 (_mm_srli_epi64 (x, n), _mm_slli_epi64 (x, 64 - n));
+}
+
+TC_AVX2_TARGET
+static inline __m128i sha512_sse2_sigma1 (__m128i x)
+{
+	return _mm_xor_si128 (_mm_xor_si128 (sha512_sse2_rotr (x, 19), sha512_sse2_rotr (x, 61)), _mm_srli_epi64 (x, 6));
+}
+
+/*
+ Computes W[t..t+3] from the 16 preceding words held in w0..w3. The sigma0
+ terms of all four words are independent; the sigma1 terms of W[t+2..t+3]
+ depend on W[t..t+1] and are computed in a second step.
+*/
+TC_AVX2_TARGET
+static inline __m256i sha512_avx2_schedule (__m256i w0, __m256i w1, __m256i w2, __m256i w3)
+{
+	__m256i w15 = _mm256_alignr_epi8 (_mm256_permute2x128_si256 (w0, w1, 0x21), w0, 8);
+	__m256i w7 = _mm256_alignr_epi8 (_mm256_permute2x128_si256 (w2, w3, 0x21), w2, 8);
+	__m256i s0 = _mm256_xor_si256 (_mm256_xor_si256 (sha512_avx2_rotr (w15, 1), sha512_avx2_rotr (w15, 8)), _mm256_srli_epi64 (w15, 7));
+	__m256i sum = _mm256_add_epi64 (_mm256_add_epi64 (w0, w7), s0);
+	__m128i lo, hi;
+
+	lo = _mm_add_epi64 (_mm256_castsi256_si128 (sum), sha512_sse2_sigma1 (_mm256_extracti128_si256 (w3, 1)));
+	hi = _mm_add_epi64 (_mm256_extracti128_si256 (sum, 1), sha512_sse2_sigma1 (lo));
+
+	return _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+}
+
+TC_AVX2_TARGET
+void sha512_avx2_compile (uint64 hash[8], const uint64 block[16])
+{
+	uint64 wk[80];
+	__m256i w0, w1, w2, w3, w4;
+	uint64 a, b, c, d, e, f, g, h;
+	int i;
+
+	w0 = _mm256_loadu_si256 ((const __m256i *) block);
+	w1 = _mm256_loadu_si256 ((const __m256i *) (block + 4));
+	w2 = _mm256_loadu_si256 ((const __m256i *) (block + 8));
+	w3 = _mm256_loadu_si256 ((const __m256i *) (block + 12));
+
+	_mm256_storeu_si256 ((__m256i *) wk, _mm256_add_epi64 (w0, _mm256_loadu_si256 ((const __m256i *) k512)));
+	_mm256_storeu_si256 ((__m256i *) (wk + 4), _mm256_add_epi64 (w1, _mm256_loadu_si256 ((const __m256i *) (k512 + 4))));
+	_mm256_storeu_si256 ((__m256i *) (wk + 8), _mm256_add_epi64 (w2, _mm256_loadu_si256 ((const __m256i *) (k512 + 8))));
+	_mm256_storeu_si256 ((__m256i *) (wk + 12), _mm256_add_epi64 (w3, _mm256_loadu_si256 ((const __m256i *) (k512 + 12))));
+
+	a = hash[0]; b = hash[1]; c = hash[2]; d = hash[3];
+	e = hash[4]; f = hash[5]; g = hash[6]; h = hash[7];
+
+	// The schedule of the words used eight rounds later runs on the vector units alongside the scalar rounds
+	for (i = 0; i < 80; i += 8)
+	{
+		if (i < 64)
+		{
+			w4 = sha512_avx2_schedule (w0, w1, w2, w3);
+			_mm256_storeu_si256 ((__m256i *) (wk + i + 16), _mm256_add_epi64 (w4, _mm256_loadu_si256 ((const __m256i *) (k512 + i + 16))));
+			w0 = sha512_avx2_schedule (w1, w2, w3, w4);
+			_mm256_storeu_si256 ((__m256i *) (wk + i + 20), _mm256_add_epi64 (w0, _mm256_loadu_si256 ((const __m256i *) (k512 + i + 20))));
+
+			w1 = w3;
+			w3 = w0;
+			w0 = w2;
+			w2 = w4;
+		}
+
+		SHA512_ROUND (a, b, c, d, e, f, g, h, i);
+		SHA512_ROUND (h, a, b, c, d, e, f, g, i + 1);
+		SHA512_ROUND (g, h, a, b, c, d, e, f, i + 2);
+		SHA512_ROUND (f, g, h, a, b, c, d, e, i + 3);
+		SHA512_ROUND (e, f, g, h, a, b, c, d, i + 4);
+		SHA512_ROUND (d, e, f, g, h, a, b, c, i + 5);
+		SHA512_ROUND (c, d, e, f, g, h, a, b, i + 6);
+		SHA512_ROUND (b, c, d, e, f, g, h, a, i + 7);
+	}
+
+	hash[0] += a; hash[1] += b; hash[2] += c; hash[3] += d;
+	hash[4] += e; hash[5] += f; hash[6] += g; hash[7] += h;
+
+	burn (wk, sizeof (wk));
+}
+
+#endif // TC_HASH_HW_X86
@@ -112,6 +112,44 @@ struct fuse_operations {
     int (*bmap)       (const char *, size_t, uint64_t *);
 };
 
+/*
+ * Low-level filesystem operations.
+ *
+ * Files are identified by inode numbers instead of paths, and the value
+ * stored in fuse_file_info.fh by open() is passed back to read(), write(),
+ * fsync() and release() for as long as the file stays open, so a
+ * filesystem can resolve the file and check access rights once per open
+ * rather than once per operation.  Inode numbers must fit in 32 bits.
+ *
+ * read() fills the caller's buffer, which is the reply buffer of the
+ * request; write() receives a pointer into the request buffer.  Both
+ * return the number of bytes transferred or a negated errno value, as do
+ * the path-based callbacks.
+ */
+typedef uint64_t fuse_ino_t;
+
+#define FUSE_ROOT_ID 1
+
+typedef int (*darwinfuse_fill_dir_t)(void *buf, const char *name,
+                                      fuse_ino_t ino, off_t off);
+
+struct darwinfuse_lowlevel_ops {
+    void *(*init)   (struct fuse_conn_info *);
+    void (*destroy) (void *);
+    int (*lookup)   (fuse_ino_t parent, const char *name, fuse_ino_t *ino);
+    int (*getattr)  (fuse_ino_t, struct stat *);
+    int (*access)   (fuse_ino_t, int);
+    int (*open)     (fuse_ino_t, struct fuse_file_info *);
+    int (*release)  (fuse_ino_t, struct fuse_file_info *);
+    int (*read)     (fuse_ino_t, char *, size_t, off_t,
+                     struct fuse_file_info *);
+    int (*write)    (fuse_ino_t, const char *, size_t, off_t,
+                     struct fuse_file_info *);
+    int (*fsync)    (fuse_ino_t, int, struct fuse_file_info *);
+    int (*readdir)  (fuse_ino_t, void *, darwinfuse_fill_dir_t, off_t,
+                     struct fuse_file_info *);
+};
+
 /* ---- API functions ---- */
 
 /*
@@ -128,6 +166,14 @@ struct fuse_operations {
 int fuse_main(int argc, char *argv[],
               const struct fuse_operations *op, void *user_data);
 
+/*
+ * Same as fuse_main(), but serves the filesystem through the low-level
+ * inode-based callbacks.
+ */
+int darwinfuse_main_lowlevel(int argc, char *argv[],
+                             const struct darwinfuse_lowlevel_ops *op,
+                             void *user_data);
+
 /*
  * Returns the FUSE context for the current request.
  * The uid/gid fields reflect the calling process's credentials
@@ -1,5 +1,6 @@
 /*
- * DarwinFUSE — fuse_main() and fuse_get_context() implementation
+ * DarwinFUSE — fuse_main(), darwinfuse_main_lowlevel() and
+ * fuse_get_context() implementation
  *
  * This is the public entry point that replaces libfuse's fuse_main().
  * It starts an NFSv4 server on localhost, calls mount_nfs to mount,
@@ -62,6 +63,10 @@ static void signal_handler(int sig)
  * Basalt calls with: argv = ["truecrypt", mountpoint, "-o", "noping_diskarb",
  *                             "-o", "nobrowse", "-o", "allow_other",
  *                             "-o", "nosuid,nodev"]
+ *
+ * attr_timeout=N sets how many seconds the client may cache attributes
+ * (default DFUSE_ATTR_TIMEOUT, 0 disables caching) and nodelegations stops
+ * the server from granting delegations.
  */
 typedef struct {
     const char *mount_point;
@@ -69,6 +74,8 @@ typedef struct {
     int         nodev;
     int         rdonly;
     int         nobrowse;
+    int         attr_timeout;   /* attr_timeout=N */
+    int         nodelegations;
 } parsed_args_t;
 
 static int parse_args(int argc, char *argv[], parsed_args_t *out)
@@ -82,6 +89,7 @@ static int parse_args(int argc, char *argv[], parsed_args_t *out)
     }
 
     out->mount_point = argv[1];
+    out->attr_timeout = DFUSE_ATTR_TIMEOUT;
 
     /* Scan for -o options */
     for (int i = 2; i < argc; i++) {
@@ -103,6 +111,10 @@ static int parse_args(int argc, char *argv[], parsed_args_t *out)
                 else if (strcmp(tok, "nodev") == 0)  out->nodev = 1;
                 else if (strcmp(tok, "ro") == 0)     out->rdonly = 1;
                 else if (strcmp(tok, "nobrowse") == 0) out->nobrowse = 1;
+                else if (strncmp(tok, "attr_timeout=", 13) == 0)
+                    out->attr_timeout = atoi(tok + 13);
+                else if (strcmp(tok, "nodelegations") == 0)
+                    out->nodelegations = 1;
                 /* Other FUSE-specific options (noping_diskarb,
                    allow_other) are silently ignored — not applicable to NFS */
             }
@@ -134,7 +146,8 @@ static int do_mount_nfs(uint16_t port, const parsed_args_t *args)
      *
      * NFSv4 notes:
      * - locallocks/nolocks are NFSv2/v3 only — omit for v4
-     * - noac: disable attribute caching (we serve fresh data each time)
+     * - actimeo: the volume is only changed through this mount, so the
+     *   client may cache attributes for a long time (noac if disabled)
      * - noacl: disable ACL support (simplifies our server)
      * - noresvport: use unprivileged source port so mount works without root
      *   (XNU allows non-root mount() if user owns the mountpoint dir)
@@ -143,12 +156,18 @@ static int do_mount_nfs(uint16_t port, const parsed_args_t *args)
      */
     char opts[512];
     int len = snprintf(opts, sizeof(opts),
-        "vers=4,tcp,noac,noacl,noresvport,"
+        "vers=4,tcp,noacl,noresvport,"
         "rsize=65536,wsize=65536,"
         "soft,intr,retrycnt=0,"
         "port=%u",
         (unsigned)port);
 
+    if (args->attr_timeout > 0)
+        len += snprintf(opts + len, sizeof(opts) - (size_t)len, ",actimeo=%d",
+                        args->attr_timeout);
+    else
+        len += snprintf(opts + len, sizeof(opts) - (size_t)len, ",noac");
+
     if (args->nosuid)
         len += snprintf(opts + len, sizeof(opts) - (size_t)len, ",nosuid");
     if (args->nodev)
@@ -220,10 +239,20 @@ static int do_mount_nfs(uint16_t port, const parsed_args_t *args)
 
 /* ---- fuse_main ---- */
 
-int fuse_main(int argc, char *argv[],
-              const struct fuse_operations *op, void *user_data)
+/*
+ * Serves the filesystem through either the path-based (op) or the
+ * inode-based (ll_op) callbacks; exactly one of them is non-NULL.
+ */
+static int run_filesystem(int argc, char *argv[],
+                          const struct fuse_operations *op,
+                          const struct darwinfuse_lowlevel_ops *ll_op,
+                          void *user_data)
 {
-    if (!op) return -1;
+    void *(*init)(struct fuse_conn_info *) = op ? op->init : ll_op->init;
+    void (*destroy)(void *) = op ? op->destroy : ll_op->destroy;
+
+    basalt_log_open_file(DFUSE_LOG_FILE);
+    basalt_log_set_sinks(BASALT_LOG_SINK_SYSLOG | BASALT_LOG_SINK_FILE | BASALT_LOG_SINK_STDERR);
 
     /* Parse arguments */
     parsed_args_t args;
@@ -254,11 +283,14 @@ int fuse_main(int argc, char *argv[],
     darwinfuse_config_t config;
     memset(&config, 0, sizeof(config));
     config.ops = op;
+    config.ll_ops = ll_op;
     config.user_data = user_data;
     config.uid = getuid();
     config.gid = getgid();
     config.volume_path = detect_volume_path();
     config.control_path = "/control";
+    config.delegations = !args.nodelegations;
+    arc4random_buf(config.write_verifier, sizeof(config.write_verifier));
 
     /* Create NFS server (binds listen socket, but does not accept yet) */
     uint16_t port = 0;
@@ -336,6 +368,7 @@ int fuse_main(int argc, char *argv[],
          * which releases the Process::Execute pipe write-ends.
          */
         DFUSE_LOG("Parent: _exit(0), daemon pid=%d", daemon_pid);
+        basalt_log_flush();
         _exit(0);
     }
 
@@ -370,14 +403,14 @@ int fuse_main(int argc, char *argv[],
      * The mount-time NFS operations (GETATTR, READDIR, ACCESS, LOOKUP)
      * don't need the thread pool — only READ/WRITE (encryption) do.
      */
-    if (op->init) {
+    if (init) {
         struct fuse_conn_info conn_info;
         memset(&conn_info, 0, sizeof(conn_info));
         conn_info.proto_major = 7;
         conn_info.proto_minor = 26;
         conn_info.max_write = 65536;
         conn_info.max_readahead = 65536;
-        init_result = op->init(&conn_info);
+        init_result = init(&conn_info);
     }
 
     /* Reinstall our signal handlers — op->init() may have set SIG_IGN
@@ -405,8 +438,24 @@ int fuse_main(int argc, char *argv[],
     nfs4_server_destroy(srv);
     g_server = NULL;
 
-    if (op->destroy)
-        op->destroy(init_result);
+    if (destroy)
+        destroy(init_result);
 
+    basalt_log_flush();
     _exit(0);
 }
+
+int fuse_main(int argc, char *argv[],
+              const struct fuse_operations *op, void *user_data)
+{
+    if (!op) return -1;
+    return run_filesystem(argc, argv, op, NULL, user_data);
+}
+
+int darwinfuse_main_lowlevel(int argc, char *argv[],
+                             const struct darwinfuse_lowlevel_ops *op,
+                             void *user_data)
+{
+    if (!op) return -1;
+    return run_filesystem(argc, argv, NULL, op, user_data);
+}
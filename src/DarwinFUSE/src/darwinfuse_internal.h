@@ -59,22 +59,31 @@
 #define DFUSE_MAX_CLIENTS   8
 #define DFUSE_READ_BUFSIZE  (256 * 1024)
 
+/* ---------- NFSv4.0 delegations and attribute caching ---------- */
+
+#define DFUSE_LEASE_TIME            90      /* Seconds */
+#define DFUSE_MAX_DELEGATIONS       16
+#define DFUSE_CALLBACK_TIMEOUT      1000    /* Milliseconds to connect to a client */
+#define DFUSE_ATTR_TIMEOUT          60      /* Default client attribute cache lifetime */
+
 /* ---------- Logging ---------- */
 
 /*
- * Logging: write to /tmp/darwinfuse.log so logs survive the
- * Process::Execute stderr redirect in Basalt's FuseService.
+ * Logging goes through the shared Basalt log (Common/Log.h): messages are
+ * queued in memory and written by a background thread.  fuse_main() adds
+ * /tmp/darwinfuse.log as a sink so logs survive the Process::Execute
+ * stderr redirect in Basalt's FuseService.
+ *
+ * DFUSE_TRACE is meant for per-operation messages on the NFS data path and
+ * is disabled unless BASALT_LOG_LEVEL=trace.
  */
-#define DFUSE_LOG(fmt, ...) do { \
-    FILE *_f = fopen("/tmp/darwinfuse.log", "a"); \
-    if (_f) { fprintf(_f, "[DarwinFUSE] " fmt "\n", ##__VA_ARGS__); fclose(_f); } \
-    fprintf(stderr, "[DarwinFUSE] " fmt "\n", ##__VA_ARGS__); \
-} while (0)
-
-#define DFUSE_ERR(fmt, ...) do { \
-    FILE *_f = fopen("/tmp/darwinfuse.log", "a"); \
-    if (_f) { fprintf(_f, "[DarwinFUSE ERROR] " fmt "\n", ##__VA_ARGS__); fclose(_f); } \
-    fprintf(stderr, "[DarwinFUSE ERROR] " fmt "\n", ##__VA_ARGS__); \
-} while (0)
+#include "Log.h"
+
+#define DFUSE_LOG_FILE      "/tmp/darwinfuse.log"
+
+#define DFUSE_ERR(fmt, ...)   basalt_log(BASALT_LOG_ERROR, "[DarwinFUSE ERROR] " fmt, ##__VA_ARGS__)
+#define DFUSE_LOG(fmt, ...)   basalt_log(BASALT_LOG_INFO, "[DarwinFUSE] " fmt, ##__VA_ARGS__)
+#define DFUSE_DEBUG(fmt, ...) basalt_log(BASALT_LOG_DEBUG, "[DarwinFUSE] " fmt, ##__VA_ARGS__)
+#define DFUSE_TRACE(fmt, ...) basalt_log(BASALT_LOG_TRACE, "[DarwinFUSE] " fmt, ##__VA_ARGS__)
 
 #endif /* DARWINFUSE_INTERNAL_H */
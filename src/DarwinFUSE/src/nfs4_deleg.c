@@ -0,0 +1,447 @@
+/*
+ * DarwinFUSE — NFSv4.0 delegations and CB_RECALL
+ *
+ * The volume image is normally used by a single local client, so it can
+ * hold a delegation for it and serve opens and attributes from its cache.
+ * Delegations are recalled over the client's callback path (RFC 7530
+ * §10.2) when another client needs the file.  The recall is sent without
+ * waiting for the reply; the holder flushes its state and returns the
+ * delegation with DELEGRETURN.  A delegation not returned within the lease
+ * time is revoked.
+ *
+ * Copyright (c) 2026 Basalt contributors. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+#include "nfs4_deleg.h"
+#include "nfs4_xdr.h"
+#include "rpc.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+void nfs4_deleg_init(nfs4_deleg_state_t *state, int enabled)
+{
+    memset(state, 0, sizeof(*state));
+    state->enabled = enabled;
+    state->next_xid = arc4random();
+
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++)
+        state->callbacks[i].fd = -1;
+}
+
+void nfs4_deleg_destroy(nfs4_deleg_state_t *state)
+{
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++) {
+        if (state->callbacks[i].fd >= 0)
+            close(state->callbacks[i].fd);
+        state->callbacks[i].fd = -1;
+    }
+}
+
+/* ---- Callback path ---- */
+
+static nfs4_callback_t *find_callback(nfs4_deleg_state_t *state,
+                                      uint64_t clientid)
+{
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++) {
+        nfs4_callback_t *cb = &state->callbacks[i];
+        if (cb->in_use && cb->clientid == clientid)
+            return cb;
+    }
+    return NULL;
+}
+
+static void callback_close(nfs4_callback_t *cb)
+{
+    if (cb->fd >= 0)
+        close(cb->fd);
+    cb->fd = -1;
+}
+
+/* Parse an IPv4 universal address "h1.h2.h3.h4.p1.p2" (RFC 5665 §5.2.3.3) */
+static int parse_uaddr(const char *uaddr, struct sockaddr_in *addr)
+{
+    unsigned int h[4], p[2];
+    char extra;
+
+    if (sscanf(uaddr, "%u.%u.%u.%u.%u.%u%c",
+               &h[0], &h[1], &h[2], &h[3], &p[0], &p[1], &extra) != 6)
+        return -1;
+
+    for (int i = 0; i < 4; i++)
+        if (h[i] > 255) return -1;
+    if (p[0] > 255 || p[1] > 255)
+        return -1;
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl((h[0] << 24) | (h[1] << 16) | (h[2] << 8) | h[3]);
+    addr->sin_port = htons((uint16_t)((p[0] << 8) | p[1]));
+    return addr->sin_port != 0 ? 0 : -1;
+}
+
+static int callback_connect(nfs4_callback_t *cb);
+
+void nfs4_deleg_set_callback(nfs4_deleg_state_t *state, uint64_t clientid,
+                             uint32_t program, uint32_t ident,
+                             const char *netid, const char *addr)
+{
+    nfs4_callback_t *cb = find_callback(state, clientid);
+
+    if (!cb) {
+        for (int i = 0; i < DFUSE_MAX_CLIENTS && !cb; i++) {
+            if (!state->callbacks[i].in_use)
+                cb = &state->callbacks[i];
+        }
+        if (!cb) return;
+    }
+
+    callback_close(cb);
+    memset(cb, 0, sizeof(*cb));
+    cb->in_use = 1;
+    cb->clientid = clientid;
+    cb->program = program;
+    cb->ident = ident;
+    cb->fd = -1;
+
+    if (strcmp(netid, "tcp") != 0 || parse_uaddr(addr, &cb->addr) < 0) {
+        DFUSE_DEBUG("No usable callback path (%s %s)", netid, addr);
+        cb->down = 1;
+        return;
+    }
+
+    /* Start connecting so that the path is ready by the first OPEN */
+    callback_connect(cb);
+}
+
+static int callback_down(nfs4_callback_t *cb)
+{
+    DFUSE_LOG("Callback path of client %llx is down",
+              (unsigned long long)cb->clientid);
+    callback_close(cb);
+    cb->connecting = 0;
+    cb->down = 1;
+    return -1;
+}
+
+/*
+ * Connect to the client's callback service, or reuse the connection made
+ * for an earlier recall after discarding the replies received on it.  The
+ * server loop is never blocked: 1 is returned while the connection is in
+ * progress, 0 once it is established and -1 if the path is down.
+ */
+static int callback_connect(nfs4_callback_t *cb)
+{
+    if (cb->down)
+        return -1;
+
+    if (cb->fd >= 0 && cb->connecting) {
+        struct pollfd pfd = { .fd = cb->fd, .events = POLLOUT, .revents = 0 };
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        if (poll(&pfd, 1, 0) == 0) {
+            if ((time(NULL) - cb->connecting) * 1000 <= DFUSE_CALLBACK_TIMEOUT)
+                return 1;
+            return callback_down(cb);
+        }
+        if (getsockopt(cb->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0)
+            return callback_down(cb);
+
+        cb->connecting = 0;
+        return 0;
+    }
+
+    if (cb->fd >= 0) {
+        char buf[512];
+        ssize_t n;
+        while ((n = read(cb->fd, buf, sizeof(buf))) > 0)
+            ;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return 0;
+        callback_close(cb);
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0)
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    cb->fd = fd;
+    if (connect(fd, (struct sockaddr *)&cb->addr, sizeof(cb->addr)) == 0)
+        return 0;
+    if (errno != EINPROGRESS)
+        return callback_down(cb);
+
+    cb->connecting = time(NULL);
+    return 1;
+}
+
+/*
+ * Send CB_COMPOUND { CB_RECALL } for a delegation (RFC 7530 §16.2).
+ * Returns 1 if the callback connection is still being established.
+ */
+static int send_recall(nfs4_deleg_state_t *state, const nfs4_deleg_t *d)
+{
+    nfs4_callback_t *cb = find_callback(state, d->clientid);
+    if (!cb)
+        return -1;
+
+    int rc = callback_connect(cb);
+    if (rc != 0)
+        return rc;
+
+    uint8_t msg[256];
+    xdr_buf_t x;
+    xdr_init(&x, msg + 4, sizeof(msg) - 4);
+
+    rpc_encode_call(&x, state->next_xid++, cb->program,
+                    NFS4_CALLBACK_VERSION, CB_COMPOUND);
+
+    /* CB_COMPOUND4args { tag, minorversion, callback_ident, argarray<> } */
+    xdr_encode_string(&x, "");
+    xdr_encode_uint32(&x, 0);
+    xdr_encode_uint32(&x, cb->ident);
+    xdr_encode_uint32(&x, 1);
+
+    /* CB_RECALL4args { stateid, truncate, fh } */
+    xdr_encode_uint32(&x, OP_CB_RECALL);
+    xdr_encode_uint32(&x, d->stateid.seqid);
+    xdr_encode_opaque_fixed(&x, d->stateid.other, 12);
+    xdr_encode_bool(&x, 0);
+    uint32_t fh = htonl(d->fh_id);
+    xdr_encode_opaque(&x, &fh, DFUSE_FH_LEN);
+
+    if (x.error)
+        return -1;
+
+    uint32_t len = (uint32_t)xdr_getpos(&x);
+    rpc_encode_record_mark(msg, len, 1);
+
+    /* The message is far smaller than the socket buffer */
+    if (write(cb->fd, msg, 4 + len) != (ssize_t)(4 + len)) {
+        callback_close(cb);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* ---- Delegations ---- */
+
+static void deleg_free(nfs4_deleg_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+static int deleg_expired(const nfs4_deleg_t *d, time_t now)
+{
+    return d->recalled && now - d->recalled >= DFUSE_LEASE_TIME;
+}
+
+static void deleg_revoke(nfs4_deleg_state_t *state, nfs4_deleg_t *d,
+                         const char *reason)
+{
+    DFUSE_LOG("Revoking delegation of client %llx (%s)",
+              (unsigned long long)d->clientid, reason);
+    state->revoked++;
+    deleg_free(d);
+}
+
+void nfs4_deleg_drop_client(nfs4_deleg_state_t *state, uint64_t clientid)
+{
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        if (state->delegs[i].in_use && state->delegs[i].clientid == clientid)
+            deleg_free(&state->delegs[i]);
+    }
+
+    for (int i = 0; i < DFUSE_MAX_CLIENTS * MAX_OPEN_STATEIDS; i++) {
+        if (state->opens[i].count && state->opens[i].clientid == clientid)
+            state->opens[i].count = 0;
+    }
+
+    nfs4_callback_t *cb = find_callback(state, clientid);
+    if (cb) {
+        callback_close(cb);
+        cb->in_use = 0;
+    }
+}
+
+void nfs4_deleg_note_open(nfs4_deleg_state_t *state, uint64_t clientid,
+                          uint32_t fh_id, int delta)
+{
+    nfs4_open_ref_t *free_ref = NULL;
+
+    for (int i = 0; i < DFUSE_MAX_CLIENTS * MAX_OPEN_STATEIDS; i++) {
+        nfs4_open_ref_t *ref = &state->opens[i];
+
+        if (ref->count == 0) {
+            if (!free_ref) free_ref = ref;
+            continue;
+        }
+
+        if (ref->clientid == clientid && ref->fh_id == fh_id) {
+            if (delta < 0 && ref->count > 0)
+                ref->count--;
+            else if (delta > 0)
+                ref->count++;
+            return;
+        }
+    }
+
+    if (delta > 0 && free_ref) {
+        free_ref->clientid = clientid;
+        free_ref->fh_id = fh_id;
+        free_ref->count = 1;
+    }
+}
+
+uint32_t nfs4_deleg_check(nfs4_deleg_state_t *state, uint64_t clientid,
+                          uint32_t fh_id, int write)
+{
+    uint32_t status = NFS4_OK;
+    time_t now = time(NULL);
+
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        nfs4_deleg_t *d = &state->delegs[i];
+
+        if (!d->in_use || d->fh_id != fh_id || d->clientid == clientid)
+            continue;
+        if (d->type == OPEN_DELEGATE_READ && !write)
+            continue;
+
+        if (!d->recalled) {
+            int rc = send_recall(state, d);
+            if (rc < 0) {
+                /* The holder cannot be told; it finds out on its next use */
+                deleg_revoke(state, d, "recall failed");
+                continue;
+            }
+            if (rc > 0) {
+                /* Retried when the client repeats the request */
+                status = NFS4ERR_DELAY;
+                continue;
+            }
+            DFUSE_DEBUG("Recalled delegation of client %llx for fh %u",
+                        (unsigned long long)d->clientid, fh_id);
+            d->recalled = now;
+            state->recalled++;
+        } else if (deleg_expired(d, now)) {
+            deleg_revoke(state, d, "not returned");
+            continue;
+        }
+
+        status = NFS4ERR_DELAY;
+    }
+
+    return status;
+}
+
+const nfs4_deleg_t *nfs4_deleg_grant(nfs4_deleg_state_t *state,
+                                     uint64_t clientid, uint32_t fh_id,
+                                     uint32_t share_access)
+{
+    if (!state->enabled)
+        return NULL;
+
+    nfs4_deleg_t *slot = NULL;
+
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        nfs4_deleg_t *d = &state->delegs[i];
+        if (!d->in_use) {
+            if (!slot) slot = d;
+            continue;
+        }
+        /* The client keeps the delegation it has; others' block a new one */
+        if (d->fh_id == fh_id)
+            return NULL;
+    }
+    if (!slot)
+        return NULL;
+
+    for (int i = 0; i < DFUSE_MAX_CLIENTS * MAX_OPEN_STATEIDS; i++) {
+        const nfs4_open_ref_t *ref = &state->opens[i];
+        if (ref->count && ref->fh_id == fh_id && ref->clientid != clientid)
+            return NULL;
+    }
+
+    /* A delegation is only safe if it can be recalled */
+    nfs4_callback_t *cb = find_callback(state, clientid);
+    if (!cb || callback_connect(cb) != 0)
+        return NULL;
+
+    slot->in_use = 1;
+    slot->type = (share_access & OPEN4_SHARE_ACCESS_WRITE)
+        ? OPEN_DELEGATE_WRITE : OPEN_DELEGATE_READ;
+    slot->fh_id = fh_id;
+    slot->clientid = clientid;
+    slot->stateid.seqid = 1;
+    arc4random_buf(slot->stateid.other, sizeof(slot->stateid.other));
+    slot->recalled = 0;
+
+    state->granted++;
+    return slot;
+}
+
+const nfs4_deleg_t *nfs4_deleg_find(const nfs4_deleg_state_t *state,
+                                    uint64_t clientid, const uint8_t *other)
+{
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        const nfs4_deleg_t *d = &state->delegs[i];
+        if (d->in_use && d->clientid == clientid
+            && memcmp(d->stateid.other, other, 12) == 0)
+            return d;
+    }
+    return NULL;
+}
+
+uint32_t nfs4_deleg_return(nfs4_deleg_state_t *state, uint64_t clientid,
+                           const uint8_t *other)
+{
+    nfs4_deleg_t *d = (nfs4_deleg_t *)nfs4_deleg_find(state, clientid, other);
+    if (!d)
+        return NFS4ERR_BAD_STATEID;
+
+    deleg_free(d);
+    return NFS4_OK;
+}
+
+int64_t nfs4_deleg_next_expiry(const nfs4_deleg_state_t *state)
+{
+    int64_t next = -1;
+    time_t now = time(NULL);
+
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        const nfs4_deleg_t *d = &state->delegs[i];
+        if (!d->in_use || !d->recalled)
+            continue;
+
+        int64_t left = ((int64_t)d->recalled + DFUSE_LEASE_TIME - now) * 1000;
+        if (left < 0) left = 0;
+        if (next < 0 || left < next)
+            next = left;
+    }
+    return next;
+}
+
+void nfs4_deleg_expire(nfs4_deleg_state_t *state)
+{
+    time_t now = time(NULL);
+
+    for (int i = 0; i < DFUSE_MAX_DELEGATIONS; i++) {
+        nfs4_deleg_t *d = &state->delegs[i];
+        if (d->in_use && deleg_expired(d, now))
+            deleg_revoke(state, d, "not returned");
+    }
+}
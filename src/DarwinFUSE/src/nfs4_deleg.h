@@ -0,0 +1,119 @@
+/*
+ * DarwinFUSE — NFSv4.0 delegations and CB_RECALL
+ *
+ * Copyright (c) 2026 Basalt contributors. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+#ifndef DARWINFUSE_NFS4_DELEG_H
+#define DARWINFUSE_NFS4_DELEG_H
+
+#include "nfs4_ops.h"
+#include "darwinfuse_internal.h"
+#include <stdint.h>
+#include <time.h>
+#include <netinet/in.h>
+
+/* Callback program (RFC 7530 §16.33) */
+#define NFS4_CALLBACK_VERSION   1
+#define CB_COMPOUND             1
+#define OP_CB_RECALL            4
+
+/*
+ * A delegation lets the client serve opens, attributes and cached data of
+ * a file locally until the server recalls it.  It is recalled when another
+ * client opens the file, or reads or writes it in a way that conflicts.
+ */
+typedef struct {
+    int            in_use;
+    uint32_t       type;        /* OPEN_DELEGATE_READ or OPEN_DELEGATE_WRITE */
+    uint32_t       fh_id;
+    uint64_t       clientid;
+    nfs4_stateid_t stateid;
+    time_t         recalled;    /* Time CB_RECALL was sent, 0 if not recalled */
+} nfs4_deleg_t;
+
+/* Callback path given by a v4.0 client in SETCLIENTID */
+typedef struct {
+    int                in_use;
+    uint64_t           clientid;
+    uint32_t           program;
+    uint32_t           ident;
+    struct sockaddr_in addr;
+    int                fd;      /* Connection to the callback service, or -1 */
+    time_t             connecting;  /* Time the pending connect started, or 0 */
+    int                down;    /* Connecting failed; no delegations granted */
+} nfs4_callback_t;
+
+/* Files opened by each client, used to decide whether a delegation is safe */
+typedef struct {
+    uint64_t clientid;
+    uint32_t fh_id;
+    uint32_t count;
+} nfs4_open_ref_t;
+
+/* Server-wide state shared by all connections */
+typedef struct nfs4_deleg_state {
+    int              enabled;
+    uint32_t         next_xid;
+    nfs4_callback_t  callbacks[DFUSE_MAX_CLIENTS];
+    nfs4_open_ref_t  opens[DFUSE_MAX_CLIENTS * MAX_OPEN_STATEIDS];
+    nfs4_deleg_t     delegs[DFUSE_MAX_DELEGATIONS];
+
+    uint64_t         granted;
+    uint64_t         recalled;
+    uint64_t         revoked;
+} nfs4_deleg_state_t;
+
+void nfs4_deleg_init(nfs4_deleg_state_t *state, int enabled);
+void nfs4_deleg_destroy(nfs4_deleg_state_t *state);
+
+/*
+ * Record the callback path of a client (SETCLIENTID).  netid and addr are
+ * the RPC universal address; only "tcp" is supported.
+ */
+void nfs4_deleg_set_callback(nfs4_deleg_state_t *state, uint64_t clientid,
+                             uint32_t program, uint32_t ident,
+                             const char *netid, const char *addr);
+
+/* Forget the delegations, opens and callback path of a client */
+void nfs4_deleg_drop_client(nfs4_deleg_state_t *state, uint64_t clientid);
+
+/* Track the opens of a client; delta is +1 for OPEN and -1 for CLOSE */
+void nfs4_deleg_note_open(nfs4_deleg_state_t *state, uint64_t clientid,
+                          uint32_t fh_id, int delta);
+
+/*
+ * Check an access to a file by a client against the delegations held by
+ * other clients.  Conflicting delegations are recalled and NFS4ERR_DELAY is
+ * returned until they have been returned, or revoked after the lease time.
+ */
+uint32_t nfs4_deleg_check(nfs4_deleg_state_t *state, uint64_t clientid,
+                          uint32_t fh_id, int write);
+
+/*
+ * Grant a delegation for a file just opened by a client, if no other
+ * client has it open and the client's callback path works.  Returns NULL
+ * if no delegation is granted.
+ */
+const nfs4_deleg_t *nfs4_deleg_grant(nfs4_deleg_state_t *state,
+                                     uint64_t clientid, uint32_t fh_id,
+                                     uint32_t share_access);
+
+/* Look up a delegation of a client by the "other" field of its stateid */
+const nfs4_deleg_t *nfs4_deleg_find(const nfs4_deleg_state_t *state,
+                                    uint64_t clientid, const uint8_t *other);
+
+/* DELEGRETURN: NFS4_OK or NFS4ERR_BAD_STATEID */
+uint32_t nfs4_deleg_return(nfs4_deleg_state_t *state, uint64_t clientid,
+                           const uint8_t *other);
+
+/*
+ * Milliseconds until the first recalled delegation reaches the end of its
+ * lease, or -1 if no recall is pending.  The server arms its timer with it
+ * and then calls nfs4_deleg_expire() to revoke what was not returned.
+ */
+int64_t nfs4_deleg_next_expiry(const nfs4_deleg_state_t *state);
+void nfs4_deleg_expire(nfs4_deleg_state_t *state);
+
+#endif /* DARWINFUSE_NFS4_DELEG_H */
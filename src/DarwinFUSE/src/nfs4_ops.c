@@ -9,13 +9,19 @@
  * Licensed under the MIT License.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* SEEK_DATA and SEEK_HOLE with -std=c11 */
+#endif
+
 #include "nfs4_ops.h"
+#include "nfs4_deleg.h"
 #include "nfs4_xdr.h"
 #include "darwinfuse_internal.h"
 #include "fuse_context.h"
 
 #include <fuse.h>
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -38,10 +44,8 @@ static uint32_t fh_get_id(const uint8_t *fh, uint32_t fh_len)
     return ntohl(net);
 }
 
-static const char *fh_to_path(const darwinfuse_config_t *config,
-                               const uint8_t *fh, uint32_t fh_len)
+static const char *id_to_path(const darwinfuse_config_t *config, uint32_t id)
 {
-    uint32_t id = fh_get_id(fh, fh_len);
     switch (id) {
     case DFUSE_FH_ROOT:    return "/";
     case DFUSE_FH_VOLUME:  return config->volume_path;
@@ -63,6 +67,172 @@ static uint32_t name_to_fh_id(const darwinfuse_config_t *config, const char *nam
     return 0;
 }
 
+/* ---- Client state helpers ---- */
+
+/* Recall delegations of other clients that conflict with an access */
+static uint32_t check_delegations(nfs4_conn_state_t *conn, uint32_t id,
+                                  int write)
+{
+    if (!conn->delegs) return NFS4_OK;
+    return nfs4_deleg_check(conn->delegs, conn->clientid, id, write);
+}
+
+/* ---- Filesystem callbacks ---- */
+
+/*
+ * The server exports a single flat directory whose inode is FUSE_ROOT_ID
+ * (== DFUSE_FH_ROOT).  With low-level callbacks, filehandle ids are the
+ * filesystem's inode numbers; otherwise they are mapped to the fixed
+ * paths of the volume and control files.  The helpers below return 0 or
+ * a byte count on success and a negated errno value on failure.
+ */
+
+static int fs_lookup(const darwinfuse_config_t *config, uint32_t parent,
+                     const char *name, uint32_t *id)
+{
+    if (config->ll_ops) {
+        fuse_ino_t ino = 0;
+        if (!config->ll_ops->lookup) return -ENOSYS;
+
+        int rc = config->ll_ops->lookup(parent, name, &ino);
+        if (rc != 0) return rc;
+        if (ino == 0 || ino > UINT32_MAX) return -EOVERFLOW;
+
+        *id = (uint32_t)ino;
+        return 0;
+    }
+
+    if (parent != DFUSE_FH_ROOT) return -ENOTDIR;
+
+    *id = name_to_fh_id(config, name);
+    return *id ? 0 : -ENOENT;
+}
+
+/*
+ * The control file changes without writes through the mount, so the client
+ * must not use cached data of it whatever its attribute cache timeout is.
+ * Its mtime, and with it the change attribute, advances on every GETATTR;
+ * each revalidation (at least every open) then discards the cached data.
+ */
+static void control_uncached(struct stat *st)
+{
+#ifdef __APPLE__
+    clock_gettime(CLOCK_REALTIME, &st->st_mtimespec);
+#else
+    st->st_mtime = time(NULL);
+#endif
+}
+
+static int fs_getattr(const darwinfuse_config_t *config, uint32_t id,
+                      struct stat *st)
+{
+    int rc;
+
+    if (config->ll_ops) {
+        if (!config->ll_ops->getattr) return -ENOSYS;
+        rc = config->ll_ops->getattr(id, st);
+    } else {
+        const char *path = id_to_path(config, id);
+        if (!path) return -ENOENT;
+        if (!config->ops->getattr) return -ENOSYS;
+        rc = config->ops->getattr(path, st);
+    }
+
+    if (rc == 0 && id == DFUSE_FH_CONTROL)
+        control_uncached(st);
+    return rc;
+}
+
+static int fs_access(const darwinfuse_config_t *config, uint32_t id, int mask)
+{
+    if (config->ll_ops) {
+        if (!config->ll_ops->access) return 0;
+        return config->ll_ops->access(id, mask);
+    }
+
+    const char *path = id_to_path(config, id);
+    if (!path) return -ENOENT;
+    if (!config->ops->access) return 0;
+    return config->ops->access(path, mask);
+}
+
+static int fs_open(const darwinfuse_config_t *config, uint32_t id,
+                   struct fuse_file_info *fi)
+{
+    if (config->ll_ops) {
+        if (!config->ll_ops->open) return 0;
+        return config->ll_ops->open(id, fi);
+    }
+
+    const char *path = id_to_path(config, id);
+    if (!path) return -ENOENT;
+    if (!config->ops->open) return 0;
+    return config->ops->open(path, fi);
+}
+
+static void fs_release(const darwinfuse_config_t *config, uint32_t id,
+                       struct fuse_file_info *fi)
+{
+    if (config->ll_ops) {
+        if (config->ll_ops->release)
+            config->ll_ops->release(id, fi);
+        return;
+    }
+
+    const char *path = id_to_path(config, id);
+    if (path && config->ops->release)
+        config->ops->release(path, fi);
+}
+
+static int fs_read(const darwinfuse_config_t *config, uint32_t id,
+                   char *buf, size_t size, off_t off, struct fuse_file_info *fi)
+{
+    if (config->ll_ops) {
+        if (!config->ll_ops->read) return -ENOSYS;
+        return config->ll_ops->read(id, buf, size, off, fi);
+    }
+
+    const char *path = id_to_path(config, id);
+    if (!path) return -ENOENT;
+    if (!config->ops->read) return -ENOSYS;
+    return config->ops->read(path, buf, size, off, fi);
+}
+
+static int fs_write(const darwinfuse_config_t *config, uint32_t id,
+                    const char *buf, size_t size, off_t off,
+                    struct fuse_file_info *fi)
+{
+    if (config->ll_ops) {
+        if (!config->ll_ops->write) return -EROFS;
+        return config->ll_ops->write(id, buf, size, off, fi);
+    }
+
+    const char *path = id_to_path(config, id);
+    if (!path) return -ENOENT;
+    if (!config->ops->write) return -EROFS;
+    return config->ops->write(path, buf, size, off, fi);
+}
+
+static int fs_has_fsync(const darwinfuse_config_t *config)
+{
+    return config->ll_ops ? config->ll_ops->fsync != NULL
+                          : config->ops->fsync != NULL;
+}
+
+static int fs_fsync(const darwinfuse_config_t *config, uint32_t id,
+                    int datasync, struct fuse_file_info *fi)
+{
+    if (config->ll_ops) {
+        if (!config->ll_ops->fsync) return 0;
+        return config->ll_ops->fsync(id, datasync, fi);
+    }
+
+    const char *path = id_to_path(config, id);
+    if (!path) return -ENOENT;
+    if (!config->ops->fsync) return 0;
+    return config->ops->fsync(path, datasync, fi);
+}
+
 /* ---- Attribute bitmap helpers ---- */
 
 /* Our supported attributes — two bitmap words */
@@ -215,7 +385,7 @@ static void encode_fattr4(xdr_buf_t *xdr,
     }
 
     if (ATTR_SET(FATTR4_LEASE_TIME)) {
-        xdr_encode_uint32(&attr, 90);  /* 90-second lease */
+        xdr_encode_uint32(&attr, DFUSE_LEASE_TIME);
     }
 
     if (ATTR_SET(FATTR4_RDATTR_ERROR)) {
@@ -329,8 +499,9 @@ static uint32_t handle_putfh(const darwinfuse_config_t *config,
     uint32_t fh_len = xdr_decode_opaque(req, fh, sizeof(fh));
     if (req->error) return NFS4ERR_BADHANDLE;
 
+    /* Inode numbers of a low-level filesystem are validated on use */
     uint32_t id = fh_get_id(fh, fh_len);
-    if (id < DFUSE_FH_ROOT || id > DFUSE_FH_CONTROL)
+    if (id == 0 || (!config->ll_ops && id > DFUSE_FH_CONTROL))
         return NFS4ERR_BADHANDLE;
 
     memcpy(conn->current_fh, fh, fh_len);
@@ -376,19 +547,20 @@ static uint32_t handle_lookup(const darwinfuse_config_t *config,
                                xdr_buf_t *req, xdr_buf_t *rep)
 {
     /* Current FH must be a directory (root) */
-    if (fh_get_id(conn->current_fh, conn->current_fh_len) != DFUSE_FH_ROOT)
+    uint32_t parent = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (parent != DFUSE_FH_ROOT)
         return NFS4ERR_NOTDIR;
 
     char name[256];
     xdr_decode_string(req, name, sizeof(name));
     if (req->error) return NFS4ERR_INVAL;
 
-    DFUSE_LOG("  LOOKUP name='%s' (vol='%s' ctl='%s')",
-              name, config->volume_path, config->control_path);
+    DFUSE_TRACE("  LOOKUP name='%s' (vol='%s' ctl='%s')",
+                name, config->volume_path, config->control_path);
 
-    uint32_t id = name_to_fh_id(config, name);
-    if (id == 0) {
-        DFUSE_LOG("  LOOKUP '%s' -> NOENT", name);
+    uint32_t id = 0;
+    if (fs_lookup(config, parent, name, &id) != 0) {
+        DFUSE_TRACE("  LOOKUP '%s' -> NOENT", name);
         return NFS4ERR_NOENT;
     }
 
@@ -406,18 +578,15 @@ static uint32_t handle_getattr(const darwinfuse_config_t *config,
     decode_bitmap(req, req_bitmap, &req_nwords);
     if (req->error) return NFS4ERR_INVAL;
 
-    const char *path = fh_to_path(config, conn->current_fh, conn->current_fh_len);
-    if (!path) return NFS4ERR_BADHANDLE;
+    uint32_t id = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (id == 0) return NFS4ERR_BADHANDLE;
 
     struct stat st;
     memset(&st, 0, sizeof(st));
 
-    if (config->ops->getattr) {
-        int rc = config->ops->getattr(path, &st);
-        if (rc != 0) return NFS4ERR_IO;
-    } else {
-        return NFS4ERR_IO;
-    }
+    int rc = fs_getattr(config, id, &st);
+    if (rc == -ENOENT) return NFS4ERR_STALE;
+    if (rc != 0) return NFS4ERR_IO;
 
     encode_fattr4(rep, &st, req_bitmap, req_nwords,
                   conn->current_fh, conn->current_fh_len);
@@ -450,21 +619,21 @@ static uint32_t handle_access(const darwinfuse_config_t *config,
     uint32_t requested = xdr_decode_uint32(req);
     if (req->error) return NFS4ERR_INVAL;
 
-    const char *path = fh_to_path(config, conn->current_fh, conn->current_fh_len);
-    if (!path) return NFS4ERR_BADHANDLE;
+    uint32_t id = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (id == 0) return NFS4ERR_BADHANDLE;
 
-    uint32_t granted = requested;  /* default: grant everything */
+    /* Everything is granted when the filesystem has no access callback */
+    uint32_t granted = requested;
 
-    if (config->ops->access) {
-        int mask = 0;
-        if (requested & ACCESS4_READ)    mask |= R_OK;
-        if (requested & ACCESS4_MODIFY)  mask |= W_OK;
-        if (requested & ACCESS4_EXECUTE) mask |= X_OK;
+    int mask = 0;
+    if (requested & ACCESS4_READ)    mask |= R_OK;
+    if (requested & ACCESS4_MODIFY)  mask |= W_OK;
+    if (requested & ACCESS4_EXECUTE) mask |= X_OK;
 
-        int rc = config->ops->access(path, mask);
-        if (rc != 0)
-            granted = 0;
-    }
+    int rc = fs_access(config, id, mask);
+    if (rc == -ENOENT) return NFS4ERR_STALE;
+    if (rc != 0)
+        granted = 0;
 
     /* Encode: supported, access */
     xdr_encode_uint32(rep, requested);  /* supported */
@@ -480,6 +649,7 @@ static uint32_t handle_access(const darwinfuse_config_t *config,
 typedef struct {
     char     name[256];
     uint64_t cookie;
+    uint32_t id;        /* 0 if not reported by the filesystem */
 } readdir_entry_t;
 
 typedef struct {
@@ -487,20 +657,35 @@ typedef struct {
     int count;
 } readdir_collector_t;
 
-static int readdir_filler(void *buf, const char *name,
-                           const struct stat *stbuf, off_t off)
+static int readdir_collect(readdir_collector_t *col, const char *name,
+                           uint32_t id)
 {
-    readdir_collector_t *col = (readdir_collector_t *)buf;
     if (col->count >= MAX_READDIR_ENTRIES) return 1;
 
     readdir_entry_t *e = &col->entries[col->count];
     strncpy(e->name, name, sizeof(e->name) - 1);
     e->name[sizeof(e->name) - 1] = '\0';
     e->cookie = (uint64_t)(col->count + 1);
+    e->id = id;
     col->count++;
     return 0;
 }
 
+static int readdir_filler(void *buf, const char *name,
+                           const struct stat *stbuf, off_t off)
+{
+    (void)stbuf; (void)off;
+    return readdir_collect((readdir_collector_t *)buf, name, 0);
+}
+
+static int readdir_filler_ll(void *buf, const char *name,
+                              fuse_ino_t ino, off_t off)
+{
+    (void)off;
+    return readdir_collect((readdir_collector_t *)buf, name,
+                           ino <= UINT32_MAX ? (uint32_t)ino : 0);
+}
+
 static uint32_t handle_readdir(const darwinfuse_config_t *config,
                                 nfs4_conn_state_t *conn,
                                 xdr_buf_t *req, xdr_buf_t *rep)
@@ -528,9 +713,14 @@ static uint32_t handle_readdir(const darwinfuse_config_t *config,
     readdir_collector_t collector;
     memset(&collector, 0, sizeof(collector));
 
-    if (config->ops->readdir) {
-        struct fuse_file_info fi;
-        memset(&fi, 0, sizeof(fi));
+    struct fuse_file_info fi;
+    memset(&fi, 0, sizeof(fi));
+
+    if (config->ll_ops) {
+        if (config->ll_ops->readdir)
+            config->ll_ops->readdir(FUSE_ROOT_ID, &collector,
+                                    readdir_filler_ll, 0, &fi);
+    } else if (config->ops->readdir) {
         config->ops->readdir("/", &collector, readdir_filler, 0, &fi);
     }
 
@@ -556,22 +746,22 @@ static uint32_t handle_readdir(const darwinfuse_config_t *config,
         /* component name */
         xdr_encode_string(rep, e->name);
 
-        /* Per-entry attributes — get stat for this entry */
-        char path[512];
-        snprintf(path, sizeof(path), "/%s", e->name);
-
-        struct stat st;
-        memset(&st, 0, sizeof(st));
-        if (config->ops->getattr)
-            config->ops->getattr(path, &st);
-
         /* Determine this entry's filehandle */
-        uint32_t eid = name_to_fh_id(config, e->name);
+        uint32_t eid = e->id;
+        if (eid == 0)
+            fs_lookup(config, DFUSE_FH_ROOT, e->name, &eid);
+
         uint8_t efh[4];
         uint32_t efh_len = 0;
         if (eid)
             fh_set(efh, &efh_len, eid);
 
+        /* Per-entry attributes */
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        if (eid)
+            fs_getattr(config, eid, &st);
+
         encode_fattr4(rep, &st, attr_bitmap, attr_nwords, efh, efh_len);
     }
 
@@ -626,8 +816,20 @@ static uint32_t handle_open(const darwinfuse_config_t *config,
         if (fh_get_id(conn->current_fh, conn->current_fh_len) != DFUSE_FH_ROOT)
             return NFS4ERR_NOTDIR;
 
-        target_fh_id = name_to_fh_id(config, filename);
-        if (target_fh_id == 0)
+        if (fs_lookup(config, DFUSE_FH_ROOT, filename, &target_fh_id) != 0)
+            return NFS4ERR_NOENT;
+    } else if (claim_type == CLAIM_DELEGATE_CUR) {
+        /* Open under a delegation being returned: { delegate_stateid, file } */
+        uint8_t deleg_other[12];
+        xdr_decode_uint32(req);
+        xdr_decode_opaque_fixed(req, deleg_other, 12);
+        xdr_decode_string(req, filename, sizeof(filename));
+
+        if (!conn->delegs
+            || !nfs4_deleg_find(conn->delegs, conn->clientid, deleg_other))
+            return NFS4ERR_BAD_STATEID;
+
+        if (fs_lookup(config, DFUSE_FH_ROOT, filename, &target_fh_id) != 0)
             return NFS4ERR_NOENT;
     } else if (claim_type == CLAIM_FH) {
         /* Open current filehandle */
@@ -640,14 +842,15 @@ static uint32_t handle_open(const darwinfuse_config_t *config,
 
     if (req->error) return NFS4ERR_INVAL;
 
-    /* Call FUSE open callback */
-    const char *path = NULL;
-    switch (target_fh_id) {
-    case DFUSE_FH_VOLUME:  path = config->volume_path; break;
-    case DFUSE_FH_CONTROL: path = config->control_path; break;
-    default:               return NFS4ERR_ISDIR;
-    }
+    if (target_fh_id == DFUSE_FH_ROOT)
+        return NFS4ERR_ISDIR;
 
+    uint32_t status = check_delegations(conn, target_fh_id,
+                                        (share_access & OPEN4_SHARE_ACCESS_WRITE) != 0);
+    if (status != NFS4_OK)
+        return status;
+
+    /* Call FUSE open callback */
     struct fuse_file_info fi;
     memset(&fi, 0, sizeof(fi));
     if (share_access & OPEN4_SHARE_ACCESS_WRITE)
@@ -655,10 +858,9 @@ static uint32_t handle_open(const darwinfuse_config_t *config,
     else
         fi.flags = O_RDONLY;
 
-    if (config->ops->open) {
-        int rc = config->ops->open(path, &fi);
-        if (rc != 0) return NFS4ERR_ACCESS;
-    }
+    int rc = fs_open(config, target_fh_id, &fi);
+    if (rc == -ENOENT) return NFS4ERR_NOENT;
+    if (rc != 0) return NFS4ERR_ACCESS;
 
     /* Generate a stateid */
     nfs4_stateid_t sid;
@@ -666,13 +868,26 @@ static uint32_t handle_open(const darwinfuse_config_t *config,
     sid.seqid = conn->open_seqid;
     arc4random_buf(sid.other, sizeof(sid.other));
 
-    /* Store stateid */
+    /* Store stateid; without a free slot, I/O falls back to implicit opens */
     if (conn->open_stateid_count < MAX_OPEN_STATEIDS) {
         conn->open_stateids[conn->open_stateid_count] = sid;
         conn->open_fh_ids[conn->open_stateid_count] = target_fh_id;
+        conn->open_file_handles[conn->open_stateid_count] = fi.fh;
         conn->open_stateid_count++;
+        if (conn->delegs)
+            nfs4_deleg_note_open(conn->delegs, conn->clientid,
+                                 target_fh_id, 1);
+    } else {
+        fs_release(config, target_fh_id, &fi);
     }
 
+    /* The control file is never delegated; its data must not be cached */
+    const nfs4_deleg_t *deleg = NULL;
+    if (conn->delegs && claim_type != CLAIM_DELEGATE_CUR
+        && target_fh_id != DFUSE_FH_CONTROL)
+        deleg = nfs4_deleg_grant(conn->delegs, conn->clientid,
+                                 target_fh_id, share_access);
+
     /* Set current FH to opened file */
     fh_set(conn->current_fh, &conn->current_fh_len, target_fh_id);
 
@@ -692,12 +907,101 @@ static uint32_t handle_open(const darwinfuse_config_t *config,
     /* attrset bitmap (empty) */
     xdr_encode_uint32(rep, 0);
 
-    /* delegation: OPEN_DELEGATE_NONE */
-    xdr_encode_uint32(rep, OPEN_DELEGATE_NONE);
+    /* open_delegation4 */
+    if (!deleg) {
+        xdr_encode_uint32(rep, OPEN_DELEGATE_NONE);
+        return NFS4_OK;
+    }
+
+    xdr_encode_uint32(rep, deleg->type);
+    xdr_encode_uint32(rep, deleg->stateid.seqid);
+    xdr_encode_opaque_fixed(rep, deleg->stateid.other, 12);
+    xdr_encode_bool(rep, 0);            /* recall */
+
+    if (deleg->type == OPEN_DELEGATE_WRITE) {
+        /* space_limit: writes do not have to be flushed to reserve space */
+        xdr_encode_uint32(rep, NFS_LIMIT_SIZE);
+        xdr_encode_uint64(rep, UINT64_MAX);
+    }
+
+    /* permissions: an empty ACE, ACCESS is still checked by the server */
+    xdr_encode_uint32(rep, ACE4_ACCESS_ALLOWED_ACE_TYPE);
+    xdr_encode_uint32(rep, 0);
+    xdr_encode_uint32(rep, 0);
+    xdr_encode_string(rep, "");
 
     return NFS4_OK;
 }
 
+static int find_open_stateid(const nfs4_conn_state_t *conn,
+                             const uint8_t *other)
+{
+    for (int i = 0; i < conn->open_stateid_count; i++) {
+        if (memcmp(conn->open_stateids[i].other, other, 12) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Set up the file info for READ/WRITE on a file under the given stateid.
+ * The handle stored by a matching OPEN is reused.  For anonymous or unknown
+ * stateids a low-level filesystem gets an implicit open, undone by
+ * end_io(); path-based callbacks are called without a handle.
+ */
+static uint32_t begin_io(const darwinfuse_config_t *config,
+                         const nfs4_conn_state_t *conn, uint32_t id,
+                         const uint8_t *sid_other, int flags,
+                         struct fuse_file_info *fi, int *implicit_open)
+{
+    memset(fi, 0, sizeof(*fi));
+    fi->flags = flags;
+    *implicit_open = 0;
+
+    int i = find_open_stateid(conn, sid_other);
+    if (i >= 0 && conn->open_fh_ids[i] == id) {
+        fi->fh = conn->open_file_handles[i];
+        return NFS4_OK;
+    }
+
+    if (!config->ll_ops)
+        return NFS4_OK;
+
+    int rc = fs_open(config, id, fi);
+    if (rc == -ENOENT) return NFS4ERR_STALE;
+    if (rc == -EISDIR) return NFS4ERR_ISDIR;
+    if (rc != 0) return NFS4ERR_ACCESS;
+
+    *implicit_open = 1;
+    return NFS4_OK;
+}
+
+static void end_io(const darwinfuse_config_t *config, uint32_t id,
+                   struct fuse_file_info *fi, int implicit_open)
+{
+    if (implicit_open)
+        fs_release(config, id, fi);
+}
+
+void nfs4_conn_release(const darwinfuse_config_t *config,
+                       nfs4_conn_state_t *conn)
+{
+    for (int i = 0; i < conn->open_stateid_count; i++) {
+        struct fuse_file_info fi;
+        memset(&fi, 0, sizeof(fi));
+        fi.fh = conn->open_file_handles[i];
+        fs_release(config, conn->open_fh_ids[i], &fi);
+        if (conn->delegs)
+            nfs4_deleg_note_open(conn->delegs, conn->clientid,
+                                 conn->open_fh_ids[i], -1);
+    }
+    conn->open_stateid_count = 0;
+
+    /* A client's state ends with its connection */
+    if (conn->delegs && conn->clientid)
+        nfs4_deleg_drop_client(conn->delegs, conn->clientid);
+}
+
 static uint32_t handle_open_confirm(const darwinfuse_config_t *config,
                                      nfs4_conn_state_t *conn,
                                      xdr_buf_t *req, xdr_buf_t *rep)
@@ -729,8 +1033,6 @@ static uint32_t handle_close(const darwinfuse_config_t *config,
                               nfs4_conn_state_t *conn,
                               xdr_buf_t *req, xdr_buf_t *rep)
 {
-    (void)config;
-
     uint32_t seqid = xdr_decode_uint32(req);
     (void)seqid;
     uint32_t sid_seqid = xdr_decode_uint32(req);
@@ -738,20 +1040,28 @@ static uint32_t handle_close(const darwinfuse_config_t *config,
     xdr_decode_opaque_fixed(req, sid_other, 12);
 
     /* Find and remove stateid */
-    for (int i = 0; i < conn->open_stateid_count; i++) {
-        if (memcmp(conn->open_stateids[i].other, sid_other, 12) == 0) {
-            /* Return invalidated stateid */
-            xdr_encode_uint32(rep, sid_seqid + 1);
-            xdr_encode_opaque_fixed(rep, sid_other, 12);
-
-            /* Remove from array */
-            conn->open_stateid_count--;
-            if (i < conn->open_stateid_count) {
-                conn->open_stateids[i] = conn->open_stateids[conn->open_stateid_count];
-                conn->open_fh_ids[i] = conn->open_fh_ids[conn->open_stateid_count];
-            }
-            return NFS4_OK;
+    int i = find_open_stateid(conn, sid_other);
+    if (i >= 0) {
+        struct fuse_file_info fi;
+        memset(&fi, 0, sizeof(fi));
+        fi.fh = conn->open_file_handles[i];
+        fs_release(config, conn->open_fh_ids[i], &fi);
+        if (conn->delegs)
+            nfs4_deleg_note_open(conn->delegs, conn->clientid,
+                                 conn->open_fh_ids[i], -1);
+
+        /* Return invalidated stateid */
+        xdr_encode_uint32(rep, sid_seqid + 1);
+        xdr_encode_opaque_fixed(rep, sid_other, 12);
+
+        /* Remove from array */
+        conn->open_stateid_count--;
+        if (i < conn->open_stateid_count) {
+            conn->open_stateids[i] = conn->open_stateids[conn->open_stateid_count];
+            conn->open_fh_ids[i] = conn->open_fh_ids[conn->open_stateid_count];
+            conn->open_file_handles[i] = conn->open_file_handles[conn->open_stateid_count];
         }
+        return NFS4_OK;
     }
 
     /* Unknown stateid — still return success with zeroed stateid */
@@ -766,49 +1076,64 @@ static uint32_t handle_read(const darwinfuse_config_t *config,
                              xdr_buf_t *req, xdr_buf_t *rep)
 {
     /* stateid4 */
+    uint8_t sid_other[12];
     xdr_decode_uint32(req);  /* seqid */
-    xdr_skip(req, 12);       /* other */
+    xdr_decode_opaque_fixed(req, sid_other, 12);
 
     uint64_t offset = xdr_decode_uint64(req);
     uint32_t count  = xdr_decode_uint32(req);
     if (req->error) return NFS4ERR_INVAL;
 
-    const char *path = fh_to_path(config, conn->current_fh, conn->current_fh_len);
-    if (!path) return NFS4ERR_BADHANDLE;
-
-    if (!config->ops->read)
-        return NFS4ERR_NOTSUPP;
+    uint32_t id = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (id == 0) return NFS4ERR_BADHANDLE;
 
-    /* Allocate read buffer */
     if (count > 65536) count = 65536;
-    uint8_t *buf = malloc(count);
-    if (!buf) return NFS4ERR_SERVERFAULT;
+
+    uint32_t status = check_delegations(conn, id, 0);
+    if (status != NFS4_OK) return status;
 
     struct fuse_file_info fi;
-    memset(&fi, 0, sizeof(fi));
+    int implicit_open;
+    status = begin_io(config, conn, id, sid_other, O_RDONLY,
+                      &fi, &implicit_open);
+    if (status != NFS4_OK) return status;
+
+    /* Encode READ4resok: { eof, data }, reading directly into the reply */
+    size_t start_pos = xdr_getpos(rep);
+    size_t eof_pos = start_pos;
+    xdr_encode_bool(rep, 0);
+
+    uint8_t *buf = xdr_encode_opaque_begin(rep, count);
+    if (!buf) {
+        end_io(config, id, &fi, implicit_open);
+        rep->error = 0;
+        xdr_setpos(rep, start_pos);
+        return NFS4ERR_RESOURCE;
+    }
+
+    int n = fs_read(config, id, (char *)buf, count, (off_t)offset, &fi);
+    end_io(config, id, &fi, implicit_open);
 
-    int n = config->ops->read(path, (char *)buf, count, (off_t)offset, &fi);
     if (n < 0) {
-        DFUSE_LOG("  READ '%s' offset=%llu count=%u -> error %d",
-                  path, (unsigned long long)offset, count, n);
-        free(buf);
-        return NFS4ERR_IO;
+        DFUSE_LOG("  READ fileid=%u offset=%llu count=%u -> error %d",
+                  id, (unsigned long long)offset, count, n);
+        xdr_setpos(rep, start_pos);
+        return n == -ENOSYS ? NFS4ERR_NOTSUPP : NFS4ERR_IO;
     }
 
+    xdr_encode_opaque_end(rep, (uint32_t)n);
+
     /* Determine EOF */
     struct stat st;
     memset(&st, 0, sizeof(st));
-    int eof = 0;
-    if (config->ops->getattr) {
-        config->ops->getattr(path, &st);
-        eof = ((uint64_t)offset + (uint64_t)n >= (uint64_t)st.st_size) ? 1 : 0;
+    if (fs_getattr(config, id, &st) == 0
+        && (uint64_t)offset + (uint64_t)n >= (uint64_t)st.st_size) {
+        size_t end_pos = xdr_getpos(rep);
+        xdr_setpos(rep, eof_pos);
+        xdr_encode_bool(rep, 1);
+        xdr_setpos(rep, end_pos);
     }
 
-    /* Encode READ4resok: { eof, data } */
-    xdr_encode_bool(rep, eof);
-    xdr_encode_opaque(rep, buf, (uint32_t)n);
-
-    free(buf);
     return NFS4_OK;
 }
 
@@ -817,12 +1142,12 @@ static uint32_t handle_write(const darwinfuse_config_t *config,
                               xdr_buf_t *req, xdr_buf_t *rep)
 {
     /* stateid4 */
+    uint8_t sid_other[12];
     xdr_decode_uint32(req);  /* seqid */
-    xdr_skip(req, 12);       /* other */
+    xdr_decode_opaque_fixed(req, sid_other, 12);
 
     uint64_t offset = xdr_decode_uint64(req);
     uint32_t stable = xdr_decode_uint32(req);
-    (void)stable;
 
     /* data (opaque) */
     uint8_t *data = NULL;
@@ -838,27 +1163,47 @@ static uint32_t handle_write(const darwinfuse_config_t *config,
     data = req->data + req->pos;
     xdr_skip(req, padded);
 
-    const char *path = fh_to_path(config, conn->current_fh, conn->current_fh_len);
-    if (!path) return NFS4ERR_BADHANDLE;
+    uint32_t id = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (id == 0) return NFS4ERR_BADHANDLE;
 
-    if (!config->ops->write)
-        return NFS4ERR_ROFS;
+    uint32_t status = check_delegations(conn, id, 1);
+    if (status != NFS4_OK) return status;
 
     struct fuse_file_info fi;
-    memset(&fi, 0, sizeof(fi));
+    int implicit_open;
+    status = begin_io(config, conn, id, sid_other, O_RDWR,
+                      &fi, &implicit_open);
+    if (status != NFS4_OK) return status;
+
+    int n = fs_write(config, id, (const char *)data, data_len_raw,
+                     (off_t)offset, &fi);
+
+    /*
+     * Unstable writes are made durable by a later COMMIT, which lets the
+     * filesystem batch many writes into one flush.  Without an fsync
+     * callback nothing more can be done, so the data is reported as
+     * committed as before.
+     */
+    uint32_t committed = FILE_SYNC4;
+    if (n >= 0 && fs_has_fsync(config)) {
+        if (stable == UNSTABLE4) {
+            committed = UNSTABLE4;
+        } else if (fs_fsync(config, id, stable == DATA_SYNC4, &fi) < 0) {
+            n = -EIO;
+        }
+    }
 
-    int n = config->ops->write(path, (const char *)data, data_len_raw,
-                                (off_t)offset, &fi);
+    end_io(config, id, &fi, implicit_open);
+
+    if (n == -EROFS)
+        return NFS4ERR_ROFS;
     if (n < 0)
         return NFS4ERR_IO;
 
     /* Encode WRITE4resok: { count, committed, writeverf } */
     xdr_encode_uint32(rep, (uint32_t)n);
-    xdr_encode_uint32(rep, FILE_SYNC4);
-
-    /* Write verifier — 8 bytes, fixed for this server instance */
-    uint8_t writeverf[8] = {'D','F','U','S','E','v','0','1'};
-    xdr_encode_opaque_fixed(rep, writeverf, 8);
+    xdr_encode_uint32(rep, committed);
+    xdr_encode_opaque_fixed(rep, config->write_verifier, 8);
 
     return NFS4_OK;
 }
@@ -870,10 +1215,35 @@ static uint32_t handle_commit(const darwinfuse_config_t *config,
     /* Decode: offset (uint64), count (uint32) */
     xdr_decode_uint64(req);
     xdr_decode_uint32(req);
+    if (req->error) return NFS4ERR_INVAL;
+
+    uint32_t id = fh_get_id(conn->current_fh, conn->current_fh_len);
+    if (id == 0) return NFS4ERR_BADHANDLE;
+
+    /*
+     * The whole file is flushed regardless of the range.  Concurrent
+     * COMMITs and fsync() calls are coalesced by the filesystem.  COMMIT
+     * carries no stateid, so a low-level filesystem is given an implicit
+     * open for it.
+     */
+    if (fs_has_fsync(config)) {
+        static const uint8_t anonymous_stateid[12];
+        struct fuse_file_info fi;
+        int implicit_open;
+
+        uint32_t status = begin_io(config, conn, id, anonymous_stateid,
+                                   O_RDWR, &fi, &implicit_open);
+        if (status != NFS4_OK) return status;
+
+        int rc = fs_fsync(config, id, 1, &fi);
+        end_io(config, id, &fi, implicit_open);
+
+        if (rc < 0)
+            return NFS4ERR_IO;
+    }
 
     /* Reply: writeverf */
-    uint8_t writeverf[8] = {'D','F','U','S','E','v','0','1'};
-    xdr_encode_opaque_fixed(rep, writeverf, 8);
+    xdr_encode_opaque_fixed(rep, config->write_verifier, 8);
 
     return NFS4_OK;
 }
@@ -894,17 +1264,25 @@ static uint32_t handle_setclientid(const darwinfuse_config_t *config,
     xdr_skip_opaque(req);
 
     /* callback (cb_program, cb_location: netid + addr) */
-    xdr_decode_uint32(req);    /* cb_program */
-    xdr_skip_string(req);      /* r_netid */
-    xdr_skip_string(req);      /* r_addr */
+    char netid[16], addr[64];
+    uint32_t cb_program = xdr_decode_uint32(req);
+    xdr_decode_string(req, netid, sizeof(netid));
+    xdr_decode_string(req, addr, sizeof(addr));
 
     /* callback_ident */
-    xdr_decode_uint32(req);
+    uint32_t cb_ident = xdr_decode_uint32(req);
 
     if (req->error) return NFS4ERR_INVAL;
 
+    /* A new clientid replaces the connection's previous one */
+    if (conn->delegs && conn->clientid)
+        nfs4_deleg_drop_client(conn->delegs, conn->clientid);
+
     /* Generate clientid */
     conn->clientid = ((uint64_t)arc4random() << 32) | arc4random();
+    if (conn->delegs)
+        nfs4_deleg_set_callback(conn->delegs, conn->clientid, cb_program,
+                                cb_ident, netid, addr);
     memcpy(&conn->client_verifier, verifier, 8);
     conn->server_verifier = ((uint64_t)arc4random() << 32) | arc4random();
     conn->confirmed = 0;
@@ -1052,6 +1430,33 @@ static uint32_t handle_locku(const darwinfuse_config_t *config,
     return NFS4_OK;
 }
 
+/* ---- Delegations ---- */
+
+static uint32_t handle_delegreturn(const darwinfuse_config_t *config,
+                                    nfs4_conn_state_t *conn,
+                                    xdr_buf_t *req, xdr_buf_t *rep)
+{
+    (void)config; (void)rep;
+
+    uint8_t sid_other[12];
+    xdr_decode_uint32(req);  /* seqid */
+    xdr_decode_opaque_fixed(req, sid_other, 12);
+    if (req->error) return NFS4ERR_INVAL;
+
+    if (!conn->delegs) return NFS4ERR_BAD_STATEID;
+    return nfs4_deleg_return(conn->delegs, conn->clientid, sid_other);
+}
+
+/* Delegations do not survive a server restart, so there is nothing to purge */
+static uint32_t handle_delegpurge(const darwinfuse_config_t *config,
+                                   nfs4_conn_state_t *conn,
+                                   xdr_buf_t *req, xdr_buf_t *rep)
+{
+    (void)config; (void)conn; (void)rep;
+    xdr_decode_uint64(req);  /* clientid */
+    return NFS4ERR_NOTSUPP;
+}
+
 static uint32_t handle_release_lockowner(const darwinfuse_config_t *config,
                                           nfs4_conn_state_t *conn,
                                           xdr_buf_t *req, xdr_buf_t *rep)
@@ -1134,11 +1539,17 @@ int nfs4_dispatch_compound(const darwinfuse_config_t *config,
     uint32_t overall_status = NFS4_OK;
     uint32_t completed_ops = 0;
 
+    if (conn->stats)
+        conn->stats->compounds++;
+
     for (uint32_t i = 0; i < numops; i++) {
         uint32_t opnum = xdr_decode_uint32(request);
         if (request->error) break;
 
-        DFUSE_LOG("  op[%u] = %u", i, opnum);
+        DFUSE_TRACE("  op[%u] = %u", i, opnum);
+
+        if (conn->stats && opnum <= OP_RELEASE_LOCKOWNER)
+            conn->stats->ops[opnum]++;
 
         /* Encode resop header: opnum */
         xdr_encode_uint32(reply, opnum);
@@ -1218,6 +1629,12 @@ int nfs4_dispatch_compound(const darwinfuse_config_t *config,
         case OP_RELEASE_LOCKOWNER:
             status = handle_release_lockowner(config, conn, request, reply);
             break;
+        case OP_DELEGRETURN:
+            status = handle_delegreturn(config, conn, request, reply);
+            break;
+        case OP_DELEGPURGE:
+            status = handle_delegpurge(config, conn, request, reply);
+            break;
         case OP_SECINFO:
             status = handle_secinfo(config, conn, request, reply);
             break;
@@ -1226,7 +1643,7 @@ int nfs4_dispatch_compound(const darwinfuse_config_t *config,
             status = handle_verify(config, conn, request, reply);
             break;
         default:
-            DFUSE_LOG("  unsupported op %u", opnum);
+            DFUSE_DEBUG("  unsupported op %u", opnum);
             status = NFS4ERR_NOTSUPP;
             break;
         }
@@ -1241,7 +1658,7 @@ int nfs4_dispatch_compound(const darwinfuse_config_t *config,
 
         if (status != NFS4_OK) {
             overall_status = status;
-            DFUSE_LOG("  op[%u]=%u failed with status %u", i, opnum, status);
+            DFUSE_DEBUG("  op[%u]=%u failed with status %u", i, opnum, status);
             break;  /* NFSv4: stop at first error */
         }
     }
@@ -19,6 +19,8 @@
 #define OP_CLOSE                4
 #define OP_COMMIT               5
 #define OP_CREATE               6
+#define OP_DELEGPURGE           7
+#define OP_DELEGRETURN          8
 #define OP_GETATTR              9
 #define OP_GETFH                10
 #define OP_LINK                 11
@@ -70,7 +72,7 @@
 #define NFS4ERR_NOTEMPTY        66
 #define NFS4ERR_STALE           70
 #define NFS4ERR_BADHANDLE       10001
-#define NFS4ERR_BAD_STATEID     10026
+#define NFS4ERR_BAD_STATEID     10025
 #define NFS4ERR_NOTSUPP         10004
 #define NFS4ERR_SERVERFAULT     10006
 #define NFS4ERR_BADTYPE         10007
@@ -204,6 +206,12 @@
 #define OPEN_DELEGATE_READ         1
 #define OPEN_DELEGATE_WRITE        2
 
+/* Space limit of a write delegation */
+#define NFS_LIMIT_SIZE             1
+
+/* ACE type */
+#define ACE4_ACCESS_ALLOWED_ACE_TYPE 0
+
 /* Write stable how */
 #define UNSTABLE4                  0
 #define DATA_SYNC4                 1
@@ -222,6 +230,14 @@ typedef struct {
 
 #define MAX_OPEN_STATEIDS  8
 
+/* Operations counted per server, logged when the server exits */
+typedef struct {
+    uint64_t compounds;
+    uint64_t ops[OP_RELEASE_LOCKOWNER + 1];
+} nfs4_stats_t;
+
+struct nfs4_deleg_state;
+
 typedef struct {
     /* Current and saved filehandle */
     uint8_t  current_fh[128];
@@ -238,10 +254,15 @@ typedef struct {
     /* Open file tracking */
     nfs4_stateid_t open_stateids[MAX_OPEN_STATEIDS];
     uint32_t       open_fh_ids[MAX_OPEN_STATEIDS];  /* which FH each stateid belongs to */
+    uint64_t       open_file_handles[MAX_OPEN_STATEIDS];  /* fuse_file_info.fh set by open */
     int            open_stateid_count;
 
     /* Sequence counter for open_confirm */
     uint32_t open_seqid;
+
+    /* Server-wide delegations and operation counters */
+    struct nfs4_deleg_state *delegs;
+    nfs4_stats_t            *stats;
 } nfs4_conn_state_t;
 
 /*
@@ -258,4 +279,10 @@ int nfs4_dispatch_compound(const darwinfuse_config_t *config,
                            xdr_buf_t *request,
                            xdr_buf_t *reply);
 
+/*
+ * Release the files left open by a connection that is being closed.
+ */
+void nfs4_conn_release(const darwinfuse_config_t *config,
+                       nfs4_conn_state_t *conn);
+
 #endif /* DARWINFUSE_NFS4_OPS_H */
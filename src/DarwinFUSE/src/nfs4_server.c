@@ -1,8 +1,9 @@
 /*
  * DarwinFUSE — NFSv4 TCP server
  *
- * Single-threaded poll()-based event loop serving NFSv4 COMPOUND requests
- * over TCP on localhost. Designed for the simple use case of a FUSE
+ * Single-threaded event loop serving NFSv4 COMPOUND requests over TCP on
+ * localhost.  Readiness comes from kqueue or epoll (reactor.c); the loop
+ * sleeps until a socket becomes readable or a recalled delegation expires. Designed for the simple use case of a FUSE
  * filesystem replacement where only the macOS NFS client connects.
  *
  * Copyright (c) 2025 Basalt contributors. All rights reserved.
@@ -11,8 +12,10 @@
 
 #include "nfs4_server.h"
 #include "nfs4_ops.h"
+#include "nfs4_deleg.h"
 #include "nfs4_xdr.h"
 #include "rpc.h"
+#include "reactor.h"
 #include "darwinfuse_internal.h"
 #include "fuse_context.h"
 
@@ -22,7 +25,6 @@
 #include <errno.h>
 #include <signal.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -58,8 +60,11 @@ struct darwinfuse_server {
     volatile int        running;
     int                 had_client;     /* true once a client connected */
 
-    client_conn_t       clients[DFUSE_MAX_CLIENTS];
+    client_conn_t       clients[DFUSE_MAX_CLIENTS]; /* Free if fd < 0 */
     int                 num_clients;
+
+    nfs4_deleg_state_t  delegs;         /* Delegations may conflict between clients */
+    nfs4_stats_t        stats;
 };
 
 /* ---- Helpers ---- */
@@ -77,15 +82,46 @@ static void set_tcp_nodelay(int fd)
     setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
 }
 
-static void client_init(client_conn_t *c, int fd)
+static void client_init(darwinfuse_server_t *srv, client_conn_t *c, int fd)
 {
     memset(c, 0, sizeof(*c));
     c->fd = fd;
     c->read_state = CLIENT_STATE_READ_MARK;
+    c->nfs_state.delegs = &srv->delegs;
+    c->nfs_state.stats = &srv->stats;
+}
+
+/*
+ * Log how many requests the client needed.  Comparing a run with the
+ * default attribute cache and delegations against one mounted with
+ * attr_timeout=0,nodelegations shows the revalidation traffic saved.
+ */
+static void log_stats(const darwinfuse_server_t *srv)
+{
+    const nfs4_stats_t *st = &srv->stats;
+
+    DFUSE_LOG("NFS requests: %llu COMPOUNDs, GETATTR %llu, ACCESS %llu, "
+              "LOOKUP %llu, OPEN %llu, CLOSE %llu, READ %llu, WRITE %llu, "
+              "COMMIT %llu",
+              (unsigned long long)st->compounds,
+              (unsigned long long)st->ops[OP_GETATTR],
+              (unsigned long long)st->ops[OP_ACCESS],
+              (unsigned long long)st->ops[OP_LOOKUP],
+              (unsigned long long)st->ops[OP_OPEN],
+              (unsigned long long)st->ops[OP_CLOSE],
+              (unsigned long long)st->ops[OP_READ],
+              (unsigned long long)st->ops[OP_WRITE],
+              (unsigned long long)st->ops[OP_COMMIT]);
+    DFUSE_LOG("Delegations: %llu granted, %llu recalled, %llu revoked",
+              (unsigned long long)srv->delegs.granted,
+              (unsigned long long)srv->delegs.recalled,
+              (unsigned long long)srv->delegs.revoked);
 }
 
-static void client_close(client_conn_t *c)
+static void client_close(darwinfuse_server_t *srv, client_conn_t *c)
 {
+    nfs4_conn_release(&srv->config, &c->nfs_state);
+
     if (c->fd >= 0) {
         close(c->fd);
         c->fd = -1;
@@ -238,7 +274,10 @@ darwinfuse_server_t *nfs4_server_create(const darwinfuse_config_t *config,
     if (!srv) return NULL;
 
     srv->config = *config;
+    nfs4_deleg_init(&srv->delegs, config->delegations);
     srv->listen_fd = -1;
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++)
+        srv->clients[i].fd = -1;
     srv->wakeup_pipe[0] = -1;
     srv->wakeup_pipe[1] = -1;
 
@@ -298,97 +337,138 @@ fail:
     return NULL;
 }
 
-int nfs4_server_run(darwinfuse_server_t *srv)
+/* Accept all pending connections; the listen socket is edge-triggered */
+static void accept_clients(darwinfuse_server_t *srv, reactor_t *r)
 {
-    /* pollfd layout: [0] = listen_fd, [1] = wakeup_pipe, [2..N+1] = clients */
-    struct pollfd pfds[2 + DFUSE_MAX_CLIENTS];
+    for (;;) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int cfd = accept(srv->listen_fd, (struct sockaddr *)&client_addr,
+                         &client_len);
+        if (cfd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                DFUSE_ERR("accept: %s", strerror(errno));
+            return;
+        }
 
-    while (srv->running) {
-        int nfds = 0;
-
-        /* Listen socket */
-        pfds[nfds].fd = srv->listen_fd;
-        pfds[nfds].events = POLLIN;
-        pfds[nfds].revents = 0;
-        nfds++;
-
-        /* Wakeup pipe */
-        pfds[nfds].fd = srv->wakeup_pipe[0];
-        pfds[nfds].events = POLLIN;
-        pfds[nfds].revents = 0;
-        nfds++;
-
-        /* Client connections */
-        for (int i = 0; i < srv->num_clients; i++) {
-            pfds[nfds].fd = srv->clients[i].fd;
-            pfds[nfds].events = POLLIN;
-            pfds[nfds].revents = 0;
-            nfds++;
+        client_conn_t *c = NULL;
+        for (int i = 0; i < DFUSE_MAX_CLIENTS && !c; i++) {
+            if (srv->clients[i].fd < 0)
+                c = &srv->clients[i];
         }
 
-        int ret = poll(pfds, (nfds_t)nfds, 1000);  /* 1-second timeout */
-        if (ret < 0) {
-            if (errno == EINTR) continue;
-            DFUSE_ERR("poll: %s", strerror(errno));
-            return -1;
+        if (!c) {
+            close(cfd);
+            continue;
         }
 
-        /* Check wakeup pipe */
-        if (pfds[1].revents & POLLIN) {
-            char dummy[16];
-            while (read(srv->wakeup_pipe[0], dummy, sizeof(dummy)) > 0)
-                ;
-            if (!srv->running)
-                break;
+        set_nonblocking(cfd);
+        set_tcp_nodelay(cfd);
+        client_init(srv, c, cfd);
+
+        if (reactor_add(r, cfd, c) < 0) {
+            DFUSE_ERR("reactor_add: %s", strerror(errno));
+            client_close(srv, c);
+            continue;
         }
 
-        /* Accept new connections */
-        if (pfds[0].revents & POLLIN) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
-            int cfd = accept(srv->listen_fd, (struct sockaddr *)&client_addr,
-                             &client_len);
-            if (cfd >= 0) {
-                if (srv->num_clients >= DFUSE_MAX_CLIENTS) {
-                    close(cfd);
-                } else {
-                    set_nonblocking(cfd);
-                    set_tcp_nodelay(cfd);
-                    client_init(&srv->clients[srv->num_clients], cfd);
-                    srv->num_clients++;
-                    srv->had_client = 1;
-                    DFUSE_LOG("Client connected (fd=%d, total=%d)", cfd, srv->num_clients);
-                }
-            }
+        srv->num_clients++;
+        srv->had_client = 1;
+        DFUSE_LOG("Client connected (fd=%d, total=%d)", cfd, srv->num_clients);
+    }
+}
+
+/*
+ * The reactor is created for each run: kqueue descriptors are not
+ * inherited by the daemon child that runs the server after fork().
+ */
+int nfs4_server_run(darwinfuse_server_t *srv)
+{
+    reactor_t *r = reactor_create();
+    if (!r) {
+        DFUSE_ERR("reactor_create: %s", strerror(errno));
+        return -1;
+    }
+
+    /* The addresses of the listen socket and wakeup pipe identify them */
+    if (reactor_add(r, srv->listen_fd, &srv->listen_fd) < 0
+        || reactor_add(r, srv->wakeup_pipe[0], srv->wakeup_pipe) < 0) {
+        DFUSE_ERR("reactor_add: %s", strerror(errno));
+        reactor_destroy(r);
+        return -1;
+    }
+
+    /* Connections accepted by an earlier run */
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++) {
+        client_conn_t *c = &srv->clients[i];
+        if (c->fd >= 0 && reactor_add(r, c->fd, c) < 0) {
+            client_close(srv, c);
+            srv->num_clients--;
+        }
+    }
+
+    DFUSE_DEBUG("Event loop using %s", reactor_backend());
+
+    int rc = 0;
+    int64_t timer = -1;
+
+    while (srv->running) {
+        /* Only a pending delegation recall needs a timeout */
+        int64_t expiry = nfs4_deleg_next_expiry(&srv->delegs);
+        if (expiry != timer) {
+            reactor_set_timer(r, expiry);
+            timer = expiry;
+        }
+
+        reactor_event_t events[REACTOR_MAX_EVENTS];
+        int n = reactor_wait(r, events, REACTOR_MAX_EVENTS);
+        if (n < 0) {
+            DFUSE_ERR("reactor_wait: %s", strerror(errno));
+            rc = -1;
+            break;
         }
 
-        /* Process client data */
-        for (int i = 0; i < srv->num_clients; i++) {
-            int pfd_idx = 2 + i;
-            if (pfds[pfd_idx].revents & (POLLIN | POLLERR | POLLHUP)) {
-                if (client_read(srv, &srv->clients[i]) < 0) {
-                    DFUSE_LOG("Client disconnected (fd=%d)", srv->clients[i].fd);
-                    client_close(&srv->clients[i]);
-                    /* Compact: move last client to this slot */
+        for (int i = 0; i < n; i++) {
+            void *data = events[i].data;
+
+            if (data == NULL) {
+                timer = -1;
+                nfs4_deleg_expire(&srv->delegs);
+            } else if (data == srv->wakeup_pipe) {
+                char dummy[16];
+                while (read(srv->wakeup_pipe[0], dummy, sizeof(dummy)) > 0)
+                    ;
+            } else if (data == &srv->listen_fd) {
+                accept_clients(srv, r);
+            } else {
+                /* A hang-up is seen by client_read() as EOF or an error */
+                client_conn_t *c = data;
+                if (c->fd >= 0 && client_read(srv, c) < 0) {
+                    DFUSE_LOG("Client disconnected (fd=%d)", c->fd);
+                    reactor_remove(r, c->fd);
+                    client_close(srv, c);
                     srv->num_clients--;
-                    if (i < srv->num_clients)
-                        srv->clients[i] = srv->clients[srv->num_clients];
-                    i--;  /* re-check this slot */
                 }
             }
         }
 
+        if (!srv->running)
+            break;
+
         /*
          * If we had a client connection and all clients disconnected,
          * the mount has been unmounted. Exit the event loop.
          */
         if (srv->had_client && srv->num_clients == 0) {
             DFUSE_LOG("All clients disconnected — exiting event loop");
+            log_stats(srv);
             break;
         }
     }
 
-    return 0;
+    reactor_destroy(r);
+    return rc;
 }
 
 void nfs4_server_stop(darwinfuse_server_t *srv)
@@ -422,8 +502,12 @@ void nfs4_server_destroy(darwinfuse_server_t *srv)
 {
     if (!srv) return;
 
-    for (int i = 0; i < srv->num_clients; i++)
-        client_close(&srv->clients[i]);
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++) {
+        if (srv->clients[i].fd >= 0)
+            client_close(srv, &srv->clients[i]);
+    }
+
+    nfs4_deleg_destroy(&srv->delegs);
 
     if (srv->listen_fd >= 0) close(srv->listen_fd);
     if (srv->wakeup_pipe[0] >= 0) close(srv->wakeup_pipe[0]);
@@ -442,7 +526,7 @@ void nfs4_server_close_inherited_fds(darwinfuse_server_t *srv)
     if (srv->listen_fd >= 0) keep[nkeep++] = srv->listen_fd;
     if (srv->wakeup_pipe[0] >= 0) keep[nkeep++] = srv->wakeup_pipe[0];
     if (srv->wakeup_pipe[1] >= 0) keep[nkeep++] = srv->wakeup_pipe[1];
-    for (int i = 0; i < srv->num_clients; i++)
+    for (int i = 0; i < DFUSE_MAX_CLIENTS; i++)
         if (srv->clients[i].fd >= 0) keep[nkeep++] = srv->clients[i].fd;
 
     /* Close everything from fd 3 up to a reasonable limit */
@@ -13,15 +13,19 @@
 
 /* Forward declaration */
 struct fuse_operations;
+struct darwinfuse_lowlevel_ops;
 
 /* Server configuration passed from fuse_main shim */
 typedef struct {
-    const struct fuse_operations *ops;
+    const struct fuse_operations *ops;          /* Path-based callbacks, or */
+    const struct darwinfuse_lowlevel_ops *ll_ops; /* inode-based callbacks */
     void       *user_data;
     uid_t       uid;            /* Owner UID (for access control) */
     gid_t       gid;            /* Owner GID */
     const char *volume_path;    /* e.g. "/volume.dmg" or "/volume" */
     const char *control_path;   /* "/control" */
+    uint8_t     write_verifier[8]; /* Changes on restart; clients then resend unstable writes */
+    int         delegations;    /* Grant NFSv4.0 read/write delegations */
 } darwinfuse_config_t;
 
 /* Opaque server state */
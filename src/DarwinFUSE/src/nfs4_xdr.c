@@ -120,6 +120,29 @@ void xdr_encode_bool(xdr_buf_t *xdr, int val)
     xdr_encode_uint32(xdr, val ? 1 : 0);
 }
 
+uint8_t *xdr_encode_opaque_begin(xdr_buf_t *xdr, uint32_t maxlen)
+{
+    if (!xdr_check_encode(xdr, 4 + xdr_pad(maxlen))) return NULL;
+
+    /* Length is filled in by xdr_encode_opaque_end() */
+    xdr->pos += 4;
+    return xdr->data + xdr->pos;
+}
+
+void xdr_encode_opaque_end(xdr_buf_t *xdr, uint32_t len)
+{
+    if (xdr->error) return;
+
+    uint32_t net = htonl(len);
+    memcpy(xdr->data + xdr->pos - 4, &net, 4);
+
+    size_t padded = xdr_pad(len);
+    if (padded > len)
+        memset(xdr->data + xdr->pos + len, 0, padded - len);
+
+    xdr->pos += padded;
+}
+
 /* ---- Decode ---- */
 
 uint32_t xdr_decode_uint32(xdr_buf_t *xdr)
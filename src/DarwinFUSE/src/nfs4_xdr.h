@@ -37,6 +37,12 @@ void     xdr_encode_opaque_fixed(xdr_buf_t *xdr, const void *data, uint32_t len)
 void     xdr_encode_string(xdr_buf_t *xdr, const char *str);
 void     xdr_encode_bool(xdr_buf_t *xdr, int val);
 
+/* Encode variable-length opaque in place: begin reserves room for up to
+ * maxlen bytes and returns where to write them (NULL if the buffer is too
+ * small); end sets the actual length and pads. */
+uint8_t *xdr_encode_opaque_begin(xdr_buf_t *xdr, uint32_t maxlen);
+void     xdr_encode_opaque_end(xdr_buf_t *xdr, uint32_t len);
+
 /* ---- Decode primitives ---- */
 
 uint32_t xdr_decode_uint32(xdr_buf_t *xdr);
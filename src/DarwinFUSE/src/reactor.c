@@ -0,0 +1,340 @@
+/*
+ * DarwinFUSE — readiness notification for the server event loop
+ *
+ * Copyright (c) 2026 Basalt contributors. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* clock_gettime() and timerfd with -std=c11 */
+#endif
+
+#include "reactor.h"
+#include "darwinfuse_internal.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(DFUSE_REACTOR_POLL)
+#   define REACTOR_POLL
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#   define REACTOR_KQUEUE
+#elif defined(__linux__)
+#   define REACTOR_EPOLL
+#else
+#   define REACTOR_POLL
+#endif
+
+/* ---- kqueue ---- */
+
+#ifdef REACTOR_KQUEUE
+
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+
+#define REACTOR_TIMER_IDENT 1
+
+struct reactor {
+    int kq;
+};
+
+const char *reactor_backend(void)
+{
+    return "kqueue";
+}
+
+reactor_t *reactor_create(void)
+{
+    reactor_t *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+
+    r->kq = kqueue();
+    if (r->kq < 0) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+void reactor_destroy(reactor_t *r)
+{
+    if (!r) return;
+    close(r->kq);
+    free(r);
+}
+
+int reactor_add(reactor_t *r, int fd, void *data)
+{
+    struct kevent kev;
+    EV_SET(&kev, fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, data);
+    return kevent(r->kq, &kev, 1, NULL, 0, NULL);
+}
+
+void reactor_remove(reactor_t *r, int fd)
+{
+    struct kevent kev;
+    EV_SET(&kev, fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    kevent(r->kq, &kev, 1, NULL, 0, NULL);
+}
+
+int reactor_set_timer(reactor_t *r, int64_t timeout_ms)
+{
+    struct kevent kev;
+
+    if (timeout_ms < 0) {
+        EV_SET(&kev, REACTOR_TIMER_IDENT, EVFILT_TIMER, EV_DELETE, 0, 0, NULL);
+        if (kevent(r->kq, &kev, 1, NULL, 0, NULL) < 0 && errno != ENOENT)
+            return -1;
+        return 0;
+    }
+
+    /* Re-adding an existing timer replaces its period */
+    EV_SET(&kev, REACTOR_TIMER_IDENT, EVFILT_TIMER, EV_ADD | EV_ONESHOT,
+           0, (intptr_t)timeout_ms, NULL);
+    return kevent(r->kq, &kev, 1, NULL, 0, NULL);
+}
+
+int reactor_wait(reactor_t *r, reactor_event_t *events, int max_events)
+{
+    struct kevent kevs[REACTOR_MAX_EVENTS];
+    if (max_events > REACTOR_MAX_EVENTS)
+        max_events = REACTOR_MAX_EVENTS;
+
+    int n = kevent(r->kq, NULL, 0, kevs, max_events, NULL);
+    if (n < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        if (kevs[i].filter == EVFILT_TIMER) {
+            events[i].data = NULL;
+            events[i].hangup = 0;
+        } else {
+            events[i].data = kevs[i].udata;
+            events[i].hangup = (kevs[i].flags & (EV_EOF | EV_ERROR)) != 0;
+        }
+    }
+    return n;
+}
+
+#endif /* REACTOR_KQUEUE */
+
+/* ---- epoll ---- */
+
+#ifdef REACTOR_EPOLL
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+struct reactor {
+    int epfd;
+    int timerfd;
+};
+
+const char *reactor_backend(void)
+{
+    return "epoll";
+}
+
+reactor_t *reactor_create(void)
+{
+    reactor_t *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    r->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    /* The timer is registered like any fd; its data pointer marks it */
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = &r->timerfd;
+
+    if (r->epfd < 0 || r->timerfd < 0
+        || epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->timerfd, &ev) < 0) {
+        int err = errno;
+        if (r->epfd >= 0) close(r->epfd);
+        if (r->timerfd >= 0) close(r->timerfd);
+        free(r);
+        errno = err;
+        return NULL;
+    }
+    return r;
+}
+
+void reactor_destroy(reactor_t *r)
+{
+    if (!r) return;
+    close(r->timerfd);
+    close(r->epfd);
+    free(r);
+}
+
+int reactor_add(reactor_t *r, int fd, void *data)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = data;
+    return epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+void reactor_remove(reactor_t *r, int fd)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+int reactor_set_timer(reactor_t *r, int64_t timeout_ms)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+
+    if (timeout_ms >= 0) {
+        /* An all-zero it_value would disarm the timer */
+        its.it_value.tv_sec = (time_t)(timeout_ms / 1000);
+        its.it_value.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        if (timeout_ms == 0)
+            its.it_value.tv_nsec = 1;
+    }
+    return timerfd_settime(r->timerfd, 0, &its, NULL);
+}
+
+int reactor_wait(reactor_t *r, reactor_event_t *events, int max_events)
+{
+    struct epoll_event evs[REACTOR_MAX_EVENTS];
+    if (max_events > REACTOR_MAX_EVENTS)
+        max_events = REACTOR_MAX_EVENTS;
+
+    int n = epoll_wait(r->epfd, evs, max_events, -1);
+    if (n < 0)
+        return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        if (evs[i].data.ptr == &r->timerfd) {
+            uint64_t expirations;
+            if (read(r->timerfd, &expirations, sizeof(expirations)) < 0) {
+                /* Already consumed */
+            }
+            events[i].data = NULL;
+            events[i].hangup = 0;
+        } else {
+            events[i].data = evs[i].data.ptr;
+            events[i].hangup = (evs[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0;
+        }
+    }
+    return n;
+}
+
+#endif /* REACTOR_EPOLL */
+
+/* ---- poll() ---- */
+
+#ifdef REACTOR_POLL
+
+#include <poll.h>
+#include <time.h>
+
+#define REACTOR_POLL_MAX_FDS    (DFUSE_MAX_CLIENTS + 4)
+
+struct reactor {
+    struct pollfd fds[REACTOR_POLL_MAX_FDS];
+    void         *data[REACTOR_POLL_MAX_FDS];
+    int           nfds;
+    int64_t       deadline;     /* Monotonic time in ms, -1 if disarmed */
+};
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+const char *reactor_backend(void)
+{
+    return "poll";
+}
+
+reactor_t *reactor_create(void)
+{
+    reactor_t *r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->deadline = -1;
+    return r;
+}
+
+void reactor_destroy(reactor_t *r)
+{
+    free(r);
+}
+
+int reactor_add(reactor_t *r, int fd, void *data)
+{
+    if (r->nfds >= REACTOR_POLL_MAX_FDS) {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    r->fds[r->nfds].fd = fd;
+    r->fds[r->nfds].events = POLLIN;
+    r->fds[r->nfds].revents = 0;
+    r->data[r->nfds] = data;
+    r->nfds++;
+    return 0;
+}
+
+void reactor_remove(reactor_t *r, int fd)
+{
+    for (int i = 0; i < r->nfds; i++) {
+        if (r->fds[i].fd == fd) {
+            r->nfds--;
+            r->fds[i] = r->fds[r->nfds];
+            r->data[i] = r->data[r->nfds];
+            return;
+        }
+    }
+}
+
+int reactor_set_timer(reactor_t *r, int64_t timeout_ms)
+{
+    r->deadline = timeout_ms < 0 ? -1 : monotonic_ms() + timeout_ms;
+    return 0;
+}
+
+/* Level-triggered; callers reading until EAGAIN work with either model */
+int reactor_wait(reactor_t *r, reactor_event_t *events, int max_events)
+{
+    int timeout = -1;
+    if (r->deadline >= 0) {
+        int64_t left = r->deadline - monotonic_ms();
+        timeout = left <= 0 ? 0 : (left > INT32_MAX ? INT32_MAX : (int)left);
+    }
+
+    int ret = poll(r->fds, (nfds_t)r->nfds, timeout);
+    if (ret < 0)
+        return errno == EINTR ? 0 : -1;
+
+    int n = 0;
+    for (int i = 0; i < r->nfds && n < max_events && ret > 0; i++) {
+        if (!r->fds[i].revents)
+            continue;
+        events[n].data = r->data[i];
+        events[n].hangup = (r->fds[i].revents & (POLLHUP | POLLERR)) != 0;
+        n++;
+        ret--;
+    }
+
+    if (n < max_events && r->deadline >= 0 && monotonic_ms() >= r->deadline) {
+        r->deadline = -1;
+        events[n].data = NULL;
+        events[n].hangup = 0;
+        n++;
+    }
+    return n;
+}
+
+#endif /* REACTOR_POLL */
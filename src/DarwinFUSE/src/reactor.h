@@ -0,0 +1,54 @@
+/*
+ * DarwinFUSE — readiness notification for the server event loop
+ *
+ * Copyright (c) 2026 Basalt contributors. All rights reserved.
+ * Licensed under the MIT License.
+ */
+
+#ifndef DARWINFUSE_REACTOR_H
+#define DARWINFUSE_REACTOR_H
+
+#include <stdint.h>
+
+/*
+ * Backends: kqueue on macOS and the BSDs, epoll with a timerfd on Linux,
+ * and poll() elsewhere or when DFUSE_REACTOR_POLL is defined.
+ *
+ * Read readiness is edge-triggered with kqueue and epoll: an event is only
+ * reported again after new data arrived, so the caller must read until
+ * EAGAIN.  reactor_wait() blocks without periodic wakeups; the only timeout
+ * is the one-shot timer set with reactor_set_timer().
+ */
+
+#define REACTOR_MAX_EVENTS  32
+
+typedef struct reactor reactor_t;
+
+typedef struct {
+    void *data;     /* As passed to reactor_add(); NULL for the timer */
+    int   hangup;   /* Peer closed or error; reading reports the cause */
+} reactor_event_t;
+
+/* Returns NULL on failure with errno set */
+reactor_t *reactor_create(void);
+void reactor_destroy(reactor_t *r);
+
+/* Name of the backend, for logging */
+const char *reactor_backend(void);
+
+/* Watch fd for read readiness; data identifies it in reported events */
+int  reactor_add(reactor_t *r, int fd, void *data);
+
+/* Stop watching fd; must be called before fd is closed */
+void reactor_remove(reactor_t *r, int fd);
+
+/* Arm the timer to fire once after timeout_ms; a negative value disarms it */
+int  reactor_set_timer(reactor_t *r, int64_t timeout_ms);
+
+/*
+ * Wait for events.  Returns the number of events stored, 0 if interrupted
+ * by a signal, or -1 on error.
+ */
+int  reactor_wait(reactor_t *r, reactor_event_t *events, int max_events);
+
+#endif /* DARWINFUSE_REACTOR_H */
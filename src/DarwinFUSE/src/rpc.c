@@ -9,6 +9,7 @@
 #include "darwinfuse_internal.h"
 #include <arpa/inet.h>
 #include <string.h>
+#include <unistd.h>
 
 int rpc_parse_call(xdr_buf_t *xdr, rpc_call_header_t *hdr)
 {
@@ -127,6 +128,37 @@ void rpc_encode_reply_denied(xdr_buf_t *xdr, uint32_t xid)
     xdr_encode_uint32(xdr, RPC_MSG_VERSION);
 }
 
+void rpc_encode_call(xdr_buf_t *xdr, uint32_t xid, uint32_t program,
+                     uint32_t version, uint32_t procedure)
+{
+    xdr_encode_uint32(xdr, xid);
+    xdr_encode_uint32(xdr, RPC_CALL);
+    xdr_encode_uint32(xdr, RPC_MSG_VERSION);
+    xdr_encode_uint32(xdr, program);
+    xdr_encode_uint32(xdr, version);
+    xdr_encode_uint32(xdr, procedure);
+
+    /* Credentials: AUTH_SYS { stamp, machinename, uid, gid, gids<> } */
+    xdr_encode_uint32(xdr, AUTH_SYS);
+    size_t len_pos = xdr_getpos(xdr);
+    xdr_encode_uint32(xdr, 0);
+    size_t body_pos = xdr_getpos(xdr);
+    xdr_encode_uint32(xdr, 0);
+    xdr_encode_string(xdr, "localhost");
+    xdr_encode_uint32(xdr, (uint32_t)getuid());
+    xdr_encode_uint32(xdr, (uint32_t)getgid());
+    xdr_encode_uint32(xdr, 0);
+
+    size_t end_pos = xdr_getpos(xdr);
+    xdr_setpos(xdr, len_pos);
+    xdr_encode_uint32(xdr, (uint32_t)(end_pos - body_pos));
+    xdr_setpos(xdr, end_pos);
+
+    /* Verifier: AUTH_NONE */
+    xdr_encode_uint32(xdr, AUTH_NONE);
+    xdr_encode_uint32(xdr, 0);
+}
+
 /* ---- TCP Record Marking ---- */
 
 void rpc_encode_record_mark(uint8_t *buf, uint32_t payload_len, int last_fragment)
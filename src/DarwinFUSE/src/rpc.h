@@ -51,6 +51,13 @@ void rpc_encode_reply_error(xdr_buf_t *xdr, uint32_t xid, uint32_t stat);
  */
 void rpc_encode_reply_denied(xdr_buf_t *xdr, uint32_t xid);
 
+/*
+ * Encode an ONC RPC call header with AUTH_SYS credentials of the server
+ * process.  Used for callbacks to the client (CB_COMPOUND).
+ */
+void rpc_encode_call(xdr_buf_t *xdr, uint32_t xid, uint32_t program,
+                     uint32_t version, uint32_t procedure);
+
 /* ---- TCP Record Marking (RFC 5531 §11) ---- */
 
 /*
@@ -17,6 +17,7 @@
 #include <unistd.h>
 #include <time.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/wait.h>
 
@@ -29,6 +30,7 @@
 #include "Platform/Unix/Poller.h"
 #include "Volume/EncryptionThreadPool.h"
 #include "Core/Core.h"
+#include "Core/VolumeKeyRotator.h"
 
 namespace Basalt
 {
@@ -68,6 +70,8 @@ namespace Basalt
 #endif
 			if (!EncryptionThreadPool::IsRunning())
 				EncryptionThreadPool::Start();
+
+			FuseService::StartKeyRotation();
 		}
 		catch (exception &e)
 		{
@@ -97,22 +101,148 @@ namespace Basalt
 		}
 	}
 
-	static int fuse_service_getattr (const char *path, struct stat *statData)
+	static int fuse_service_fsync (const char *path, int datasync, struct fuse_file_info *fi)
 	{
 		try
 		{
-			Memory::Zero (statData, sizeof(*statData));
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
 
-			statData->st_uid = FuseService::GetUserId();
-			statData->st_gid = FuseService::GetGroupId();
-			statData->st_atime = time (NULL);
-			statData->st_ctime = time (NULL);
-			statData->st_mtime = time (NULL);
+			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
+			{
+				FuseService::SyncVolume();
+				return 0;
+			}
+
+			if (strcmp (path, FuseService::GetControlPath()) == 0)
+				return 0;
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -ENOENT;
+	}
+
+#if defined (FALLOC_FL_PUNCH_HOLE) && FUSE_VERSION >= 29
+	static void fuse_service_zero_volume_range (uint64 offset, uint64 length)
+	{
+		size_t sectorSize = FuseService::GetVolumeSectorSize();
+		uint64 sectorOffset = offset - (offset % sectorSize);
+
+		SecureBuffer sector (sectorSize);
+		FuseService::ReadVolumeSectors (sector, sectorOffset);
+		sector.GetRange (offset - sectorOffset, length).Zero();
+		FuseService::WriteVolumeSectors (sector, sectorOffset);
+	}
+
+	static int fuse_service_fallocate_volume (int mode, off_t offset, off_t length)
+	{
+		if (offset < 0 || length <= 0)
+			return -EINVAL;
+
+		uint64 start = offset;
+		uint64 end = (uint64) offset + length;
+		uint64 volumeSize = FuseService::GetVolumeSize();
+
+		// The volume image cannot grow, and preallocation within it is left to the host
+		if (mode == 0 || mode == FALLOC_FL_KEEP_SIZE)
+			return (end <= volumeSize || mode == FALLOC_FL_KEEP_SIZE) ? 0 : -EFBIG;
+
+		if (mode != (FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE))
+			return -EOPNOTSUPP;
+
+		if (end > volumeSize)
+			end = volumeSize;
+
+		if (start >= end)
+			return 0;
+
+		// A punched hole reads back as zeros, including partial sectors at its edges
+		size_t sectorSize = FuseService::GetVolumeSectorSize();
+		uint64 alignedStart = (start + sectorSize - 1) / sectorSize * sectorSize;
+		uint64 alignedEnd = end / sectorSize * sectorSize;
+
+		if (alignedStart > alignedEnd)
+		{
+			fuse_service_zero_volume_range (start, end - start);
+			return 0;
+		}
+
+		if (start < alignedStart)
+			fuse_service_zero_volume_range (start, alignedStart - start);
+
+		if (alignedEnd < end)
+			fuse_service_zero_volume_range (alignedEnd, end - alignedEnd);
+
+		if (alignedStart < alignedEnd)
+			FuseService::DiscardVolumeSectors (alignedStart, alignedEnd - alignedStart);
+
+		return 0;
+	}
+
+	static int fuse_service_fallocate (const char *path, int mode, off_t offset, off_t length, struct fuse_file_info *fi)
+	{
+		try
+		{
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
+
+			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
+				return fuse_service_fallocate_volume (mode, offset, length);
+
+			if (strcmp (path, FuseService::GetControlPath()) == 0)
+				return -EOPNOTSUPP;
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -ENOENT;
+	}
+#endif
+
+	static int fuse_service_flush (const char *path, struct fuse_file_info *fi)
+	{
+		// Every close() flushes; the host file is synced only on fsync and NFS COMMIT
+		return 0;
+	}
+
+	static void fuse_service_init_stat (struct stat *statData)
+	{
+		Memory::Zero (statData, sizeof(*statData));
+
+		statData->st_uid = FuseService::GetUserId();
+		statData->st_gid = FuseService::GetGroupId();
+		statData->st_atime = time (NULL);
+		statData->st_ctime = time (NULL);
+		statData->st_mtime = time (NULL);
+	}
+
+	static void fuse_service_set_file_stat (struct stat *statData, uint64 size)
+	{
+		statData->st_mode = S_IFREG | 0600;
+		statData->st_nlink = 1;
+		statData->st_size = size;
+	}
+
+	static void fuse_service_set_root_stat (struct stat *statData)
+	{
+		statData->st_mode = S_IFDIR | 0500;
+		statData->st_nlink = 2;
+	}
+
+	static int fuse_service_getattr (const char *path, struct stat *statData)
+	{
+		try
+		{
+			fuse_service_init_stat (statData);
 
 			if (strcmp (path, "/") == 0)
 			{
-				statData->st_mode = S_IFDIR | 0500;
-				statData->st_nlink = 2;
+				fuse_service_set_root_stat (statData);
 			}
 			else
 			{
@@ -120,21 +250,11 @@ namespace Basalt
 					return -EACCES;
 
 				if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
-				{
-					statData->st_mode = S_IFREG | 0600;
-					statData->st_nlink = 1;
-					statData->st_size = FuseService::GetVolumeSize();
-				}
+					fuse_service_set_file_stat (statData, FuseService::GetVolumeSize());
 				else if (strcmp (path, FuseService::GetControlPath()) == 0)
-				{
-					statData->st_mode = S_IFREG | 0600;
-					statData->st_nlink = 1;
-					statData->st_size = FuseService::GetVolumeInfo()->Size();
-				}
+					fuse_service_set_file_stat (statData, FuseService::GetVolumeInfo()->Size());
 				else
-				{
 					return -ENOENT;
-				}
 			}
 		}
 		catch (...)
@@ -186,65 +306,71 @@ namespace Basalt
 		return -ENOENT;
 	}
 
-	static int fuse_service_read (const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	static int fuse_service_read_control (char *buf, size_t size, off_t offset)
+	{
+		shared_ptr <Buffer> infoBuf = FuseService::GetVolumeInfo();
+		BufferPtr outBuf ((byte *)buf, size);
+
+		if (offset >= (off_t) infoBuf->Size())
+			return 0;
+
+		if (offset + size > infoBuf->Size())
+			size = infoBuf->Size () - offset;
+
+		outBuf.CopyFrom (infoBuf->GetRange (offset, size));
+		return size;
+	}
+
+	static int fuse_service_read_volume (char *buf, size_t size, off_t offset)
 	{
 		try
 		{
-			if (!FuseService::CheckAccessRights())
-				return -EACCES;
+			// Test for read beyond the end of the volume
+			if ((uint64) offset + size > FuseService::GetVolumeSize())
+				size = FuseService::GetVolumeSize() - offset;
 
-			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
+			size_t sectorSize = FuseService::GetVolumeSectorSize();
+			if (size % sectorSize != 0 || offset % sectorSize != 0)
 			{
-				try
-				{
-					// Test for read beyond the end of the volume
-					if ((uint64) offset + size > FuseService::GetVolumeSize())
-						size = FuseService::GetVolumeSize() - offset;
-
-					size_t sectorSize = FuseService::GetVolumeSectorSize();
-					if (size % sectorSize != 0 || offset % sectorSize != 0)
-					{
-						// Support for non-sector-aligned read operations is required by some loop device tools
-						// which may analyze the volume image before attaching it as a device
-
-						uint64 alignedOffset = offset - (offset % sectorSize);
-						uint64 alignedSize = size + (offset % sectorSize);
-
-						if (alignedSize % sectorSize != 0)
-							alignedSize += sectorSize - (alignedSize % sectorSize);
-
-						SecureBuffer alignedBuffer (alignedSize);
-
-						FuseService::ReadVolumeSectors (alignedBuffer, alignedOffset);
-						BufferPtr ((byte *) buf, size).CopyFrom (alignedBuffer.GetRange (offset % sectorSize, size));
-					}
-					else
-					{
-						FuseService::ReadVolumeSectors (BufferPtr ((byte *) buf, size), offset);
-					}
-				}
-				catch (MissingVolumeData&)
-				{
-					return 0;
-				}
+				// Support for non-sector-aligned read operations is required by some loop device tools
+				// which may analyze the volume image before attaching it as a device
 
-				return size;
-			}
+				uint64 alignedOffset = offset - (offset % sectorSize);
+				uint64 alignedSize = size + (offset % sectorSize);
 
-			if (strcmp (path, FuseService::GetControlPath()) == 0)
+				if (alignedSize % sectorSize != 0)
+					alignedSize += sectorSize - (alignedSize % sectorSize);
+
+				SecureBuffer alignedBuffer (alignedSize);
+
+				FuseService::ReadVolumeSectors (alignedBuffer, alignedOffset);
+				BufferPtr ((byte *) buf, size).CopyFrom (alignedBuffer.GetRange (offset % sectorSize, size));
+			}
+			else
 			{
-				shared_ptr <Buffer> infoBuf = FuseService::GetVolumeInfo();
-				BufferPtr outBuf ((byte *)buf, size);
+				FuseService::ReadVolumeSectors (BufferPtr ((byte *) buf, size), offset);
+			}
+		}
+		catch (MissingVolumeData&)
+		{
+			return 0;
+		}
 
-				if (offset >= (off_t) infoBuf->Size())
-					return 0;
+		return size;
+	}
+
+	static int fuse_service_read (const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		try
+		{
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
 
-				if (offset + size > infoBuf->Size())
-					size = infoBuf->Size () - offset;
+			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
+				return fuse_service_read_volume (buf, size, offset);
 
-				outBuf.CopyFrom (infoBuf->GetRange (offset, size));
-				return size;
-			}
+			if (strcmp (path, FuseService::GetControlPath()) == 0)
+				return fuse_service_read_control (buf, size, offset);
 		}
 		catch (...)
 		{
@@ -277,6 +403,21 @@ namespace Basalt
 		return 0;
 	}
 
+	static int fuse_service_write_control (const char *buf, size_t size)
+	{
+		if (FuseService::AuxDeviceInfoReceived())
+			return -EACCES;
+
+		FuseService::ReceiveAuxDeviceInfo (ConstBufferPtr ((const byte *)buf, size));
+		return size;
+	}
+
+	static int fuse_service_write_volume (const char *buf, size_t size, off_t offset)
+	{
+		FuseService::WriteVolumeSectors (BufferPtr ((byte *) buf, size), offset);
+		return size;
+	}
+
 	static int fuse_service_write (const char *path, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
 	{
 		try
@@ -285,19 +426,10 @@ namespace Basalt
 				return -EACCES;
 
 			if (strcmp (path, FuseService::GetVolumeImagePath()) == 0)
-			{
-				FuseService::WriteVolumeSectors (BufferPtr ((byte *) buf, size), offset);
-				return size;
-			}
+				return fuse_service_write_volume (buf, size, offset);
 
 			if (strcmp (path, FuseService::GetControlPath()) == 0)
-			{
-				if (FuseService::AuxDeviceInfoReceived())
-					return -EACCES;
-
-				FuseService::ReceiveAuxDeviceInfo (ConstBufferPtr ((const byte *)buf, size));
-				return size;
-			}
+				return fuse_service_write_control (buf, size);
 		}
 #ifdef TC_FREEBSD
 		// FreeBSD apparently retries failed write operations forever, which may lead to a system crash.
@@ -318,6 +450,196 @@ namespace Basalt
 		return -ENOENT;
 	}
 
+#ifdef DARWINFUSE
+	// Low-level interface: files are resolved and access rights checked by lookup, getattr, access
+	// and open. The inode stored in fuse_file_info::fh by open selects the file in I/O operations.
+	struct FuseServiceInode
+	{
+		enum Enum
+		{
+			Root = FUSE_ROOT_ID,
+			VolumeImage,
+			Control
+		};
+	};
+
+	static int fuse_service_ll_access (fuse_ino_t ino, int mask)
+	{
+		return fuse_service_access (nullptr, mask);
+	}
+
+	static int fuse_service_ll_fsync (fuse_ino_t ino, int datasync, struct fuse_file_info *fi)
+	{
+		try
+		{
+			switch (fi->fh)
+			{
+			case FuseServiceInode::VolumeImage:
+				FuseService::SyncVolume();
+				return 0;
+
+			case FuseServiceInode::Control:
+				return 0;
+			}
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -EBADF;
+	}
+
+	static int fuse_service_ll_getattr (fuse_ino_t ino, struct stat *statData)
+	{
+		try
+		{
+			fuse_service_init_stat (statData);
+
+			if (ino == FuseServiceInode::Root)
+			{
+				fuse_service_set_root_stat (statData);
+				return 0;
+			}
+
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
+
+			switch (ino)
+			{
+			case FuseServiceInode::VolumeImage:
+				fuse_service_set_file_stat (statData, FuseService::GetVolumeSize());
+				return 0;
+
+			case FuseServiceInode::Control:
+				fuse_service_set_file_stat (statData, FuseService::GetVolumeInfo()->Size());
+				return 0;
+			}
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -ENOENT;
+	}
+
+	static int fuse_service_ll_lookup (fuse_ino_t parent, const char *name, fuse_ino_t *ino)
+	{
+		if (parent != FuseServiceInode::Root)
+			return -ENOTDIR;
+
+		if (strcmp (name, FuseService::GetVolumeImagePath() + 1) == 0)
+			*ino = FuseServiceInode::VolumeImage;
+		else if (strcmp (name, FuseService::GetControlPath() + 1) == 0)
+			*ino = FuseServiceInode::Control;
+		else
+			return -ENOENT;
+
+		return 0;
+	}
+
+	static int fuse_service_ll_open (fuse_ino_t ino, struct fuse_file_info *fi)
+	{
+		try
+		{
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
+
+			switch (ino)
+			{
+			case FuseServiceInode::Root:
+				return -EISDIR;
+
+			case FuseServiceInode::VolumeImage:
+				fi->fh = ino;
+				return 0;
+
+			case FuseServiceInode::Control:
+				fi->direct_io = 1;
+				fi->fh = ino;
+				return 0;
+			}
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -ENOENT;
+	}
+
+	static int fuse_service_ll_read (fuse_ino_t ino, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		try
+		{
+			switch (fi->fh)
+			{
+			case FuseServiceInode::VolumeImage:
+				return fuse_service_read_volume (buf, size, offset);
+
+			case FuseServiceInode::Control:
+				return fuse_service_read_control (buf, size, offset);
+			}
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -EBADF;
+	}
+
+	static int fuse_service_ll_readdir (fuse_ino_t ino, void *buf, darwinfuse_fill_dir_t filler, off_t offset, struct fuse_file_info *fi)
+	{
+		try
+		{
+			if (!FuseService::CheckAccessRights())
+				return -EACCES;
+
+			if (ino != FuseServiceInode::Root)
+				return -ENOTDIR;
+
+			filler (buf, ".", FuseServiceInode::Root, 0);
+			filler (buf, "..", FuseServiceInode::Root, 0);
+			filler (buf, FuseService::GetVolumeImagePath() + 1, FuseServiceInode::VolumeImage, 0);
+			filler (buf, FuseService::GetControlPath() + 1, FuseServiceInode::Control, 0);
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return 0;
+	}
+
+	static int fuse_service_ll_release (fuse_ino_t ino, struct fuse_file_info *fi)
+	{
+		return 0;
+	}
+
+	static int fuse_service_ll_write (fuse_ino_t ino, const char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+	{
+		try
+		{
+			switch (fi->fh)
+			{
+			case FuseServiceInode::VolumeImage:
+				return fuse_service_write_volume (buf, size, offset);
+
+			case FuseServiceInode::Control:
+				return fuse_service_write_control (buf, size);
+			}
+		}
+		catch (...)
+		{
+			return FuseService::ExceptionToErrorCode();
+		}
+
+		return -EBADF;
+	}
+#endif
+
 	bool FuseService::CheckAccessRights ()
 	{
 		return fuse_get_context()->uid == 0 || fuse_get_context()->uid == UserId;
@@ -325,6 +647,9 @@ namespace Basalt
 	
 	void FuseService::CloseMountedVolume ()
 	{
+		RequestScheduler.reset();
+		VolumeFlusher.reset();
+
 		if (MountedVolume)
 		{
 			// This process will exit before the use count of MountedVolume reaches zero
@@ -338,8 +663,40 @@ namespace Basalt
 		}
 	}
 
+	void FuseService::DiscardVolumeSectors (uint64 byteOffset, uint64 length)
+	{
+		if (!MountedVolume)
+			throw NotInitialized (SRC_POS);
+
+		MountedVolume->DiscardSectors (byteOffset, length);
+	}
+
 	void FuseService::Dismount ()
 	{
+		if (KeyRotator)
+		{
+			KeyRotator->Stop();
+			KeyRotator.reset();
+
+			unlink (string (VolumeKeyRotator::GetControlFilePath (DirectoryPath (FuseMountPoint))).c_str());
+		}
+
+		if (MountedVolume && MountedVolume->GetChangeTracker())
+		{
+			// Queued writes must be recorded before the change map is flagged as consistent
+			RequestScheduler.reset();
+			VolumeFlusher.reset();
+
+			try
+			{
+				MountedVolume->GetChangeTracker()->Close();
+			}
+			catch (Exception &e)
+			{
+				SystemLog::WriteException (e);
+			}
+		}
+
 		CloseMountedVolume();
 
 		if (EncryptionThreadPool::IsRunning())
@@ -369,6 +726,10 @@ namespace Basalt
 		{
 			return -EPERM;
 		}
+		catch (NotImplemented&)
+		{
+			return -EOPNOTSUPP;
+		}
 		catch (SystemException &e)
 		{
 			SystemLog::WriteException (e);
@@ -395,6 +756,18 @@ namespace Basalt
 
 			OpenVolumeInfo.Set (*MountedVolume);
 			OpenVolumeInfo.SlotNumber = SlotNumber;
+			OpenVolumeInfo.KeyRotationPaused = KeyRotator && KeyRotator->GetProgressInfo().Paused;
+
+			if (VolumeFlusher)
+			{
+				GroupCommitStatistics syncStatistics = VolumeFlusher->GetStatistics();
+				OpenVolumeInfo.SyncFlushCount = syncStatistics.FlushCount;
+				OpenVolumeInfo.SyncLatencyMax = syncStatistics.LatencyMax;
+				OpenVolumeInfo.SyncLatencyP50 = syncStatistics.LatencyP50;
+				OpenVolumeInfo.SyncLatencyP90 = syncStatistics.LatencyP90;
+				OpenVolumeInfo.SyncLatencyP99 = syncStatistics.LatencyP99;
+				OpenVolumeInfo.SyncRequestCount = syncStatistics.RequestCount;
+			}
 
 			OpenVolumeInfo.Serialize (stream);
 		}
@@ -423,7 +796,7 @@ namespace Basalt
 		return MountedVolume->GetSize();
 	}
 
-	void FuseService::Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint)
+	void FuseService::Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint, VolumeSyncPolicy::Enum syncPolicy, uint32 syncMaxDelay, bool allowDiscard, uint32 queueDepth)
 	{
 		list <string> args;
 		args.push_back (FuseService::GetDeviceType());
@@ -448,7 +821,7 @@ namespace Basalt
 		args.push_back ("-o");
 		args.push_back ("nosuid,nodev");
 		
-		ExecFunctor execFunctor (openVolume, slotNumber);
+		ExecFunctor execFunctor (openVolume, slotNumber, fuseMountPoint, syncPolicy, syncMaxDelay, allowDiscard, queueDepth);
 		Process::Execute ("fuse", args, -1, &execFunctor);
 
 		for (int t = 0; true; t++)
@@ -473,7 +846,10 @@ namespace Basalt
 		if (!MountedVolume)
 			throw NotInitialized (SRC_POS);
 
-		MountedVolume->ReadSectors (buffer, byteOffset);
+		if (RequestScheduler)
+			RequestScheduler->ReadSectors (buffer, byteOffset);
+		else
+			MountedVolume->ReadSectors (buffer, byteOffset);
 	}
 
 	void FuseService::ReceiveAuxDeviceInfo (const ConstBufferPtr &buffer)
@@ -525,12 +901,80 @@ namespace Basalt
 #endif
 	}
 
+	void FuseService::StartKeyRotation ()
+	{
+		// Key rotation of an outer volume would destroy the protected hidden volume
+		if (!MountedVolume
+			|| !MountedVolume->IsKeyRotationInProgress()
+			|| MountedVolume->GetProtectionType() != VolumeProtection::None)
+		{
+			return;
+		}
+
+		// Requests left over from a previous mount at the same location must not apply
+		unlink (string (VolumeKeyRotator::GetControlFilePath (DirectoryPath (FuseMountPoint))).c_str());
+
+		struct ControlFunctor : public Functor
+		{
+			virtual void operator() ()
+			{
+				FuseService::UpdateKeyRotationControl();
+			}
+		};
+
+		KeyRotator.reset (new VolumeKeyRotator (MountedVolume, shared_ptr <Functor> (new ControlFunctor)));
+		KeyRotator->Start();
+	}
+
+	void FuseService::SyncVolume ()
+	{
+		if (!VolumeFlusher)
+			throw NotInitialized (SRC_POS);
+
+		VolumeFlusher->Sync();
+	}
+
+	void FuseService::UpdateKeyRotationControl ()
+	{
+		// Pause and throttling requests are stored alongside the aux mount directory (see SendAuxDeviceInfo)
+		string controlPath = VolumeKeyRotator::GetControlFilePath (DirectoryPath (FuseMountPoint));
+
+		struct stat statData;
+		if (lstat (controlPath.c_str(), &statData) != 0 || !S_ISREG (statData.st_mode))
+			return;
+
+		// Only the user who mounted the volume may control its key rotation
+		if (statData.st_uid != 0 && statData.st_uid != UserId)
+			return;
+
+		KeyRotationControl control;
+		try
+		{
+			control = VolumeKeyRotator::ReadControlFile (controlPath);
+		}
+		catch (...)
+		{
+			// The file may be in the middle of being written
+			return;
+		}
+
+		if (control.Paused)
+			KeyRotator->Pause();
+		else
+			KeyRotator->Resume();
+
+		KeyRotator->SetMaxBytesPerSecond (control.MaxBytesPerSecond);
+	}
+
 	void FuseService::WriteVolumeSectors (const ConstBufferPtr &buffer, uint64 byteOffset)
 	{
 		if (!MountedVolume)
 			throw NotInitialized (SRC_POS);
 
-		MountedVolume->WriteSectors (buffer, byteOffset);
+		if (RequestScheduler)
+			RequestScheduler->WriteSectors (buffer, byteOffset);
+		else
+			MountedVolume->WriteSectors (buffer, byteOffset);
 	}
 	
 	void FuseService::OnSignal (int signal)
@@ -553,8 +997,14 @@ namespace Basalt
 		gettimeofday (&tv, NULL);
 		FuseService::OpenVolumeInfo.SerialInstanceNumber = (uint64)tv.tv_sec * 1000000ULL + tv.tv_usec;
 
+		FuseService::FuseMountPoint = FuseMountPoint;
 		FuseService::MountedVolume = MountedVolume;
 		FuseService::SlotNumber = SlotNumber;
+		FuseService::VolumeFlusher.reset (new GroupCommitFlusher (MountedVolume->GetFile(), SyncPolicy, SyncMaxDelay));
+
+		// A queue depth of zero passes requests to the volume in arrival order
+		if (QueueDepth > 0)
+			FuseService::RequestScheduler.reset (new VolumeRequestScheduler (MountedVolume, QueueDepth));
 
 		FuseService::UserId = getuid();
 		FuseService::GroupId = getgid();
@@ -579,6 +1029,8 @@ namespace Basalt
 
 		fuse_service_oper.access = fuse_service_access;
 		fuse_service_oper.destroy = fuse_service_destroy;
+		fuse_service_oper.flush = fuse_service_flush;
+		fuse_service_oper.fsync = fuse_service_fsync;
 		fuse_service_oper.getattr = fuse_service_getattr;
 		fuse_service_oper.init = fuse_service_init;
 		fuse_service_oper.open = fuse_service_open;
@@ -587,13 +1039,36 @@ namespace Basalt
 		fuse_service_oper.readdir = fuse_service_readdir;
 		fuse_service_oper.write = fuse_service_write;
 
+#if defined (FALLOC_FL_PUNCH_HOLE) && FUSE_VERSION >= 29
+		if (AllowDiscard)
+			fuse_service_oper.fallocate = fuse_service_fallocate;
+#endif
+
 #ifdef TC_MACOSX
 		// On macOS with DarwinFUSE, fuse_main handles daemonization
 		// internally (forks a daemon child and returns 0 in the parent).
 		// No signal-handler child is needed — DarwinFUSE's daemon handles
 		// its own lifecycle.  We just call fuse_main and _exit.
 		setsid ();
+#ifdef DARWINFUSE
+		static darwinfuse_lowlevel_ops fuse_service_ll_oper;
+
+		fuse_service_ll_oper.access = fuse_service_ll_access;
+		fuse_service_ll_oper.destroy = fuse_service_destroy;
+		fuse_service_ll_oper.fsync = fuse_service_ll_fsync;
+		fuse_service_ll_oper.getattr = fuse_service_ll_getattr;
+		fuse_service_ll_oper.init = fuse_service_init;
+		fuse_service_ll_oper.lookup = fuse_service_ll_lookup;
+		fuse_service_ll_oper.open = fuse_service_ll_open;
+		fuse_service_ll_oper.read = fuse_service_ll_read;
+		fuse_service_ll_oper.readdir = fuse_service_ll_readdir;
+		fuse_service_ll_oper.release = fuse_service_ll_release;
+		fuse_service_ll_oper.write = fuse_service_ll_write;
+
+		_exit (darwinfuse_main_lowlevel (argc, argv, &fuse_service_ll_oper, NULL));
+#else
 		_exit (fuse_main (argc, argv, &fuse_service_oper, NULL));
+#endif
 #else
 		// Create a new session
 		setsid ();
@@ -629,10 +1104,14 @@ namespace Basalt
 #endif
 	}
 
+	string FuseService::FuseMountPoint;
+	shared_ptr <VolumeKeyRotator> FuseService::KeyRotator;
 	VolumeInfo FuseService::OpenVolumeInfo;
 	Mutex FuseService::OpenVolumeInfoMutex;
 	shared_ptr <Volume> FuseService::MountedVolume;
+	unique_ptr <VolumeRequestScheduler> FuseService::RequestScheduler;
 	VolumeSlotNumber FuseService::SlotNumber;
+	unique_ptr <GroupCommitFlusher> FuseService::VolumeFlusher;
 	uid_t FuseService::UserId;
 	gid_t FuseService::GroupId;
 	unique_ptr <Pipe> FuseService::SignalHandlerPipe;
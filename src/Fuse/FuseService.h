@@ -14,11 +14,14 @@
 #include "Platform/Unix/Pipe.h"
 #include "Platform/Unix/Process.h"
 #endif
+#include "Volume/GroupCommitFlusher.h"
 #include "Volume/VolumeInfo.h"
+#include "Volume/VolumeRequestScheduler.h"
 #include "Volume/Volume.h"
 
 namespace Basalt
 {
+	class VolumeKeyRotator;
 
 	class FuseService
 	{
@@ -26,15 +29,20 @@ namespace Basalt
 	protected:
 		struct ExecFunctor : public ProcessExecFunctor
 		{
-			ExecFunctor (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber)
-				: MountedVolume (openVolume), SlotNumber (slotNumber)
+			ExecFunctor (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint, VolumeSyncPolicy::Enum syncPolicy, uint32 syncMaxDelay, bool allowDiscard, uint32 queueDepth)
+				: AllowDiscard (allowDiscard), FuseMountPoint (fuseMountPoint), MountedVolume (openVolume), QueueDepth (queueDepth), SlotNumber (slotNumber), SyncMaxDelay (syncMaxDelay), SyncPolicy (syncPolicy)
 			{
 			}
 			virtual void operator() (int argc, char *argv[]);
 
 		protected:
+			bool AllowDiscard;
+			string FuseMountPoint;
 			shared_ptr <Volume> MountedVolume;
+			uint32 QueueDepth;
 			VolumeSlotNumber SlotNumber;
+			uint32 SyncMaxDelay;
+			VolumeSyncPolicy::Enum SyncPolicy;
 		};
 
 		friend struct ExecFunctor;
@@ -45,6 +53,7 @@ namespace Basalt
 #ifndef TC_WINDOWS
 		static bool CheckAccessRights ();
 #endif
+		static void DiscardVolumeSectors (uint64 byteOffset, uint64 length);
 		static void Dismount ();
 		static int ExceptionToErrorCode ();
 		static const char *GetControlPath () { return "/control"; }
@@ -57,10 +66,13 @@ namespace Basalt
 		static shared_ptr <Buffer> GetVolumeInfo ();
 		static uint64 GetVolumeSize ();
 		static uint64 GetVolumeSectorSize () { return MountedVolume->GetSectorSize(); }
-		static void Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint);
+		static void Mount (shared_ptr <Volume> openVolume, VolumeSlotNumber slotNumber, const string &fuseMountPoint, VolumeSyncPolicy::Enum syncPolicy = VolumeSyncPolicy::Grouped, uint32 syncMaxDelay = GroupCommitFlusher::DefaultMaxDelay, bool allowDiscard = false, uint32 queueDepth = VolumeRequestScheduler::DefaultQueueDepth);
 		static void ReadVolumeSectors (const BufferPtr &buffer, uint64 byteOffset);
 		static void ReceiveAuxDeviceInfo (const ConstBufferPtr &buffer);
 		static void SendAuxDeviceInfo (const DirectoryPath &fuseMountPoint, const DevicePath &virtualDevice, const DevicePath &loopDevice = DevicePath());
+		static void StartKeyRotation ();
+		static void SyncVolume ();
+		static void UpdateKeyRotationControl ();
 		static void WriteVolumeSectors (const ConstBufferPtr &buffer, uint64 byteOffset);
 
 	protected:
@@ -70,10 +82,14 @@ namespace Basalt
 		static void OnSignal (int signal);
 #endif
 
+		static string FuseMountPoint;
+		static shared_ptr <VolumeKeyRotator> KeyRotator;
 		static VolumeInfo OpenVolumeInfo;
 		static Mutex OpenVolumeInfoMutex;
 		static shared_ptr <Volume> MountedVolume;
+		static unique_ptr <VolumeRequestScheduler> RequestScheduler;
 		static VolumeSlotNumber SlotNumber;
+		static unique_ptr <GroupCommitFlusher> VolumeFlusher;
 #ifndef TC_WINDOWS
 		static uid_t UserId;
 		static gid_t GroupId;
@@ -0,0 +1,481 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <string.h>
+#include "Platform/Platform.h"
+#include "Volume/EncryptionThreadPool.h"
+#include "Volume/Keyfile.h"
+#include "Volume/Volume.h"
+#include "Volume/VolumeException.h"
+#include "Volume/VolumePassword.h"
+#include "basalt.h"
+
+using namespace Basalt;
+
+struct basalt_volume
+{
+	struct AsyncRequest
+	{
+		basalt_completion_t Completion;
+		void *Context;
+		byte *Data;
+		uint64 Offset;
+		size_t Size;
+		bool Write;
+	};
+
+	basalt_volume () : AsyncThreadsStarted (false), Closing (false) { }
+
+	shared_ptr <Volume> OpenVolume;
+
+	// Aligned writes share the lock. Partial sectors are read, modified and written back
+	// under the exclusive lock, so that no concurrent write can be undone by the write-back.
+	SharedMutex WriteMutex;
+
+	SyncEvent AsyncEvent;
+	Mutex AsyncMutex;
+	list <AsyncRequest> AsyncQueue;
+	list < shared_ptr <Thread> > AsyncThreads;
+	bool AsyncThreadsStarted;
+	bool Closing;
+};
+
+namespace Basalt
+{
+	static const size_t LibraryAsyncThreadCount = 4;
+
+	static Mutex LibraryMutex;
+	static size_t LibraryOpenVolumeCount = 0;
+	static bool LibraryThreadPoolStarted = false;
+
+	static int LibraryExceptionToError ()
+	{
+		try
+		{
+			throw;
+		}
+		catch (std::bad_alloc&)
+		{
+			return BASALT_ERROR_NO_MEMORY;
+		}
+		catch (PasswordException&)
+		{
+			return BASALT_ERROR_PASSWORD;
+		}
+		catch (VolumeProtected&)
+		{
+			return BASALT_ERROR_PROTECTED;
+		}
+		catch (VolumeReadOnly&)
+		{
+			return BASALT_ERROR_READ_ONLY;
+		}
+		catch (VolumeHostInUse&)
+		{
+			return BASALT_ERROR_IN_USE;
+		}
+		catch (HigherVersionRequired&)
+		{
+			return BASALT_ERROR_UNSUPPORTED;
+		}
+		catch (UnsupportedSectorSize&)
+		{
+			return BASALT_ERROR_UNSUPPORTED;
+		}
+		catch (ParameterIncorrect&)
+		{
+			return BASALT_ERROR_PARAMETER;
+		}
+		catch (MissingVolumeData&)
+		{
+			return BASALT_ERROR_IO;
+		}
+		catch (SystemException&)
+		{
+			return BASALT_ERROR_IO;
+		}
+		catch (...)
+		{
+			return BASALT_ERROR_UNKNOWN;
+		}
+	}
+
+	static bool LibraryIsRangeValid (const basalt_volume *volume, size_t size, uint64 offset)
+	{
+		uint64 volumeSize = volume->OpenVolume->GetSize();
+		return offset <= volumeSize && size <= volumeSize - offset;
+	}
+
+	static void LibraryRead (basalt_volume *volume, byte *data, size_t size, uint64 offset)
+	{
+		uint64 sectorSize = volume->OpenVolume->GetSectorSize();
+
+		if (size == 0)
+			return;
+
+		if (offset % sectorSize == 0 && size % sectorSize == 0)
+		{
+			volume->OpenVolume->ReadSectors (BufferPtr (data, size), offset);
+			return;
+		}
+
+		uint64 alignedStart = offset - offset % sectorSize;
+		uint64 alignedEnd = (offset + size + sectorSize - 1) / sectorSize * sectorSize;
+
+		SecureBuffer buffer (static_cast <size_t> (alignedEnd - alignedStart));
+		volume->OpenVolume->ReadSectors (buffer, alignedStart);
+		memcpy (data, buffer.Ptr() + (offset - alignedStart), size);
+	}
+
+	static void LibraryWrite (basalt_volume *volume, const byte *data, size_t size, uint64 offset)
+	{
+		uint64 sectorSize = volume->OpenVolume->GetSectorSize();
+
+		if (size == 0)
+			return;
+
+		if (offset % sectorSize == 0 && size % sectorSize == 0)
+		{
+			SharedScopeLock lock (volume->WriteMutex);
+			volume->OpenVolume->WriteSectors (ConstBufferPtr (data, size), offset);
+			return;
+		}
+
+		uint64 alignedStart = offset - offset % sectorSize;
+		uint64 alignedEnd = (offset + size + sectorSize - 1) / sectorSize * sectorSize;
+
+		SecureBuffer buffer (static_cast <size_t> (alignedEnd - alignedStart));
+		BufferPtr firstSector = buffer.GetRange (0, static_cast <size_t> (sectorSize));
+		BufferPtr lastSector = buffer.GetRange (buffer.Size() - static_cast <size_t> (sectorSize), static_cast <size_t> (sectorSize));
+
+		ExclusiveScopeLock lock (volume->WriteMutex);
+
+		if (offset != alignedStart)
+			volume->OpenVolume->ReadSectors (firstSector, alignedStart);
+
+		if (offset + size != alignedEnd && (alignedEnd - alignedStart > sectorSize || offset == alignedStart))
+			volume->OpenVolume->ReadSectors (lastSector, alignedEnd - sectorSize);
+
+		memcpy (buffer.Ptr() + (offset - alignedStart), data, size);
+		volume->OpenVolume->WriteSectors (buffer, alignedStart);
+	}
+
+	static void LibraryAsyncThread (basalt_volume *volume)
+	{
+		while (true)
+		{
+			basalt_volume::AsyncRequest request;
+			bool requestPending = false;
+			bool morePending = false;
+			{
+				ScopeLock lock (volume->AsyncMutex);
+
+				if (!volume->AsyncQueue.empty())
+				{
+					request = volume->AsyncQueue.front();
+					volume->AsyncQueue.pop_front();
+					requestPending = true;
+					morePending = !volume->AsyncQueue.empty();
+				}
+				else if (volume->Closing)
+				{
+					break;
+				}
+			}
+
+			if (!requestPending)
+			{
+				volume->AsyncEvent.Wait();
+				continue;
+			}
+
+			// The event wakes one thread at a time, and signals arriving together wake only one
+			if (morePending)
+				volume->AsyncEvent.Signal();
+
+			int result = BASALT_OK;
+			try
+			{
+				if (request.Write)
+					LibraryWrite (volume, request.Data, request.Size, request.Offset);
+				else
+					LibraryRead (volume, request.Data, request.Size, request.Offset);
+			}
+			catch (...)
+			{
+				result = LibraryExceptionToError();
+			}
+
+			request.Completion (request.Context, result);
+		}
+
+		// Let the other threads see the queue closed
+		volume->AsyncEvent.Signal();
+	}
+
+	static int LibrarySubmit (basalt_volume *volume, bool write, byte *data, size_t size, uint64 offset, basalt_completion_t completion, void *context)
+	{
+		if (!volume || (!data && size > 0) || !completion)
+			return BASALT_ERROR_PARAMETER;
+
+		if (!LibraryIsRangeValid (volume, size, offset))
+			return BASALT_ERROR_PARAMETER;
+
+		try
+		{
+			ScopeLock lock (volume->AsyncMutex);
+
+			if (volume->Closing)
+				return BASALT_ERROR_PARAMETER;
+
+			if (!volume->AsyncThreadsStarted)
+			{
+				struct AsyncThreadFunctor : public Functor
+				{
+					AsyncThreadFunctor (basalt_volume *volume) : LibraryVolume (volume) { }
+					virtual void operator() ()
+					{
+						LibraryAsyncThread (LibraryVolume);
+					}
+					basalt_volume *LibraryVolume;
+				};
+
+				for (size_t i = 0; i < LibraryAsyncThreadCount; ++i)
+				{
+					shared_ptr <Thread> thread (new Thread);
+					thread->Start (new AsyncThreadFunctor (volume));
+					volume->AsyncThreads.push_back (thread);
+				}
+
+				volume->AsyncThreadsStarted = true;
+			}
+
+			basalt_volume::AsyncRequest request;
+			request.Completion = completion;
+			request.Context = context;
+			request.Data = data;
+			request.Offset = offset;
+			request.Size = size;
+			request.Write = write;
+
+			volume->AsyncQueue.push_back (request);
+		}
+		catch (...)
+		{
+			return LibraryExceptionToError();
+		}
+
+		volume->AsyncEvent.Signal();
+		return BASALT_OK;
+	}
+}
+
+int basalt_api_version (void)
+{
+	return BASALT_API_VERSION;
+}
+
+const char *basalt_strerror (int error)
+{
+	switch (error)
+	{
+	case BASALT_OK:					return "Success";
+	case BASALT_ERROR_PARAMETER:	return "Invalid parameter";
+	case BASALT_ERROR_PASSWORD:		return "Incorrect password or not a valid volume";
+	case BASALT_ERROR_IO:			return "Input/output error";
+	case BASALT_ERROR_READ_ONLY:	return "Volume is read-only";
+	case BASALT_ERROR_PROTECTED:	return "Write to a protected hidden volume area";
+	case BASALT_ERROR_IN_USE:		return "Volume host is in use";
+	case BASALT_ERROR_UNSUPPORTED:	return "Volume not supported";
+	case BASALT_ERROR_NO_MEMORY:	return "Out of memory";
+	default:						return "Unknown error";
+	}
+}
+
+int basalt_open (const char *path, const char *password, const char *const *keyfiles, unsigned int flags, basalt_volume_t **volume)
+{
+	if (!path || !volume)
+		return BASALT_ERROR_PARAMETER;
+
+	*volume = nullptr;
+
+	try
+	{
+		shared_ptr <VolumePassword> volumePassword;
+		if (password)
+			volumePassword.reset (new VolumePassword (password, strlen (password)));
+
+		shared_ptr <KeyfileList> keyfileList;
+		if (keyfiles && keyfiles[0])
+		{
+			keyfileList.reset (new KeyfileList);
+			for (const char *const *keyfile = keyfiles; *keyfile; ++keyfile)
+				keyfileList->push_back (shared_ptr <Keyfile> (new Keyfile (FilesystemPath (StringConverter::ToWide (string (*keyfile))))));
+		}
+
+		unique_ptr <basalt_volume> newVolume (new basalt_volume);
+		newVolume->OpenVolume.reset (new Volume);
+
+		{
+			ScopeLock lock (LibraryMutex);
+			if (!EncryptionThreadPool::IsRunning())
+			{
+				EncryptionThreadPool::Start();
+				LibraryThreadPoolStarted = true;
+			}
+			++LibraryOpenVolumeCount;
+		}
+
+		try
+		{
+			newVolume->OpenVolume->Open (VolumePath (StringConverter::ToWide (string (path))), false, volumePassword, keyfileList,
+				(flags & BASALT_OPEN_READ_ONLY) ? VolumeProtection::ReadOnly : VolumeProtection::None,
+				shared_ptr <VolumePassword> (), shared_ptr <KeyfileList> (),
+				(flags & BASALT_OPEN_SHARED) != 0, VolumeType::Unknown, (flags & BASALT_OPEN_BACKUP_HEADER) != 0);
+		}
+		catch (...)
+		{
+			ScopeLock lock (LibraryMutex);
+			if (--LibraryOpenVolumeCount == 0 && LibraryThreadPoolStarted)
+			{
+				EncryptionThreadPool::Stop();
+				LibraryThreadPoolStarted = false;
+			}
+			throw;
+		}
+
+		*volume = newVolume.release();
+	}
+	catch (...)
+	{
+		return LibraryExceptionToError();
+	}
+
+	return BASALT_OK;
+}
+
+int basalt_close (basalt_volume_t *volume)
+{
+	if (!volume)
+		return BASALT_ERROR_PARAMETER;
+
+	int result = BASALT_OK;
+
+	try
+	{
+		// Queued requests are completed before the threads exit
+		{
+			ScopeLock lock (volume->AsyncMutex);
+			volume->Closing = true;
+		}
+
+		volume->AsyncEvent.Signal();
+
+		for (const shared_ptr <Thread> &thread : volume->AsyncThreads)
+			thread->Join();
+
+		if (volume->OpenVolume->GetProtectionType() != VolumeProtection::ReadOnly)
+			volume->OpenVolume->GetFile()->Flush();
+
+		volume->OpenVolume->Close();
+	}
+	catch (...)
+	{
+		result = LibraryExceptionToError();
+	}
+
+	delete volume;
+
+	try
+	{
+		ScopeLock lock (LibraryMutex);
+		if (--LibraryOpenVolumeCount == 0 && LibraryThreadPoolStarted)
+		{
+			EncryptionThreadPool::Stop();
+			LibraryThreadPoolStarted = false;
+		}
+	}
+	catch (...)
+	{
+		if (result == BASALT_OK)
+			result = LibraryExceptionToError();
+	}
+
+	return result;
+}
+
+int basalt_flush (basalt_volume_t *volume)
+{
+	if (!volume)
+		return BASALT_ERROR_PARAMETER;
+
+	try
+	{
+		volume->OpenVolume->GetFile()->Flush();
+	}
+	catch (...)
+	{
+		return LibraryExceptionToError();
+	}
+
+	return BASALT_OK;
+}
+
+uint32_t basalt_get_sector_size (const basalt_volume_t *volume)
+{
+	return volume ? static_cast <uint32_t> (volume->OpenVolume->GetSectorSize()) : 0;
+}
+
+uint64_t basalt_get_size (const basalt_volume_t *volume)
+{
+	return volume ? volume->OpenVolume->GetSize() : 0;
+}
+
+int basalt_pread (basalt_volume_t *volume, void *buffer, size_t size, uint64_t offset)
+{
+	if (!volume || (!buffer && size > 0) || !LibraryIsRangeValid (volume, size, offset))
+		return BASALT_ERROR_PARAMETER;
+
+	try
+	{
+		LibraryRead (volume, static_cast <byte *> (buffer), size, offset);
+	}
+	catch (...)
+	{
+		return LibraryExceptionToError();
+	}
+
+	return BASALT_OK;
+}
+
+int basalt_pread_async (basalt_volume_t *volume, void *buffer, size_t size, uint64_t offset, basalt_completion_t completion, void *context)
+{
+	return LibrarySubmit (volume, false, static_cast <byte *> (buffer), size, offset, completion, context);
+}
+
+int basalt_pwrite (basalt_volume_t *volume, const void *buffer, size_t size, uint64_t offset)
+{
+	if (!volume || (!buffer && size > 0) || !LibraryIsRangeValid (volume, size, offset))
+		return BASALT_ERROR_PARAMETER;
+
+	try
+	{
+		LibraryWrite (volume, static_cast <const byte *> (buffer), size, offset);
+	}
+	catch (...)
+	{
+		return LibraryExceptionToError();
+	}
+
+	return BASALT_OK;
+}
+
+int basalt_pwrite_async (basalt_volume_t *volume, const void *buffer, size_t size, uint64_t offset, basalt_completion_t completion, void *context)
+{
+	return LibrarySubmit (volume, true, static_cast <byte *> (const_cast <void *> (buffer)), size, offset, completion, context);
+}
@@ -0,0 +1,244 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+// Tests of the volume access library, built and run by "make libbasalt-test"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "Platform/Platform.h"
+#include "Volume/EncryptionAlgorithm.h"
+#include "Volume/Pkcs5Kdf.h"
+#include "Volume/VolumeHeader.h"
+#include "Volume/VolumeLayout.h"
+#include "basalt.h"
+
+namespace Basalt
+{
+	class LibraryTest
+	{
+	public:
+		static void TestAll (const string &volumePath);
+
+	protected:
+		static void CreateVolume (const string &volumePath);
+		static void TestConcurrentWrites (const string &volumePath);
+
+		static const char *const Password;
+		static const uint64 VolumeSize = 4 * 1024 * 1024;
+	};
+
+	const char *const LibraryTest::Password = "library test";
+
+	void LibraryTest::CreateVolume (const string &volumePath)
+	{
+		VolumeLayoutV2Normal layout;
+
+		// A legacy KDF keeps opening the volume fast
+		shared_ptr <Pkcs5Kdf> kdf (new Pkcs5HmacSha512_Legacy);
+
+		VolumeHeaderCreationOptions options;
+		options.EA.reset (new AES);
+		options.Kdf = kdf;
+		options.Type = VolumeType::Normal;
+		options.SectorSize = ENCRYPTION_DATA_UNIT_SIZE;
+		options.VolumeDataStart = layout.GetHeaderSize() * 2;
+		options.VolumeDataSize = layout.GetMaxDataSize (VolumeSize);
+
+		SecureBuffer dataKey (options.EA->GetKeySize() * 2);
+		for (size_t i = 0; i < dataKey.Size(); ++i)
+			dataKey[i] = (byte) i;
+
+		SecureBuffer salt (VolumeHeader::GetSaltSize());
+		for (size_t i = 0; i < salt.Size(); ++i)
+			salt[i] = (byte) (i * 3);
+
+		SecureBuffer headerKey (VolumeHeader::GetLargestSerializedKeySize());
+		kdf->DeriveKey (headerKey, VolumePassword (Password, strlen (Password)), salt);
+
+		options.DataKey = dataKey;
+		options.Salt = salt;
+		options.HeaderKey = headerKey;
+
+		SecureBuffer header (layout.GetHeaderSize());
+		layout.GetHeader()->Create (header, options);
+
+		File volumeFile;
+		volumeFile.Open (FilePath (StringConverter::ToWide (volumePath)), File::CreateReadWrite);
+		volumeFile.Write (header);
+
+		SecureBuffer fill (static_cast <size_t> (VolumeSize) - header.Size());
+		fill.Zero();
+		volumeFile.Write (fill);
+	}
+
+	void LibraryTest::TestAll (const string &volumePath)
+	{
+		CreateVolume (volumePath);
+		finally_do_arg (string, volumePath, { unlink (finally_arg.c_str()); });
+
+		TestConcurrentWrites (volumePath);
+	}
+
+	void LibraryTest::TestConcurrentWrites (const string &volumePath)
+	{
+		static const size_t AlignedWriterCount = 2;
+		static const size_t PartialWriterCount = 2;
+		static const size_t SectorsPerWriter = 32;
+		static const size_t PartialWriteSize = 16;
+		static const uint32 IterationCount = 2000;
+
+		basalt_volume_t *volume;
+		if (basalt_open (volumePath.c_str(), Password, nullptr, 0, &volume) != BASALT_OK)
+			throw TestFailed (SRC_POS);
+
+		finally_do_arg (basalt_volume_t *, volume, { basalt_close (finally_arg); });
+
+		const size_t sectorSize = basalt_get_sector_size (volume);
+		const size_t regionSize = SectorsPerWriter * sectorSize;
+		SharedVal <size_t> failures (0);
+
+		/*
+		 * Each aligned writer rewrites its own sectors with an increasing counter and checks
+		 * the bytes no partial writer touches. The partial writers update the first bytes of
+		 * every sector; a partial write that undid an aligned one would leave an older counter.
+		 */
+		struct AlignedWriter : public Functor
+		{
+			AlignedWriter (basalt_volume_t *volume, uint64 offset, size_t size, size_t sectorSize, SharedVal <size_t> &failures)
+				: Failures (failures), Offset (offset), SectorSize (sectorSize), Size (size), Volume (volume) { }
+
+			virtual void operator() ()
+			{
+				Buffer data (Size);
+				Buffer readBack (Size);
+
+				for (uint32 counter = 1; counter <= IterationCount; ++counter)
+				{
+					for (size_t i = 0; i < Size; i += sizeof (counter))
+						memcpy (data.Ptr() + i, &counter, sizeof (counter));
+
+					if (basalt_pwrite (Volume, data.Ptr(), data.Size(), Offset) != BASALT_OK
+						|| basalt_pread (Volume, readBack.Ptr(), readBack.Size(), Offset) != BASALT_OK)
+					{
+						Failures.Increment();
+						return;
+					}
+
+					for (size_t sector = 0; sector < Size; sector += SectorSize)
+					{
+						for (size_t i = PartialWriterCount * PartialWriteSize; i < SectorSize; i += sizeof (counter))
+						{
+							uint32 sectorCounter;
+							memcpy (&sectorCounter, readBack.Ptr() + sector + i, sizeof (sectorCounter));
+
+							if (sectorCounter < counter)
+							{
+								Failures.Increment();
+								return;
+							}
+						}
+					}
+				}
+			}
+
+			SharedVal <size_t> &Failures;
+			uint64 Offset;
+			size_t SectorSize;
+			size_t Size;
+			basalt_volume_t *Volume;
+		};
+
+		struct PartialWriter : public Functor
+		{
+			PartialWriter (basalt_volume_t *volume, size_t byteOffset, size_t size, size_t sectorSize, SharedVal <size_t> &failures)
+				: ByteOffset (byteOffset), Failures (failures), SectorSize (sectorSize), Size (size), Volume (volume) { }
+
+			virtual void operator() ()
+			{
+				byte data[PartialWriteSize];
+				memset (data, 0xff, sizeof (data));
+
+				for (uint32 i = 0; i < IterationCount; ++i)
+				{
+					for (size_t sector = 0; sector < Size; sector += SectorSize)
+					{
+						if (basalt_pwrite (Volume, data, sizeof (data), sector + ByteOffset) != BASALT_OK)
+						{
+							Failures.Increment();
+							return;
+						}
+					}
+				}
+			}
+
+			size_t ByteOffset;
+			SharedVal <size_t> &Failures;
+			size_t SectorSize;
+			size_t Size;
+			basalt_volume_t *Volume;
+		};
+
+		list < shared_ptr <Thread> > threads;
+
+		for (size_t i = 0; i < AlignedWriterCount; ++i)
+		{
+			make_shared_auto (Thread, thread);
+			thread->Start (new AlignedWriter (volume, i * regionSize, regionSize, sectorSize, failures));
+			threads.push_back (thread);
+		}
+
+		for (size_t i = 0; i < PartialWriterCount; ++i)
+		{
+			make_shared_auto (Thread, thread);
+			thread->Start (new PartialWriter (volume, i * PartialWriteSize, AlignedWriterCount * regionSize, sectorSize, failures));
+			threads.push_back (thread);
+		}
+
+		for (const auto &thread : threads)
+			thread->Join();
+
+		if (failures.Get() != 0)
+			throw TestFailed (SRC_POS);
+
+		// The last aligned write of every sector must have survived
+		Buffer data (AlignedWriterCount * regionSize);
+		if (basalt_pread (volume, data.Ptr(), data.Size(), 0) != BASALT_OK)
+			throw TestFailed (SRC_POS);
+
+		for (size_t sector = 0; sector < data.Size(); sector += sectorSize)
+		{
+			for (size_t i = 0; i < sectorSize; i += sizeof (uint32))
+			{
+				uint32 counter;
+				memcpy (&counter, data.Ptr() + sector + i, sizeof (counter));
+
+				if (counter != IterationCount && (i >= PartialWriterCount * PartialWriteSize || counter != 0xffffffff))
+					throw TestFailed (SRC_POS);
+			}
+		}
+	}
+}
+
+int main (int argc, char **argv)
+{
+	using namespace Basalt;
+
+	try
+	{
+		LibraryTest::TestAll (argc > 1 ? argv[1] : "libbasalt-test.tc");
+	}
+	catch (Exception &e)
+	{
+		fprintf (stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	puts ("libbasalt tests passed");
+	return 0;
+}
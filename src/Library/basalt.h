@@ -0,0 +1,99 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+/*
+ * libbasalt: access to the data of Basalt and TrueCrypt volumes from within
+ * a process, without mounting them. The data area of an opened volume is
+ * read and written like a file; sectors are decrypted and encrypted by the
+ * encryption thread pool of the library.
+ *
+ * All functions are thread-safe. Any number of reads and writes of a volume
+ * may be in progress at a time, both blocking and asynchronous ones. The
+ * result of writes to the same bytes in progress at the same time is
+ * undefined, as with a block device.
+ *
+ * Functions return BASALT_OK or a negative error code.
+ */
+
+#ifndef BASALT_H
+#define BASALT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented when the interface changes incompatibly */
+#define BASALT_API_VERSION          1
+
+#define BASALT_OK                   0
+#define BASALT_ERROR_PARAMETER      (-1)    /* Invalid argument, or beyond the end of the volume */
+#define BASALT_ERROR_PASSWORD       (-2)    /* Incorrect password or keyfiles, or not a volume */
+#define BASALT_ERROR_IO             (-3)    /* The host file or device failed */
+#define BASALT_ERROR_READ_ONLY      (-4)    /* Write to a volume opened read-only */
+#define BASALT_ERROR_PROTECTED      (-5)    /* Write to the area of a protected hidden volume */
+#define BASALT_ERROR_IN_USE         (-6)    /* The host file or device is in use */
+#define BASALT_ERROR_UNSUPPORTED    (-7)    /* Volume format or sector size not supported */
+#define BASALT_ERROR_NO_MEMORY      (-8)
+#define BASALT_ERROR_UNKNOWN        (-9)
+
+/* Flags of basalt_open() */
+#define BASALT_OPEN_READ_ONLY       0x1
+#define BASALT_OPEN_BACKUP_HEADER   0x2     /* Use the backup header embedded in the volume */
+#define BASALT_OPEN_SHARED          0x4     /* Allow the host to be open elsewhere */
+
+typedef struct basalt_volume basalt_volume_t;
+
+/* Called on a library thread when an asynchronous request completes */
+typedef void (*basalt_completion_t)(void *context, int result);
+
+int basalt_api_version(void);
+const char *basalt_strerror(int error);
+
+/*
+ * Open the volume hosted by a file or device.  keyfiles is a NULL-terminated
+ * array of paths of keyfiles or directories of keyfiles, or NULL.  Hidden
+ * volumes are opened by the password of the hidden volume.
+ */
+int basalt_open(const char *path, const char *password, const char *const *keyfiles,
+                unsigned int flags, basalt_volume_t **volume);
+
+/* Waits for the asynchronous requests of the volume, flushes and closes it */
+int basalt_close(basalt_volume_t *volume);
+
+uint64_t basalt_get_size(const basalt_volume_t *volume);
+uint32_t basalt_get_sector_size(const basalt_volume_t *volume);
+
+/*
+ * Read or write size bytes at offset within the data area.  Offset and size
+ * need not be aligned to sectors, but aligned requests avoid reading and
+ * rewriting partial sectors.
+ */
+int basalt_pread(basalt_volume_t *volume, void *buffer, size_t size, uint64_t offset);
+int basalt_pwrite(basalt_volume_t *volume, const void *buffer, size_t size, uint64_t offset);
+
+/* Make completed writes durable */
+int basalt_flush(basalt_volume_t *volume);
+
+/*
+ * Queue a read or write and return immediately.  The buffer must remain
+ * valid until the completion function has been called with the result of
+ * the request.  Requests are not ordered with respect to each other.
+ */
+int basalt_pread_async(basalt_volume_t *volume, void *buffer, size_t size, uint64_t offset,
+                       basalt_completion_t completion, void *context);
+int basalt_pwrite_async(basalt_volume_t *volume, const void *buffer, size_t size, uint64_t offset,
+                        basalt_completion_t completion, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BASALT_H */
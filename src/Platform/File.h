@@ -66,6 +66,7 @@ namespace Basalt
 		static void Copy (const FilePath &sourcePath, const FilePath &destinationPath, bool preserveTimestamps = true);
 		void Delete ();
 		void Flush () const;
+		void FlushData () const;
 		uint32 GetDeviceSectorSize () const;
 		static size_t GetOptimalReadSize () { return OptimalReadSize; }
 		static size_t GetOptimalWriteSize ()  { return OptimalWriteSize; }
@@ -74,6 +75,7 @@ namespace Basalt
 		FilePath GetPath () const;
 		uint64 Length () const;
 		void Open (const FilePath &path, FileOpenMode mode = OpenRead, FileShareMode shareMode = ShareReadWrite, FileOpenFlags flags = FlagsNone);
+		void PunchHole (uint64 position, uint64 length) const;
 		uint64 Read (const BufferPtr &buffer) const;
 		void ReadCompleteBuffer (const BufferPtr &buffer) const;
 		uint64 ReadAt (const BufferPtr &buffer, uint64 position) const;
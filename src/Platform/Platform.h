@@ -20,6 +20,7 @@
 #include "Functor.h"
 #include "Memory.h"
 #include "Mutex.h"
+#include "SharedMutex.h"
 #include "SharedPtr.h"
 #include "SystemException.h"
 #include "Thread.h"
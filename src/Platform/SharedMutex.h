@@ -0,0 +1,66 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Platform_SharedMutex
+#define TC_HEADER_Platform_SharedMutex
+
+#include <pthread.h>
+#include "PlatformBase.h"
+
+namespace Basalt
+{
+	// Any number of shared owners or one exclusive owner; not recursive
+	class SharedMutex
+	{
+	public:
+		SharedMutex ();
+		~SharedMutex ();
+
+		void Lock ();
+		void LockShared ();
+		void Unlock ();
+
+	protected:
+		bool Initialized;
+		pthread_rwlock_t SystemLock;
+
+	private:
+		SharedMutex (const SharedMutex &);
+		SharedMutex &operator= (const SharedMutex &);
+	};
+
+	class ExclusiveScopeLock
+	{
+	public:
+		ExclusiveScopeLock (SharedMutex &mutex) : ScopeMutex (mutex) { mutex.Lock(); }
+		~ExclusiveScopeLock () { ScopeMutex.Unlock(); }
+
+	protected:
+		SharedMutex &ScopeMutex;
+
+	private:
+		ExclusiveScopeLock (const ExclusiveScopeLock &);
+		ExclusiveScopeLock &operator= (const ExclusiveScopeLock &);
+	};
+
+	class SharedScopeLock
+	{
+	public:
+		SharedScopeLock (SharedMutex &mutex) : ScopeMutex (mutex) { mutex.LockShared(); }
+		~SharedScopeLock () { ScopeMutex.Unlock(); }
+
+	protected:
+		SharedMutex &ScopeMutex;
+
+	private:
+		SharedScopeLock (const SharedScopeLock &);
+		SharedScopeLock &operator= (const SharedScopeLock &);
+	};
+}
+
+#endif // TC_HEADER_Platform_SharedMutex
@@ -17,6 +17,7 @@ namespace Basalt
 	{
 	public:
 		static wstring GetPlatformName ();
+		static size_t GetProcessorCount ();
 		static vector <int> GetVersion ();
 		static bool IsVersionAtLeast (int versionNumber1, int versionNumber2, int versionNumber3 = 0);
 
@@ -12,6 +12,7 @@
 #include <utime.h>
 
 #ifdef TC_LINUX
+#include <linux/falloc.h>
 #include <sys/mount.h>
 #endif
 
@@ -90,6 +91,24 @@ namespace Basalt
 		throw_sys_sub_if (fsync (FileHandle) != 0, wstring (Path));
 	}
 
+	void File::FlushData () const
+	{
+		if_debug (ValidateState());
+
+#if defined (TC_MACOSX)
+		// fsync() does not flush the write cache of the drive on Mac OS X
+		if (fcntl (FileHandle, F_FULLFSYNC) == 0)
+			return;
+
+		// Not supported by some filesystems
+		throw_sys_sub_if (fsync (FileHandle) != 0, wstring (Path));
+#elif defined (TC_LINUX)
+		throw_sys_sub_if (fdatasync (FileHandle) != 0, wstring (Path));
+#else
+		throw_sys_sub_if (fsync (FileHandle) != 0, wstring (Path));
+#endif
+	}
+
 	uint32 File::GetDeviceSectorSize () const
 	{
 		if (Path.IsDevice())
@@ -278,6 +297,53 @@ namespace Basalt
 		FileIsOpen = true;
 	}
 
+	void File::PunchHole (uint64 position, uint64 length) const
+	{
+		if_debug (ValidateState());
+
+		if (length == 0)
+			return;
+
+#if defined (TC_LINUX)
+		throw_sys_sub_if (fallocate (FileHandle, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, position, length) == -1, wstring (Path));
+
+#elif defined (TC_MACOSX)
+		// F_PUNCHHOLE deallocates whole filesystem blocks only, so partial blocks at the edges are zeroed
+		struct stat statData;
+		throw_sys_sub_if (fstat (FileHandle, &statData) == -1, wstring (Path));
+
+		uint64 blockSize = statData.st_blksize > 0 ? statData.st_blksize : 4096;
+		uint64 end = position + length;
+		uint64 alignedStart = (position + blockSize - 1) / blockSize * blockSize;
+		uint64 alignedEnd = end / blockSize * blockSize;
+
+		if (alignedStart >= alignedEnd)
+			alignedStart = alignedEnd = end;
+
+		// Without a whole block in the range, it spans less than two blocks
+		Buffer zeros ((size_t) blockSize * 2);
+		zeros.Zero();
+
+		if (position < alignedStart)
+			WriteAt (zeros.GetRange (0, (size_t) (alignedStart - position)), position);
+
+		if (alignedEnd < end)
+			WriteAt (zeros.GetRange (0, (size_t) (end - alignedEnd)), alignedEnd);
+
+		if (alignedEnd > alignedStart)
+		{
+			struct fpunchhole punchHole;
+			Memory::Zero (&punchHole, sizeof (punchHole));
+			punchHole.fp_offset = alignedStart;
+			punchHole.fp_length = alignedEnd - alignedStart;
+
+			throw_sys_sub_if (fcntl (FileHandle, F_PUNCHHOLE, &punchHole) == -1, wstring (Path));
+		}
+#else
+		throw NotImplemented (SRC_POS);
+#endif
+	}
+
 	uint64 File::Read (const BufferPtr &buffer) const
 	{
 		if_debug (ValidateState());
@@ -0,0 +1,75 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <pthread.h>
+#include "Platform/SharedMutex.h"
+#include "Platform/SystemException.h"
+
+namespace Basalt
+{
+	SharedMutex::SharedMutex ()
+	{
+		pthread_rwlockattr_t attributes;
+
+		int status = pthread_rwlockattr_init (&attributes);
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+
+#ifdef __GLIBC__
+		// glibc prefers readers by default, which lets a stream of shared owners starve an exclusive one
+		status = pthread_rwlockattr_setkind_np (&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+#endif
+
+		status = pthread_rwlock_init (&SystemLock, &attributes);
+		pthread_rwlockattr_destroy (&attributes);
+
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+
+		Initialized = true;
+	}
+
+	SharedMutex::~SharedMutex ()
+	{
+		Initialized = false;
+#ifdef DEBUG
+		int status =
+#endif
+		pthread_rwlock_destroy (&SystemLock);
+
+#ifdef DEBUG
+		if (status != 0)
+			SystemLog::WriteException (SystemException (SRC_POS, status));
+#endif
+	}
+
+	void SharedMutex::Lock ()
+	{
+		assert (Initialized);
+		int status = pthread_rwlock_wrlock (&SystemLock);
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+	}
+
+	void SharedMutex::LockShared ()
+	{
+		assert (Initialized);
+		int status = pthread_rwlock_rdlock (&SystemLock);
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+	}
+
+	void SharedMutex::Unlock ()
+	{
+		int status = pthread_rwlock_unlock (&SystemLock);
+		if (status != 0)
+			throw SystemException (SRC_POS, status);
+	}
+}
@@ -9,6 +9,7 @@
 #include "Platform/SystemException.h"
 #include "Platform/SystemInfo.h"
 #include <sys/utsname.h>
+#include <unistd.h>
 
 namespace Basalt
 {
@@ -28,6 +29,12 @@ namespace Basalt
 
 	}
 
+	size_t SystemInfo::GetProcessorCount ()
+	{
+		long cpuCount = sysconf (_SC_NPROCESSORS_ONLN);
+		return cpuCount < 1 ? 1 : (size_t) cpuCount;
+	}
+
 	vector <int> SystemInfo::GetVersion ()
 	{
 		struct utsname unameData;
@@ -6,22 +6,19 @@
  packages.
 */
 
-#include <syslog.h>
+#include "Common/Log.h"
 #include "Platform/SystemLog.h"
 
 namespace Basalt
 {
 	void SystemLog::WriteDebug (const string &debugMessage)
 	{
-		openlog ("truecrypt", LOG_PID, LOG_USER);
-		syslog (LOG_DEBUG, "%s", debugMessage.c_str());
-		closelog();
+		// Diagnostics of the C++ code have always been logged; only per-operation tracing is off by default
+		basalt_log (BASALT_LOG_INFO, "%s", debugMessage.c_str());
 	}
 
 	void SystemLog::WriteError (const string &errorMessage)
 	{
-		openlog ("truecrypt", LOG_PID, LOG_USER);
-		syslog (LOG_ERR, "%s", errorMessage.c_str());
-		closelog();
+		basalt_log (BASALT_LOG_ERROR, "%s", errorMessage.c_str());
 	}
 }
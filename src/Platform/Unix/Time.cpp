@@ -18,6 +18,6 @@ namespace Basalt
 		gettimeofday (&tv, NULL);
 
 		// Unix time => Windows file time
-		return  ((uint64) tv.tv_sec + 134774LL * 24 * 3600) * 1000LL * 1000 * 10;
+		return  ((uint64) tv.tv_sec + 134774LL * 24 * 3600) * 1000LL * 1000 * 10 + (uint64) tv.tv_usec * 10;
 	}
 }
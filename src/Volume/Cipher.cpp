@@ -12,13 +12,10 @@
 #include "Crypto/Blowfish.h"
 #include "Crypto/Des.h"
 #include "Crypto/Cast.h"
+#include "Crypto/CryptoDispatch.h"
 #include "Crypto/Serpent.h"
 #include "Crypto/Twofish.h"
 
-#ifdef TC_AES_HW_CPU
-#	include "Crypto/Aes_hw_cpu.h"
-#endif
-
 namespace Basalt
 {
 	Cipher::Cipher () : Initialized (false)
@@ -106,11 +103,9 @@ namespace Basalt
 	// AES
 	void CipherAES::Decrypt (byte *data) const
 	{
-#ifdef TC_AES_HW_CPU
 		if (IsHwSupportAvailable())
-			aes_hw_cpu_decrypt (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), data);
+			crypto_dispatch()->AesDecrypt (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), data);
 		else
-#endif
 			aes_decrypt (data, data, (aes_decrypt_ctx *) (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx)));
 	}
 
@@ -119,30 +114,43 @@ namespace Basalt
 		if (!Initialized)
 			throw NotInitialized (SRC_POS);
 
-#ifdef TC_AES_HW_CPU
 		if ((blockCount & (32 - 1)) == 0
 			&& IsHwSupportAvailable())
 		{
+			void (*decrypt32Blocks) (const byte *, byte *) = crypto_dispatch()->AesDecrypt32Blocks;
+
 			while (blockCount > 0)
 			{
-				aes_hw_cpu_decrypt_32_blocks (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), data);
+				decrypt32Blocks (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), data);
 
 				data += 32 * GetBlockSize();
 				blockCount -= 32;
 			}
 		}
 		else
-#endif
 			Cipher::DecryptBlocks (data, blockCount);
 	}
 
+	bool CipherAES::DecryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		void (*decrypt) (const byte *, const byte *, byte *, uint64, uint64) = crypto_dispatch()->AesXtsDecrypt;
+
+		if (!decrypt || !HwSupportEnabled || typeid (secondaryCipher) != typeid (CipherAES))
+			return false;
+
+		const CipherAES &tweakCipher = static_cast <const CipherAES &> (secondaryCipher);
+		decrypt (ScheduledKey.Ptr() + sizeof (aes_encrypt_ctx), tweakCipher.ScheduledKey.Ptr(), data, dataUnitNo, dataUnitCount);
+		return true;
+	}
+
 	void CipherAES::Encrypt (byte *data) const
 	{
-#ifdef TC_AES_HW_CPU
 		if (IsHwSupportAvailable())
-			aes_hw_cpu_encrypt (ScheduledKey.Ptr(), data);
+			crypto_dispatch()->AesEncrypt (ScheduledKey.Ptr(), data);
 		else
-#endif
 			aes_encrypt (data, data, (aes_encrypt_ctx *) ScheduledKey.Ptr());
 	}
 
@@ -151,23 +159,52 @@ namespace Basalt
 		if (!Initialized)
 			throw NotInitialized (SRC_POS);
 
-#ifdef TC_AES_HW_CPU
 		if ((blockCount & (32 - 1)) == 0
 			&& IsHwSupportAvailable())
 		{
+			void (*encrypt32Blocks) (const byte *, byte *) = crypto_dispatch()->AesEncrypt32Blocks;
+
 			while (blockCount > 0)
 			{
-				aes_hw_cpu_encrypt_32_blocks (ScheduledKey.Ptr(), data);
+				encrypt32Blocks (ScheduledKey.Ptr(), data);
 
 				data += 32 * GetBlockSize();
 				blockCount -= 32;
 			}
 		}
 		else
-#endif
 			Cipher::EncryptBlocks (data, blockCount);
 	}
 
+	bool CipherAES::EncryptCounterBlocks (byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		void (*generate) (const byte *, byte *, uint64, uint64, uint64) = crypto_dispatch()->AesCtrGenerate;
+
+		if (!generate || !HwSupportEnabled)
+			return false;
+
+		generate (ScheduledKey.Ptr(), data, counterHigh, counterLow, blockCount);
+		return true;
+	}
+
+	bool CipherAES::EncryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const
+	{
+		if (!Initialized)
+			throw NotInitialized (SRC_POS);
+
+		void (*encrypt) (const byte *, const byte *, byte *, uint64, uint64) = crypto_dispatch()->AesXtsEncrypt;
+
+		if (!encrypt || !HwSupportEnabled || typeid (secondaryCipher) != typeid (CipherAES))
+			return false;
+
+		const CipherAES &tweakCipher = static_cast <const CipherAES &> (secondaryCipher);
+		encrypt (ScheduledKey.Ptr(), tweakCipher.ScheduledKey.Ptr(), data, dataUnitNo, dataUnitCount);
+		return true;
+	}
+
 	size_t CipherAES::GetScheduledKeySize () const
 	{
 		return sizeof(aes_encrypt_ctx) + sizeof(aes_decrypt_ctx);
@@ -175,19 +212,7 @@ namespace Basalt
 
 	bool CipherAES::IsHwSupportAvailable () const
 	{
-#ifdef TC_AES_HW_CPU
-		static bool state = false;
-		static bool stateValid = false;
-
-		if (!stateValid)
-		{
-			state = is_aes_hw_cpu_supported() ? true : false;
-			stateValid = true;
-		}
-		return state && HwSupportEnabled;
-#else
-		return false;
-#endif
+		return HwSupportEnabled && crypto_dispatch()->AesEncrypt != nullptr;
 	}
 
 	void CipherAES::SetCipherKey (const byte *key)
@@ -24,9 +24,12 @@ namespace Basalt
 
 		virtual void DecryptBlock (byte *data) const;
 		virtual void DecryptBlocks (byte *data, size_t blockCount) const;
+		virtual bool DecryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const { return false; }
 		static void EnableHwSupport (bool enable) { HwSupportEnabled = enable; }
 		virtual void EncryptBlock (byte *data) const;
 		virtual void EncryptBlocks (byte *data, size_t blockCount) const;
+		virtual bool EncryptCounterBlocks (byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount) const { return false; }
+		virtual bool EncryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const { return false; }
 		static CipherList GetAvailableCiphers ();
 		virtual size_t GetBlockSize () const = 0;
 		virtual const SecureBuffer &GetKey () const { return Key; }
@@ -92,7 +95,10 @@ namespace Basalt
 	
 #define TC_CIPHER_ADD_METHODS \
 	virtual void DecryptBlocks (byte *data, size_t blockCount) const; \
+	virtual bool DecryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const; \
 	virtual void EncryptBlocks (byte *data, size_t blockCount) const; \
+	virtual bool EncryptCounterBlocks (byte *data, uint64 counterHigh, uint64 counterLow, uint64 blockCount) const; \
+	virtual bool EncryptXtsDataUnits (const Cipher &secondaryCipher, byte *data, uint64 dataUnitNo, uint64 dataUnitCount) const; \
 	virtual bool IsHwSupportAvailable () const;
 
 	TC_CIPHER (AES, 16, 32);
@@ -120,10 +126,6 @@ namespace Basalt
 
 #undef TC_EXCEPTION
 
-#if ((defined (TC_ARCH_X86) || defined (TC_ARCH_X64)) && !defined (__ppc__)) || defined (__aarch64__)
-#	define TC_AES_HW_CPU
-#endif
-
 }
 
 #endif // TC_HEADER_Encryption_Ciphers
@@ -173,6 +173,13 @@ namespace Basalt
 		return IsModeSupported (*mode);
 	}
 
+	void EncryptionAlgorithm::ReEncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionAlgorithm &targetAlgorithm, uint64 targetSectorIndex) const
+	{
+		if_debug (ValidateState ());
+		if_debug (targetAlgorithm.ValidateState ());
+		Mode->ReEncryptSectors (data, sectorIndex, sectorCount, sectorSize, *targetAlgorithm.Mode, targetSectorIndex);
+	}
+
 	void EncryptionAlgorithm::SetMode (shared_ptr <EncryptionMode> mode)
 	{
 		if (!IsModeSupported (*mode))
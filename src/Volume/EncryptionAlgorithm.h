@@ -41,6 +41,7 @@ namespace Basalt
 		bool IsDeprecated () const { return Deprecated; }
 		virtual bool IsModeSupported (const EncryptionMode &mode) const;
 		virtual bool IsModeSupported (const shared_ptr <EncryptionMode> mode) const;
+		virtual void ReEncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionAlgorithm &targetAlgorithm, uint64 targetSectorIndex) const;
 		virtual void SetKey (const ConstBufferPtr &key);
 		virtual void SetMode (shared_ptr <EncryptionMode> mode);
 
@@ -32,6 +32,32 @@ namespace Basalt
 		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::EncryptDataUnits, this, data, sectorIndex, sectorCount, sectorSize);
 	}
 
+	void EncryptionMode::ReEncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionMode &targetMode, uint64 targetSectorIndex) const
+	{
+		EncryptionThreadPool::DoWork (EncryptionThreadPool::WorkType::ReEncryptDataUnits, this, data, sectorIndex, sectorCount, sectorSize, &targetMode, targetSectorIndex);
+	}
+
+	void EncryptionMode::ReEncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionMode &targetMode, uint64 targetSectorIndex) const
+	{
+		// Decrypt and encrypt in small slices so that the data stays in cache between both passes
+		uint64 sliceSectorCount = ReEncryptionSliceSize / sectorSize;
+		if (sliceSectorCount < 1)
+			sliceSectorCount = 1;
+
+		while (sectorCount > 0)
+		{
+			uint64 count = sectorCount < sliceSectorCount ? sectorCount : sliceSectorCount;
+
+			DecryptSectorsCurrentThread (data, sectorIndex, count, sectorSize);
+			targetMode.EncryptSectorsCurrentThread (data, targetSectorIndex, count, sectorSize);
+
+			data += count * sectorSize;
+			sectorIndex += count;
+			targetSectorIndex += count;
+			sectorCount -= count;
+		}
+	}
+
 	EncryptionModeList EncryptionMode::GetAvailableModes ()
 	{
 		EncryptionModeList l;
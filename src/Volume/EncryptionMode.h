@@ -36,6 +36,8 @@ namespace Basalt
 		virtual shared_ptr <EncryptionMode> GetNew () const = 0;
 		virtual uint64 GetSectorOffset () const { return SectorOffset; }
 		virtual bool IsKeySet () const { return KeySet; }
+		void ReEncryptSectors (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionMode &targetMode, uint64 targetSectorIndex) const;
+		void ReEncryptSectorsCurrentThread (byte *data, uint64 sectorIndex, uint64 sectorCount, size_t sectorSize, const EncryptionMode &targetMode, uint64 targetSectorIndex) const;
 		virtual void SetKey (const ConstBufferPtr &key) = 0;
 		virtual void SetCiphers (const CipherList &ciphers) { Ciphers = ciphers; }
 		virtual void SetSectorOffset (int64 offset) { SectorOffset = offset; }
@@ -48,6 +50,7 @@ namespace Basalt
 		virtual void ValidateParameters (byte *data, uint64 sectorCount, size_t sectorSize) const;
 
 		static const size_t EncryptionDataUnitSize = ENCRYPTION_DATA_UNIT_SIZE;
+		static const size_t ReEncryptionSliceSize = 32 * 1024;
 
 		CipherList Ciphers;
 		bool KeySet;
@@ -19,49 +19,39 @@ namespace Basalt
 
 	void EncryptionModeLRW::DecryptBuffer (byte *data, uint64 length, uint64 blockIndex) const
 	{
-		size_t blockSize = Ciphers.front()->GetBlockSize();
-		if (blockSize != 8 && blockSize != 16)
-			throw ParameterIncorrect (SRC_POS);
-
-		byte i[8];
-		*(uint64 *)i = Endian::Big (blockIndex);
+		size_t blockSize = ValidateBlockSize();
 
+		byte whiteningValues[EncryptionDataUnitSize];
 		byte t[Cipher::MaxBlockSize];
+		uint64 blockCount = length / blockSize;
 
-		for (unsigned int b = 0; b < length / blockSize; b++)
+		InitTweak (t, blockIndex, blockSize);
+
+		while (blockCount > 0)
 		{
-			if (blockSize == 8)
-			{
-				Gf64MulTab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			}
-			else
-			{
-				Gf128MulBy64Tab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor128 ((uint64 *)data, (uint64 *)t);
-			}
+			size_t chunkBlockCount = sizeof (whiteningValues) / blockSize;
+			if (blockCount < chunkBlockCount)
+				chunkBlockCount = (size_t) blockCount;
+
+			size_t chunkLength = chunkBlockCount * blockSize;
+
+			GenerateWhiteningValues (whiteningValues, t, blockIndex, chunkBlockCount, blockSize);
+			XorBlocks (data, whiteningValues, chunkLength);
 
 			for (CipherList::const_reverse_iterator iCipherList = Ciphers.rbegin();
 				iCipherList != Ciphers.rend();
 				++iCipherList)
 			{
-				const Cipher &c = **iCipherList;
-
-				if (c.GetBlockSize () != blockSize)
-					throw ParameterIncorrect (SRC_POS);
-
-				c.DecryptBlock (data);
+				(*iCipherList)->DecryptBlocks (data, chunkBlockCount);
 			}
 
-			if (blockSize == 8)
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			else
-				Xor128 ((uint64 *)data, (uint64 *)t);
+			XorBlocks (data, whiteningValues, chunkLength);
 
-			data += blockSize;
-			IncrementBlockIndex (i);
+			data += chunkLength;
+			blockCount -= chunkBlockCount;
 		}
 
+		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
 		Memory::Erase (t, sizeof (t));
 	}
 
@@ -83,49 +73,39 @@ namespace Basalt
 
 	void EncryptionModeLRW::EncryptBuffer (byte *data, uint64 length, uint64 blockIndex) const
 	{
-		size_t blockSize = Ciphers.front()->GetBlockSize();
-		if (blockSize != 8 && blockSize != 16)
-			throw ParameterIncorrect (SRC_POS);
-
-		byte i[8];
-		*(uint64 *)i = Endian::Big (blockIndex);
+		size_t blockSize = ValidateBlockSize();
 
+		byte whiteningValues[EncryptionDataUnitSize];
 		byte t[Cipher::MaxBlockSize];
+		uint64 blockCount = length / blockSize;
 
-		for (unsigned int b = 0; b < length / blockSize; b++)
+		InitTweak (t, blockIndex, blockSize);
+
+		while (blockCount > 0)
 		{
-			if (blockSize == 8)
-			{
-				Gf64MulTab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			}
-			else
-			{
-				Gf128MulBy64Tab (i, t, (GfCtx *) (GfContext.Ptr()));
-				Xor128 ((uint64 *)data, (uint64 *)t);
-			}
+			size_t chunkBlockCount = sizeof (whiteningValues) / blockSize;
+			if (blockCount < chunkBlockCount)
+				chunkBlockCount = (size_t) blockCount;
+
+			size_t chunkLength = chunkBlockCount * blockSize;
+
+			GenerateWhiteningValues (whiteningValues, t, blockIndex, chunkBlockCount, blockSize);
+			XorBlocks (data, whiteningValues, chunkLength);
 
 			for (CipherList::const_iterator iCipherList = Ciphers.begin();
 				iCipherList != Ciphers.end();
 				++iCipherList)
 			{
-				const Cipher &c = **iCipherList;
-
-				if (c.GetBlockSize () != blockSize)
-					throw ParameterIncorrect (SRC_POS);
-
-				c.EncryptBlock (data);
+				(*iCipherList)->EncryptBlocks (data, chunkBlockCount);
 			}
 
-			if (blockSize == 8)
-				Xor64 ((uint64 *)data, (uint64 *)t);
-			else
-				Xor128 ((uint64 *)data, (uint64 *)t);
+			XorBlocks (data, whiteningValues, chunkLength);
 
-			data += blockSize;
-			IncrementBlockIndex (i);
+			data += chunkLength;
+			blockCount -= chunkBlockCount;
 		}
 
+		FAST_ERASE64 (whiteningValues, sizeof (whiteningValues));
 		Memory::Erase (t, sizeof (t));
 	}
 
@@ -139,12 +119,41 @@ namespace Basalt
 			SectorToBlockIndex (sectorIndex));
 	}
 
-	void EncryptionModeLRW::IncrementBlockIndex (byte *index) const
+	void EncryptionModeLRW::GenerateWhiteningValues (byte *whiteningValues, byte *tweak, uint64 &blockIndex, size_t blockCount, size_t blockSize) const
+	{
+		// Multiplication by the tweak key is linear over GF(2), so the tweak of block i + 1 equals the tweak
+		// of block i XORed with the product of the key and (i XOR (i + 1)). The latter is always of the form
+		// 2^(k+1) - 1, where k is the number of trailing one bits of i, and its products are precomputed.
+		const byte *increments = (blockSize == 8 ? TweakIncrements64 : TweakIncrements128).Ptr();
+
+		for (size_t b = 0; b < blockCount; ++b)
+		{
+			if (blockSize == 8)
+				*(uint64 *) whiteningValues = *(uint64 *) tweak;
+			else
+			{
+				((uint64 *) whiteningValues)[0] = ((uint64 *) tweak)[0];
+				((uint64 *) whiteningValues)[1] = ((uint64 *) tweak)[1];
+			}
+
+			whiteningValues += blockSize;
+
+			if (blockIndex != 0xffffFFFFffffFFFFULL)
+				XorBlocks (tweak, increments + __builtin_ctzll (~blockIndex) * blockSize, blockSize);
+
+			++blockIndex;
+		}
+	}
+
+	void EncryptionModeLRW::InitTweak (byte *tweak, uint64 blockIndex, size_t blockSize) const
 	{
-		if (index[7] != 0xff)
-			index[7]++;
+		byte i[8];
+		*(uint64 *) i = Endian::Big (blockIndex);
+
+		if (blockSize == 8)
+			Gf64MulTab (i, tweak, (GfCtx *) (GfContext.Ptr()));
 		else
-			*(uint64 *)index = Endian::Big ( Endian::Big (*(uint64 *)index) + 1 );
+			Gf128MulBy64Tab (i, tweak, (GfCtx *) (GfContext.Ptr()));
 	}
 
 	uint64 EncryptionModeLRW::SectorToBlockIndex (uint64 sectorIndex) const
@@ -170,7 +179,11 @@ namespace Basalt
 			throw ParameterIncorrect (SRC_POS);
 
 		if (!KeySet)
+		{
 			GfContext.Allocate (sizeof (GfCtx));
+			TweakIncrements64.Allocate (TweakIncrementCount * 8);
+			TweakIncrements128.Allocate (TweakIncrementCount * 16);
+		}
 
 		if (!Gf64TabInit ((unsigned char *) key.Get(), (GfCtx *) (GfContext.Ptr())))
 			throw bad_alloc();
@@ -178,18 +191,39 @@ namespace Basalt
 		if (!Gf128Tab64Init ((unsigned char *) key.Get(), (GfCtx *) (GfContext.Ptr())))
 			throw bad_alloc();
 
+		for (size_t k = 0; k < TweakIncrementCount; ++k)
+		{
+			uint64 delta = (k == TweakIncrementCount - 1) ? 0xffffFFFFffffFFFFULL : (2ULL << k) - 1;
+
+			InitTweak (TweakIncrements64.Ptr() + k * 8, delta, 8);
+			InitTweak (TweakIncrements128.Ptr() + k * 16, delta, 16);
+		}
+
 		Key.CopyFrom (key);
 		KeySet = true;
 	}
 
-	void EncryptionModeLRW::Xor64 (uint64 *a, const uint64 *b) const
+	size_t EncryptionModeLRW::ValidateBlockSize () const
 	{
-		*a ^= *b;
+		size_t blockSize = Ciphers.front()->GetBlockSize();
+		if (blockSize != 8 && blockSize != 16)
+			throw ParameterIncorrect (SRC_POS);
+
+		for (const auto &cipher : Ciphers)
+		{
+			if (cipher->GetBlockSize() != blockSize)
+				throw ParameterIncorrect (SRC_POS);
+		}
+
+		return blockSize;
 	}
 
-	void EncryptionModeLRW::Xor128 (uint64 *a, const uint64 *b) const
+	void EncryptionModeLRW::XorBlocks (byte *data, const byte *whiteningValues, size_t length) const
 	{
-		*a++ ^= *b++;
-		*a ^= *b;
+		uint64 *dataPtr64 = (uint64 *) data;
+		const uint64 *whiteningValuesPtr64 = (const uint64 *) whiteningValues;
+
+		for (size_t i = 0; i < length / sizeof (uint64); ++i)
+			*dataPtr64++ ^= *whiteningValuesPtr64++;
 	}
 }
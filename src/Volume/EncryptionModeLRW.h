@@ -33,13 +33,18 @@ namespace Basalt
 	protected:
 		void DecryptBuffer (byte *plainText, uint64 length, uint64 blockIndex) const;
 		void EncryptBuffer (byte *plainText, uint64 length, uint64 blockIndex) const;
-		void IncrementBlockIndex (byte *index) const;
+		void GenerateWhiteningValues (byte *whiteningValues, byte *tweak, uint64 &blockIndex, size_t blockCount, size_t blockSize) const;
+		void InitTweak (byte *tweak, uint64 blockIndex, size_t blockSize) const;
 		uint64 SectorToBlockIndex (uint64 sectorIndex) const;
-		void Xor64 (uint64 *a, const uint64 *b) const;
-		void Xor128 (uint64 *a, const uint64 *b) const;
+		size_t ValidateBlockSize () const;
+		void XorBlocks (byte *data, const byte *whiteningValues, size_t length) const;
+
+		static const size_t TweakIncrementCount = 64;
 
 		SecureBuffer GfContext;
 		SecureBuffer Key;
+		SecureBuffer TweakIncrements64;
+		SecureBuffer TweakIncrements128;
 
 	private:
 		EncryptionModeLRW (const EncryptionModeLRW &);
@@ -48,6 +48,20 @@ namespace Basalt
 
 		startDataUnitNo += SectorOffset;
 
+		// Whole data units are processed in one pass by the wide kernel of the CPU tier if one is available
+		uint64 wideDataUnitCount = (startCipherBlockNo == 0) ? length / ENCRYPTION_DATA_UNIT_SIZE : 0;
+		if (wideDataUnitCount > 0 && cipher.EncryptXtsDataUnits (secondaryCipher, buffer, startDataUnitNo, wideDataUnitCount))
+		{
+			buffer += wideDataUnitCount * ENCRYPTION_DATA_UNIT_SIZE;
+			length -= wideDataUnitCount * ENCRYPTION_DATA_UNIT_SIZE;
+			startDataUnitNo += wideDataUnitCount;
+
+			if (length == 0)
+				return;
+
+			bufPtr = (uint64 *) buffer;
+		}
+
 		/* The encrypted data unit number (i.e. the resultant ciphertext block) is to be multiplied in the
 		finite field GF(2^128) by j-th power of n, where j is the sequential plaintext/ciphertext block
 		number and n is 2, a primitive element of GF(2^128). This can be (and is) simplified and implemented
@@ -222,6 +236,20 @@ namespace Basalt
 
 		startDataUnitNo += SectorOffset;
 
+		// Whole data units are processed in one pass by the wide kernel of the CPU tier if one is available
+		uint64 wideDataUnitCount = (startCipherBlockNo == 0) ? length / ENCRYPTION_DATA_UNIT_SIZE : 0;
+		if (wideDataUnitCount > 0 && cipher.DecryptXtsDataUnits (secondaryCipher, buffer, startDataUnitNo, wideDataUnitCount))
+		{
+			buffer += wideDataUnitCount * ENCRYPTION_DATA_UNIT_SIZE;
+			length -= wideDataUnitCount * ENCRYPTION_DATA_UNIT_SIZE;
+			startDataUnitNo += wideDataUnitCount;
+
+			if (length == 0)
+				return;
+
+			bufPtr = (uint64 *) buffer;
+		}
+
 		// Convert the 64-bit data unit number into a little-endian 16-byte array. 
 		// Note that as we are converting a 64-bit number into a 16-byte array we can always zero the last 8 bytes.
 		dataUnitNo = startDataUnitNo;
@@ -352,6 +380,27 @@ namespace Basalt
 			SetSecondaryCipherKeys();
 	}
 
+	void EncryptionModeXTS::SetCiphers (const CipherList &ciphers, const CipherList &secondaryCiphers)
+	{
+		// The secondary ciphers are keyed by the caller and may be shared with other modes
+		if (ciphers.size() != secondaryCiphers.size())
+			throw ParameterIncorrect (SRC_POS);
+
+		for (size_t i = 0; i < ciphers.size(); ++i)
+		{
+			if (typeid (*ciphers[i]) != typeid (*secondaryCiphers[i]))
+				throw ParameterIncorrect (SRC_POS);
+		}
+
+		EncryptionMode::SetCiphers (ciphers);
+		SecondaryCiphers = secondaryCiphers;
+
+		if (SecondaryKey.Size() > 0)
+			SecondaryKey.Free();
+
+		KeySet = true;
+	}
+
 	void EncryptionModeXTS::SetKey (const ConstBufferPtr &key)
 	{
 		SecondaryKey.Allocate (key.Size());
@@ -29,6 +29,7 @@ namespace Basalt
 		virtual wstring GetName () const { return L"XTS"; };
 		virtual shared_ptr <EncryptionMode> GetNew () const { return shared_ptr <EncryptionMode> (new EncryptionModeXTS); }
 		virtual void SetCiphers (const CipherList &ciphers);
+		virtual void SetCiphers (const CipherList &ciphers, const CipherList &secondaryCiphers);
 		virtual void SetKey (const ConstBufferPtr &key);
 
 	protected:
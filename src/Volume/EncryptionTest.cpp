@@ -9,6 +9,7 @@
 #include "Cipher.h"
 #include "Common/Crc.h"
 #include "Common/Argon2Kdf.h"
+#include "Crypto/CryptoDispatch.h"
 #include "Crc32.h"
 #include "EncryptionAlgorithm.h"
 #include "EncryptionMode.h"
@@ -16,6 +17,8 @@
 #include "EncryptionModeLRW.h"
 #include "EncryptionModeXTS.h"
 #include "EncryptionTest.h"
+#include "EncryptionThreadPool.h"
+#include "Hash.h"
 #include "Pkcs5Kdf.h"
 
 namespace Basalt
@@ -23,7 +26,21 @@ namespace Basalt
 	void EncryptionTest::TestAll ()
 	{
 		TestAll (false);
-		TestAll (true);
+
+		// Test the kernels selected by every tier the CPU supports; the generic tier covers the portable hash functions
+		int forcedTier = cpu_get_tier();
+		finally_do_arg (int, forcedTier, { EncryptionThreadPool::ForceCpuTier (finally_arg); });
+
+		bool hwSupportEnabled = Cipher::IsHwSupportEnabled();
+		finally_do_arg (bool, hwSupportEnabled, { Cipher::EnableHwSupport (finally_arg); });
+
+		Cipher::EnableHwSupport (true);
+
+		for (int tier = CPU_TIER_GENERIC; tier < CPU_TIER_COUNT; ++tier)
+		{
+			if (EncryptionThreadPool::ForceCpuTier (tier))
+				TestKernels();
+		}
 	}
 
 	void EncryptionTest::TestAll (bool enableCpuEncryptionSupport)
@@ -33,12 +50,62 @@ namespace Basalt
 
 		Cipher::EnableHwSupport (enableCpuEncryptionSupport);
 
-		TestCiphers();
-		TestXtsAES();
-		TestXts();
+		TestKernels();
 		TestLegacyModes();
 		TestPkcs5();
 		TestArgon2id();
+		TestThreadPool();
+	}
+
+	void EncryptionTest::TestHashes ()
+	{
+		struct
+		{
+			const char *Message;
+			const char *Sha1Digest;
+			const char *Sha512Digest;
+		} static const vectors[] =
+		{
+			{
+				"abc",
+				"\xa9\x99\x3e\x36\x47\x06\x81\x6a\xba\x3e\x25\x71\x78\x50\xc2\x6c\x9c\xd0\xd8\x9d",
+				"\xdd\xaf\x35\xa1\x93\x61\x7a\xba\xcc\x41\x73\x49\xae\x20\x41\x31\x12\xe6\xfa\x4e\x89\xa9\x7e\xa2\x0a\x9e\xee\xe6\x4b\x55\xd3\x9a"
+				"\x21\x92\x99\x2a\x27\x4f\xc1\xa8\x36\xba\x3c\x23\xa3\xfe\xeb\xbd\x45\x4d\x44\x23\x64\x3c\xe8\x0e\x2a\x9a\xc9\x4f\xa5\x4c\xa4\x9f"
+			},
+			{
+				"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+				"\xa4\x9b\x24\x46\xa0\x2c\x64\x5b\xf4\x19\xf9\x95\xb6\x70\x91\x25\x3a\x04\xa2\x59",
+				"\x8e\x95\x9b\x75\xda\xe3\x13\xda\x8c\xf4\xf7\x28\x14\xfc\x14\x3f\x8f\x77\x79\xc6\xeb\x9f\x7f\xa1\x72\x99\xae\xad\xb6\x88\x90\x18"
+				"\x50\x1d\x28\x9e\x49\x00\xf7\xe4\x33\x1b\x99\xde\xc4\xb5\x43\x3a\xc7\xd3\x29\xee\xb6\xdd\x26\x54\x5e\x96\xe5\x5b\x87\x4b\xe9\x09"
+			}
+		};
+
+		for (size_t i = 0; i < array_capacity (vectors); ++i)
+		{
+			ConstBufferPtr message ((const byte *) vectors[i].Message, strlen (vectors[i].Message));
+
+			Sha1 sha1;
+			Buffer sha1Digest (sha1.GetDigestSize());
+			sha1.ProcessData (message);
+			sha1.GetDigest (sha1Digest);
+			if (memcmp (sha1Digest.Ptr(), vectors[i].Sha1Digest, sha1Digest.Size()) != 0)
+				throw TestFailed (SRC_POS);
+
+			Sha512 sha512;
+			Buffer sha512Digest (sha512.GetDigestSize());
+			sha512.ProcessData (message);
+			sha512.GetDigest (sha512Digest);
+			if (memcmp (sha512Digest.Ptr(), vectors[i].Sha512Digest, sha512Digest.Size()) != 0)
+				throw TestFailed (SRC_POS);
+		}
+	}
+
+	void EncryptionTest::TestKernels ()
+	{
+		TestCiphers();
+		TestXtsAES();
+		TestXts();
+		TestHashes();
 	}
 
 	void EncryptionTest::TestLegacyModes ()
@@ -113,6 +180,41 @@ namespace Basalt
 				}
 			}
 		}
+
+		// LRW tweaks are derived incrementally from the previous block's tweak. Use a sector number
+		// whose block indices carry through almost all 64 bits to verify the precomputed increments.
+		secNo = 0x00FFFFFFFFFFFFFFull;
+
+		for (auto &_ea_ptr : EncryptionAlgorithm::GetAvailableAlgorithms())
+		{
+			EncryptionAlgorithm &ea = *_ea_ptr;
+
+			if (typeid (ea) != typeid (AES) && typeid (ea) != typeid (Blowfish))
+				continue;
+
+			shared_ptr <EncryptionMode> mode (new EncryptionModeLRW);
+			mode->SetKey (ConstBufferPtr (iv, mode->GetKeySize()));
+
+			for (i = 0; i < sizeof (buf); i++)
+				buf[i] = (byte) i;
+
+			ea.SetMode (mode);
+			ea.SetKey (ConstBufferPtr (buf, ea.GetKeySize()));
+
+			ea.EncryptSectors (buf, secNo, sizeof (buf) / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+			crc = ::GetCrc32 (buf, sizeof (buf));
+
+			if (typeid (ea) == typeid (AES)			&& crc != 0x672bca92) throw TestFailed (SRC_POS);
+			if (typeid (ea) == typeid (Blowfish)	&& crc != 0xeed73272) throw TestFailed (SRC_POS);
+
+			ea.DecryptSectors (buf, secNo, sizeof (buf) / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+
+			for (i = 0; i < sizeof (buf); i++)
+			{
+				if (buf[i] != (byte) i)
+					throw TestFailed (SRC_POS);
+			}
+		}
 	}
 
 
@@ -209,6 +311,28 @@ namespace Basalt
 			if (origCrc != Crc32::ProcessBuffer (testData))
 				throw TestFailed (SRC_POS);
 
+			// Counter blocks, crossing a carry into the high half of the counter
+			const uint64 counterHigh = 0x0123456789abcdefULL;
+			const uint64 counterLow = 0xffffffffffffffffULL - 40;
+			const size_t counterBlockCount = 70;
+			Buffer counterData (counterBlockCount * aes.GetBlockSize());
+
+			if (aes.EncryptCounterBlocks (counterData, counterHigh, counterLow, counterBlockCount))
+			{
+				byte block[16];
+				for (size_t i = 0; i < counterBlockCount; ++i)
+				{
+					uint64 high = Endian::Big (counterHigh + (counterLow + i < counterLow ? 1 : 0));
+					uint64 low = Endian::Big (counterLow + i);
+					memcpy (block, &high, sizeof (high));
+					memcpy (block + sizeof (high), &low, sizeof (low));
+					aes.EncryptBlock (block);
+
+					if (memcmp (block, counterData.Ptr() + i * sizeof (block), sizeof (block)) != 0)
+						throw TestFailed (SRC_POS);
+				}
+			}
+
 			CipherSerpent serpent;
 			TestCipher (serpent, SerpentTestVectors, array_capacity (SerpentTestVectors));
 
@@ -471,6 +595,91 @@ namespace Basalt
 			if (memcmp (XtsTestVectors[i].ciphertext, p, sizeof (p)) != 0)
 				throw TestFailed (SRC_POS);
 		}
+
+		// Wide kernels process several data units at once; compare them with the portable implementation
+		// on a buffer whose length is not a multiple of their batch size and ends with a partial data unit
+		byte buf[ENCRYPTION_DATA_UNIT_SIZE * 7 + BYTES_PER_XTS_BLOCK * 3];
+		byte ref[sizeof (buf)];
+
+		for (i = 0; i < sizeof (buf); i++)
+			buf[i] = (byte) (i * 7);
+
+		memcpy (ref, buf, sizeof (buf));
+
+		AES aes;
+		shared_ptr <EncryptionMode> xts (new EncryptionModeXTS);
+		aes.SetKey (ConstBufferPtr (XtsTestVectors[0].key1, sizeof (XtsTestVectors[0].key1)));
+		xts->SetKey (ConstBufferPtr (XtsTestVectors[0].key2, sizeof (XtsTestVectors[0].key2)));
+		xts->SetSectorOffset (-3);	// Data unit numbers wrap around within the buffer
+		aes.SetMode (xts);
+
+		aes.Encrypt (buf, sizeof (buf));
+		{
+			bool hwSupportEnabled = Cipher::IsHwSupportEnabled();
+			finally_do_arg (bool, hwSupportEnabled, { Cipher::EnableHwSupport (finally_arg); });
+
+			Cipher::EnableHwSupport (false);
+			aes.Encrypt (ref, sizeof (ref));
+		}
+
+		if (memcmp (buf, ref, sizeof (buf)) != 0)
+			throw TestFailed (SRC_POS);
+
+		aes.Decrypt (buf, sizeof (buf));
+
+		for (i = 0; i < sizeof (buf); i++)
+		{
+			if (buf[i] != (byte) (i * 7))
+				throw TestFailed (SRC_POS);
+		}
+	}
+
+	void EncryptionTest::TestThreadPool ()
+	{
+		// Sectors larger than a data unit are split between the threads of the pool at sector boundaries
+		bool poolStarted = !EncryptionThreadPool::IsRunning();
+		if (poolStarted)
+			EncryptionThreadPool::Start (4);
+
+		finally_do_arg (bool, poolStarted, { if (finally_arg) EncryptionThreadPool::Stop(); });
+
+		AES aes;
+		shared_ptr <EncryptionMode> xts (new EncryptionModeXTS);
+		aes.SetKey (ConstBufferPtr (XtsTestVectors[0].key1, sizeof (XtsTestVectors[0].key1)));
+		xts->SetKey (ConstBufferPtr (XtsTestVectors[0].key2, sizeof (XtsTestVectors[0].key2)));
+		aes.SetMode (xts);
+
+		const size_t sectorSize = 4096;
+		const uint64 startSector = 0x123456;
+		const uint64 sectorCounts[] = { 2, 3, 5, 64, 257 };
+
+		for (size_t i = 0; i < array_capacity (sectorCounts); i++)
+		{
+			uint64 sectorCount = sectorCounts[i];
+			Buffer data ((size_t) (sectorCount * sectorSize));
+			Buffer ref (data.Size());
+
+			for (size_t j = 0; j < data.Size(); j++)
+				data[j] = (byte) (j * 7 + i);
+
+			ref.CopyFrom (data);
+
+			aes.EncryptSectors (data, startSector, sectorCount, sectorSize);
+
+			for (uint64 sector = 0; sector < sectorCount; sector++)
+				xts->EncryptSectorsCurrentThread (ref.Ptr() + sector * sectorSize, startSector + sector, 1, sectorSize);
+
+			if (memcmp (data, ref, data.Size()) != 0)
+				throw TestFailed (SRC_POS);
+
+			aes.DecryptSectors (data, startSector, sectorCount, sectorSize);
+
+			for (size_t j = 0; j < data.Size(); j++)
+			{
+				if (data[j] != (byte) (j * 7 + i))
+					throw TestFailed (SRC_POS);
+			}
+		}
 	}
 
 	void EncryptionTest::TestXts ()
@@ -23,8 +23,11 @@ namespace Basalt
 	protected:
 		static void TestArgon2id ();
 		static void TestCiphers ();
+		static void TestHashes ();
+		static void TestKernels ();
 		static void TestLegacyModes ();
 		static void TestPkcs5 ();
+		static void TestThreadPool ();
 		static void TestXts ();
 		static void TestXtsAES ();
 
@@ -18,11 +18,12 @@
 #include "Platform/SyncEvent.h"
 #include "Platform/SystemLog.h"
 #include "Common/Crypto.h"
+#include "Crypto/CryptoDispatch.h"
 #include "EncryptionThreadPool.h"
 
 namespace Basalt
 {
-	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize)
+	void EncryptionThreadPool::DoWork (WorkType::Enum type, const EncryptionMode *encryptionMode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize, const EncryptionMode *targetMode, uint64 targetStartUnitNo)
 	{
 		size_t fragmentCount;
 		size_t unitsPerFragment;
@@ -30,6 +31,7 @@ namespace Basalt
 
 		byte *fragmentData;
 		uint64 fragmentStartUnitNo;
+		uint64 fragmentTargetStartUnitNo;
 
 		WorkItem *workItem;
 		WorkItem *firstFragmentWorkItem;
@@ -49,6 +51,10 @@ namespace Basalt
 				encryptionMode->EncryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize);
 				break;
 
+			case WorkType::ReEncryptDataUnits:
+				encryptionMode->ReEncryptSectorsCurrentThread (data, startUnitNo, unitCount, sectorSize, *targetMode, targetStartUnitNo);
+				break;
+
 			default:
 				throw ParameterIncorrect (SRC_POS);
 			}
@@ -72,8 +78,12 @@ namespace Basalt
 				++unitsPerFragment;
 		}
 
+		if (type == WorkType::ReEncryptDataUnits && !targetMode)
+			throw ParameterIncorrect (SRC_POS);
+
 		fragmentData = data;
 		fragmentStartUnitNo = startUnitNo;
+		fragmentTargetStartUnitNo = targetStartUnitNo;
 
 		{
 			ScopeLock lock (EnqueueMutex);
@@ -107,9 +117,12 @@ namespace Basalt
 				workItem->Encryption.UnitCount = unitsPerFragment;
 				workItem->Encryption.StartUnitNo = fragmentStartUnitNo;
 				workItem->Encryption.SectorSize = sectorSize;
+				workItem->Encryption.TargetMode = targetMode;
+				workItem->Encryption.TargetStartUnitNo = fragmentTargetStartUnitNo;
 
-				fragmentData += unitsPerFragment * ENCRYPTION_DATA_UNIT_SIZE;
+				fragmentData += unitsPerFragment * sectorSize;
 				fragmentStartUnitNo += unitsPerFragment;
+				fragmentTargetStartUnitNo += unitsPerFragment;
 
 				if (remainder > 0 && --remainder == 0)
 					--unitsPerFragment;
@@ -132,39 +145,58 @@ namespace Basalt
 			itemException->Throw();
 	}
 
-	void EncryptionThreadPool::Start ()
+	bool EncryptionThreadPool::ForceCpuTier (int tier)
+	{
+		// Holding the enqueue lock keeps new work out while the queued work drains
+		ScopeLock lock (EnqueueMutex);
+
+		for (size_t i = 0; i < QueueSize; ++i)
+		{
+			while (WorkItemQueue[i].State != WorkItem::State::Free)
+			{
+				WorkItemCompletedEvent.Wait();
+			}
+		}
+
+		return crypto_dispatch_force_tier (tier) != 0;
+	}
+
+	void EncryptionThreadPool::Start (size_t threadCount)
 	{
 		if (ThreadPoolRunning)
 			return;
 
-		size_t cpuCount;
+		size_t cpuCount = threadCount;
 
+		if (cpuCount == 0)
+		{
 #ifdef TC_WINDOWS
 
-		SYSTEM_INFO sysInfo;
-		GetSystemInfo (&sysInfo);
-		cpuCount = sysInfo.dwNumberOfProcessors;
+			SYSTEM_INFO sysInfo;
+			GetSystemInfo (&sysInfo);
+			cpuCount = sysInfo.dwNumberOfProcessors;
 
 #elif defined (_SC_NPROCESSORS_ONLN)
-		
-		cpuCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
-		if (cpuCount == (size_t) -1)
-			cpuCount = 1;
+
+			cpuCount = (size_t) sysconf (_SC_NPROCESSORS_ONLN);
+			if (cpuCount == (size_t) -1)
+				cpuCount = 1;
 
 #elif defined (TC_MACOSX)
 
-		int cpuCountSys;
-		int mib[2] = { CTL_HW, HW_NCPU };
+			int cpuCountSys;
+			int mib[2] = { CTL_HW, HW_NCPU };
 
-		size_t len = sizeof (cpuCountSys);
-		if (sysctl (mib, 2, &cpuCountSys, &len, nullptr, 0) == -1)
-			cpuCountSys = 1;
+			size_t len = sizeof (cpuCountSys);
+			if (sysctl (mib, 2, &cpuCountSys, &len, nullptr, 0) == -1)
+				cpuCountSys = 1;
 
-		cpuCount = (size_t) cpuCountSys;
+			cpuCount = (size_t) cpuCountSys;
 
 #else
 #	error Cannot determine CPU count
 #endif
+		}
 
 		if (cpuCount < 2)
 			return;
@@ -225,6 +257,7 @@ namespace Basalt
 			thread->Join();
 		}
 
+		RunningThreads.clear();
 		ThreadCount = 0;
 		ThreadPoolRunning = false;
 	}
@@ -289,6 +322,10 @@ namespace Basalt
 						workItem->Encryption.Mode->EncryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize);
 						break;
 
+					case WorkType::ReEncryptDataUnits:
+						workItem->Encryption.Mode->ReEncryptSectorsCurrentThread (workItem->Encryption.Data, workItem->Encryption.StartUnitNo, workItem->Encryption.UnitCount, workItem->Encryption.SectorSize, *workItem->Encryption.TargetMode, workItem->Encryption.TargetStartUnitNo);
+						break;
+
 					default:
 						throw ParameterIncorrect (SRC_POS);
 					}
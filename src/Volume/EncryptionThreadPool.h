@@ -23,6 +23,7 @@ namespace Basalt
 			{
 				EncryptDataUnits,
 				DecryptDataUnits,
+				ReEncryptDataUnits,
 				DeriveKey
 			};
 		};
@@ -55,13 +56,16 @@ namespace Basalt
 					uint64 StartUnitNo;
 					uint64 UnitCount;
 					size_t SectorSize;
+					const EncryptionMode *TargetMode;
+					uint64 TargetStartUnitNo;
 				} Encryption;
 			};
 		};
 
-		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize);
+		static void DoWork (WorkType::Enum type, const EncryptionMode *mode, byte *data, uint64 startUnitNo, uint64 unitCount, size_t sectorSize, const EncryptionMode *targetMode = nullptr, uint64 targetStartUnitNo = 0);
+		static bool ForceCpuTier (int tier);	// Waits until no work item is queued or in progress
 		static bool IsRunning () { return ThreadPoolRunning; }
-		static void Start ();
+		static void Start (size_t threadCount = 0);	// Zero: one thread per CPU
 		static void Stop ();
 
 		/*
@@ -0,0 +1,176 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <algorithm>
+#include "Platform/Time.h"
+#include "GroupCommitFlusher.h"
+
+namespace Basalt
+{
+	GroupCommitFlusher::GroupCommitFlusher (shared_ptr <File> file, VolumeSyncPolicy::Enum policy, uint32 maxDelay)
+		: HostFile (file), MaxDelay (maxDelay), Policy (policy),
+		FlushCount (0), FlushInProgress (false), LastBatchSize (0), LatencySampleIndex (0), RequestCount (0)
+	{
+		LatencySamples.reserve (LatencySampleCount);
+	}
+
+	void GroupCommitFlusher::AddLatencySample (uint64 startTime)
+	{
+		// Time is measured in units of 100 ns and may be set back
+		uint64 currentTime = Time::GetCurrent();
+		uint64 latency = currentTime > startTime ? (currentTime - startTime) / 10 : 0;
+
+		ScopeLock lock (StateMutex);
+
+		if (LatencySamples.size() < LatencySampleCount)
+			LatencySamples.push_back (latency);
+		else
+			LatencySamples[LatencySampleIndex] = latency;
+
+		LatencySampleIndex = (LatencySampleIndex + 1) % LatencySampleCount;
+	}
+
+	void GroupCommitFlusher::FlushAsLeader (Waiter &leader)
+	{
+		// LastBatchSize is written only by the current leader
+		if (MaxDelay > 0 && LastBatchSize > 1)
+			Thread::Sleep (MaxDelay);
+
+		// Requests queued before the flush starts are covered by it
+		list <Waiter *> batch;
+		{
+			ScopeLock lock (StateMutex);
+			batch.swap (PendingWaiters);
+		}
+
+		try
+		{
+			HostFile->FlushData();
+		}
+		catch (Exception &e)
+		{
+			leader.FlushException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			leader.FlushException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			leader.FlushException.reset (new UnknownException (SRC_POS));
+		}
+
+		Waiter *nextLeader = nullptr;
+		{
+			ScopeLock lock (StateMutex);
+			++FlushCount;
+			LastBatchSize = batch.size() + 1;
+
+			if (PendingWaiters.empty())
+			{
+				FlushInProgress = false;
+			}
+			else
+			{
+				nextLeader = PendingWaiters.front();
+				PendingWaiters.pop_front();
+				nextLeader->Leader = true;
+			}
+		}
+
+		// A waiter may be destroyed as soon as it is signaled
+		for (Waiter *waiter : batch)
+		{
+			waiter->FlushException = leader.FlushException;
+			waiter->CompletedEvent.Signal();
+		}
+
+		if (nextLeader)
+			nextLeader->CompletedEvent.Signal();
+	}
+
+	GroupCommitStatistics GroupCommitFlusher::GetStatistics () const
+	{
+		GroupCommitStatistics statistics;
+		vector <uint64> samples;
+
+		{
+			ScopeLock lock (StateMutex);
+			statistics.RequestCount = RequestCount;
+			statistics.FlushCount = FlushCount;
+			samples = LatencySamples;
+		}
+
+		statistics.LatencyP50 = statistics.LatencyP90 = statistics.LatencyP99 = statistics.LatencyMax = 0;
+
+		if (!samples.empty())
+		{
+			sort (samples.begin(), samples.end());
+			statistics.LatencyP50 = samples[(samples.size() - 1) * 50 / 100];
+			statistics.LatencyP90 = samples[(samples.size() - 1) * 90 / 100];
+			statistics.LatencyP99 = samples[(samples.size() - 1) * 99 / 100];
+			statistics.LatencyMax = samples.back();
+		}
+
+		return statistics;
+	}
+
+	void GroupCommitFlusher::Sync ()
+	{
+		uint64 startTime = Time::GetCurrent();
+
+		if (Policy == VolumeSyncPolicy::None)
+		{
+			ScopeLock lock (StateMutex);
+			++RequestCount;
+			return;
+		}
+
+		if (Policy == VolumeSyncPolicy::Strict)
+		{
+			HostFile->FlushData();
+
+			{
+				ScopeLock lock (StateMutex);
+				++RequestCount;
+				++FlushCount;
+			}
+
+			AddLatencySample (startTime);
+			return;
+		}
+
+		Waiter waiter;
+		{
+			ScopeLock lock (StateMutex);
+			++RequestCount;
+
+			if (FlushInProgress)
+			{
+				PendingWaiters.push_back (&waiter);
+			}
+			else
+			{
+				FlushInProgress = true;
+				waiter.Leader = true;
+			}
+		}
+
+		// A queued request is either completed by the leader or promoted to the next leader
+		if (!waiter.Leader)
+			waiter.CompletedEvent.Wait();
+
+		if (waiter.Leader)
+			FlushAsLeader (waiter);
+
+		if (waiter.FlushException)
+			waiter.FlushException->Throw();
+
+		AddLatencySample (startTime);
+	}
+}
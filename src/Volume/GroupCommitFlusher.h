@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_GroupCommitFlusher
+#define TC_HEADER_Volume_GroupCommitFlusher
+
+#include "Platform/Platform.h"
+
+namespace Basalt
+{
+	struct VolumeSyncPolicy
+	{
+		enum Enum
+		{
+			Grouped = 0,	// Concurrent sync requests share one flush of the host file
+			Strict,			// Each sync request flushes the host file
+			None			// Sync requests return without flushing
+		};
+	};
+
+	struct GroupCommitStatistics
+	{
+		uint64 RequestCount;
+		uint64 FlushCount;
+
+		// Latency of recent sync requests in microseconds
+		uint64 LatencyP50;
+		uint64 LatencyP90;
+		uint64 LatencyP99;
+		uint64 LatencyMax;
+	};
+
+	/*
+	 * Makes data written to the host file durable on request (NFS COMMIT,
+	 * FUSE fsync). With the grouped policy, requests arriving while a flush
+	 * is in progress are queued and covered by a single following flush.
+	 * When the previous flush served more than one request, the next flush
+	 * is delayed by up to MaxDelay milliseconds to collect further requests.
+	 */
+	class GroupCommitFlusher
+	{
+	public:
+		GroupCommitFlusher (shared_ptr <File> file, VolumeSyncPolicy::Enum policy, uint32 maxDelay = DefaultMaxDelay);
+		virtual ~GroupCommitFlusher () { }
+
+		VolumeSyncPolicy::Enum GetPolicy () const { return Policy; }
+		GroupCommitStatistics GetStatistics () const;
+		void Sync ();
+
+		static const uint32 DefaultMaxDelay = 1;
+		static const size_t LatencySampleCount = 4096;
+
+	protected:
+		struct Waiter
+		{
+			Waiter () : Leader (false) { }
+
+			SyncEvent CompletedEvent;
+			shared_ptr <Exception> FlushException;
+			bool Leader;
+		};
+
+		void AddLatencySample (uint64 startTime);
+		void FlushAsLeader (Waiter &leader);
+
+		shared_ptr <File> HostFile;
+		uint32 MaxDelay;
+		VolumeSyncPolicy::Enum Policy;
+
+		uint64 FlushCount;
+		bool FlushInProgress;
+		size_t LastBatchSize;
+		vector <uint64> LatencySamples;
+		size_t LatencySampleIndex;
+		list <Waiter *> PendingWaiters;
+		uint64 RequestCount;
+		mutable Mutex StateMutex;
+
+	private:
+		GroupCommitFlusher (const GroupCommitFlusher &);
+		GroupCommitFlusher &operator= (const GroupCommitFlusher &);
+	};
+}
+
+#endif // TC_HEADER_Volume_GroupCommitFlusher
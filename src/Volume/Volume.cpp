@@ -9,8 +9,10 @@
 #ifndef TC_WINDOWS
 #include <errno.h>
 #endif
+#include "Crc32.h"
 #include "EncryptionModeLRW.h"
 #include "EncryptionModeXTS.h"
+#include "Hash.h"
 #include "Volume.h"
 #include "VolumeHeader.h"
 #include "VolumeLayout.h"
@@ -24,14 +26,131 @@ namespace Basalt
 		VolumeDataSize (0),
 		TopWriteOffset (0),
 		TotalDataRead (0),
-		TotalDataWritten (0)
+		TotalDataWritten (0),
+		KeyRotationInProgress (false),
+		RotationWatermark (0)
 	{
 	}
 
+	// Sectors deallocated by DiscardSectors() read as zeros from the host. Ciphertext is all zeros
+	// with negligible probability, so such sectors are taken to hold zeros rather than encrypted data.
+	static bool IsDiscardedSector (const byte *sector, size_t sectorSize)
+	{
+		return sector[0] == 0 && memcmp (sector, sector + 1, sectorSize - 1) == 0;
+	}
+
+	static void FindDiscardedSectors (const ConstBufferPtr &buffer, size_t sectorSize, vector <size_t> &sectors)
+	{
+		for (size_t offset = 0; offset < buffer.Size(); offset += sectorSize)
+		{
+			if (IsDiscardedSector (buffer.Get() + offset, sectorSize))
+				sectors.push_back (offset / sectorSize);
+		}
+	}
+
+	// Key rotation journal: header followed by a checksum of the old ciphertext of each sector of the chunk being re-encrypted
+	static const size_t KeyRotationJournalHeaderSize = 24;
+
+	static uint64 GetKeyRotationSectorChecksum (Sha512 &sha, const ConstBufferPtr &sector)
+	{
+		sha.Init();
+		sha.ProcessData (sector);
+
+		byte digest[512 / 8];
+		sha.GetDigest (BufferPtr (digest, sizeof (digest)));
+
+		uint64 checksum;
+		memcpy (&checksum, digest, sizeof (checksum));
+		return checksum;
+	}
+
 	Volume::~Volume ()
 	{
 	}
 
+	shared_ptr <VolumeChangeTracker> Volume::AttachChangeTracker ()
+	{
+		if (ChangeTrackerPath.IsEmpty())
+			return shared_ptr <VolumeChangeTracker> ();
+
+		ScopeLock lock (ChangeTrackerMutex);
+
+		if (!ChangeTracker)
+			ChangeTracker.reset (new VolumeChangeTracker (ChangeTrackerPath, VolumeHostSize));
+
+		return ChangeTracker;
+	}
+
+	void Volume::BeginKeyRotation (const ConstBufferPtr &newDataKey, const ConstBufferPtr &headerSalt, const ConstBufferPtr &headerKey, const ConstBufferPtr &rotationHeaderSalt, const ConstBufferPtr &rotationHeaderKey)
+	{
+		if_debug (ValidateState ());
+
+		if (Protection == VolumeProtection::ReadOnly)
+			throw VolumeReadOnly (SRC_POS);
+
+		// Re-encryption of the outer volume would destroy the hidden volume
+		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
+			throw VolumeProtected (SRC_POS);
+
+		if (RotationHeader
+			|| !Layout->HasBackupHeader()
+			|| Layout->GetHeaderSize() != TC_VOLUME_HEADER_SIZE
+			|| SystemEncryption
+			|| (Header->GetFlags() & TC_HEADER_FLAG_ENCRYPTED_SYSTEM)
+			|| typeid (*EA->GetMode()) != typeid (EncryptionModeXTS)
+			|| newDataKey.Size() != EA->GetKeySize() * 2
+			|| (KeyRotationChunkSize / SectorSize) * sizeof (uint64) + KeyRotationJournalHeaderSize > Layout->GetHeaderSize() - TC_VOLUME_HEADER_EFFECTIVE_SIZE)
+		{
+			throw ParameterIncorrect (SRC_POS);
+		}
+
+		shared_ptr <EncryptionAlgorithm> rotationEA = EA->GetNew();
+		rotationEA->SetKey (newDataKey.GetRange (0, rotationEA->GetKeySize()));
+		shared_ptr <EncryptionMode> mode = EA->GetMode()->GetNew();
+		mode->SetKey (newDataKey.GetRange (rotationEA->GetKeySize(), rotationEA->GetKeySize()));
+		rotationEA->SetMode (mode);
+
+		shared_ptr <VolumeHeader> rotationHeader (new VolumeHeader (Layout->GetHeaderSize()));
+		SecureBuffer headerBuffer (Layout->GetHeaderSize());
+
+		VolumeHeaderCreationOptions options;
+		options.DataKey = newDataKey;
+		options.EA = EA->GetNew();
+		options.Kdf = Header->GetPkcs5Kdf();
+		options.HeaderKey = rotationHeaderKey;
+		options.Salt = rotationHeaderSalt;
+		options.SectorSize = (uint32) SectorSize;
+		options.VolumeDataSize = Header->GetVolumeDataSize();
+		options.VolumeDataStart = Header->GetEncryptedAreaStart();
+		options.Type = Type;
+
+		rotationHeader->Create (headerBuffer, options);
+		rotationHeader->SetFlags (Header->GetFlags() | TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS);
+
+		HeaderSalt.CopyFrom (headerSalt);
+		HeaderKey.CopyFrom (headerKey);
+		RotationHeaderSalt.CopyFrom (rotationHeaderSalt);
+		RotationHeaderKey.CopyFrom (rotationHeaderKey);
+
+		{
+			ScopeLock lock (RotationMutex);
+			RotationEA = rotationEA;
+			RotationHeader = rotationHeader;
+			RotationWatermark = 0;
+			KeyRotationInProgress = true;
+		}
+
+		// The header with the new key replaces the backup header before the volume header is flagged.
+		// An interruption in between leaves the volume usable with the old key.
+		WriteKeyRotationHeader (true);
+		VolumeFile->Flush();
+
+		Header->SetFlags (Header->GetFlags() | TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS);
+		Header->EncryptNew (headerBuffer, HeaderSalt, HeaderKey, shared_ptr <Pkcs5Kdf> ());
+		VolumeFile->WriteAt (headerBuffer.GetRange (0, TC_VOLUME_HEADER_EFFECTIVE_SIZE), GetHostOffset (Layout->GetHeaderOffset()));
+		VolumeFile->Flush();
+	}
+
 	void Volume::CheckProtectedRange (uint64 writeHostOffset, uint64 writeLength)
 	{
 		uint64 writeHostEndOffset = writeHostOffset + writeLength - 1;
@@ -47,10 +166,112 @@ namespace Basalt
 	{
 		if (VolumeFile.get() == nullptr)
 			throw NotInitialized (SRC_POS);
-		
+
+		if (ChangeTracker)
+		{
+			ChangeTracker->Close();
+			ChangeTracker.reset();
+		}
+
+		ChangeTrackerPath = FilePath();
 		VolumeFile.reset();
 	}
 
+	void Volume::CryptSectors (bool encrypt, const BufferPtr &buffer, uint64 hostOffset) const
+	{
+		// Sectors below the watermark have been re-encrypted with the new key
+		uint64 rotatedEndOffset = VolumeDataOffset + RotationWatermark;
+		uint64 length = buffer.Size();
+		uint64 rotatedLength = 0;
+
+		if (hostOffset < rotatedEndOffset)
+			rotatedLength = (rotatedEndOffset - hostOffset < length) ? rotatedEndOffset - hostOffset : length;
+
+		if (rotatedLength > 0)
+		{
+			BufferPtr rotated = buffer.GetRange (0, (size_t) rotatedLength);
+
+			if (encrypt)
+				RotationEA->EncryptSectors (rotated, hostOffset / SectorSize, rotatedLength / SectorSize, SectorSize);
+			else
+				RotationEA->DecryptSectors (rotated, hostOffset / SectorSize, rotatedLength / SectorSize, SectorSize);
+		}
+
+		if (length > rotatedLength)
+		{
+			BufferPtr remaining = buffer.GetRange ((size_t) rotatedLength, (size_t) (length - rotatedLength));
+			uint64 remainingHostOffset = hostOffset + rotatedLength;
+
+			if (encrypt)
+				EA->EncryptSectors (remaining, remainingHostOffset / SectorSize, remaining.Size() / SectorSize, SectorSize);
+			else
+				EA->DecryptSectors (remaining, remainingHostOffset / SectorSize, remaining.Size() / SectorSize, SectorSize);
+		}
+	}
+
+	void Volume::DiscardSectors (uint64 byteOffset, uint64 length)
+	{
+		if_debug (ValidateState ());
+
+		uint64 hostOffset = VolumeDataOffset + byteOffset;
+
+		if (length % SectorSize != 0
+			|| byteOffset % SectorSize != 0
+			|| byteOffset + length > VolumeDataSize)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (Protection == VolumeProtection::ReadOnly)
+			throw VolumeReadOnly (SRC_POS);
+
+		if (HiddenVolumeProtectionTriggered)
+			throw VolumeProtected (SRC_POS);
+
+		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
+			CheckProtectedRange (hostOffset, length);
+
+		shared_ptr <VolumeChangeTracker> changeTracker = AttachChangeTracker();
+
+		if (RotationEA)
+		{
+			// A chunk being re-encrypted must not be deallocated between reading and writing it
+			ScopeLock lock (RotationMutex);
+			VolumeFile->PunchHole (hostOffset, length);
+		}
+		else
+		{
+			VolumeFile->PunchHole (hostOffset, length);
+		}
+
+		if (changeTracker)
+			changeTracker->MarkChanged (hostOffset, length);
+	}
+
+	void Volume::FinishKeyRotation ()
+	{
+		if_debug (ValidateState ());
+
+		if (!KeyRotationInProgress || RotationWatermark != VolumeDataSize)
+			throw ParameterIncorrect (SRC_POS);
+
+		WriteKeyRotationJournal (ConstBufferPtr(), 0, true);
+		VolumeFile->Flush();
+
+		{
+			ScopeLock lock (RotationMutex);
+			KeyRotationInProgress = false;
+		}
+
+		RotationHeader->SetFlags (RotationHeader->GetFlags() & ~TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS);
+		Header->SetFlags (Header->GetFlags() & ~TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS);
+
+		// All data is encrypted with the new key. Replacing the volume header completes the rotation.
+		WriteKeyRotationHeader (false);
+		VolumeFile->Flush();
+
+		WriteKeyRotationHeader (true);
+		VolumeFile->Flush();
+	}
+
 	shared_ptr <EncryptionAlgorithm> Volume::GetEncryptionAlgorithm () const
 	{
 		if_debug (ValidateState ());
@@ -94,7 +315,13 @@ namespace Basalt
 				throw;
 		}
 
-		return Open (file, password, keyfiles, protection, protectionPassword, protectionKeyfiles, volumeType, useBackupHeaders, partitionInSystemEncryptionScope);
+		Open (file, password, keyfiles, protection, protectionPassword, protectionKeyfiles, volumeType, useBackupHeaders, partitionInSystemEncryptionScope);
+
+		// Writes are recorded if change tracking has been enabled for the container. The tracker is
+		// attached by the first data write, as only Close() marks its map as consistent again.
+		FilePath trackerPath = VolumeChangeTracker::GetTrackerPath (FilePath (wstring (volumePath)));
+		if (protection != VolumeProtection::ReadOnly && trackerPath.IsFile())
+			ChangeTrackerPath = trackerPath;
 	}
 
 	void Volume::Open (shared_ptr <File> volumeFile, shared_ptr <VolumePassword> password, shared_ptr <KeyfileList> keyfiles, VolumeProtection::Enum protection, shared_ptr <VolumePassword> protectionPassword, shared_ptr <KeyfileList> protectionKeyfiles, VolumeType::Enum volumeType, bool useBackupHeaders, bool partitionInSystemEncryptionScope)
@@ -194,6 +421,9 @@ namespace Basalt
 				{
 					// Header decrypted
 
+					if (header->GetFlags() & TC_HEADER_FLAG_REENCRYPTION_IN_PROGRESS)
+						throw VolumeEncryptionNotCompleted (SRC_POS);
+
 					if (typeid (*layout) == typeid (VolumeLayoutV2Normal) && header->GetRequiredMinProgramVersion() < 0x600)
 					{
 						// VolumeLayoutV1Normal has been opened as VolumeLayoutV2Normal
@@ -266,6 +496,14 @@ namespace Basalt
 							}
 						}
 					}
+
+					if (header->GetFlags() & TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS)
+					{
+						if (useBackupHeaders || !layout->HasBackupHeader())
+							throw KeyRotationNotCompleted (SRC_POS);
+
+						OpenKeyRotation (passwordKey, headerBuffer.GetRange (0, VolumeHeader::GetSaltSize()));
+					}
 					return;
 				}
 			}
@@ -307,6 +545,46 @@ namespace Basalt
 		}
 	}
 
+	void Volume::OpenKeyRotation (shared_ptr <VolumePassword> passwordKey, const ConstBufferPtr &headerSalt)
+	{
+		// The header with the new key is stored at the location of the backup header and uses the same KDF
+		SecureBuffer rotationHeaderBuffer (Layout->GetHeaderSize());
+		if (VolumeFile->ReadAt (rotationHeaderBuffer, GetHostOffset (Layout->GetBackupHeaderOffset())) != rotationHeaderBuffer.Size())
+			throw KeyRotationNotCompleted (SRC_POS);
+
+		Pkcs5KdfList keyDerivationFunctions;
+		keyDerivationFunctions.push_back (Header->GetPkcs5Kdf());
+
+		shared_ptr <VolumeHeader> rotationHeader (new VolumeHeader (Layout->GetHeaderSize()));
+
+		if (!rotationHeader->Decrypt (rotationHeaderBuffer, *passwordKey, keyDerivationFunctions, Layout->GetSupportedEncryptionAlgorithms(), Layout->GetSupportedEncryptionModes())
+			|| !(rotationHeader->GetFlags() & TC_HEADER_FLAG_KEY_ROTATION_IN_PROGRESS)
+			|| typeid (*rotationHeader->GetEncryptionAlgorithm()) != typeid (*EA)
+			|| rotationHeader->GetSectorSize() != SectorSize
+			|| rotationHeader->GetVolumeDataSize() != Header->GetVolumeDataSize()
+			|| rotationHeader->GetEncryptedAreaStart() != Header->GetEncryptedAreaStart()
+			|| rotationHeader->GetEncryptedAreaLength() > VolumeDataSize
+			|| rotationHeader->GetEncryptedAreaLength() % SectorSize != 0)
+		{
+			throw KeyRotationNotCompleted (SRC_POS);
+		}
+
+		HeaderSalt.CopyFrom (headerSalt);
+		HeaderKey.Allocate (VolumeHeader::GetLargestSerializedKeySize());
+		Header->GetPkcs5Kdf()->DeriveKey (HeaderKey, *passwordKey, HeaderSalt);
+
+		RotationHeaderSalt.CopyFrom (rotationHeaderBuffer.GetRange (0, VolumeHeader::GetSaltSize()));
+		RotationHeaderKey.Allocate (VolumeHeader::GetLargestSerializedKeySize());
+		Header->GetPkcs5Kdf()->DeriveKey (RotationHeaderKey, *passwordKey, RotationHeaderSalt);
+
+		RotationEA = rotationHeader->GetEncryptionAlgorithm();
+		RotationHeader = rotationHeader;
+		RotationWatermark = rotationHeader->GetEncryptedAreaLength();
+		KeyRotationInProgress = true;
+
+		RecoverKeyRotationJournal();
+	}
+
 	void Volume::ReadSectors (const BufferPtr &buffer, uint64 byteOffset)
 	{
 		if_debug (ValidateState ());
@@ -317,10 +595,30 @@ namespace Basalt
 		if (length % SectorSize != 0 || byteOffset % SectorSize != 0)
 			throw ParameterIncorrect (SRC_POS);
 
-		if (VolumeFile->ReadAt (buffer, hostOffset) != length)
-			throw MissingVolumeData (SRC_POS);
+		vector <size_t> discardedSectors;
+
+		if (RotationEA)
+		{
+			// The key rotation watermark must not move between reading and decrypting the data
+			ScopeLock lock (RotationMutex);
+
+			if (VolumeFile->ReadAt (buffer, hostOffset) != length)
+				throw MissingVolumeData (SRC_POS);
 
-		EA->DecryptSectors (buffer, hostOffset / SectorSize, length / SectorSize, SectorSize);
+			FindDiscardedSectors (buffer, SectorSize, discardedSectors);
+			CryptSectors (false, buffer, hostOffset);
+		}
+		else
+		{
+			if (VolumeFile->ReadAt (buffer, hostOffset) != length)
+				throw MissingVolumeData (SRC_POS);
+
+			FindDiscardedSectors (buffer, SectorSize, discardedSectors);
+			EA->DecryptSectors (buffer, hostOffset / SectorSize, length / SectorSize, SectorSize);
+		}
+
+		for (size_t sector : discardedSectors)
+			buffer.GetRange (sector * SectorSize, SectorSize).Zero();
 
 		TotalDataRead += length;
 	}
@@ -332,9 +630,13 @@ namespace Basalt
 		if (Protection == VolumeProtection::ReadOnly)
 			throw VolumeReadOnly (SRC_POS);
 
+		// The backup header location holds the header with the new key until key rotation completes
+		if (KeyRotationInProgress)
+			throw KeyRotationNotCompleted (SRC_POS);
+
 		SecureBuffer newHeaderBuffer (Layout->GetHeaderSize());
 		
-		Header->EncryptNew (newHeaderBuffer, newSalt, newHeaderKey, newPkcs5Kdf);
+		(RotationHeader ? RotationHeader : Header)->EncryptNew (newHeaderBuffer, newSalt, newHeaderKey, newPkcs5Kdf);
 
 		int headerOffset = backupHeader ? Layout->GetBackupHeaderOffset() : Layout->GetHeaderOffset();
 
@@ -346,12 +648,185 @@ namespace Basalt
 		VolumeFile->Write (newHeaderBuffer);
 	}
 
+	void Volume::RecoverKeyRotationJournal ()
+	{
+		uint64 journalOffset = GetKeyRotationJournalOffset();
+		SecureBuffer journal (Layout->GetHeaderSize() - TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+
+		if (VolumeFile->ReadAt (journal, journalOffset) != journal.Size())
+			throw KeyRotationNotCompleted (SRC_POS);
+
+		RotationEA->DecryptSectors (journal, journalOffset / ENCRYPTION_DATA_UNIT_SIZE, journal.Size() / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+
+		// The journal is flushed before the chunk is written. A journal which is not valid or
+		// which describes a chunk below the watermark means no chunk was being written.
+		if (memcmp (journal.Ptr(), "BKRJ", 4) != 0
+			|| Endian::Big (*reinterpret_cast <uint32 *> (journal.Ptr() + 4)) != Crc32::ProcessBuffer (journal.GetRange (8, journal.Size() - 8)))
+		{
+			return;
+		}
+
+		uint64 chunkOffset = Endian::Big (*reinterpret_cast <uint64 *> (journal.Ptr() + 8));
+		uint64 sectorCount = Endian::Big (*reinterpret_cast <uint32 *> (journal.Ptr() + 16));
+
+		if (chunkOffset != RotationWatermark)
+			return;
+
+		if (sectorCount == 0
+			|| sectorCount > (journal.Size() - KeyRotationJournalHeaderSize) / sizeof (uint64)
+			|| chunkOffset + sectorCount * SectorSize > VolumeDataSize)
+		{
+			throw KeyRotationNotCompleted (SRC_POS);
+		}
+
+		if (Protection == VolumeProtection::ReadOnly)
+			throw KeyRotationNotCompleted (SRC_POS);
+
+		// Sectors which still match the checksum of their old ciphertext were not overwritten before the interruption
+		uint64 hostOffset = VolumeDataOffset + chunkOffset;
+		SecureBuffer chunk ((size_t) (sectorCount * SectorSize));
+
+		if (VolumeFile->ReadAt (chunk, hostOffset) != chunk.Size())
+			throw MissingVolumeData (SRC_POS);
+
+		Sha512 sha;
+		for (uint64 i = 0; i < sectorCount; ++i)
+		{
+			BufferPtr sector = chunk.GetRange ((size_t) (i * SectorSize), SectorSize);
+			uint64 checksum;
+			memcpy (&checksum, journal.Ptr() + KeyRotationJournalHeaderSize + i * sizeof (uint64), sizeof (checksum));
+
+			// Deallocated sectors read as zeros with either key
+			if (!IsDiscardedSector (sector.Get(), SectorSize) && GetKeyRotationSectorChecksum (sha, sector) == checksum)
+				EA->ReEncryptSectors (sector, hostOffset / SectorSize + i, 1, SectorSize, *RotationEA, hostOffset / SectorSize + i);
+		}
+
+		VolumeFile->WriteAt (chunk, hostOffset);
+		VolumeFile->Flush();
+
+		RotationWatermark += chunk.Size();
+		WriteKeyRotationHeader (true);
+		VolumeFile->Flush();
+	}
+
+	uint64 Volume::RotateKeyChunk ()
+	{
+		if_debug (ValidateState ());
+
+		if (Protection == VolumeProtection::ReadOnly)
+			throw VolumeReadOnly (SRC_POS);
+
+		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
+			throw VolumeProtected (SRC_POS);
+
+		uint64 chunkLength;
+		{
+			ScopeLock lock (RotationMutex);
+
+			if (!KeyRotationInProgress)
+				throw ParameterIncorrect (SRC_POS);
+
+			chunkLength = VolumeDataSize - RotationWatermark;
+			if (chunkLength > KeyRotationChunkSize)
+				chunkLength = KeyRotationChunkSize;
+
+			if (chunkLength == 0)
+				return 0;
+
+			uint64 hostOffset = VolumeDataOffset + RotationWatermark;
+			SecureBuffer chunk ((size_t) chunkLength);
+			shared_ptr <VolumeChangeTracker> changeTracker = AttachChangeTracker();
+
+			if (VolumeFile->ReadAt (chunk, hostOffset) != chunk.Size())
+				throw MissingVolumeData (SRC_POS);
+
+			WriteKeyRotationJournal (chunk, RotationWatermark, false);
+			VolumeFile->Flush();
+
+			vector <size_t> discardedSectors;
+			FindDiscardedSectors (chunk, SectorSize, discardedSectors);
+
+			EA->ReEncryptSectors (chunk, hostOffset / SectorSize, chunkLength / SectorSize, SectorSize, *RotationEA, hostOffset / SectorSize);
+
+			// Deallocated sectors read as zeros with either key and are left as they are, so that holes in the host file remain
+			size_t runStart = 0;
+			discardedSectors.push_back (chunk.Size() / SectorSize);
+
+			for (size_t sector : discardedSectors)
+			{
+				if (sector > runStart)
+					VolumeFile->WriteAt (chunk.GetRange (runStart * SectorSize, (sector - runStart) * SectorSize), hostOffset + runStart * SectorSize);
+
+				runStart = sector + 1;
+			}
+
+			VolumeFile->Flush();
+
+			if (changeTracker)
+				changeTracker->MarkChanged (hostOffset, chunkLength);
+
+			RotationWatermark += chunkLength;
+		}
+
+		// Writes to the chunk made before the watermark is persisted are recognized by the journal
+		WriteKeyRotationHeader (true);
+		VolumeFile->Flush();
+
+		return chunkLength;
+	}
+
 	void Volume::ValidateState () const
 	{
 		if (VolumeFile.get() == nullptr)
 			throw NotInitialized (SRC_POS);
 	}
 
+	void Volume::WriteKeyRotationHeader (bool backupHeader)
+	{
+		// During key rotation, the encrypted area of the header with the new key ends at the watermark
+		RotationHeader->SetEncryptedArea (Header->GetEncryptedAreaStart(), KeyRotationInProgress ? RotationWatermark : Header->GetEncryptedAreaLength());
+
+		SecureBuffer headerBuffer (Layout->GetHeaderSize());
+
+		if (backupHeader)
+			RotationHeader->EncryptNew (headerBuffer, RotationHeaderSalt, RotationHeaderKey, shared_ptr <Pkcs5Kdf> ());
+		else
+			RotationHeader->EncryptNew (headerBuffer, HeaderSalt, HeaderKey, shared_ptr <Pkcs5Kdf> ());
+
+		// The rest of the header area holds the journal
+		VolumeFile->WriteAt (headerBuffer.GetRange (0, TC_VOLUME_HEADER_EFFECTIVE_SIZE),
+			GetHostOffset (backupHeader ? Layout->GetBackupHeaderOffset() : Layout->GetHeaderOffset()));
+	}
+
+	void Volume::WriteKeyRotationJournal (const ConstBufferPtr &chunk, uint64 chunkOffset, bool clear)
+	{
+		uint64 journalOffset = GetKeyRotationJournalOffset();
+		SecureBuffer journal (Layout->GetHeaderSize() - TC_VOLUME_HEADER_EFFECTIVE_SIZE);
+		journal.Zero();
+
+		if (!clear)
+		{
+			uint32 sectorCount = (uint32) (chunk.Size() / SectorSize);
+
+			memcpy (journal.Ptr(), "BKRJ", 4);
+			*reinterpret_cast <uint64 *> (journal.Ptr() + 8) = Endian::Big (chunkOffset);
+			*reinterpret_cast <uint32 *> (journal.Ptr() + 16) = Endian::Big (sectorCount);
+
+			Sha512 sha;
+			for (uint32 i = 0; i < sectorCount; ++i)
+			{
+				uint64 checksum = GetKeyRotationSectorChecksum (sha, chunk.GetRange (i * SectorSize, SectorSize));
+				memcpy (journal.Ptr() + KeyRotationJournalHeaderSize + i * sizeof (uint64), &checksum, sizeof (checksum));
+			}
+
+			*reinterpret_cast <uint32 *> (journal.Ptr() + 4) = Endian::Big (Crc32::ProcessBuffer (journal.GetRange (8, journal.Size() - 8)));
+		}
+
+		// The journal is encrypted with the new key so that it cannot be distinguished from random data
+		RotationEA->EncryptSectors (journal, journalOffset / ENCRYPTION_DATA_UNIT_SIZE, journal.Size() / ENCRYPTION_DATA_UNIT_SIZE, ENCRYPTION_DATA_UNIT_SIZE);
+		VolumeFile->WriteAt (journal, journalOffset);
+	}
+
 	void Volume::WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset)
 	{
 		if_debug (ValidateState ());
@@ -373,11 +848,28 @@ namespace Basalt
 		if (Protection == VolumeProtection::HiddenVolumeReadOnly)
 			CheckProtectedRange (hostOffset, length);
 
+		shared_ptr <VolumeChangeTracker> changeTracker = AttachChangeTracker();
+
 		SecureBuffer encBuf (buffer.Size());
 		encBuf.CopyFrom (buffer);
 
-		EA->EncryptSectors (encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
-		VolumeFile->WriteAt (encBuf, hostOffset);
+		if (RotationEA)
+		{
+			// The key rotation watermark must not move between encrypting and writing the data
+			ScopeLock lock (RotationMutex);
+
+			CryptSectors (true, encBuf, hostOffset);
+			VolumeFile->WriteAt (encBuf, hostOffset);
+		}
+		else
+		{
+			EA->EncryptSectors (encBuf, hostOffset / SectorSize, length / SectorSize, SectorSize);
+			VolumeFile->WriteAt (encBuf, hostOffset);
+		}
+
+		// Recorded after the write, so that a backup started in between copies the new data or sees the change next time
+		if (changeTracker)
+			changeTracker->MarkChanged (hostOffset, length);
 
 		TotalDataWritten += length;
 		
@@ -10,11 +10,13 @@
 #define TC_HEADER_Volume_Volume
 
 #include "Platform/Platform.h"
+#include "Platform/Mutex.h"
 #include "Platform/StringConverter.h"
 #include "EncryptionAlgorithm.h"
 #include "EncryptionMode.h"
 #include "Keyfile.h"
 #include "VolumePassword.h"
+#include "VolumeChangeTracker.h"
 #include "VolumeException.h"
 #include "VolumeLayout.h"
 
@@ -68,13 +70,18 @@ namespace Basalt
 		Volume ();
 		virtual ~Volume ();
 
+		void BeginKeyRotation (const ConstBufferPtr &newDataKey, const ConstBufferPtr &headerSalt, const ConstBufferPtr &headerKey, const ConstBufferPtr &rotationHeaderSalt, const ConstBufferPtr &rotationHeaderKey);
 		void Close ();
+		void DiscardSectors (uint64 byteOffset, uint64 length);
+		void FinishKeyRotation ();
+		shared_ptr <VolumeChangeTracker> GetChangeTracker () const { return ChangeTracker; }
 		shared_ptr <EncryptionAlgorithm> GetEncryptionAlgorithm () const;
 		shared_ptr <EncryptionMode> GetEncryptionMode () const;
 		shared_ptr <File> GetFile () const { return VolumeFile; }
 		shared_ptr <VolumeHeader> GetHeader () const { return Header; }
 		uint64 GetHeaderCreationTime () const { return Header->GetHeaderCreationTime(); }
 		uint64 GetHostSize () const { return VolumeHostSize; }
+		uint64 GetKeyRotationWatermark () const { return RotationWatermark; }
 		shared_ptr <VolumeLayout> GetLayout () const { return Layout; }
 		VolumePath GetPath () const { return VolumeFile->GetPath(); }
 		VolumeProtection::Enum GetProtectionType () const { return Protection; }
@@ -89,16 +96,31 @@ namespace Basalt
 		uint64 GetVolumeCreationTime () const { return Header->GetVolumeCreationTime(); }
 		bool IsHiddenVolumeProtectionTriggered () const { return HiddenVolumeProtectionTriggered; }
 		bool IsInSystemEncryptionScope () const { return SystemEncryption; }
+		bool IsKeyRotationInProgress () const { return KeyRotationInProgress; }
 		void Open (const VolumePath &volumePath, bool preserveTimestamps, shared_ptr <VolumePassword> password, shared_ptr <KeyfileList> keyfiles, VolumeProtection::Enum protection = VolumeProtection::None, shared_ptr <VolumePassword> protectionPassword = shared_ptr <VolumePassword> (), shared_ptr <KeyfileList> protectionKeyfiles = shared_ptr <KeyfileList> (), bool sharedAccessAllowed = false, VolumeType::Enum volumeType = VolumeType::Unknown, bool useBackupHeaders = false, bool partitionInSystemEncryptionScope = false);
 		void Open (shared_ptr <File> volumeFile, shared_ptr <VolumePassword> password, shared_ptr <KeyfileList> keyfiles, VolumeProtection::Enum protection = VolumeProtection::None, shared_ptr <VolumePassword> protectionPassword = shared_ptr <VolumePassword> (), shared_ptr <KeyfileList> protectionKeyfiles = shared_ptr <KeyfileList> (), VolumeType::Enum volumeType = VolumeType::Unknown, bool useBackupHeaders = false, bool partitionInSystemEncryptionScope = false);
 		void ReadSectors (const BufferPtr &buffer, uint64 byteOffset);
 		void ReEncryptHeader (bool backupHeader, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf);
+		uint64 RotateKeyChunk ();
 		void WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset);
 
+		static const uint64 KeyRotationChunkSize = 2 * BYTES_PER_MB;
+
 	protected:
+		shared_ptr <VolumeChangeTracker> AttachChangeTracker ();
 		void CheckProtectedRange (uint64 writeHostOffset, uint64 writeLength);
+		void CryptSectors (bool encrypt, const BufferPtr &buffer, uint64 hostOffset) const;
+		uint64 GetHostOffset (int headerOffset) const { return headerOffset >= 0 ? (uint64) headerOffset : VolumeHostSize + headerOffset; }
+		uint64 GetKeyRotationJournalOffset () const { return GetHostOffset (Layout->GetHeaderOffset()) + TC_VOLUME_HEADER_EFFECTIVE_SIZE; }
+		void OpenKeyRotation (shared_ptr <VolumePassword> passwordKey, const ConstBufferPtr &headerSalt);
+		void RecoverKeyRotationJournal ();
 		void ValidateState () const;
+		void WriteKeyRotationHeader (bool backupHeader);
+		void WriteKeyRotationJournal (const ConstBufferPtr &chunk, uint64 chunkOffset, bool clear);
 
+		shared_ptr <VolumeChangeTracker> ChangeTracker;	// Attached by the first write
+		Mutex ChangeTrackerMutex;
+		FilePath ChangeTrackerPath;
 		shared_ptr <EncryptionAlgorithm> EA;
 		shared_ptr <VolumeHeader> Header;
 		bool HiddenVolumeProtectionTriggered;
@@ -117,6 +139,17 @@ namespace Basalt
 		uint64 TotalDataRead;
 		uint64 TotalDataWritten;
 
+		// Master key rotation. Data below the watermark is encrypted with the new key
+		bool KeyRotationInProgress;
+		shared_ptr <EncryptionAlgorithm> RotationEA;
+		shared_ptr <VolumeHeader> RotationHeader;
+		SecureBuffer HeaderKey;
+		SecureBuffer HeaderSalt;
+		SecureBuffer RotationHeaderKey;
+		SecureBuffer RotationHeaderSalt;
+		Mutex RotationMutex;
+		uint64 RotationWatermark;
+
 	private:
 		Volume (const Volume &);
 		Volume &operator= (const Volume &);
@@ -0,0 +1,343 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "Platform/Time.h"
+#include "VolumeChangeTracker.h"
+#include "VolumeHeader.h"
+
+namespace Basalt
+{
+	static const char TrackerMagic[8] = { 'B', 'S', 'L', 'T', 'C', 'H', 'N', 'G' };
+
+	VolumeChangeTracker::VolumeChangeTracker (const FilePath &path, uint64 hostSize)
+		: Dirty (false), Generation (0), HostSize (hostSize), LastCheckpointTime (0)
+	{
+		TrackerFile.Open (path, File::OpenReadWrite);
+
+		FileHeader header;
+		bool headerValid = true;
+		try
+		{
+			header = ReadHeader (TrackerFile);
+		}
+		catch (ParameterIncorrect &)
+		{
+			// A damaged or foreign map is replaced by one marking all blocks as changed. The last token
+			// is unknown, so generations restart high enough to exceed the tokens normally issued.
+			header.BlockSize = BlockSize;
+			header.Flags = 0;
+			header.HostSize = hostSize;
+			header.Token = RecreatedToken;
+			headerValid = false;
+		}
+
+		size_t blockCount = (size_t) ((hostSize + BlockSize - 1) / BlockSize);
+		BlockGenerations.resize (blockCount, 0);
+		DirtyPages.resize ((blockCount * sizeof (uint32) + PageSize - 1) / PageSize, false);
+
+		Generation = header.Token + 1;
+
+		// Writes made while the map was flagged as in use may not have been recorded
+		bool valid = headerValid && !(header.Flags & FlagInUse) && header.HostSize == hostSize && header.BlockSize == BlockSize;
+
+		if (valid && blockCount > 0)
+		{
+			Buffer map (blockCount * sizeof (uint32));
+			valid = TrackerFile.ReadAt (map, HeaderSize) == map.Size();
+
+			for (size_t i = 0; valid && i < blockCount; ++i)
+			{
+				uint32 generation;
+				memcpy (&generation, map.Ptr() + i * sizeof (uint32), sizeof (generation));
+				BlockGenerations[i] = Endian::Little (generation);
+			}
+		}
+
+		if (!valid)
+		{
+			for (size_t i = 0; i < blockCount; ++i)
+				BlockGenerations[i] = Generation;
+
+			for (size_t i = 0; i < DirtyPages.size(); ++i)
+				DirtyPages[i] = true;
+
+			Dirty = true;
+		}
+
+		// The in-use flag must be durable before the volume is written
+		Checkpoint (true);
+		TrackerFile.Flush();
+	}
+
+	VolumeChangeTracker::~VolumeChangeTracker ()
+	{
+		// The map stays flagged as in use unless it has been closed. Another process, such as
+		// the FUSE service a mounted volume has been handed over to, may still be using it.
+	}
+
+	void VolumeChangeTracker::Checkpoint (bool inUse)
+	{
+		if (Dirty)
+		{
+			for (size_t pageIndex = 0; pageIndex < DirtyPages.size(); ++pageIndex)
+			{
+				if (!DirtyPages[pageIndex])
+					continue;
+
+				// Adjacent dirty pages are written together
+				size_t endPage = pageIndex;
+				while (endPage < DirtyPages.size() && DirtyPages[endPage])
+					DirtyPages[endPage++] = false;
+
+				size_t firstBlock = pageIndex * PageSize / sizeof (uint32);
+				size_t endBlock = endPage * PageSize / sizeof (uint32);
+				if (endBlock > BlockGenerations.size())
+					endBlock = BlockGenerations.size();
+
+				Buffer map ((endBlock - firstBlock) * sizeof (uint32));
+				for (size_t i = firstBlock; i < endBlock; ++i)
+				{
+					uint32 generation = Endian::Little (BlockGenerations[i]);
+					memcpy (map.Ptr() + (i - firstBlock) * sizeof (uint32), &generation, sizeof (generation));
+				}
+
+				TrackerFile.WriteAt (map, HeaderSize + firstBlock * sizeof (uint32));
+				pageIndex = endPage;
+			}
+
+			Dirty = false;
+			++Generation;
+		}
+
+		WriteHeader (inUse);
+
+		// Time is measured in units of 100 ns
+		LastCheckpointTime = Time::GetCurrent();
+	}
+
+	void VolumeChangeTracker::Close ()
+	{
+		ScopeLock lock (TrackerMutex);
+
+		if (!TrackerFile.IsOpen())
+			return;
+
+		// The map must be complete on disk before it is flagged as consistent
+		Checkpoint (true);
+		TrackerFile.Flush();
+
+		WriteHeader (false);
+		TrackerFile.Flush();
+		TrackerFile.Close();
+	}
+
+	void VolumeChangeTracker::Create (const FilePath &path, uint64 hostSize, uint32 generation)
+	{
+		size_t blockCount = (size_t) ((hostSize + BlockSize - 1) / BlockSize);
+
+		// All blocks belong to the first generation, which a backup with an earlier token copies completely
+		Buffer data (HeaderSize + blockCount * sizeof (uint32));
+		data.Zero();
+
+		memcpy (data.Ptr(), TrackerMagic, sizeof (TrackerMagic));
+
+		uint32 value = Endian::Little ((uint32) Version);
+		memcpy (data.Ptr() + 8, &value, sizeof (value));
+		value = Endian::Little ((uint32) BlockSize);
+		memcpy (data.Ptr() + 12, &value, sizeof (value));
+		uint64 size = Endian::Little (hostSize);
+		memcpy (data.Ptr() + 16, &size, sizeof (size));
+		value = Endian::Little (generation);
+		memcpy (data.Ptr() + 24, &value, sizeof (value));
+
+		for (size_t i = 0; i < blockCount; ++i)
+			memcpy (data.Ptr() + HeaderSize + i * sizeof (uint32), &value, sizeof (value));
+
+		File file;
+		file.Open (path, File::CreateWrite);
+		file.Write (data);
+		file.Flush();
+	}
+
+	uint32 VolumeChangeTracker::GetChanges (const FilePath &path, uint32 sinceToken, bool volumeInUse, VolumeChangedRangeList &ranges)
+	{
+		File file;
+		file.Open (path, File::OpenRead);
+		FileHeader header = ReadHeader (file);
+
+		ranges.clear();
+
+		if (header.HostSize == 0)
+			return header.Token;
+
+		if ((header.Flags & FlagInUse) && !volumeInUse)
+		{
+			// The volume was not closed properly. It is marked as changed completely, with a generation
+			// newer than the token, when it is opened next.
+			VolumeChangedRange range = { 0, header.HostSize };
+			ranges.push_back (range);
+			return header.Token;
+		}
+
+		if (sinceToken > header.Token)
+		{
+			// The token was issued by a map that has since been recreated
+			VolumeChangedRange range = { 0, header.HostSize };
+			ranges.push_back (range);
+			return header.Token;
+		}
+
+		size_t blockCount = (size_t) ((header.HostSize + header.BlockSize - 1) / header.BlockSize);
+		Buffer map (blockCount * sizeof (uint32));
+		if (file.ReadAt (map, HeaderSize) != map.Size())
+			throw ParameterIncorrect (SRC_POS);
+
+		// Headers may be written without the volume being open (password change, header restore),
+		// so the blocks holding the volume headers and the backup headers are always included
+		uint64 headerGroupSize = header.HostSize < TC_VOLUME_HEADER_GROUP_SIZE ? header.HostSize : TC_VOLUME_HEADER_GROUP_SIZE;
+		size_t headerEndBlock = (size_t) ((headerGroupSize + header.BlockSize - 1) / header.BlockSize);
+		size_t backupHeaderBlock = (size_t) ((header.HostSize - headerGroupSize) / header.BlockSize);
+
+		bool inRange = false;
+		for (size_t i = 0; i <= blockCount; ++i)
+		{
+			bool changed = false;
+			if (i < blockCount)
+			{
+				uint32 generation;
+				memcpy (&generation, map.Ptr() + i * sizeof (uint32), sizeof (generation));
+
+				changed = Endian::Little (generation) > sinceToken || i < headerEndBlock || i >= backupHeaderBlock;
+			}
+
+			if (changed && !inRange)
+			{
+				VolumeChangedRange range = { (uint64) i * header.BlockSize, 0 };
+				ranges.push_back (range);
+				inRange = true;
+			}
+			else if (!changed && inRange)
+			{
+				uint64 endOffset = (uint64) i * header.BlockSize;
+				if (endOffset > header.HostSize)
+					endOffset = header.HostSize;
+
+				ranges.back().Length = endOffset - ranges.back().Offset;
+				inRange = false;
+			}
+		}
+
+		return header.Token;
+	}
+
+	void VolumeChangeTracker::MarkChanged (uint64 hostOffset, uint64 length)
+	{
+		if (length == 0)
+			return;
+
+		ScopeLock lock (TrackerMutex);
+
+		if (!TrackerFile.IsOpen() || BlockGenerations.empty())
+			return;
+
+		size_t firstBlock = (size_t) (hostOffset / BlockSize);
+		size_t lastBlock = (size_t) ((hostOffset + length - 1) / BlockSize);
+		if (lastBlock >= BlockGenerations.size())
+			lastBlock = BlockGenerations.size() - 1;
+
+		for (size_t i = firstBlock; i <= lastBlock; ++i)
+		{
+			if (BlockGenerations[i] != Generation)
+			{
+				BlockGenerations[i] = Generation;
+				DirtyPages[i * sizeof (uint32) / PageSize] = true;
+				Dirty = true;
+			}
+		}
+
+		if (Dirty && Time::GetCurrent() - LastCheckpointTime >= CheckpointInterval * 10000000ULL)
+		{
+			try
+			{
+				Checkpoint (true);
+			}
+			catch (...)
+			{
+				// The write itself has succeeded. The map remains flagged as in use, and all of it is written
+				// at the next checkpoint, as the pages written before the failure are not known.
+				for (size_t i = 0; i < DirtyPages.size(); ++i)
+					DirtyPages[i] = true;
+			}
+		}
+	}
+
+	VolumeChangeTracker::FileHeader VolumeChangeTracker::ReadHeader (File &file)
+	{
+		Buffer data (HeaderSize);
+		if (file.ReadAt (data, 0) != data.Size()
+			|| memcmp (data.Ptr(), TrackerMagic, sizeof (TrackerMagic)) != 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		uint32 version;
+		memcpy (&version, data.Ptr() + 8, sizeof (version));
+		if (Endian::Little (version) != Version)
+			throw ParameterIncorrect (SRC_POS);
+
+		FileHeader header;
+		memcpy (&header.BlockSize, data.Ptr() + 12, sizeof (header.BlockSize));
+		memcpy (&header.HostSize, data.Ptr() + 16, sizeof (header.HostSize));
+		memcpy (&header.Token, data.Ptr() + 24, sizeof (header.Token));
+		memcpy (&header.Flags, data.Ptr() + 28, sizeof (header.Flags));
+
+		header.BlockSize = Endian::Little (header.BlockSize);
+		header.HostSize = Endian::Little (header.HostSize);
+		header.Token = Endian::Little (header.Token);
+		header.Flags = Endian::Little (header.Flags);
+
+		if (header.BlockSize == 0)
+			throw ParameterIncorrect (SRC_POS);
+
+		return header;
+	}
+
+	void VolumeChangeTracker::Reset (const FilePath &path, uint64 hostSize)
+	{
+		// Blocks are stamped with a generation newer than any token issued by the old map
+		uint32 generation = RecreatedToken;
+		try
+		{
+			File file;
+			file.Open (path, File::OpenRead);
+			generation = ReadHeader (file).Token + 1;
+		}
+		catch (ParameterIncorrect &) { }
+
+		Create (path, hostSize, generation);
+	}
+
+	void VolumeChangeTracker::WriteHeader (bool inUse)
+	{
+		byte data[32];
+		memcpy (data, TrackerMagic, sizeof (TrackerMagic));
+
+		uint32 value = Endian::Little ((uint32) Version);
+		memcpy (data + 8, &value, sizeof (value));
+		value = Endian::Little ((uint32) BlockSize);
+		memcpy (data + 12, &value, sizeof (value));
+		uint64 size = Endian::Little (HostSize);
+		memcpy (data + 16, &size, sizeof (size));
+
+		// Blocks of the current generation have not been written yet
+		value = Endian::Little (Generation - 1);
+		memcpy (data + 24, &value, sizeof (value));
+		value = Endian::Little (inUse ? FlagInUse : (uint32) 0);
+		memcpy (data + 28, &value, sizeof (value));
+
+		TrackerFile.WriteAt (ConstBufferPtr (data, sizeof (data)), 0);
+	}
+}
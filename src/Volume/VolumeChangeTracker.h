@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeChangeTracker
+#define TC_HEADER_Volume_VolumeChangeTracker
+
+#include "Platform/Platform.h"
+
+namespace Basalt
+{
+	struct VolumeChangedRange
+	{
+		uint64 Offset;		// Offset in the host file
+		uint64 Length;
+	};
+
+	typedef list <VolumeChangedRange> VolumeChangedRangeList;
+
+	/*
+	 * Records which blocks of a container file have been written, so that
+	 * backups can copy only the changed ciphertext. The tracking file next to
+	 * the container holds the generation in which each block was last
+	 * written. A generation ends at each checkpoint; the last completed
+	 * generation is the token passed to GetChanges() by the next backup.
+	 *
+	 * Checkpoints write the modified part of the map without flushing it. The
+	 * file is flagged as in use while the volume is open, and the flag is
+	 * cleared by Close() after the map has been flushed. A map still flagged
+	 * on the next open may have missed writes, so all blocks are then taken
+	 * to have changed. So are all blocks of a map that cannot be read, which
+	 * is recreated.
+	 *
+	 * Volume attaches the tracker on the first data write, so that opening a
+	 * volume only to change its header does not flag the map.
+	 */
+	class VolumeChangeTracker
+	{
+	public:
+		VolumeChangeTracker (const FilePath &path, uint64 hostSize);
+		virtual ~VolumeChangeTracker ();
+
+		void Close ();
+		static void Create (const FilePath &path, uint64 hostSize, uint32 generation = 1);
+		static uint32 GetChanges (const FilePath &path, uint32 sinceToken, bool volumeInUse, VolumeChangedRangeList &ranges);
+		static FilePath GetTrackerPath (const FilePath &volumePath) { return FilePath (wstring (volumePath) + L".changes"); }
+		void MarkChanged (uint64 hostOffset, uint64 length);
+		static void Reset (const FilePath &path, uint64 hostSize);	// Marks all blocks as changed, e.g. after the host has been resized
+
+		static const uint32 BlockSize = 1024 * 1024;
+		static const uint32 CheckpointInterval = 30;	// Seconds
+
+	protected:
+		struct FileHeader
+		{
+			uint32 BlockSize;
+			uint32 Flags;
+			uint64 HostSize;
+			uint32 Token;
+		};
+
+		void Checkpoint (bool inUse);
+		static FileHeader ReadHeader (File &file);
+		void WriteHeader (bool inUse);
+
+		static const size_t HeaderSize = 4096;
+		static const size_t PageSize = 4096;
+		static const uint32 FlagInUse = 0x1;
+		static const uint32 RecreatedToken = 0x80000000;
+		static const uint32 Version = 1;
+
+		vector <uint32> BlockGenerations;
+		vector <bool> DirtyPages;
+		bool Dirty;
+		uint32 Generation;			// Stamped on blocks written since the last checkpoint
+		uint64 HostSize;
+		uint64 LastCheckpointTime;
+		File TrackerFile;
+		Mutex TrackerMutex;
+
+	private:
+		VolumeChangeTracker (const VolumeChangeTracker &);
+		VolumeChangeTracker &operator= (const VolumeChangeTracker &);
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeChangeTracker
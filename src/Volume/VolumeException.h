@@ -27,6 +27,7 @@ namespace Basalt
 #define TC_EXCEPTION_SET \
 	TC_EXCEPTION (HigherVersionRequired); \
 	TC_EXCEPTION (KeyfilePathEmpty); \
+	TC_EXCEPTION (KeyRotationNotCompleted); \
 	TC_EXCEPTION (MissingVolumeData); \
 	TC_EXCEPTION (MountedVolumeInUse); \
 	TC_EXCEPTION (UnsupportedSectorSize); \
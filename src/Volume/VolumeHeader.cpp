@@ -11,6 +11,7 @@
 #include "Pkcs5Kdf.h"
 #include "Pkcs5Kdf.h"
 #include "VolumeHeader.h"
+#include "VolumeHeaderTrialSet.h"
 #include "VolumeException.h"
 #include "Common/Crypto.h"
 
@@ -84,46 +85,39 @@ namespace Basalt
 			throw PasswordEmpty (SRC_POS);
 
 		ConstBufferPtr salt (encryptedData.GetRange (SaltOffset, SaltSize));
+		ConstBufferPtr encryptedHeader (encryptedData.GetRange (EncryptedHeaderDataOffset, EncryptedHeaderDataSize));
 		SecureBuffer header (EncryptedHeaderDataSize);
+		BufferPtr firstBlock (header.GetRange (0, Cipher::MaxBlockSize));
 		SecureBuffer headerKey (GetLargestSerializedKeySize());
 
+		// Cipher objects are allocated once and each distinct key schedule is expanded once per derived key
+		VolumeHeaderTrialSet trials (encryptionAlgorithms, encryptionModes, LegacyEncryptionModeKeyAreaSize);
+
 		for (const auto &pkcs5 : keyDerivationFunctions)
 		{
 			pkcs5->DeriveKey (headerKey, password, salt);
+			trials.SetKey (headerKey);
 
-			for (auto mode : encryptionModes)
+			for (const auto &candidate : trials.GetCandidates())
 			{
-				if (typeid (*mode) != typeid (EncryptionModeXTS))
-					mode->SetKey (headerKey.GetRange (0, mode->GetKeySize()));
+				// The modes decrypt the first cipher block independently of the rest, which is enough to check the magic
+				firstBlock.CopyFrom (encryptedHeader.GetRange (0, firstBlock.Size()));
+				trials.Decrypt (candidate, firstBlock);
+
+				if (!IsMagicValid (firstBlock))
+					continue;
+
+				header.CopyFrom (encryptedHeader);
+				trials.Decrypt (candidate, header);
+
+				shared_ptr <EncryptionAlgorithm> ea = candidate.EA;
+				shared_ptr <EncryptionMode> mode = candidate.Mode;
 
-				for (auto ea : encryptionAlgorithms)
+				if (Deserialize (header, ea, mode))
 				{
-					if (!ea->IsModeSupported (mode))
-						continue;
-
-					if (typeid (*mode) == typeid (EncryptionModeXTS))
-					{
-						ea->SetKey (headerKey.GetRange (0, ea->GetKeySize()));
-
-						mode = mode->GetNew();
-						mode->SetKey (headerKey.GetRange (ea->GetKeySize(), ea->GetKeySize()));
-					}
-					else
-					{
-						ea->SetKey (headerKey.GetRange (LegacyEncryptionModeKeyAreaSize, ea->GetKeySize()));
-					}
-
-					ea->SetMode (mode);
-
-					header.CopyFrom (encryptedData.GetRange (EncryptedHeaderDataOffset, EncryptedHeaderDataSize));
-					ea->Decrypt (header);
-
-					if (Deserialize (header, ea, mode))
-					{
-						EA = ea;
-						Pkcs5 = pkcs5;
-						return true;
-					}
+					EA = ea;
+					Pkcs5 = pkcs5;
+					return true;
 				}
 			}
 		}
@@ -136,13 +130,7 @@ namespace Basalt
 		if (header.Size() != EncryptedHeaderDataSize)
 			throw ParameterIncorrect (SRC_POS);
 
-		// Accept TrueCrypt ("TRUE"), VeraCrypt ("VERA"), and Basalt ("BSLT") volumes
-		bool validMagic =
-			(header[0] == 'T' && header[1] == 'R' && header[2] == 'U' && header[3] == 'E') ||
-			(header[0] == 'V' && header[1] == 'E' && header[2] == 'R' && header[3] == 'A') ||
-			(header[0] == 'B' && header[1] == 'S' && header[2] == 'L' && header[3] == 'T');
-
-		if (!validMagic)
+		if (!IsMagicValid (header))
 			return false;
 
 		size_t offset = 4;
@@ -192,11 +180,6 @@ namespace Basalt
 			throw ParameterIncorrect (SRC_POS);
 		}
 
-#if !(defined (TC_WINDOWS) || defined (TC_LINUX))
-		if (SectorSize != TC_SECTOR_SIZE_LEGACY)
-			throw UnsupportedSectorSize (SRC_POS);
-#endif
-
 		offset = DataAreaKeyOffset;
 
 		if (VolumeKeyAreaCrc32 != Crc32::ProcessBuffer (header.GetRange (offset, DataKeyAreaMaxSize)))
@@ -243,6 +226,17 @@ namespace Basalt
 		return Endian::Big (*reinterpret_cast<const T *> (header.Get() + offset));
 	}
 
+	bool VolumeHeader::IsMagicValid (const ConstBufferPtr &header)
+	{
+		if (header.Size() < 4)
+			return false;
+
+		// Accept TrueCrypt ("TRUE"), VeraCrypt ("VERA"), and Basalt ("BSLT") volumes
+		return (header[0] == 'T' && header[1] == 'R' && header[2] == 'U' && header[3] == 'E')
+			|| (header[0] == 'V' && header[1] == 'E' && header[2] == 'R' && header[3] == 'A')
+			|| (header[0] == 'B' && header[1] == 'S' && header[2] == 'L' && header[3] == 'T');
+	}
+
 	void VolumeHeader::EncryptNew (const BufferPtr &newHeaderBuffer, const ConstBufferPtr &newSalt, const ConstBufferPtr &newHeaderKey, shared_ptr <Pkcs5Kdf> newPkcs5Kdf)
 	{
 		if (newHeaderBuffer.Size() != HeaderSize || newSalt.Size() != SaltSize)
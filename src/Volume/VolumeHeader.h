@@ -71,13 +71,17 @@ namespace Basalt
 		static uint32 GetSaltSize () { return SaltSize; }
 		uint64 GetVolumeDataSize () const { return VolumeDataSize; }
 		VolumeTime GetVolumeCreationTime () const { return VolumeCreationTime; }
+		void SetEncryptedArea (uint64 start, uint64 length) { EncryptedAreaStart = start; EncryptedAreaLength = length; }
+		void SetFlags (uint32 flags) { Flags = flags; }
 		void SetSize (uint32 headerSize);
+		void SetVolumeDataSize (uint64 size) { VolumeDataSize = size; }
 
 	protected:
 		bool Deserialize (const ConstBufferPtr &header, shared_ptr <EncryptionAlgorithm> &ea, shared_ptr <EncryptionMode> &mode);
 		template <typename T> T DeserializeEntry (const ConstBufferPtr &header, size_t &offset) const;
 		template <typename T> T DeserializeEntryAt (const ConstBufferPtr &header, const size_t &offset) const;
 		void Init ();
+		static bool IsMagicValid (const ConstBufferPtr &header);
 		void Serialize (const BufferPtr &header) const;
 		template <typename T> void SerializeEntry (const T &entry, const BufferPtr &header, size_t &offset) const;
 
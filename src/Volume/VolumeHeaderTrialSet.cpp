@@ -0,0 +1,118 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include "EncryptionModeXTS.h"
+#include "VolumeHeaderTrialSet.h"
+#include "Platform/Memory.h"
+
+namespace Basalt
+{
+	VolumeHeaderTrialSet::VolumeHeaderTrialSet (const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, size_t legacyModeKeyAreaSize)
+	{
+		// The order of the candidates is the order in which the header was tried before, mode by mode
+		for (const auto &mode : encryptionModes)
+		{
+			bool legacyMode = (typeid (*mode) != typeid (EncryptionModeXTS));
+			shared_ptr <EncryptionMode> legacyModeInstance;
+
+			if (legacyMode)
+			{
+				// The key of a legacy mode does not depend on the algorithm, so one instance serves all candidates
+				legacyModeInstance = mode->GetNew();
+				LegacyModes.push_back (legacyModeInstance);
+			}
+
+			for (const auto &ea : encryptionAlgorithms)
+			{
+				if (!ea->IsModeSupported (mode))
+					continue;
+
+				Candidate candidate;
+				candidate.EA = ea;
+				candidate.LegacyMode = legacyMode;
+				candidate.XtsKeysEqual = false;
+
+				size_t keyOffset = legacyMode ? legacyModeKeyAreaSize : 0;
+				for (const auto &cipher : ea->GetCiphers())
+				{
+					candidate.Ciphers.push_back (GetSlotCipher (*cipher, keyOffset));
+
+					if (!legacyMode)
+						candidate.SecondaryCiphers.push_back (GetSlotCipher (*cipher, ea->GetKeySize() + keyOffset));
+
+					keyOffset += cipher->GetKeySize();
+				}
+
+				if (legacyMode)
+				{
+					candidate.Mode = legacyModeInstance;
+				}
+				else
+				{
+					shared_ptr <EncryptionModeXTS> xts (new EncryptionModeXTS);
+					xts->SetCiphers (candidate.Ciphers, candidate.SecondaryCiphers);
+					candidate.Mode = xts;
+				}
+
+				Candidates.push_back (candidate);
+			}
+		}
+	}
+
+	void VolumeHeaderTrialSet::Decrypt (const Candidate &candidate, const BufferPtr &data) const
+	{
+		// EncryptionModeXTS::SetKey() rejects a secondary key equal to the primary one
+		if (candidate.XtsKeysEqual)
+			throw ParameterIncorrect (SRC_POS);
+
+		if (candidate.LegacyMode)
+			candidate.Mode->SetCiphers (candidate.Ciphers);
+
+		candidate.Mode->Decrypt (data, data.Size());
+	}
+
+	shared_ptr <Cipher> VolumeHeaderTrialSet::GetSlotCipher (const Cipher &cipher, size_t keyOffset)
+	{
+		for (const auto &slot : KeySlots)
+		{
+			if (slot.KeyOffset == keyOffset && typeid (*slot.SlotCipher) == typeid (cipher))
+				return slot.SlotCipher;
+		}
+
+		KeySlot slot;
+		slot.SlotCipher = cipher.GetNew();
+		slot.KeyOffset = keyOffset;
+		KeySlots.push_back (slot);
+
+		return slot.SlotCipher;
+	}
+
+	void VolumeHeaderTrialSet::SetKey (const ConstBufferPtr &headerKey)
+	{
+		for (const auto &slot : KeySlots)
+			slot.SlotCipher->SetKey (headerKey.GetRange (slot.KeyOffset, slot.SlotCipher->GetKeySize()));
+
+		for (const auto &mode : LegacyModes)
+			mode->SetKey (headerKey.GetRange (0, mode->GetKeySize()));
+
+		for (auto &candidate : Candidates)
+		{
+			if (candidate.LegacyMode)
+				continue;
+
+			candidate.XtsKeysEqual = false;
+
+			for (size_t i = 0; i < candidate.Ciphers.size(); ++i)
+			{
+				const SecureBuffer &key = candidate.Ciphers[i]->GetKey();
+				if (Memory::ConstantTimeCompare (key.Ptr(), candidate.SecondaryCiphers[i]->GetKey().Ptr(), key.Size()))
+					candidate.XtsKeysEqual = true;
+			}
+		}
+	}
+}
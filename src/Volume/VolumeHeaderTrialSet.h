@@ -0,0 +1,67 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeHeaderTrialSet
+#define TC_HEADER_Volume_VolumeHeaderTrialSet
+
+#include "Platform/Platform.h"
+#include "Cipher.h"
+#include "EncryptionAlgorithm.h"
+#include "EncryptionMode.h"
+
+namespace Basalt
+{
+	/*
+	 * Encryption algorithm and mode combinations tried when decrypting a volume
+	 * header. Many combinations use the same cipher keyed from the same slice of
+	 * the header key (e.g. AES at offset 32 is the XTS secondary cipher of AES,
+	 * the second cipher of AES-Twofish and the legacy-mode key of AES). Such
+	 * ciphers are shared, so that SetKey() expands each distinct key schedule
+	 * once per derived header key, and all objects are allocated up front.
+	 */
+	class VolumeHeaderTrialSet
+	{
+	public:
+		struct Candidate
+		{
+			shared_ptr <EncryptionAlgorithm> EA; // Algorithm of the list passed to the constructor
+			shared_ptr <EncryptionMode> Mode;
+			CipherList Ciphers;
+			CipherList SecondaryCiphers;
+			bool LegacyMode;
+			bool XtsKeysEqual;
+		};
+
+		VolumeHeaderTrialSet (const EncryptionAlgorithmList &encryptionAlgorithms, const EncryptionModeList &encryptionModes, size_t legacyModeKeyAreaSize);
+		virtual ~VolumeHeaderTrialSet () { }
+
+		void Decrypt (const Candidate &candidate, const BufferPtr &data) const;
+		const vector <Candidate> &GetCandidates () const { return Candidates; }
+		size_t GetKeyScheduleCount () const { return KeySlots.size(); }
+		void SetKey (const ConstBufferPtr &headerKey);
+
+	protected:
+		struct KeySlot
+		{
+			shared_ptr <Cipher> SlotCipher;
+			size_t KeyOffset;
+		};
+
+		shared_ptr <Cipher> GetSlotCipher (const Cipher &cipher, size_t keyOffset);
+
+		vector <Candidate> Candidates;
+		vector <KeySlot> KeySlots;
+		EncryptionModeList LegacyModes;
+
+	private:
+		VolumeHeaderTrialSet (const VolumeHeaderTrialSet &);
+		VolumeHeaderTrialSet &operator= (const VolumeHeaderTrialSet &);
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeHeaderTrialSet
@@ -25,6 +25,9 @@ namespace Basalt
 		EncryptionModeName = sr.DeserializeWString ("EncryptionModeName");
 		sr.Deserialize ("HeaderCreationTime", HeaderCreationTime);
 		sr.Deserialize ("HiddenVolumeProtectionTriggered", HiddenVolumeProtectionTriggered);
+		sr.Deserialize ("KeyRotationInProgress", KeyRotationInProgress);
+		sr.Deserialize ("KeyRotationPaused", KeyRotationPaused);
+		sr.Deserialize ("KeyRotationSizeDone", KeyRotationSizeDone);
 		LoopDevice = sr.DeserializeWString ("LoopDevice");
 		sr.Deserialize ("MinRequiredProgramVersion", MinRequiredProgramVersion);
 		MountPoint = sr.DeserializeWString ("MountPoint");
@@ -35,6 +38,12 @@ namespace Basalt
 		sr.Deserialize ("SerialInstanceNumber", SerialInstanceNumber);
 		sr.Deserialize ("Size", Size);
 		sr.Deserialize ("SlotNumber", SlotNumber);
+		sr.Deserialize ("SyncFlushCount", SyncFlushCount);
+		sr.Deserialize ("SyncLatencyMax", SyncLatencyMax);
+		sr.Deserialize ("SyncLatencyP50", SyncLatencyP50);
+		sr.Deserialize ("SyncLatencyP90", SyncLatencyP90);
+		sr.Deserialize ("SyncLatencyP99", SyncLatencyP99);
+		sr.Deserialize ("SyncRequestCount", SyncRequestCount);
 		sr.Deserialize ("SystemEncryption", SystemEncryption);
 		sr.Deserialize ("TopWriteOffset", TopWriteOffset);
 		sr.Deserialize ("TotalDataRead", TotalDataRead);
@@ -64,6 +73,9 @@ namespace Basalt
 		sr.Serialize ("EncryptionModeName", EncryptionModeName);
 		sr.Serialize ("HeaderCreationTime", HeaderCreationTime);
 		sr.Serialize ("HiddenVolumeProtectionTriggered", HiddenVolumeProtectionTriggered);
+		sr.Serialize ("KeyRotationInProgress", KeyRotationInProgress);
+		sr.Serialize ("KeyRotationPaused", KeyRotationPaused);
+		sr.Serialize ("KeyRotationSizeDone", KeyRotationSizeDone);
 		sr.Serialize ("LoopDevice", wstring (LoopDevice));
 		sr.Serialize ("MinRequiredProgramVersion", MinRequiredProgramVersion);
 		sr.Serialize ("MountPoint", wstring (MountPoint));
@@ -74,6 +86,12 @@ namespace Basalt
 		sr.Serialize ("SerialInstanceNumber", SerialInstanceNumber);
 		sr.Serialize ("Size", Size);
 		sr.Serialize ("SlotNumber", SlotNumber);
+		sr.Serialize ("SyncFlushCount", SyncFlushCount);
+		sr.Serialize ("SyncLatencyMax", SyncLatencyMax);
+		sr.Serialize ("SyncLatencyP50", SyncLatencyP50);
+		sr.Serialize ("SyncLatencyP90", SyncLatencyP90);
+		sr.Serialize ("SyncLatencyP99", SyncLatencyP99);
+		sr.Serialize ("SyncRequestCount", SyncRequestCount);
 		sr.Serialize ("SystemEncryption", SystemEncryption);
 		sr.Serialize ("TopWriteOffset", TopWriteOffset);
 		sr.Serialize ("TotalDataRead", TotalDataRead);
@@ -93,12 +111,21 @@ namespace Basalt
 		HeaderCreationTime = volume.GetHeaderCreationTime();
 		VolumeCreationTime = volume.GetVolumeCreationTime();
 		HiddenVolumeProtectionTriggered = volume.IsHiddenVolumeProtectionTriggered();
+		KeyRotationInProgress = volume.IsKeyRotationInProgress();
+		KeyRotationPaused = false;
+		KeyRotationSizeDone = volume.GetKeyRotationWatermark();
 		MinRequiredProgramVersion = volume.GetHeader()->GetRequiredMinProgramVersion();
 		Path = volume.GetPath();
 		Pkcs5IterationCount = volume.GetPkcs5Kdf()->GetIterationCount();
 		Pkcs5PrfName = volume.GetPkcs5Kdf()->GetName();
 		Protection = volume.GetProtectionType();
 		Size = volume.GetSize();
+		SyncFlushCount = 0;
+		SyncLatencyMax = 0;
+		SyncLatencyP50 = 0;
+		SyncLatencyP90 = 0;
+		SyncLatencyP99 = 0;
+		SyncRequestCount = 0;
 		SystemEncryption = volume.IsInSystemEncryptionScope();
 		Type = volume.GetType();
 		TopWriteOffset = volume.GetTopWriteOffset();
@@ -38,6 +38,9 @@ namespace Basalt
 		wstring EncryptionModeName;
 		VolumeTime HeaderCreationTime;
 		bool HiddenVolumeProtectionTriggered;
+		bool KeyRotationInProgress;
+		bool KeyRotationPaused;
+		uint64 KeyRotationSizeDone;
 		DevicePath LoopDevice;
 		uint32 MinRequiredProgramVersion;
 		DirectoryPath MountPoint;
@@ -49,6 +52,12 @@ namespace Basalt
 		uint64 SerialInstanceNumber;
 		uint64 Size;
 		VolumeSlotNumber SlotNumber;
+		uint64 SyncFlushCount;
+		uint64 SyncLatencyMax;		// Microseconds
+		uint64 SyncLatencyP50;
+		uint64 SyncLatencyP90;
+		uint64 SyncLatencyP99;
+		uint64 SyncRequestCount;
 		bool SystemEncryption;
 		uint64 TopWriteOffset;
 		uint64 TotalDataRead;
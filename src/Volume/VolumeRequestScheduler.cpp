@@ -0,0 +1,226 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#include <algorithm>
+#include "Platform/Time.h"
+#include "VolumeRequestScheduler.h"
+
+namespace Basalt
+{
+	VolumeRequestScheduler::VolumeRequestScheduler (shared_ptr <Volume> volume, uint32 queueDepth)
+		: ScheduledVolume (volume), QueueDepth (queueDepth > 0 ? queueDepth : 1),
+		InFlightCount (0), WritesStarved (0)
+	{
+		// A merged write touching the protected area of a hidden volume would fail its other requests too
+		MergeWrites = volume->GetProtectionType() != VolumeProtection::HiddenVolumeReadOnly;
+	}
+
+	void VolumeRequestScheduler::Execute (Request &request)
+	{
+		try
+		{
+			if (request.Write)
+				ScheduledVolume->WriteSectors (request.WriteBuffer, request.ByteOffset);
+			else
+				ScheduledVolume->ReadSectors (request.ReadBuffer, request.ByteOffset);
+		}
+		catch (Exception &e)
+		{
+			request.RequestException.reset (e.CloneNew());
+		}
+		catch (exception &e)
+		{
+			request.RequestException.reset (new ExternalException (SRC_POS, StringConverter::ToExceptionString (e)));
+		}
+		catch (...)
+		{
+			request.RequestException.reset (new UnknownException (SRC_POS));
+		}
+	}
+
+	void VolumeRequestScheduler::ExecuteBatch (Request &leader)
+	{
+		if (leader.Batch.empty())
+		{
+			Execute (leader);
+			return;
+		}
+
+		vector <Request *> requests (leader.Batch.begin(), leader.Batch.end());
+		requests.push_back (&leader);
+
+		sort (requests.begin(), requests.end(), [] (const Request *a, const Request *b) { return a->ByteOffset < b->ByteOffset; });
+
+		uint64 startOffset = requests.front()->ByteOffset;
+		size_t totalSize = 0;
+		for (const Request *request : requests)
+			totalSize += request->Size;
+
+		try
+		{
+			// Holds plaintext of the volume
+			SecureBuffer buffer (totalSize);
+
+			if (leader.Write)
+			{
+				for (const Request *request : requests)
+					buffer.GetRange (request->ByteOffset - startOffset, request->Size).CopyFrom (request->WriteBuffer);
+
+				ScheduledVolume->WriteSectors (buffer, startOffset);
+			}
+			else
+			{
+				ScheduledVolume->ReadSectors (buffer, startOffset);
+
+				for (Request *request : requests)
+					request->ReadBuffer.CopyFrom (buffer.GetRange (request->ByteOffset - startOffset, request->Size));
+			}
+		}
+		catch (...)
+		{
+			// Only the requests which fail on their own report an error
+			for (Request *request : requests)
+				Execute (*request);
+		}
+
+		// A request may be destroyed as soon as it is signaled
+		for (Request *request : leader.Batch)
+			request->CompletedEvent.Signal();
+	}
+
+	void VolumeRequestScheduler::MergeAdjacent (Request &leader, list <Request *> &queue)
+	{
+		uint64 startOffset = leader.ByteOffset;
+		uint64 endOffset = leader.ByteOffset + leader.Size;
+		size_t totalSize = leader.Size;
+
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+
+			for (list <Request *>::iterator i = queue.begin(); i != queue.end(); ++i)
+			{
+				Request *request = *i;
+				if (totalSize + request->Size > MaxMergeSize)
+					continue;
+
+				if (request->ByteOffset == endOffset)
+					endOffset += request->Size;
+				else if (request->ByteOffset + request->Size == startOffset)
+					startOffset = request->ByteOffset;
+				else
+					continue;
+
+				totalSize += request->Size;
+				leader.Batch.push_back (request);
+				queue.erase (i);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	void VolumeRequestScheduler::ReadSectors (const BufferPtr &buffer, uint64 byteOffset)
+	{
+		Request request (buffer, byteOffset, Time::GetCurrent() + ReadDeadline * 10000ULL);
+		Submit (request);
+	}
+
+	void VolumeRequestScheduler::Release ()
+	{
+		list <Request *> dispatched;
+		{
+			ScopeLock lock (QueueMutex);
+			--InFlightCount;
+
+			while (InFlightCount < QueueDepth)
+			{
+				Request *request = SelectNext();
+				if (!request)
+					break;
+
+				++InFlightCount;
+				request->Dispatched = true;
+				dispatched.push_back (request);
+			}
+		}
+
+		for (Request *request : dispatched)
+			request->CompletedEvent.Signal();
+	}
+
+	VolumeRequestScheduler::Request *VolumeRequestScheduler::SelectNext ()
+	{
+		if (ReadQueue.empty() && WriteQueue.empty())
+			return nullptr;
+
+		// Time is measured in units of 100 ns and may be set back, which only delays expiry
+		uint64 currentTime = Time::GetCurrent();
+
+		bool selectWrite;
+		if (ReadQueue.empty())
+			selectWrite = true;
+		else if (WriteQueue.empty() || ReadQueue.front()->Deadline <= currentTime)
+			selectWrite = false;
+		else
+			selectWrite = WriteQueue.front()->Deadline <= currentTime || WritesStarved >= WriteStarvationLimit;
+
+		if (selectWrite)
+			WritesStarved = 0;
+		else if (!WriteQueue.empty())
+			++WritesStarved;
+
+		// Queues are in arrival order, so their fronts expire first
+		list <Request *> &queue = selectWrite ? WriteQueue : ReadQueue;
+		Request *request = queue.front();
+		queue.pop_front();
+
+		if (!request->Write || MergeWrites)
+			MergeAdjacent (*request, queue);
+
+		return request;
+	}
+
+	void VolumeRequestScheduler::Submit (Request &request)
+	{
+		{
+			ScopeLock lock (QueueMutex);
+
+			// Requests wait only while the volume is busy, so the queues are empty when a slot is free
+			if (InFlightCount < QueueDepth)
+			{
+				++InFlightCount;
+				request.Dispatched = true;
+			}
+			else
+			{
+				(request.Write ? WriteQueue : ReadQueue).push_back (&request);
+			}
+		}
+
+		// A waiting request is either completed by the thread of another request or dispatched
+		if (!request.Dispatched)
+			request.CompletedEvent.Wait();
+
+		if (request.Dispatched)
+		{
+			ExecuteBatch (request);
+			Release();
+		}
+
+		if (request.RequestException)
+			request.RequestException->Throw();
+	}
+
+	void VolumeRequestScheduler::WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset)
+	{
+		Request request (buffer, byteOffset, Time::GetCurrent() + WriteDeadline * 10000ULL);
+		Submit (request);
+	}
+}
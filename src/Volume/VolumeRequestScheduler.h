@@ -0,0 +1,89 @@
+/*
+ Copyright (c) 2026 Basalt contributors. All rights reserved.
+
+ Governed by the TrueCrypt License 3.0 the full text of which is contained in
+ the file License.txt included in TrueCrypt binary and source code distribution
+ packages.
+*/
+
+#ifndef TC_HEADER_Volume_VolumeRequestScheduler
+#define TC_HEADER_Volume_VolumeRequestScheduler
+
+#include "Platform/Platform.h"
+#include "Volume.h"
+
+namespace Basalt
+{
+	/*
+	 * Limits the number of requests processed by a volume at a time to the
+	 * queue depth and decides the order of the requests waiting beyond it.
+	 * Reads and writes wait in separate queues. Reads are preferred, as their
+	 * callers are blocked on them, but a write is dispatched when its deadline
+	 * expires or after WriteStarvationLimit read batches passed waiting writes.
+	 *
+	 * Waiting requests adjacent to a dispatched one are merged with it into a
+	 * single request of up to MaxMergeSize bytes, so that the data is
+	 * encrypted by the thread pool and transferred to the host file in larger
+	 * units. The thread of the dispatched request performs the merged request.
+	 */
+	class VolumeRequestScheduler
+	{
+	public:
+		VolumeRequestScheduler (shared_ptr <Volume> volume, uint32 queueDepth = DefaultQueueDepth);
+		virtual ~VolumeRequestScheduler () { }
+
+		uint32 GetQueueDepth () const { return QueueDepth; }
+		void ReadSectors (const BufferPtr &buffer, uint64 byteOffset);
+		void WriteSectors (const ConstBufferPtr &buffer, uint64 byteOffset);
+
+		static const uint32 DefaultQueueDepth = 4;
+		static const size_t MaxMergeSize = 1024 * 1024;
+		static const uint32 ReadDeadline = 50;		// Milliseconds
+		static const uint32 WriteDeadline = 500;
+		static const size_t WriteStarvationLimit = 2;
+
+	protected:
+		struct Request
+		{
+			Request (const BufferPtr &readBuffer, uint64 byteOffset, uint64 deadline)
+				: ByteOffset (byteOffset), Deadline (deadline), Dispatched (false), ReadBuffer (readBuffer), Size (readBuffer.Size()), Write (false) { }
+
+			Request (const ConstBufferPtr &writeBuffer, uint64 byteOffset, uint64 deadline)
+				: ByteOffset (byteOffset), Deadline (deadline), Dispatched (false), Size (writeBuffer.Size()), Write (true), WriteBuffer (writeBuffer) { }
+
+			list <Request *> Batch;		// Requests merged into this one
+			uint64 ByteOffset;
+			SyncEvent CompletedEvent;
+			uint64 Deadline;
+			bool Dispatched;
+			BufferPtr ReadBuffer;
+			shared_ptr <Exception> RequestException;
+			size_t Size;
+			bool Write;
+			ConstBufferPtr WriteBuffer;
+		};
+
+		void Execute (Request &request);
+		void ExecuteBatch (Request &leader);
+		void MergeAdjacent (Request &leader, list <Request *> &queue);
+		void Release ();
+		Request *SelectNext ();
+		void Submit (Request &request);
+
+		shared_ptr <Volume> ScheduledVolume;
+		bool MergeWrites;
+		uint32 QueueDepth;
+
+		size_t InFlightCount;
+		Mutex QueueMutex;
+		list <Request *> ReadQueue;
+		list <Request *> WriteQueue;
+		size_t WritesStarved;
+
+	private:
+		VolumeRequestScheduler (const VolumeRequestScheduler &);
+		VolumeRequestScheduler &operator= (const VolumeRequestScheduler &);
+	};
+}
+
+#endif // TC_HEADER_Volume_VolumeRequestScheduler